@@ -84,6 +84,31 @@ void generateSymmetricKeyFromSharedSecret(SecByteBlock &key, SecByteBlock &share
     SHA256().CalculateDigest(key, sharedSecret.BytePtr(), sharedSecret.SizeInBytes());
 }
 
+/**
+ * Derive the initialization vector for the messages one side sends under the session key, so
+ * the third message and its reply are never encrypted under the same key and IV.
+ *
+ * Hashes a direction byte, 0 for the side that sent the first message and 1 for the side that
+ * replied to it, followed by the initiator's and the responder's random numbers, and keeps
+ * the first AES::BLOCKSIZE bytes of the digest.
+ */
+void generateInitializationVector(byte *ivBytes, bool fromInitiator, 
+        const SecByteBlock &initiatorRandomNumber, const SecByteBlock &responderRandomNumber) {
+    if (initiatorRandomNumber.SizeInBytes() == 0 || responderRandomNumber.SizeInBytes() == 0) {
+        throw runtime_error("Random number is empty!!!");
+    }
+    SecByteBlock input(1 + initiatorRandomNumber.SizeInBytes() 
+            + responderRandomNumber.SizeInBytes());
+    input.BytePtr()[0] = fromInitiator ? 0 : 1;
+    memcpy(input.BytePtr() + 1, initiatorRandomNumber.BytePtr(), 
+            initiatorRandomNumber.SizeInBytes());
+    memcpy(input.BytePtr() + 1 + initiatorRandomNumber.SizeInBytes(), 
+            responderRandomNumber.BytePtr(), responderRandomNumber.SizeInBytes());
+    SecByteBlock digest(SHA256::DIGESTSIZE);
+    SHA256().CalculateDigest(digest, input.BytePtr(), input.SizeInBytes());
+    memcpy(ivBytes, digest.BytePtr(), AES::BLOCKSIZE);
+}
+
 /**
  * DO NOT encrypt with any additionally authenticated (but unencrypted) data.
 
@@ -301,4 +326,68 @@ bool decryptFile(const string &inputFileName, const string &authInputFileName,
     delete[] retrievedData;
 
     return true;
-}
\ No newline at end of file
+}
+
+/**
+ * Encrypts input in memory with GCM<AES>, key and ivBytes, without additionally authenticated 
+ * data. The output is laid out like the file written by encryptFile, the cipher text followed 
+ * by the MAC, so either side of a session can use files or memory.
+ */
+void encryptBytes(const vector<byte> &input, vector<byte> &output, SecByteBlock &key, 
+        byte *ivBytes) {
+    GCM<AES>::Encryption encrypt;
+    encrypt.SetKeyWithIV(key, key.size(), ivBytes, AES::BLOCKSIZE);
+
+    string cipherText;
+    AuthenticatedEncryptionFilter encryptionFilter(encrypt, 
+            new StringSink(cipherText), false, MAC_SIZE);
+    encryptionFilter.ChannelPut(DEFAULT_CHANNEL, input.data(), input.size());
+    encryptionFilter.ChannelMessageEnd(DEFAULT_CHANNEL);
+
+    output.assign(cipherText.begin(), cipherText.end());
+}
+
+/**
+ * Decrypts and verifies input laid out like the files written by encryptFile, the cipher text 
+ * followed by the MAC. Returns false, leaving output empty, if the data was tampered with.
+ */
+bool decryptBytes(const vector<byte> &input, vector<byte> &output, SecByteBlock &key, 
+        byte *ivBytes) {
+    output.clear();
+    if (input.size() <= MAC_SIZE) {
+        cerr << "Input of " << input.size() << " bytes is too short to hold a MAC" 
+                << " in decryptBytes in lgtm_crypto.cpp" << endl;
+        return false;
+    }
+    GCM<AES>::Decryption decrypt;
+    decrypt.SetKeyWithIV(key, key.size(), ivBytes, AES::BLOCKSIZE);
+    AuthenticatedDecryptionFilter decryptionFilter(decrypt, 
+            NULL,
+            AuthenticatedDecryptionFilter::MAC_AT_BEGIN | 
+            AuthenticatedDecryptionFilter::THROW_EXCEPTION, MAC_SIZE);
+
+    // The order of the "ChannelPut" calls is important!!! (MAC -> ENCRYPTED DATA)
+    size_t encryptedDataLength = input.size() - MAC_SIZE;
+    decryptionFilter.ChannelPut(DEFAULT_CHANNEL, input.data() + encryptedDataLength, MAC_SIZE);
+    decryptionFilter.ChannelPut(DEFAULT_CHANNEL, input.data(), encryptedDataLength);
+
+    // Check data authenticity here...
+    try {
+        decryptionFilter.ChannelMessageEnd(AAD_CHANNEL);
+        decryptionFilter.ChannelMessageEnd(DEFAULT_CHANNEL);
+    } catch (const CryptoPP::Exception &e) {
+        cerr << "DATA FOUND TO BE TAMPERED WITH IN decryptBytes ON FIRST CHECK" << endl;
+        return false;
+    }
+    if (!decryptionFilter.GetLastResult()) {
+        cerr << "DATA FOUND TO BE TAMPERED WITH IN decryptBytes ON SECOND CHECK" << endl;
+        return false;
+    }
+
+    decryptionFilter.SetRetrievalChannel(DEFAULT_CHANNEL);
+    output.resize(decryptionFilter.MaxRetrievable());
+    if (!output.empty()) {
+        decryptionFilter.Get(output.data(), output.size());
+    }
+    return true;
+}
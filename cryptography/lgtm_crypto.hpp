@@ -37,6 +37,7 @@
 #include "../../cryptopp/secblock.h"
 #include "../../cryptopp/sha.h"
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <stdexcept>
@@ -87,6 +88,8 @@ void generateDiffieHellmanParameters(SecByteBlock &publicKey, SecByteBlock &priv
 bool diffieHellmanSharedSecretAgreement(SecByteBlock &sharedSecret, SecByteBlock &otherPublicKey, 
         SecByteBlock &privateKey);
 void generateSymmetricKeyFromSharedSecret(SecByteBlock &key, SecByteBlock &sharedSecret);
+void generateInitializationVector(byte *ivBytes, bool fromInitiator, 
+        const SecByteBlock &initiatorRandomNumber, const SecByteBlock &responderRandomNumber);
 
 // Encryption/Decryption----------------------------------------------------------------------------
 void encryptFile(const string &inputFileName, const string &outputFileName, 
@@ -98,4 +101,9 @@ void encryptFile(const string &inputFileName, const string &authInputFileName,
         const string &outputFileName, SecByteBlock &key, byte *ivBytes);
 bool decryptFile(const string &inputFileName, const string &authInputFileName, 
         const string &outputFileName, SecByteBlock &key, byte *ivBytes);
+// In memory, same format as the files
+void encryptBytes(const vector<byte> &input, vector<byte> &output, SecByteBlock &key, 
+        byte *ivBytes);
+bool decryptBytes(const vector<byte> &input, vector<byte> &output, SecByteBlock &key, 
+        byte *ivBytes);
 #endif
\ No newline at end of file
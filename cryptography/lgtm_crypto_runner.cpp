@@ -191,11 +191,13 @@ bool thirdMessage() {
     writeToFile(SHARED_SECRET_FILE_NAME, sharedSecret);
     writeToFile(COMPUTED_KEY_FILE_NAME, key);
 
-    // Read in the current initialization vector from file
+    // Derive the initialization vector of the first sender's messages
+    SecByteBlock randomNumber;
+    SecByteBlock otherRandomNumber;
+    readFromFile(FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, randomNumber);
+    readFromFile(OTHER_FIRST_MESSAGE_RANDOM_NUMBER, otherRandomNumber);
     byte curIv[AES::BLOCKSIZE];
-    // TODO: actually read it in
-    // Set to 0 for now
-    memset(curIv, 0, AES::BLOCKSIZE);
+    generateInitializationVector(curIv, true, randomNumber, otherRandomNumber);
 
     // Encrypt facial recognition params
     encryptFile(FACIAL_RECOGNITION_FILE_NAME, 
@@ -214,16 +216,21 @@ bool replyToThirdMessage() {
     SecByteBlock key;
     readFromFile(COMPUTED_KEY_FILE_NAME, key);
 
-    // Read in the current initialization vector from file
+    // Derive the initialization vectors of each side's messages, the first sender's random
+    // number is the other one
+    SecByteBlock randomNumber;
+    SecByteBlock otherRandomNumber;
+    readFromFile(FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, randomNumber);
+    readFromFile(OTHER_FIRST_MESSAGE_RANDOM_NUMBER, otherRandomNumber);
+    byte receivedIv[AES::BLOCKSIZE];
     byte curIv[AES::BLOCKSIZE];
-    // TODO: actually read it in
-    // Set to 0 for now
-    memset(curIv, 0, AES::BLOCKSIZE);
+    generateInitializationVector(receivedIv, true, otherRandomNumber, randomNumber);
+    generateInitializationVector(curIv, false, otherRandomNumber, randomNumber);
 
     // Decrypt received facial recognition params
     if (!decryptFile(THIRD_MESSAGE_FILE_NAME, 
             RECEIVED_FACIAL_RECOGNITION_FILE_NAME,
-            key, curIv)) {
+            key, receivedIv)) {
         cerr << "Security Error in replyToThirdMessage. MAC could not be verified." << endl;
         return false;
     }
@@ -244,11 +251,13 @@ bool decryptThirdMessageReply() {
     SecByteBlock key;
     readFromFile(COMPUTED_KEY_FILE_NAME, key);
 
-    // Read in the current initialization vector from file
+    // Derive the initialization vector of the replying side's messages
+    SecByteBlock randomNumber;
+    SecByteBlock otherRandomNumber;
+    readFromFile(FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, randomNumber);
+    readFromFile(OTHER_FIRST_MESSAGE_RANDOM_NUMBER, otherRandomNumber);
     byte curIv[AES::BLOCKSIZE];
-    // TODO: actually read it in
-    // Set to 0 for now
-    memset(curIv, 0, AES::BLOCKSIZE);
+    generateInitializationVector(curIv, false, randomNumber, otherRandomNumber);
 
     // Decrypt facial recognition params
     if (!decryptFile(THIRD_MESSAGE_REPLY_FILE_NAME,
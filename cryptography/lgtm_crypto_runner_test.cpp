@@ -31,6 +31,7 @@
 #include "../../cryptopp/secblock.h"
 
 #include <fstream>
+#include <iterator>
 #include <string>
 #include <vector>
 
@@ -93,6 +94,22 @@ static const string RECEIVED_FACIAL_RECOGNITION_PARAMS_STRING
 static const unsigned int RANDOM_NUMBER_SIZE = 256;
 
 //~Simulated Reply Functions------------------------------------------------------------------------
+/**
+ * Derive the initialization vector the simulated side sends under, either as the first sender
+ * or as the side replying to the runner's first message.
+ */
+void generateSimulatedInitializationVector(byte *ivBytes, bool simulatedFirstMessage) {
+    SecByteBlock randomNumber;
+    SecByteBlock simulatedRandomNumber;
+    readFromFile(FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, randomNumber);
+    readFromFile(TEST_OTHER_FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, simulatedRandomNumber);
+    if (simulatedFirstMessage) {
+        generateInitializationVector(ivBytes, true, simulatedRandomNumber, randomNumber);
+    } else {
+        generateInitializationVector(ivBytes, false, randomNumber, simulatedRandomNumber);
+    }
+}
+
 /**
  * Simulate a reply to the first message by creating a file holding another public key.
  */
@@ -159,10 +176,9 @@ void simulateThirdMessageReply() {
             RECEIVED_FACIAL_RECOGNITION_PARAMS_STRING.length());
     plainTextOutputStream.close();
 
-    // Encrypt received facial recognition params
-    // TODO: This test will need to get more sophisticated when the IV is set differently.
+    // Encrypt received facial recognition params as the replying side
     byte curIv[AES::BLOCKSIZE];
-    memset(curIv, 0, AES::BLOCKSIZE);
+    generateSimulatedInitializationVector(curIv, false);
     encryptFile(TEST_UNENCRYPTED_RECEIVED_FACIAL_RECOGNITION_FILE_NAME,
             THIRD_MESSAGE_REPLY_FILE_NAME,
             key, curIv);
@@ -184,10 +200,9 @@ void simulateThirdMessage() {
             RECEIVED_FACIAL_RECOGNITION_PARAMS_STRING.length());
     plainTextOutputStream.close();
 
-    // Encrypt received facial recognition params
-    // TODO: This test will need to get more sophisticated when the IV is set differently.
+    // Encrypt received facial recognition params as the first sender
     byte curIv[AES::BLOCKSIZE];
-    memset(curIv, 0, AES::BLOCKSIZE);
+    generateSimulatedInitializationVector(curIv, true);
     encryptFile(TEST_UNENCRYPTED_RECEIVED_FACIAL_RECOGNITION_FILE_NAME,
             THIRD_MESSAGE_FILE_NAME,
             key, curIv);
@@ -245,7 +260,7 @@ bool checkFacialRecognitionFile() {
     inputStream.close();
 
     bool equalityCheck = (RECEIVED_FACIAL_RECOGNITION_PARAMS_STRING.compare(
-            string(facialRecognitionString)) == 0);
+            string(facialRecognitionString, fileLength)) == 0);
 
     delete[] facialRecognitionString;
 
@@ -360,6 +375,99 @@ bool testOtherWayCorruption() {
     }
 }
 
+/**
+ * Check that buffers encrypted in memory decrypt from files and the other way around, and that
+ * a corrupted buffer is rejected.
+ */
+bool testInMemory() {
+    cout << endl << "testInMemory: " << endl;
+    // Agree on a key as the first sender
+    firstMessage();
+    simulateFirstMessageReply();
+    if (!thirdMessage()) {
+        cout << endl << "In Memory Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    SecByteBlock key;
+    readFromFile(COMPUTED_KEY_FILE_NAME, key);
+    byte curIv[AES::BLOCKSIZE];
+    generateSimulatedInitializationVector(curIv, false);
+    vector<byte> plainText(RECEIVED_FACIAL_RECOGNITION_PARAMS_STRING.begin(), 
+            RECEIVED_FACIAL_RECOGNITION_PARAMS_STRING.end());
+
+    // Encrypt in memory, decrypt the file
+    vector<byte> cipherText;
+    encryptBytes(plainText, cipherText, key, curIv);
+    ofstream outputStream(THIRD_MESSAGE_REPLY_FILE_NAME, ios::out | ios::binary);
+    outputStream.write((char*) cipherText.data(), cipherText.size());
+    outputStream.close();
+    if (!decryptThirdMessageReply() || !checkFacialRecognitionFile()) {
+        cout << endl << "In Memory Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+
+    // Encrypt the file, decrypt in memory
+    simulateThirdMessageReply();
+    ifstream inputStream(THIRD_MESSAGE_REPLY_FILE_NAME, ios::in | ios::binary);
+    vector<byte> fileCipherText((std::istreambuf_iterator<char>(inputStream)), 
+            std::istreambuf_iterator<char>());
+    inputStream.close();
+    vector<byte> decrypted;
+    if (!decryptBytes(fileCipherText, decrypted, key, curIv) || decrypted != plainText) {
+        cout << endl << "In Memory Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+
+    // Corrupt a byte of the cipher text
+    fileCipherText[4] ^= 0x4;
+    if (decryptBytes(fileCipherText, decrypted, key, curIv)) {
+        cout << endl << "In Memory Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    cout << endl << "In Memory Test Passed!" << endl << endl;
+    return true;
+}
+
+/**
+ * Check that each side encrypts under its own initialization vector, so the third message and
+ * its reply never share a key and IV, and a third message reflected back as its own reply is
+ * rejected.
+ */
+bool testDirectionalIv() {
+    cout << endl << "testDirectionalIv: " << endl;
+    firstMessage();
+    simulateFirstMessageReply();
+    SecByteBlock randomNumber;
+    SecByteBlock otherRandomNumber;
+    readFromFile(FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, randomNumber);
+    readFromFile(TEST_OTHER_FIRST_MESSAGE_RANDOM_NUMBER_FILE_NAME, otherRandomNumber);
+    byte initiatorIv[AES::BLOCKSIZE];
+    byte responderIv[AES::BLOCKSIZE];
+    generateInitializationVector(initiatorIv, true, randomNumber, otherRandomNumber);
+    generateInitializationVector(responderIv, false, randomNumber, otherRandomNumber);
+    if (memcmp(initiatorIv, responderIv, AES::BLOCKSIZE) == 0) {
+        cout << endl << "Directional IV Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+
+    // Reflect the third message back as its reply
+    if (!thirdMessage()) {
+        cout << endl << "Directional IV Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    ifstream inputStream(THIRD_MESSAGE_FILE_NAME, ios::in | ios::binary);
+    ofstream outputStream(THIRD_MESSAGE_REPLY_FILE_NAME, ios::out | ios::binary);
+    outputStream << inputStream.rdbuf();
+    inputStream.close();
+    outputStream.close();
+    if (decryptThirdMessageReply()) {
+        cout << endl << "Directional IV Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    cout << endl << "Directional IV Test Passed!" << endl << endl;
+    return true;
+}
+
 //~Main Runner Function-----------------------------------------------------------------------------
 /**
  * Run tests.
@@ -390,9 +498,19 @@ int main(int argc, char *argv[]) {
                 testOtherWayCorruption();
                 return 0;
             }
+            case 5:
+            {
+                testInMemory();
+                return 0;
+            }
+            case 6:
+            {
+                testDirectionalIv();
+                return 0;
+            }
             default:
             {
-                cout << "Tests are numbered 1-4, please re-enter your input and try again." 
+                cout << "Tests are numbered 1-6, please re-enter your input and try again." 
                         << endl;
                 return 0;
             }
@@ -412,6 +530,12 @@ int main(int argc, char *argv[]) {
     if (!testOtherWayCorruption()) {
         return 1;
     }
+    if (!testInMemory()) {
+        return 1;
+    }
+    if (!testDirectionalIv()) {
+        return 1;
+    }
     cout << endl << endl << "ALL TESTS PASSED!!!!!" << endl;
     return 0;
 }
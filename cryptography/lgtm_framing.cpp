@@ -0,0 +1,242 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "lgtm_framing.hpp"
+
+#include <algorithm>
+
+//~Function Headers---------------------------------------------------------------------------------
+static void openInput(ifstream &inputStream, const string &fileName);
+static void openOutput(ofstream &outputStream, const string &fileName);
+static uint64_t getFileSize(ifstream &inputStream);
+static void seekTo(ifstream &inputStream, uint64_t offset);
+static void copyBytes(ifstream &inputStream, ofstream &outputStream, uint64_t count);
+static bool matchesAt(ifstream &inputStream, uint64_t offset, const string &marker);
+static bool searchMarker(ifstream &inputStream, uint64_t start, const string &marker, 
+        uint64_t &offset);
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Writes header, then the contents of inputFileName, then footer to outputFileName. Either 
+ * marker may be empty.
+ */
+void frameFile(const string &inputFileName, const string &outputFileName, 
+        const string &header, const string &footer) {
+    ifstream inputStream;
+    openInput(inputStream, inputFileName);
+    ofstream outputStream;
+    openOutput(outputStream, outputFileName);
+    outputStream.write(header.data(), header.size());
+    copyBytes(inputStream, outputStream, getFileSize(inputStream));
+    outputStream.write(footer.data(), footer.size());
+    if (!outputStream) {
+        throw runtime_error("Error in frameFile, could not write outputFileName: " 
+                + outputFileName);
+    }
+}
+
+/**
+ * Writes what is between header and footer in inputFileName to outputFileName. The header 
+ * must start the file. The footer is looked for at the very end first, where the scripts put
+ * it, so finding it takes one read; otherwise the first footer after the header ends the 
+ * payload, as with anything trailing it from reassembly. Returns false if either is missing.
+ */
+bool stripFrame(const string &inputFileName, const string &outputFileName, 
+        const string &header, const string &footer) {
+    ifstream inputStream;
+    openInput(inputStream, inputFileName);
+    uint64_t fileSize = getFileSize(inputStream);
+    if (fileSize < header.size() + footer.size() || !matchesAt(inputStream, 0, header)) {
+        return false;
+    }
+    uint64_t payloadEnd = fileSize - footer.size();
+    if (!matchesAt(inputStream, payloadEnd, footer) 
+            && !searchMarker(inputStream, header.size(), footer, payloadEnd)) {
+        return false;
+    }
+    ofstream outputStream;
+    openOutput(outputStream, outputFileName);
+    seekTo(inputStream, header.size());
+    copyBytes(inputStream, outputStream, payloadEnd - header.size());
+    return true;
+}
+
+/**
+ * Finds the byte offset of the first marker in fileName, reading it in large blocks. Returns 
+ * false if there is none.
+ */
+bool findMarker(const string &fileName, const string &marker, uint64_t &offset) {
+    ifstream inputStream;
+    openInput(inputStream, fileName);
+    return searchMarker(inputStream, 0, marker, offset);
+}
+
+/**
+ * Writes the contents of inputFileName to outputFileName as an envelope: its length, itself 
+ * and footer. The length locates the footer without searching, and the footer still ends the
+ * message for receivers that look for it.
+ */
+void writeEnvelope(const string &inputFileName, const string &outputFileName, 
+        const string &footer) {
+    ifstream inputStream;
+    openInput(inputStream, inputFileName);
+    uint64_t payloadSize = getFileSize(inputStream);
+    ofstream outputStream;
+    openOutput(outputStream, outputFileName);
+    char length[ENVELOPE_LENGTH_SIZE];
+    for (unsigned int i = 0; i < ENVELOPE_LENGTH_SIZE; i++) {
+        length[i] = (char) (payloadSize >> (8 * (ENVELOPE_LENGTH_SIZE - 1 - i)));
+    }
+    outputStream.write(length, ENVELOPE_LENGTH_SIZE);
+    copyBytes(inputStream, outputStream, payloadSize);
+    outputStream.write(footer.data(), footer.size());
+    if (!outputStream) {
+        throw runtime_error("Error in writeEnvelope, could not write outputFileName: " 
+                + outputFileName);
+    }
+}
+
+/**
+ * Writes the payload of the envelope in inputFileName to outputFileName. Returns false if the
+ * envelope was cut short or the footer is not where its length says, e.g. when frames were 
+ * lost. Anything after the footer is ignored.
+ */
+bool readEnvelope(const string &inputFileName, const string &outputFileName, 
+        const string &footer) {
+    ifstream inputStream;
+    openInput(inputStream, inputFileName);
+    uint64_t fileSize = getFileSize(inputStream);
+    if (fileSize < ENVELOPE_LENGTH_SIZE + footer.size()) {
+        return false;
+    }
+    unsigned char length[ENVELOPE_LENGTH_SIZE];
+    inputStream.read((char*) length, ENVELOPE_LENGTH_SIZE);
+    uint64_t payloadSize = 0;
+    for (unsigned int i = 0; i < ENVELOPE_LENGTH_SIZE; i++) {
+        payloadSize = (payloadSize << 8) | length[i];
+    }
+    if (payloadSize > fileSize - ENVELOPE_LENGTH_SIZE - footer.size() 
+            || !matchesAt(inputStream, ENVELOPE_LENGTH_SIZE + payloadSize, footer)) {
+        return false;
+    }
+    ofstream outputStream;
+    openOutput(outputStream, outputFileName);
+    seekTo(inputStream, ENVELOPE_LENGTH_SIZE);
+    copyBytes(inputStream, outputStream, payloadSize);
+    return true;
+}
+
+static void openInput(ifstream &inputStream, const string &fileName) {
+    inputStream.open(fileName, ios::in | ios::binary);
+    if (!inputStream.is_open()) {
+        throw runtime_error("Error in lgtm_framing, could not open input file: " + fileName);
+    }
+}
+
+static void openOutput(ofstream &outputStream, const string &fileName) {
+    outputStream.open(fileName, ios::out | ios::binary | ios::trunc);
+    if (!outputStream.is_open()) {
+        throw runtime_error("Error in lgtm_framing, could not open output file: " + fileName);
+    }
+}
+
+/**
+ * Size of the input, leaving it positioned at the start.
+ */
+static uint64_t getFileSize(ifstream &inputStream) {
+    inputStream.seekg(0, inputStream.end);
+    uint64_t fileSize = inputStream.tellg();
+    inputStream.seekg(0, inputStream.beg);
+    return fileSize;
+}
+
+/**
+ * Seeks even after an earlier read ran into the end of the input.
+ */
+static void seekTo(ifstream &inputStream, uint64_t offset) {
+    inputStream.clear();
+    inputStream.seekg(offset);
+}
+
+/**
+ * Copies count bytes from the current input position, FRAMING_BLOCK_SIZE at a time.
+ */
+static void copyBytes(ifstream &inputStream, ofstream &outputStream, uint64_t count) {
+    vector<char> buffer(FRAMING_BLOCK_SIZE);
+    while (count > 0) {
+        size_t blockSize = (size_t) std::min<uint64_t>(count, buffer.size());
+        inputStream.read(buffer.data(), blockSize);
+        if ((size_t) inputStream.gcount() != blockSize) {
+            throw runtime_error("Error in lgtm_framing, input ended early");
+        }
+        outputStream.write(buffer.data(), blockSize);
+        if (!outputStream) {
+            throw runtime_error("Error in lgtm_framing, could not write output");
+        }
+        count -= blockSize;
+    }
+}
+
+static bool matchesAt(ifstream &inputStream, uint64_t offset, const string &marker) {
+    seekTo(inputStream, offset);
+    string found(marker.size(), '\0');
+    inputStream.read(&found[0], marker.size());
+    return (size_t) inputStream.gcount() == marker.size() && found == marker;
+}
+
+/**
+ * Finds the first marker at or after start, reading FRAMING_BLOCK_SIZE at a time and keeping
+ * the end of each block so markers split across blocks are found too.
+ */
+static bool searchMarker(ifstream &inputStream, uint64_t start, const string &marker, 
+        uint64_t &offset) {
+    if (marker.empty()) {
+        offset = start;
+        return true;
+    }
+    seekTo(inputStream, start);
+    size_t carry = marker.size() - 1;
+    vector<char> buffer(carry + FRAMING_BLOCK_SIZE);
+    // Offset in the file of buffer[0]
+    uint64_t bufferOffset = start;
+    size_t buffered = 0;
+    for (;;) {
+        inputStream.read(buffer.data() + buffered, FRAMING_BLOCK_SIZE);
+        size_t readBytes = inputStream.gcount();
+        if (readBytes == 0) {
+            return false;
+        }
+        buffered += readBytes;
+        vector<char>::iterator found = std::search(buffer.begin(), 
+                buffer.begin() + buffered, marker.begin(), marker.end());
+        if (found != buffer.begin() + buffered) {
+            offset = bufferOffset + (found - buffer.begin());
+            return true;
+        }
+        // Keep the tail that could start a marker
+        size_t kept = std::min(carry, buffered);
+        std::copy(buffer.begin() + buffered - kept, buffer.begin() + buffered, buffer.begin());
+        bufferOffset += buffered - kept;
+        buffered = kept;
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LGTM_FRAMING_HPP_
+#define LGTM_FRAMING_HPP_
+
+#include <cstdint>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using std::ifstream;
+using std::ios;
+using std::ofstream;
+using std::runtime_error;
+using std::string;
+using std::vector;
+
+//~Constants----------------------------------------------------------------------------------------
+// Bytes moved per read and write, in place of dd's one byte blocks
+static const unsigned int FRAMING_BLOCK_SIZE = 1 << 16;
+// Bytes of the big-endian payload length that starts an envelope
+static const unsigned int ENVELOPE_LENGTH_SIZE = 8;
+
+//~Function Headers---------------------------------------------------------------------------------
+// Messages framed by marker strings, as sent by the protocol scripts
+void frameFile(const string &inputFileName, const string &outputFileName, 
+        const string &header, const string &footer);
+bool stripFrame(const string &inputFileName, const string &outputFileName, 
+        const string &header, const string &footer);
+bool findMarker(const string &fileName, const string &marker, uint64_t &offset);
+// Length-prefixed envelopes: <8 byte big-endian length><payload><footer>
+void writeEnvelope(const string &inputFileName, const string &outputFileName, 
+        const string &footer);
+bool readEnvelope(const string &inputFileName, const string &outputFileName, 
+        const string &footer);
+#endif
@@ -0,0 +1,110 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+// g++ -std=c++11 -O2 lgtm_framing.cpp lgtm_framing_runner.cpp -o lgtm_framing
+
+#include "lgtm_framing.hpp"
+
+#include <cstring>
+#include <iostream>
+
+using std::cerr;
+using std::cout;
+using std::endl;
+
+//~Function Headers---------------------------------------------------------------------------------
+static void printUsage(const char *program);
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Adds and strips the markers of protocol messages in large blocks, in place of dd bs=1, and 
+ * finds markers in place of grep.
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string command = argv[1];
+    string inputFileName = argv[2];
+    string outputFileName = argv[3];
+    string header;
+    string footer;
+    for (int i = 4; i < argc; i++) {
+        if (strncmp(argv[i], "--header=", 9) == 0) {
+            header = argv[i] + 9;
+        } else if (strncmp(argv[i], "--footer=", 9) == 0) {
+            footer = argv[i] + 9;
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        if (command == "frame") {
+            frameFile(inputFileName, outputFileName, header, footer);
+        } else if (command == "strip") {
+            if (!stripFrame(inputFileName, outputFileName, header, footer)) {
+                cerr << "No frame marked by the header and footer in " << inputFileName << endl;
+                return 1;
+            }
+        } else if (command == "find") {
+            // The marker takes the place of the output file
+            uint64_t offset;
+            if (!findMarker(inputFileName, outputFileName, offset)) {
+                return 1;
+            }
+            cout << offset << endl;
+        } else if (command == "wrap") {
+            writeEnvelope(inputFileName, outputFileName, footer);
+        } else if (command == "unwrap") {
+            if (!readEnvelope(inputFileName, outputFileName, footer)) {
+                cerr << "Incomplete or corrupt envelope in " << inputFileName << endl;
+                return 1;
+            }
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    } catch (const runtime_error &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
+
+static void printUsage(const char *program) {
+    cout << "usage: " << program << " <command> <input> <output> [--header=<marker>]" 
+            << " [--footer=<marker>]" << endl;
+    cout << "\t frame -- Write header, input and footer to output." << endl;
+    cout << "\t strip -- Write what is between header and footer in input to output, failing" 
+            << " if either is missing." << endl;
+    cout << "\t find <input> <marker> -- Print the byte offset of the first marker in input," 
+            << " failing if there is none." << endl;
+    cout << "\t wrap -- Write input to output as a length-prefixed envelope ending in footer." 
+            << endl;
+    cout << "\t unwrap -- Write the payload of the envelope in input to output, failing if it" 
+            << " is incomplete." << endl;
+    cout << "\t Output is truncated first, so it must not be the input." << endl;
+}
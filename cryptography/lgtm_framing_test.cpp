@@ -0,0 +1,193 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+// g++ -std=c++11 -g3 -ggdb -O0 -Wall lgtm_framing.cpp lgtm_framing_test.cpp -o lgtm_framing_test
+
+#include "lgtm_framing.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+
+using std::cout;
+using std::endl;
+
+//~Global variables---------------------------------------------------------------------------------
+static const string TEST_PAYLOAD_FILE_NAME = ".lgtm-test-framing-payload";
+static const string TEST_FRAMED_FILE_NAME = ".lgtm-test-framing-framed";
+static const string TEST_STRIPPED_FILE_NAME = ".lgtm-test-framing-stripped";
+
+static const string FACIAL_RECOGNITION_HEADER = "facial-recognition-params";
+static const string THIRD_MESSAGE_FOOTER = "lgtm-third-message-footer";
+
+// Spans several blocks and ends partway through one
+static const unsigned int TEST_PAYLOAD_SIZE = 3 * FRAMING_BLOCK_SIZE + 1234;
+
+//~Functions----------------------------------------------------------------------------------------
+static vector<char> readTestFile(const string &fileName) {
+    ifstream inputStream(fileName, ios::in | ios::binary);
+    return vector<char>((std::istreambuf_iterator<char>(inputStream)), 
+            std::istreambuf_iterator<char>());
+}
+
+static void writeTestFile(const string &fileName, const vector<char> &contents) {
+    ofstream outputStream(fileName, ios::out | ios::binary);
+    outputStream.write(contents.data(), contents.size());
+}
+
+static vector<char> makePayload() {
+    vector<char> payload(TEST_PAYLOAD_SIZE);
+    srand(98);
+    for (unsigned int i = 0; i < payload.size(); i++) {
+        payload[i] = (char) rand();
+    }
+    return payload;
+}
+
+bool testFrameAndStrip() {
+    cout << endl << "testFrameAndStrip: " << endl;
+    vector<char> payload = makePayload();
+    writeTestFile(TEST_PAYLOAD_FILE_NAME, payload);
+    frameFile(TEST_PAYLOAD_FILE_NAME, TEST_FRAMED_FILE_NAME, FACIAL_RECOGNITION_HEADER, 
+            THIRD_MESSAGE_FOOTER);
+    vector<char> framed = readTestFile(TEST_FRAMED_FILE_NAME);
+    string expected = FACIAL_RECOGNITION_HEADER + string(payload.begin(), payload.end()) 
+            + THIRD_MESSAGE_FOOTER;
+    if (string(framed.begin(), framed.end()) != expected) {
+        cout << endl << "Frame Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    // Footer at the end
+    if (!stripFrame(TEST_FRAMED_FILE_NAME, TEST_STRIPPED_FILE_NAME, FACIAL_RECOGNITION_HEADER, 
+            THIRD_MESSAGE_FOOTER) || readTestFile(TEST_STRIPPED_FILE_NAME) != payload) {
+        cout << endl << "Strip Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    // Footer followed by padding, as left by reassembly
+    framed.insert(framed.end(), 100, '\0');
+    writeTestFile(TEST_FRAMED_FILE_NAME, framed);
+    if (!stripFrame(TEST_FRAMED_FILE_NAME, TEST_STRIPPED_FILE_NAME, FACIAL_RECOGNITION_HEADER, 
+            THIRD_MESSAGE_FOOTER) || readTestFile(TEST_STRIPPED_FILE_NAME) != payload) {
+        cout << endl << "Strip Padded Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    // Footer missing
+    framed.resize(framed.size() - 100 - 1);
+    writeTestFile(TEST_FRAMED_FILE_NAME, framed);
+    if (stripFrame(TEST_FRAMED_FILE_NAME, TEST_STRIPPED_FILE_NAME, FACIAL_RECOGNITION_HEADER, 
+            THIRD_MESSAGE_FOOTER)) {
+        cout << endl << "Strip Missing Footer Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    cout << endl << "Frame And Strip Test PASSED!!!!" << endl << endl;
+    return true;
+}
+
+bool testFindMarker() {
+    cout << endl << "testFindMarker: " << endl;
+    vector<char> contents(2 * FRAMING_BLOCK_SIZE, 'x');
+    // Split across the first two blocks
+    uint64_t markerOffset = FRAMING_BLOCK_SIZE - 5;
+    std::copy(THIRD_MESSAGE_FOOTER.begin(), THIRD_MESSAGE_FOOTER.end(), 
+            contents.begin() + markerOffset);
+    writeTestFile(TEST_FRAMED_FILE_NAME, contents);
+    uint64_t offset;
+    if (!findMarker(TEST_FRAMED_FILE_NAME, THIRD_MESSAGE_FOOTER, offset) 
+            || offset != markerOffset) {
+        cout << endl << "Find Marker Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    if (findMarker(TEST_FRAMED_FILE_NAME, FACIAL_RECOGNITION_HEADER, offset)) {
+        cout << endl << "Find Missing Marker Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    cout << endl << "Find Marker Test PASSED!!!!" << endl << endl;
+    return true;
+}
+
+bool testEnvelope() {
+    cout << endl << "testEnvelope: " << endl;
+    vector<char> payload = makePayload();
+    writeTestFile(TEST_PAYLOAD_FILE_NAME, payload);
+    writeEnvelope(TEST_PAYLOAD_FILE_NAME, TEST_FRAMED_FILE_NAME, THIRD_MESSAGE_FOOTER);
+    vector<char> envelope = readTestFile(TEST_FRAMED_FILE_NAME);
+    if (envelope.size() != ENVELOPE_LENGTH_SIZE + payload.size() + THIRD_MESSAGE_FOOTER.size()
+            || !readEnvelope(TEST_FRAMED_FILE_NAME, TEST_STRIPPED_FILE_NAME, 
+                    THIRD_MESSAGE_FOOTER) 
+            || readTestFile(TEST_STRIPPED_FILE_NAME) != payload) {
+        cout << endl << "Envelope Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    // A lost frame moves the footer
+    envelope.erase(envelope.begin() + 1000, envelope.begin() + 1100);
+    writeTestFile(TEST_FRAMED_FILE_NAME, envelope);
+    if (readEnvelope(TEST_FRAMED_FILE_NAME, TEST_STRIPPED_FILE_NAME, THIRD_MESSAGE_FOOTER)) {
+        cout << endl << "Envelope Lost Frame Test FAILED!!!!" << endl << endl;
+        return false;
+    }
+    cout << endl << "Envelope Test PASSED!!!!" << endl << endl;
+    return true;
+}
+
+int main(int argc, char *argv[]) {
+
+    // Run a specific test
+    if (argc > 1) {
+        int testNumber = atoi(argv[1]);
+        switch(testNumber) {
+            case 1:
+            {
+                testFrameAndStrip();
+                return 0;
+            }
+            case 2:
+            {
+                testFindMarker();
+                return 0;
+            }
+            case 3:
+            {
+                testEnvelope();
+                return 0;
+            }
+            default:
+            {
+                cout << "Tests are numbered 1-3, please re-enter your input and try again." 
+                        << endl;
+                return 0;
+            }
+        }
+    }
+
+    // Run all tests
+    if (!testFrameAndStrip()) {
+        return 1;
+    }
+    if (!testFindMarker()) {
+        return 1;
+    }
+    if (!testEnvelope()) {
+        return 1;
+    }
+    return 0;
+}
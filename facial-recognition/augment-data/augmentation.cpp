@@ -0,0 +1,183 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "augmentation.hpp"
+
+#include <cmath>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Rotations run from -ROTATION_LIMIT to ROTATION_LIMIT degrees on each axis in ROTATION_STEP
+// steps. Empirical ranges: x-axis [-12.5, 12.5], y-axis [-10, 10], z-axis [0, 360).
+static const int ROTATION_LIMIT = 5;
+static const int ROTATION_STEP = 5;
+static const double CAMERA_DISTANCE = 200;
+static const double FOCAL_DISTANCE = 200;
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Lists every combination of x, y, and z rotations, z outermost and y innermost.
+ */
+AugmentationTransforms::AugmentationTransforms() {
+    for (int z = -ROTATION_LIMIT; z <= ROTATION_LIMIT; z += ROTATION_STEP) {
+        for (int x = -ROTATION_LIMIT; x <= ROTATION_LIMIT; x += ROTATION_STEP) {
+            for (int y = -ROTATION_LIMIT; y <= ROTATION_LIMIT; y += ROTATION_STEP) {
+                Rotation rotation = {x, y, z};
+                rotations.push_back(rotation);
+            }
+        }
+    }
+}
+
+const vector<Rotation> &AugmentationTransforms::getRotations() const {
+    return rotations;
+}
+
+/**
+ * The warp matrix of every rotation, in getRotations order, for images of the given size.
+ * If outputSize is not empty the matrices also scale the rotated image to outputSize.
+ */
+const vector<Mat> &AugmentationTransforms::getMatrices(const Size &size, const Size &outputSize) {
+    lock_guard<std::mutex> lock(matricesMutex);
+    SizeKey key = make_pair(make_pair(size.width, size.height), 
+            make_pair(outputSize.width, outputSize.height));
+    vector<Mat> &matrices = matricesBySize[key];
+    if (matrices.empty()) {
+        for (unsigned int i = 0; i < rotations.size(); i++) {
+            Mat matrix = computeRotationMatrix(size, rotations[i].x, rotations[i].y, 
+                    rotations[i].z, 0, 0, CAMERA_DISTANCE, FOCAL_DISTANCE);
+            if (outputSize.area() > 0) {
+                matrix = composeCropTransform(matrix, Rect(Point(0, 0), size), outputSize);
+            }
+            matrices.push_back(matrix);
+        }
+    }
+    return matrices;
+}
+
+/**
+ * Builds the perspective matrix that rotates an image of the given size by alpha, beta, and
+ * gamma degrees around the x, y, and z axes, moves it by (dx, dy, dz), and projects it back
+ * onto the image plane with focal distance f.
+ */
+Mat computeRotationMatrix(const Size &size, double alpha, double beta, double gamma, 
+        double dx, double dy, double dz, double f) {
+    alpha = alpha * CV_PI / 180.;
+    beta = beta * CV_PI / 180.;
+    gamma = gamma * CV_PI / 180.;
+    // get width and height for ease of use in matrices
+    double w = (double) size.width;
+    double h = (double) size.height;
+    // Projection 2D -> 3D matrix
+    Mat A1 = (Mat_<double>(4,3) <<
+              1, 0, -w/2,
+              0, 1, -h/2,
+              0, 0,    0,
+              0, 0,    1);
+    // Rotation matrices around the X, Y, and Z axis
+    Mat RX = (Mat_<double>(4, 4) <<
+              1,          0,           0, 0,
+              0, cos(alpha), -sin(alpha), 0,
+              0, sin(alpha),  cos(alpha), 0,
+              0,          0,           0, 1);
+    Mat RY = (Mat_<double>(4, 4) <<
+              cos(beta), 0, -sin(beta), 0,
+              0, 1,          0, 0,
+              sin(beta), 0,  cos(beta), 0,
+              0, 0,          0, 1);
+    Mat RZ = (Mat_<double>(4, 4) <<
+              cos(gamma), -sin(gamma), 0, 0,
+              sin(gamma),  cos(gamma), 0, 0,
+              0,          0,           1, 0,
+              0,          0,           0, 1);
+    // Composed rotation matrix with (RX, RY, RZ)
+    Mat R = RX * RY * RZ;
+    // Translation matrix
+    Mat T = (Mat_<double>(4, 4) <<
+             1, 0, 0, dx,
+             0, 1, 0, dy,
+             0, 0, 1, dz,
+             0, 0, 0, 1);
+    // 3D -> 2D matrix
+    Mat A2 = (Mat_<double>(3,4) <<
+              f, 0, w / 2, 0,
+              0, f, h / 2, 0,
+              0, 0,   1,   0);
+    // Final transformation matrix
+    return A2 * (T * (R * A1));
+}
+
+/**
+ * Folds cropping the warped image to crop and scaling the crop to outputSize into transform,
+ * so a single warpPerspective goes straight from the source image to a training sample.
+ */
+Mat composeCropTransform(const Mat &transform, const Rect &crop, const Size &outputSize) {
+    double scaleX = (double) outputSize.width / crop.width;
+    double scaleY = (double) outputSize.height / crop.height;
+    Mat cropAndScale = (Mat_<double>(3, 3) <<
+            scaleX,      0, -crop.x * scaleX,
+                 0, scaleY, -crop.y * scaleY,
+                 0,      0,                1);
+    return cropAndScale * transform;
+}
+
+/**
+ * Warps input with one of the precomputed matrices into output, which is outputSize if given
+ * (for matrices from composeCropTransform) and input's size otherwise. Grayscale input is 
+ * warped a third as much data as colour, and INTER_LINEAR or INTER_CUBIC are several times 
+ * cheaper than the default INTER_LANCZOS4.
+ */
+void applyAugmentation(const Mat &input, Mat &output, const Mat &transform, int interpolation,
+        const Size &outputSize) {
+    warpPerspective(input, output, transform, outputSize.area() > 0 ? outputSize : input.size(),
+            interpolation);
+}
+
+/**
+ * The OpenCV interpolation flag for "nearest", "linear", "cubic", or "lanczos", or -1.
+ */
+int parseInterpolation(const string &name) {
+    if (name == "nearest") {
+        return INTER_NEAREST;
+    } else if (name == "linear") {
+        return INTER_LINEAR;
+    } else if (name == "cubic") {
+        return INTER_CUBIC;
+    } else if (name == "lanczos") {
+        return INTER_LANCZOS4;
+    }
+    return -1;
+}
+
+/**
+ * The file an augmented copy of the image at path is saved to, next to the original.
+ */
+string getAugmentedFileName(const string &path, const Rotation &rotation) {
+    return path.substr(0, path.size() - 4) 
+            + "--rotated--z-" + std::to_string(rotation.z) 
+            + "--y-" + std::to_string(rotation.y) 
+            + "--x-" + std::to_string(rotation.x) 
+            + "--" + path.substr(path.size() - 4, path.size());
+}
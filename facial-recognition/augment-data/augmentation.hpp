@@ -0,0 +1,77 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef AUGMENTATION_HPP_
+#define AUGMENTATION_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * One synthetic head rotation, in degrees around each axis.
+ */
+struct Rotation {
+    int x;
+    int y;
+    int z;
+};
+
+/**
+ * The rotations applied to every training image and their perspective warp matrices.
+ *
+ * The matrices only depend on the image size (and the output size, when the warp also scales
+ * straight to the training size), so they are computed once per size and shared by every 
+ * image of that size. Safe to use from several threads.
+ */
+class AugmentationTransforms {
+public:
+    AugmentationTransforms();
+
+    const std::vector<Rotation> &getRotations() const;
+    const std::vector<cv::Mat> &getMatrices(const cv::Size &size, 
+            const cv::Size &outputSize = cv::Size());
+
+private:
+    typedef std::pair<std::pair<int, int>, std::pair<int, int> > SizeKey;
+
+    std::vector<Rotation> rotations;
+    std::map<SizeKey, std::vector<cv::Mat> > matricesBySize;
+    std::mutex matricesMutex;
+};
+
+cv::Mat computeRotationMatrix(const cv::Size &size, double alpha, double beta, double gamma, 
+        double dx, double dy, double dz, double f);
+cv::Mat composeCropTransform(const cv::Mat &transform, const cv::Rect &crop, 
+        const cv::Size &outputSize);
+void applyAugmentation(const cv::Mat &input, cv::Mat &output, const cv::Mat &transform, 
+        int interpolation = cv::INTER_LANCZOS4, const cv::Size &outputSize = cv::Size());
+int parseInterpolation(const std::string &name);
+std::string getAugmentedFileName(const std::string &path, const Rotation &rotation);
+
+#endif
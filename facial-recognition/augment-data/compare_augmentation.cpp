@@ -0,0 +1,345 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Compares the augmentation paths on speed and on the recognition accuracy of the model they
+ * train.
+ *
+ * For each path the training images are augmented in memory, an LBPH model with 
+ * train_classifier's parameters is trained on the originals plus their rotations, and every
+ * image of the test set is predicted. The legacy path (colour, lanczos, converted to grayscale
+ * afterwards as train_classifier's imread did) is the baseline for the reported speedup.
+ *
+ * The training and test sets are csv files of path;label lines or directories of subjectNN.* 
+ * images, by default the bundled yalefaces--eyewear sets. Test images that are not 
+ * training-sized are cropped to their largest face first, as cross_validate does.
+ *
+ * Usage: compare_augmentation [training csv or directory] [test csv or directory] [cascade]
+ */
+#include "augmentation.hpp"
+#include "../face-detect/face_detect.hpp"
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const char separator = ';';
+// The size the recognizers are trained at
+static const int trainingSide = 168;
+static const char *defaultTrainPath = "../data/yalefaces--eyewear";
+static const char *defaultTestPath = "../data/yalefaces--eyewear-test-set";
+static const char *defaultCascadeFileName 
+        = "../face-detect/haarcascades/haarcascade_frontalface_default.xml";
+
+/**
+ * One way of producing augmented training samples.
+ */
+struct AugmentationPath {
+    const char *name;
+    bool grayscale;
+    int interpolation;
+    bool fusedResize;
+};
+
+static const AugmentationPath PATHS[] = {
+    {"colour+lanczos (legacy)", false, INTER_LANCZOS4, false},
+    {"gray+lanczos", true, INTER_LANCZOS4, false},
+    {"gray+cubic", true, INTER_CUBIC, false},
+    {"gray+linear", true, INTER_LINEAR, false},
+    {"gray+linear+fused 168", true, INTER_LINEAR, true},
+};
+
+//~Function Headers---------------------------------------------------------------------------------
+static void readImageList(const string &path, vector<string> &paths, vector<int> &labels);
+static void readCsv(const string &fileName, vector<string> &paths, vector<int> &labels);
+static void listImages(const string &directory, vector<string> &paths);
+static int parseSubjectLabel(const string &path);
+static bool cropToFace(const Mat &image, CascadeClassifier &cascade, Mat &face);
+static double augment(const AugmentationPath &path, const vector<string> &paths, 
+        const vector<int> &labels, AugmentationTransforms &transforms, vector<Mat> &samples, 
+        vector<int> &sampleLabels);
+static double evaluate(const AugmentationPath &path, const vector<Mat> &samples, 
+        const vector<int> &sampleLabels, const vector<Mat> &testImages, 
+        const vector<int> &testLabels);
+
+//~Functions----------------------------------------------------------------------------------------
+int main(int argc, const char *argv[]) {
+    if (argc > 4) {
+        cout << "usage: " << argv[0] << " [training csv or directory, default " 
+                << defaultTrainPath << "] [test csv or directory, default " << defaultTestPath
+                << "] [cascade, default " << defaultCascadeFileName << "]" << endl;
+        return 1;
+    }
+    vector<string> trainPaths, testPaths;
+    vector<int> trainLabels, testLabels;
+    try {
+        readImageList(argc > 1 ? argv[1] : defaultTrainPath, trainPaths, trainLabels);
+        readImageList(argc > 2 ? argv[2] : defaultTestPath, testPaths, testLabels);
+    } catch (cv::Exception &e) {
+        cerr << "Error opening csv file. Reason: " << e.msg << endl;
+        return 1;
+    }
+    if (trainPaths.empty() || testPaths.empty()) {
+        cerr << "No training or test images found" << endl;
+        return 1;
+    }
+    CascadeClassifier cascade;
+    cascade.load(argc > 3 ? argv[3] : defaultCascadeFileName);
+    vector<Mat> testImages;
+    for (unsigned int i = 0; i < testPaths.size(); i++) {
+        Mat image = imread(testPaths[i], IMREAD_GRAYSCALE);
+        Mat face;
+        if (!image.empty() && !cropToFace(image, cascade, face)) {
+            printf("No face found in %s, skipping it\n", testPaths[i].c_str());
+        }
+        testImages.push_back(face);
+    }
+
+    AugmentationTransforms transforms;
+    cout << trainPaths.size() << " training images x " << transforms.getRotations().size() 
+            << " rotations, " << testPaths.size() << " test images, " 
+            << WorkerPool::shared().getThreadCount() << " threads" << endl;
+    printf("%-26s %12s %9s %10s\n", "path", "augment s", "speedup", "accuracy");
+    double baselineSeconds = 0.0;
+    vector<Mat> samples;
+    vector<int> sampleLabels;
+    for (unsigned int i = 0; i < sizeof(PATHS) / sizeof(PATHS[0]); i++) {
+        double seconds = augment(PATHS[i], trainPaths, trainLabels, transforms, samples, 
+                sampleLabels);
+        if (i == 0) {
+            baselineSeconds = seconds;
+        }
+        double accuracy = evaluate(PATHS[i], samples, sampleLabels, testImages, testLabels);
+        printf("%-26s %12.3f %8.2fx %9.1f%%\n", PATHS[i].name, seconds, 
+                baselineSeconds / seconds, 100.0 * accuracy);
+    }
+    return 0;
+}
+
+/**
+ * Reads the image paths and labels of a csv file, or lists every image under a directory, 
+ * labelled by the number in its subjectNN file name.
+ */
+static void readImageList(const string &path, vector<string> &paths, vector<int> &labels) {
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+        readCsv(path, paths, labels);
+        return;
+    }
+    vector<string> listed;
+    listImages(path, listed);
+    sort(listed.begin(), listed.end());
+    for (unsigned int i = 0; i < listed.size(); i++) {
+        int label = parseSubjectLabel(listed[i]);
+        if (label >= 0) {
+            paths.push_back(listed[i]);
+            labels.push_back(label);
+        }
+    }
+}
+
+/**
+ * Reads the image paths and labels of the csv file.
+ */
+static void readCsv(const string &fileName, vector<string> &paths, vector<int> &labels) {
+    std::ifstream file(fileName.c_str(), ifstream::in);
+    if (!file) {
+        string error_message = "No valid input file was given, please check the given fileName.";
+        CV_Error(CV_StsBadArg, error_message);
+    }
+    string line, path, classlabel;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        getline(liness, classlabel);
+        if (!path.empty() && !classlabel.empty()) {
+            paths.push_back(path);
+            labels.push_back(atoi(classlabel.c_str()));
+        }
+    }
+}
+
+/**
+ * Decodes every training image and generates its rotations the given way, timing both.
+ * Samples are grayscale and come out at the training size only on the fused path, the others
+ * keep the source size, which LBPH handles as is.
+ */
+static double augment(const AugmentationPath &path, const vector<string> &paths, 
+        const vector<int> &labels, AugmentationTransforms &transforms, vector<Mat> &samples, 
+        vector<int> &sampleLabels) {
+    int numVariants = transforms.getRotations().size() + 1;
+    Size outputSize = path.fusedResize ? Size(trainingSide, trainingSide) : Size();
+    samples.assign(paths.size() * numVariants, Mat());
+    sampleLabels.resize(samples.size());
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    WorkerPool::shared().run(paths.size(), [&](int i) {
+        Mat source = imread(paths[i], path.grayscale ? IMREAD_GRAYSCALE : IMREAD_COLOR);
+        if (source.empty()) {
+            return;
+        }
+        const vector<Mat> &matrices = transforms.getMatrices(source.size(), outputSize);
+        Mat warped;
+        for (int v = 0; v < numVariants; v++) {
+            Mat &sample = samples[i * numVariants + v];
+            sampleLabels[i * numVariants + v] = labels[i];
+            const Mat *variant = &source;
+            if (v > 0) {
+                applyAugmentation(source, warped, matrices[v - 1], path.interpolation, 
+                        outputSize);
+                variant = &warped;
+            } else if (path.fusedResize) {
+                resize(source, warped, outputSize, 0, 0, INTER_AREA);
+                variant = &warped;
+            }
+            if (path.grayscale) {
+                variant->copyTo(sample);
+            } else {
+                cvtColor(*variant, sample, CV_BGR2GRAY);
+            }
+        }
+    });
+    chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+    return seconds.count();
+}
+
+/**
+ * Trains LBPH on the samples and returns the share of the test images it labels correctly.
+ */
+static double evaluate(const AugmentationPath &path, const vector<Mat> &samples, 
+        const vector<int> &sampleLabels, const vector<Mat> &testImages, 
+        const vector<int> &testLabels) {
+    vector<Mat> trainSamples;
+    vector<int> trainLabels;
+    for (unsigned int i = 0; i < samples.size(); i++) {
+        if (!samples[i].empty()) {
+            trainSamples.push_back(samples[i]);
+            trainLabels.push_back(sampleLabels[i]);
+        }
+    }
+    Ptr<face::FaceRecognizer> model = face::createLBPHFaceRecognizer(10, 8, 4, 4);
+    model->train(trainSamples, trainLabels);
+
+    int correct = 0;
+    int tested = 0;
+    Mat testImage;
+    for (unsigned int i = 0; i < testImages.size(); i++) {
+        if (testImages[i].empty()) {
+            continue;
+        }
+        testImage = testImages[i];
+        if (path.fusedResize) {
+            resize(testImages[i], testImage, Size(trainingSide, trainingSide), 0, 0, INTER_AREA);
+        }
+        if (model->predict(testImage) == testLabels[i]) {
+            correct++;
+        }
+        tested++;
+    }
+    return tested == 0 ? 0.0 : (double) correct / tested;
+}
+
+/**
+ * Adds the path of every .jpg, .png, .pgm and .gif file under directory to paths.
+ */
+static void listImages(const string &directory, vector<string> &paths) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        string name(entry->d_name);
+        if (name.empty() || name[0] == '.') {
+            continue;
+        }
+        string path = directory + "/" + name;
+        size_t dot = name.find_last_of('.');
+        string extension = dot == string::npos ? "" : name.substr(dot + 1);
+        if (extension == "jpg" || extension == "png" || extension == "pgm" 
+                || extension == "gif") {
+            paths.push_back(path);
+        } else if (dot == string::npos) {
+            listImages(path, paths);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * The subject number in a yalefaces file name such as subject07.happy.jpg, or -1.
+ */
+static int parseSubjectLabel(const string &path) {
+    size_t slash = path.find_last_of('/');
+    string name = slash == string::npos ? path : path.substr(slash + 1);
+    if (name.compare(0, 7, "subject") != 0) {
+        return -1;
+    }
+    return atoi(name.c_str() + 7);
+}
+
+/**
+ * Crops a grayscale image that is not training-sized to its largest face, padded to a square 
+ * on white and resized to the training size, as the preprocessing tools do.
+ */
+static bool cropToFace(const Mat &image, CascadeClassifier &cascade, Mat &face) {
+    if (image.rows == trainingSide && image.cols == trainingSide) {
+        face = image;
+        return true;
+    }
+    if (cascade.empty()) {
+        return false;
+    }
+    Mat equalized;
+    equalizeHist(image, equalized);
+    vector<Rect> faces;
+    cascade.detectMultiScale(equalized, faces, 1.1, 2, CASCADE_SCALE_IMAGE, Size(30, 30));
+    int largest = findLargestFace(faces);
+    if (largest == -1) {
+        return false;
+    }
+    Mat crop = image(faces[largest]);
+    int side = max(crop.cols, crop.rows);
+    Mat squared;
+    copyMakeBorder(crop, squared, (side - crop.rows) / 2, side - crop.rows - (side - crop.rows) / 2,
+            (side - crop.cols) / 2, side - crop.cols - (side - crop.cols) / 2, BORDER_CONSTANT, 
+            Scalar(255));
+    resize(squared, face, Size(trainingSide, trainingSide), 0, 0, 
+            side > trainingSide ? INTER_AREA : INTER_CUBIC);
+    return true;
+}
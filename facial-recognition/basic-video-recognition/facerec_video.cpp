@@ -46,15 +46,20 @@
  *   See <http://www.opensource.org/licenses/bsd-license>
  */
 
-// Switch between Local Binary Patterns Histograms(2), Eigenfaces (1), and Fisherfaces (0)
-#define FACIAL_RECOGNITION_MODEL 2
-
 #include <opencv2/core/core.hpp>
 #include <opencv2/face.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/objdetect/objdetect.hpp>
 
+#include "../camera-geometry/camera_geometry.hpp"
+#include "../face-detector/face_detector.hpp"
+#include "../frame-context/frame_context.hpp"
+#include "../frame-source/frame_source.hpp"
+#include "../recognition-cache/recognition_cache.hpp"
+#include "../recognizer-factory/recognizer_factory.hpp"
+#include "../stage-timing/stage_timing.hpp"
+
 #include <iostream>
 #include <fstream>
 #include <sstream>
@@ -67,11 +72,6 @@
 using namespace cv;
 using namespace std;
 
-// Function Headers---------------------------------------------------------------------------------
-static void drawTargettingLines(int &frameWidth, int &frameHeight, Mat &frame);
-static void findAngleBounds(int &frameWidth, int &frameHeight, Rect &faceRectangle, 
-        double &leftSideAngle, double &rightSideAngle, double &topAngle, double &bottomAngle);
-
 /**
  * Read images and labels from the csv file specified by fileName.
  */
@@ -101,26 +101,46 @@ static void readCsv(const string& fileName, vector<Mat>& images, vector<int>& la
 }
 
 int main(int argc, const char *argv[]) {
+    // Pull out the optional "--" flags for headless runs, tracing, the recognizer and face 
+    // detection first.
+    FrameSourceOptions sourceOptions;
+    vector<string> traceArguments;
+    vector<string> arguments = parseFrameSourceOptions(argc, argv, sourceOptions, 
+            &traceArguments);
+    TraceOptions traceOptions;
+    vector<string> recognizerOptions;
+    bool validOptions = parseTraceOptions(traceArguments, traceOptions, &recognizerOptions);
+    RecognizerConfig recognizerConfig;
+    vector<string> detectorOptions;
+    validOptions = parseRecognizerOptions(recognizerOptions, recognizerConfig, 
+            &detectorOptions) && validOptions;
+    FaceDetectorConfig detectorConfig;
+    validOptions = parseFaceDetectorOptions(detectorOptions, detectorConfig) && validOptions;
     // Check for valid command line arguments, print usage
     // if no arguments were given.
-    if (argc < 4) {
+    if (!validOptions || arguments.size() < 4) {
         cout << "usage: " << argv[0] 
-                << " </path/to/haarCascade> </path/to/csv.ext> </path/to/device id>" << endl;
+                << " </path/to/haarCascade> </path/to/csv.ext> <device id | video | image dir>"
+                << " [/path/to/trained/classifier] [options]" << endl;
         cout << "\t </path/to/haarCascade> -- Path to the Haar Cascade for face detection." 
                 << endl;
         cout << "\t </path/to/csv.ext> -- Path to the CSV file with the face database." << endl;
         cout << "\t <device id> -- The webcam device id to grab frames from." << endl;
+        printFrameSourceUsage();
+        printRecognizerUsage();
+        printFaceDetectorUsage();
+        printTraceUsage();
         exit(1);
     }
 
     // Get the path to your CSV:
-    string haarCascadeFileName = string(argv[1]);
-    string csvFileName = string(argv[2]);
-    int deviceId = atoi(argv[3]);
+    string haarCascadeFileName = arguments[1];
+    string csvFileName = arguments[2];
+    string sourceSpec = arguments[3];
     string trainedClassifierPath;
-    if (argc == 5) {
+    if (arguments.size() == 5) {
         cout << "Reading trainedClassifierPath from input...." << endl;
-        trainedClassifierPath = string(argv[4]);
+        trainedClassifierPath = arguments[4];
         cout << "Read trainedClassifierPath as: " << trainedClassifierPath << endl;
     }
 
@@ -142,41 +162,9 @@ int main(int argc, const char *argv[]) {
         }
     }
 
-    int imgWidth = 168;
-    int imgHeight = 168;
-
     // Create a FaceRecognizer and train it on the given images:
     Ptr<face::FaceRecognizer> model;
 
-    switch (FACIAL_RECOGNITION_MODEL) {
-        case 0:
-            {
-                cout << "Using Fisherfaces" << endl;
-                double threshold = 2200.0;
-                model = face::createFisherFaceRecognizer(/*0, threshold*/);
-            }
-            break;
-        case 1:
-            {
-                cout << "Using Eigenfaces" << endl;
-                double threshold = 7250.0;
-                model = face::createEigenFaceRecognizer(/*0, threshold*/);
-            }
-            break;
-        case 2:
-            {
-                cout << "Using Local Binary Pattern Histograms" << endl;
-                int radius = 10;
-                int neighbors = 8;
-                int gridX = 4;
-                int gridY = 4;
-                double threshold = 25.0;
-                cout << "Threshold is: " << threshold << endl;
-                model = face::createLBPHFaceRecognizer(radius, neighbors, gridX, gridY, threshold);
-            }
-            break;
-    }
-
     // Load model if a path to a pretrained model was passed
     if (trainedClassifierPath.empty())  {
         cout << "Starting training..." << endl;
@@ -184,8 +172,10 @@ int main(int argc, const char *argv[]) {
         chrono::time_point<std::chrono::system_clock> start, end;
         start = std::chrono::system_clock::now();
         
+        model = createRecognizer(recognizerConfig);
+        cout << "Using " << describeRecognizer(recognizerConfig) << endl;
         model->train(images, labels);
-        model->save("new-facial-recognition-model");
+        saveRecognizer(model, recognizerConfig, "new-facial-recognition-model");
 
         end = std::chrono::system_clock::now();
         std::chrono::duration<double> elapsed_seconds = end - start;
@@ -196,7 +186,12 @@ int main(int argc, const char *argv[]) {
         chrono::time_point<std::chrono::system_clock> start, end;
         start = std::chrono::system_clock::now();
         
-        model->load(trainedClassifierPath);
+        // Saved models name their own recognizer, older ones are loaded as the flags say
+        model = loadRecognizer(trainedClassifierPath, recognizerConfig);
+        if (model.empty()) {
+            return -1;
+        }
+        cout << "Using " << describeRecognizer(recognizerConfig) << endl;
 
         end = std::chrono::system_clock::now();
         std::chrono::duration<double> elapsed_seconds = end - start;
@@ -208,57 +203,100 @@ int main(int argc, const char *argv[]) {
     // That's it for learning the Face Recognition model. You now
     // need to create the classifier for the task of Face Detection.
     // We are going to use the haar cascade you have specified in the
-    // command line arguments:
-    CascadeClassifier haarCascade;
-    haarCascade.load(haarCascadeFileName);
+    // command line arguments, or the LBP cascade if one was given:
+    FaceDetector faceDetector(detectorConfig);
+    if (!faceDetector.load(haarCascadeFileName)) {
+        return -1;
+    }
     
-    // Get a handle to the Video device:
-    VideoCapture cap(deviceId);
+    // Get a handle to the Video device, video file, or image sequence:
+    FrameSource cap;
     // Check if we can use this device at all:
-    if(!cap.isOpened()) {
-        cerr << "Capture Device ID " << deviceId << "cannot be opened." << endl;
+    if(!cap.open(sourceSpec, sourceOptions)) {
+        cerr << "Frame source " << sourceSpec << " cannot be opened." << endl;
         return -1;
     }
-    int capFrameWidth = cap.get(CV_CAP_PROP_FRAME_WIDTH);
-    int capFrameHeight = cap.get(CV_CAP_PROP_FRAME_HEIGHT);
+    int capFrameWidth = cap.getFrameSize().width;
+    int capFrameHeight = cap.getFrameSize().height;
+
+    // Faces that stay still between frames reuse their previous prediction.
+    RecognitionCache recognitionCache(model, recognizerConfig.faceSize);
+    // Every per-frame buffer is allocated once here and reused for every frame, nothing is 
+    // drawn in headless mode
+    FrameContext frameContext(Size(capFrameWidth, capFrameHeight), !sourceOptions.headless);
+    // Angles of every pixel column and row and the targetting overlay, computed once for 
+    // this camera
+    CameraGeometry cameraGeometry(Size(capFrameWidth, capFrameHeight), 
+            detectorConfig.horizontalFov);
+
+    // Time each stage of every frame
+    StageTimings timings;
+    int captureStage = timings.addStage("capture");
+    int grayscaleStage = timings.addStage("grayscale");
+    int detectStage = timings.addStage("detect");
+    int recognizeStage = timings.addStage("recognize");
+    int renderStage = timings.addStage("render");
+    // Optionally trace the stages, including the resizes and predictions on the worker threads
+    if (traceOptions.isEnabled()) {
+        TraceRecorder::shared().enable(traceOptions);
+        timings.setTrace(&TraceRecorder::shared());
+    }
+    chrono::steady_clock::time_point loopStart = chrono::steady_clock::now();
 
     try {
-        // Holds the current frame from the Video device:
-        Mat frame;
         for(;;) {
-            cap >> frame;
-            // Clone the current frame:
-            Mat original = frame.clone();
-            // Convert the current frame to grayscale:
-            Mat gray;
-            cvtColor(original, gray, CV_BGR2GRAY);
+            if (sourceOptions.maxFrames > 0 
+                    && (long) frameContext.getFrameCount() >= sourceOptions.maxFrames) {
+                break;
+            }
+            // Capture into the reused frame buffer, convert it to grayscale and copy it for 
+            // display:
+            bool captured;
+            {
+                ScopedStageTimer timer(timings, captureStage);
+                captured = cap.read(frameContext.getFrame());
+            }
+            if (!captured) {
+                break;
+            }
+            {
+                ScopedStageTimer timer(timings, grayscaleStage);
+                frameContext.prepare();
+            }
+            const Mat &gray = frameContext.getGray();
+            Mat &original = frameContext.getDisplay();
             // Find the faces in the frame:
-            vector< Rect_<int> > faces;
-            haarCascade.detectMultiScale(gray, faces);
+            vector<Rect> &faces = frameContext.getFaces();
+            {
+                ScopedStageTimer timer(timings, detectStage);
+                faceDetector.detect(gray, faces);
+            }
             // At this point you have the position of the faces in
             // faces. Now we'll get the faces, make a prediction and
             // annotate it in the video. Cool or what?
-            for(int i = 0; i < faces.size(); i++) {
+            //
+            // Resizing the face is necessary for Eigenfaces and Fisherfaces. You can easily
+            // verify this, by reading through the face recognition tutorial coming with OpenCV.
+            // Resizing IS NOT NEEDED for Local Binary Patterns Histograms, so preparing the
+            // input data really depends on the algorithm used. The recognition cache resizes
+            // each face it needs to predict to the recognizer's face size and only predicts 
+            // faces that are new or have changed since the last frame.
+            vector<TrackedIdentity> &identities = frameContext.getIdentities();
+            {
+                ScopedStageTimer timer(timings, recognizeStage);
+                recognitionCache.update(gray, faces, identities);
+            }
+            TraceRecorder::shared().reportRollingSummary(cerr);
+            if (!frameContext.isDisplayEnabled()) {
+                frameContext.finish();
+                continue;
+            }
+            chrono::steady_clock::time_point renderStart = chrono::steady_clock::now();
+            for(int i = 0; i < identities.size(); i++) {
                 // Process face by face:
-                Rect curFace = faces[i];
-                // Crop the face from the image. So simple with OpenCV C++:
-                Mat face = gray(curFace);
-                // Resizing the face is necessary for Eigenfaces and Fisherfaces. You can easily
-                // verify this, by reading through the face recognition tutorial coming with OpenCV.
-                // Resizing IS NOT NEEDED for Local Binary Patterns Histograms, so preparing the
-                // input data really depends on the algorithm used.
-                //
-                // I strongly encourage you to play around with the algorithms. See which work best
-                // in your scenario, LBPH should always be a contender for robust face recognition.
-                //
-                // Since I am showing the Fisherfaces algorithm here, I also show how to resize the
-                // face you have just found:
-                Mat resizedFace;
-                cv::resize(face, resizedFace, Size(imgWidth, imgHeight), 1.0, 1.0, INTER_CUBIC);
-                // Now perform the prediction, see how easy that is:
-                int prediction = -1;
-                double confidence = 0.0;
-                model->predict(resizedFace, prediction, confidence);
+                Rect curFace = identities[i].face;
+                int prediction = identities[i].smoothedPrediction;
+                double confidence = identities[i].confidence;
                 // If the prediction is one of the faces we can recognize
                 if (prediction > 0) {
                     // And finally write all we've found out to the original image!
@@ -283,8 +321,7 @@ int main(int argc, const char *argv[]) {
                     double rightSideAngle = -1;
                     double topAngle = -1;
                     double bottomAngle = -1;
-                    findAngleBounds(capFrameWidth, capFrameHeight, curFace, 
-                            leftSideAngle, rightSideAngle, 
+                    cameraGeometry.getAngleBounds(curFace, leftSideAngle, rightSideAngle, 
                             topAngle, bottomAngle);
                     int thetaPosX = std::max(curFace.tl().x + 10, 0);
                     int thetaPosY = std::max(curFace.br().y + 10, 0);
@@ -305,11 +342,13 @@ int main(int argc, const char *argv[]) {
                         CV_RGB(0, 255, 0), 2.0);
                 }
             }
+            frameContext.finish();
             // Add "targeting" lines
-            drawTargettingLines(capFrameWidth, capFrameHeight, original);
+            cameraGeometry.drawOverlay(original);
 
             // Show the result:
             imshow("face_recognizer", original);
+            timings.record(renderStage, renderStart, chrono::steady_clock::now());
             // And display it:
             int key = waitKey(20);
             // Exit this loop on escape OR space:
@@ -323,75 +362,20 @@ int main(int argc, const char *argv[]) {
     } catch(Exception e) {
         cap.release();
     }
+    TraceRecorder::shared().finish();
+    if (sourceOptions.headless) {
+        chrono::duration<double> loopSeconds = chrono::steady_clock::now() - loopStart;
+        timings.setField("predictions", recognitionCache.getPredictionCount());
+        timings.setField("cachedPredictions", recognitionCache.getCacheHitCount());
+        timings.setField("steadyStateBufferReallocations", 
+                frameContext.getSteadyStateBufferReallocationCount());
+        timings.writeJson(sourceOptions.jsonPath, cap.getDescription(), 
+                frameContext.getFrameCount(), loopSeconds.count());
+    }
+    cout << "Processed " << frameContext.getFrameCount() << " frames with " 
+            << frameContext.getBufferReallocationCount() << " frame buffer reallocations ("
+            << frameContext.getSteadyStateBufferReallocationCount() << " after the first frame)" 
+            << endl;
     cap.release();
     return 0;
 }
-
-/**
- * Wraps the passed angle to the range [-pi / 2, pi / 2]
- */
-static double wrapAngle(double angle) {
-    return angle - M_PI * floor(angle / M_PI) - (M_PI / 2);
-}
-
-/**
- * Calculates the horizontal angles and vertical angles of the passed in rectangle.
- * Annotates the rectangle on the frame with text describing the output.
- */
-static void findAngleBounds(int &frameWidth, int &frameHeight, Rect &faceRectangle, 
-        double &leftSideAngle, double &rightSideAngle, double &topAngle, double &bottomAngle) {
-    // Get points at the two bottom corners of the rectangle
-    int x1 = faceRectangle.tl().x - frameWidth / 2;
-    int x2 = faceRectangle.br().x - frameWidth / 2;
-
-    // Compute theta1 and theta2 (leftSideAngle and rightSideAngle)
-    // Convert to polar coordinates, with known r and unknown angle
-    double r = 639;
-    leftSideAngle = acos(x1 / r);
-    rightSideAngle = acos(x2 / r);
-    // Wrap angles to [-90, 90]
-    leftSideAngle = wrapAngle(leftSideAngle) * (180 / M_PI);
-    rightSideAngle = wrapAngle(rightSideAngle) * (180 / M_PI);
-    // Invert the circle revolution direction
-    leftSideAngle *= -1;
-    rightSideAngle *= -1;
-}
-
-/**
- * Draw a straight horizontal line across the center of the frame and annotate it with 
- * smaller vertical lines which have angle annotations from -30 - 30
- */ 
-static void drawTargettingLines(int &frameWidth, int &frameHeight, Mat &frame) {
-    // Straight horizontal line across the center of the frame
-    line(frame, Point(0, frameHeight / 2), Point(frameWidth, frameHeight / 2), CV_RGB(0, 255,0), 1);
-    int topY = frameHeight / 2 - 50;
-    int bottomY = frameHeight / 2 + 50;
-    double x1, x2;
-    double r = 639;
-    double theta;
-    string angleString1;
-    string angleString2;
-    for (int i = 0; i <= 30; i+=10) {
-        x1 = r * sin(i * (M_PI / 180));
-        x1 += frameWidth / 2;        
-        x2 = r * sin(-i * (M_PI / 180));
-        x2 += frameWidth / 2;
-        line(frame, Point(x1, topY), Point(x1, bottomY), CV_RGB(0, 255,0), 1);
-        line(frame, Point(x2, topY), Point(x2, bottomY), CV_RGB(0, 255,0), 1);
-        angleString1 = format("%d", i);
-        angleString2 = format("%d", -i);
-        if (i != 30) {
-            putText(frame, angleString1, Point(x1 - 5, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                    CV_RGB(0, 255, 0), 2.0);    
-            if (i != 0) {
-                putText(frame, angleString2, Point(x2 - 20, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                        CV_RGB(0, 255, 0), 2.0);    
-            }
-        } else {
-            putText(frame, angleString1, Point(x1 - 20, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                    CV_RGB(0, 255, 0), 2.0);    
-            putText(frame, angleString2, Point(x2 - 5, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                    CV_RGB(0, 255, 0), 2.0);    
-        }
-    }
-}
\ No newline at end of file
@@ -0,0 +1,106 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "batch_recognizer.hpp"
+
+#include "../quantized-lbph/quantized_lbph.hpp"
+#include "../stage-timing/trace_recorder.hpp"
+
+using namespace cv;
+using namespace std;
+
+//~Functions----------------------------------------------------------------------------------------
+BatchRecognizer::BatchRecognizer(const Ptr<face::FaceRecognizer> &model, const Size &faceSize,
+        WorkerPool &pool) 
+        : model(model), faceSize(faceSize), pool(pool), batchCrops(NULL), 
+        batchPredictions(NULL) {
+    resizing = dynamic_cast<face::LBPHFaceRecognizer *>(model.get()) == NULL 
+            && dynamic_cast<QuantizedLbphRecognizer *>(model.get()) == NULL;
+    resizeStage = TraceRecorder::shared().addStage("resize");
+    predictStage = TraceRecorder::shared().addStage("predict");
+}
+
+/**
+ * Predicts every crop and stores the results in predictions in the same order.
+ */
+void BatchRecognizer::predict(const vector<Mat> &crops, vector<FacePrediction> &predictions) {
+    predictions.resize(crops.size());
+    if (resizedCrops.size() < crops.size()) {
+        resizedCrops.resize(crops.size());
+    }
+    // Capturing only this keeps the task small enough for std::function not to allocate
+    batchCrops = &crops;
+    batchPredictions = &predictions;
+    pool.run(crops.size(), [this](int i) { predictOne(i); });
+}
+
+/**
+ * Predicts the face inside each rectangle of gray, in detection order.
+ */
+void BatchRecognizer::predict(const Mat &gray, const vector<Rect> &faces, 
+        vector<FacePrediction> &predictions) {
+    crops.resize(faces.size());
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        crops[i] = gray(faces[i]);
+    }
+    predict(crops, predictions);
+}
+
+/**
+ * True if crops are resized to the face size before prediction.
+ */
+bool BatchRecognizer::isResizing() const {
+    return resizing;
+}
+
+/**
+ * The cheapest interpolation that still looks right for resizing from one size to another.
+ */
+int BatchRecognizer::getInterpolation(const Size &from, const Size &to) {
+    return (to.width < from.width && to.height < from.height) ? INTER_AREA : INTER_LINEAR;
+}
+
+/**
+ * Resizes or copies the index'th crop of the batch into its slot's buffer if the model needs 
+ * it and runs the recognizer. Runs on the pool's threads, so it only touches its own slot.
+ */
+void BatchRecognizer::predictOne(int index) {
+    const Mat &crop = (*batchCrops)[index];
+    FacePrediction &prediction = (*batchPredictions)[index];
+    const Mat *input = &crop;
+    // Eigen and Fisher reshape the crop, which needs it continuous, not a view into the frame
+    if (resizing && (crop.size() != faceSize || !crop.isContinuous())) {
+        ScopedTrace trace(TraceRecorder::shared(), resizeStage);
+        if (crop.size() == faceSize) {
+            crop.copyTo(resizedCrops[index]);
+        } else {
+            cv::resize(crop, resizedCrops[index], faceSize, 0, 0, 
+                    getInterpolation(crop.size(), faceSize));
+        }
+        input = &resizedCrops[index];
+    }
+    prediction.label = -1;
+    prediction.confidence = 0.0;
+    ScopedTrace trace(TraceRecorder::shared(), predictStage);
+    model->predict(*input, prediction.label, prediction.confidence);
+}
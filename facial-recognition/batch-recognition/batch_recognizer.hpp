@@ -0,0 +1,85 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef BATCH_RECOGNIZER_HPP_
+#define BATCH_RECOGNIZER_HPP_
+
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <vector>
+
+/**
+ * The recognizer's answer for one face crop.
+ */
+struct FacePrediction {
+    int label;
+    double confidence;
+};
+
+/**
+ * Predicts the identities of all the faces in a frame at once.
+ *
+ * Each crop is resized to the model's face size only if the model needs it: Eigenfaces and 
+ * Fisherfaces compare raw pixels and need the training size, LBPH (quantized or not) builds 
+ * normalized per-cell histograms that work at any size so its crops are used as they are. 
+ * Crops are shrunk with INTER_AREA and enlarged with INTER_LINEAR, both much cheaper than 
+ * INTER_CUBIC.
+ * Predictions run in parallel on a WorkerPool and come back in the order of the crops.
+ * Each resize and prediction is recorded as a "resize" or "predict" span of the shared 
+ * TraceRecorder, on the thread that ran it.
+ */
+class BatchRecognizer {
+public:
+    BatchRecognizer(const cv::Ptr<cv::face::FaceRecognizer> &model, const cv::Size &faceSize,
+            WorkerPool &pool = WorkerPool::shared());
+
+    void predict(const std::vector<cv::Mat> &crops, std::vector<FacePrediction> &predictions);
+    void predict(const cv::Mat &gray, const std::vector<cv::Rect> &faces, 
+            std::vector<FacePrediction> &predictions);
+
+    bool isResizing() const;
+    static int getInterpolation(const cv::Size &from, const cv::Size &to);
+
+private:
+    cv::Ptr<cv::face::FaceRecognizer> model;
+    cv::Size faceSize;
+    WorkerPool &pool;
+    bool resizing;
+    int resizeStage;
+    int predictStage;
+    // One resize buffer per crop slot and the crop headers for the rectangle overload,
+    // both reused between frames
+    std::vector<cv::Mat> resizedCrops;
+    std::vector<cv::Mat> crops;
+    // The batch being predicted
+    const std::vector<cv::Mat> *batchCrops;
+    std::vector<FacePrediction> *batchPredictions;
+
+    void predictOne(int index);
+};
+
+#endif
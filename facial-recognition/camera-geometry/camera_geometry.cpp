@@ -0,0 +1,168 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "camera_geometry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const double PI = 3.14159265358979323846;
+// Angle between ticks on the overlay and half the height of each tick, in pixels
+static const int TICK_SPACING = 10;
+static const int TICK_HALF_HEIGHT = 50;
+
+//~Functions----------------------------------------------------------------------------------------
+CameraGeometry::CameraGeometry(const Size &frameSize, double horizontalFov, double yaw) 
+        : frameSize(frameSize), horizontalFov(horizontalFov), yaw(yaw), 
+        columnAngles(frameSize.width + 1), rowAngles(frameSize.height + 1) {
+    focalLength = (frameSize.width / 2.0) / tan(horizontalFov / 2.0 * PI / 180.0);
+    for (int column = 0; column <= frameSize.width; column++) {
+        double x = column - frameSize.width / 2;
+        columnAngles[column] = (float) (atan(x / focalLength) * 180.0 / PI + yaw);
+    }
+    // Rows above the center are positive
+    for (int row = 0; row <= frameSize.height; row++) {
+        double y = frameSize.height / 2 - row;
+        rowAngles[row] = (float) (atan(y / focalLength) * 180.0 / PI);
+    }
+}
+
+/**
+ * Horizontal angle of a pixel column in degrees, negative left of the camera's yaw. Columns 
+ * outside the frame are clamped to its edges.
+ */
+float CameraGeometry::getColumnAngle(int column) const {
+    return columnAngles[std::min(std::max(column, 0), frameSize.width)];
+}
+
+/**
+ * Vertical angle of a pixel row in degrees, negative below center.
+ */
+float CameraGeometry::getRowAngle(int row) const {
+    return rowAngles[std::min(std::max(row, 0), frameSize.height)];
+}
+
+/**
+ * The pixel column at the given horizontal angle, which may be outside the frame.
+ */
+int CameraGeometry::getAngleColumn(double angle) const {
+    return cvRound(frameSize.width / 2 + focalLength * tan((angle - yaw) * PI / 180.0));
+}
+
+/**
+ * Horizontal angles of the left and right sides of face.
+ */
+void CameraGeometry::getAngleBounds(const Rect &face, double &leftSideAngle, 
+        double &rightSideAngle) const {
+    leftSideAngle = getColumnAngle(face.x);
+    rightSideAngle = getColumnAngle(face.x + face.width);
+}
+
+/**
+ * Horizontal angles of the left and right sides and vertical angles of the top and bottom of
+ * face.
+ */
+void CameraGeometry::getAngleBounds(const Rect &face, double &leftSideAngle, 
+        double &rightSideAngle, double &topAngle, double &bottomAngle) const {
+    getAngleBounds(face, leftSideAngle, rightSideAngle);
+    topAngle = getRowAngle(face.y);
+    bottomAngle = getRowAngle(face.y + face.height);
+}
+
+/**
+ * Draws the targetting overlay onto frame: a horizontal line across the center of the frame
+ * with a labelled tick every ten degrees. alpha below 1 blends the overlay with the frame.
+ */
+void CameraGeometry::drawOverlay(Mat &frame, double alpha) {
+    if (frame.size() != frameSize) {
+        return;
+    }
+    if (overlay.type() != frame.type() || overlay.empty()) {
+        rasterizeOverlay(frame.type());
+    }
+    Mat frameBounds = frame(overlayBounds);
+    if (alpha >= 1.0) {
+        overlay(overlayBounds).copyTo(frameBounds, overlayMask(overlayBounds));
+        return;
+    }
+    addWeighted(frameBounds, 1.0 - alpha, overlay(overlayBounds), alpha, 0.0, blended);
+    blended.copyTo(frameBounds, overlayMask(overlayBounds));
+}
+
+const Size &CameraGeometry::getFrameSize() const {
+    return frameSize;
+}
+
+double CameraGeometry::getHorizontalFov() const {
+    return horizontalFov;
+}
+
+/**
+ * Horizontal angle of the center of the frame in degrees, positive to the right.
+ */
+double CameraGeometry::getYaw() const {
+    return yaw;
+}
+
+/**
+ * Draws the overlay once into an image of the given type and a mask of the pixels it covers,
+ * and remembers the band of rows it touches so only those are blended each frame.
+ */
+void CameraGeometry::rasterizeOverlay(int type) {
+    overlay.create(frameSize, type);
+    overlay.setTo(Scalar::all(0));
+    overlayMask.create(frameSize, CV_8UC1);
+    overlayMask.setTo(Scalar(0));
+    const Scalar color = CV_RGB(0, 255, 0);
+    int centerY = frameSize.height / 2;
+    int topY = centerY - TICK_HALF_HEIGHT;
+    int bottomY = centerY + TICK_HALF_HEIGHT;
+    line(overlay, Point(0, centerY), Point(frameSize.width, centerY), color, 1);
+    line(overlayMask, Point(0, centerY), Point(frameSize.width, centerY), Scalar(255), 1);
+    int textBottom = bottomY + 15;
+    int textDescent = 0;
+    int firstTick = TICK_SPACING * (int) ceil((yaw - horizontalFov / 2) / TICK_SPACING);
+    for (int angle = firstTick; angle <= yaw + horizontalFov / 2; angle += TICK_SPACING) {
+        int x = std::min(getAngleColumn(angle), frameSize.width - 1);
+        line(overlay, Point(x, topY), Point(x, bottomY), color, 1);
+        line(overlayMask, Point(x, topY), Point(x, bottomY), Scalar(255), 1);
+        // Center each label under its tick, keeping the ones at the edges inside the frame
+        string label = format("%d", angle);
+        int baseline = 0;
+        Size textSize = getTextSize(label, FONT_HERSHEY_PLAIN, 1.0, 2, &baseline);
+        int textX = std::min(std::max(x - textSize.width / 2, 0), 
+                frameSize.width - textSize.width);
+        putText(overlay, label, Point(textX, textBottom), FONT_HERSHEY_PLAIN, 1.0, color, 2);
+        putText(overlayMask, label, Point(textX, textBottom), FONT_HERSHEY_PLAIN, 1.0, 
+                Scalar(255), 2);
+        textDescent = std::max(textDescent, baseline);
+    }
+    int bandTop = std::max(std::min(topY, centerY) - 1, 0);
+    int bandBottom = std::min(textBottom + textDescent + 2, frameSize.height);
+    overlayBounds = Rect(0, bandTop, frameSize.width, std::max(bandBottom - bandTop, 0));
+}
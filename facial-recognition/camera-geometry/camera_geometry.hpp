@@ -0,0 +1,76 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CAMERA_GEOMETRY_HPP_
+#define CAMERA_GEOMETRY_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <vector>
+
+/**
+ * Maps pixel positions in a camera frame to angles of arrival, and draws the angle overlay.
+ *
+ * The camera is treated as a pinhole camera with the given horizontal field of view and
+ * square pixels. The angle of every pixel column and row is computed once, in degrees with
+ * the frame center at 0, so looking up the angles of a face is two table reads. On a rig with
+ * several cameras, the yaw of each camera is added to its horizontal angles so every camera
+ * reports angles around the same origin. The targetting overlay is drawn once into a cached 
+ * image and mask and blended onto each frame.
+ */
+class CameraGeometry {
+public:
+    CameraGeometry(const cv::Size &frameSize, double horizontalFov = 60.0, double yaw = 0.0);
+
+    float getColumnAngle(int column) const;
+    float getRowAngle(int row) const;
+    int getAngleColumn(double angle) const;
+    void getAngleBounds(const cv::Rect &face, double &leftSideAngle, double &rightSideAngle) const;
+    void getAngleBounds(const cv::Rect &face, double &leftSideAngle, double &rightSideAngle,
+            double &topAngle, double &bottomAngle) const;
+
+    void drawOverlay(cv::Mat &frame, double alpha = 1.0);
+
+    const cv::Size &getFrameSize() const;
+    double getHorizontalFov() const;
+    double getYaw() const;
+
+private:
+    cv::Size frameSize;
+    double horizontalFov;
+    double yaw;
+    double focalLength;
+    // One entry per pixel edge, so both sides of a rectangle ending at the frame edge fit
+    std::vector<float> columnAngles;
+    std::vector<float> rowAngles;
+
+    cv::Mat overlay;
+    cv::Mat overlayMask;
+    cv::Rect overlayBounds;
+    cv::Mat blended;
+
+    void rasterizeOverlay(int type);
+};
+
+#endif
@@ -0,0 +1,946 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Picks recognizer settings and thresholds from data instead of by hand.
+ *
+ * Runs k-fold cross-validation over the training faces for every model and every combination
+ * of the given LBPH radii, neighbor counts and grid sizes, and reports the accuracy, 
+ * misidentification rate, false reject rate, false accept rate, prediction latency and model 
+ * size at each candidate threshold. The protocol is open-set: each fold also leaves whole 
+ * subjects out of its gallery and probes with all of their faces as impostors, so the false 
+ * accept rate is the share of unknown faces accepted as someone. The best setting of each 
+ * model, the one with the lowest sum of genuine error rate and false accept rate, is then 
+ * trained on every training face but the unknown test subjects and scored on the test set.
+ * The quantized LBPH models reuse the LBPH histograms with 8 bit bins, "qlbph" with the 
+ * chi-square distance and "qlbph-l1" with histogram intersection.
+ *
+ * Each probe's nearest distance is kept, so every threshold is scored from one set of 
+ * predictions. LBPH histograms are extracted once per setting and shared by all folds.
+ *
+ * Usage: cross_validate [options], see printUsage.
+ */
+#include "../face-detect/face_detect.hpp"
+#include "../lbph-features/lbph_features.hpp"
+#include "../quantized-lbph/quantized_lbph.hpp"
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <dirent.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const char separator = ';';
+// The size the training faces are cropped and padded to
+static const Size faceSize(168, 168);
+// Histograms timed one at a time to estimate LBPH feature extraction latency
+static const int latencySamples = 8;
+
+/**
+ * What the tool was asked to evaluate.
+ */
+struct CrossValidationOptions {
+    string trainPath;
+    string testPath;
+    string cascadeFileName;
+    string outputPath;
+    int folds;
+    int unknownSubjects;
+    vector<int> unknownTestSubjects;
+    unsigned int seed;
+    vector<string> models;
+    vector<int> radii;
+    vector<int> neighbors;
+    vector<int> grids;
+    vector<double> lbphThresholds;
+    vector<double> intersectionThresholds;
+    vector<double> eigenThresholds;
+    vector<double> fisherThresholds;
+};
+
+/**
+ * Faces and their labels, read from a csv file or a directory of subjectNN.* images.
+ */
+struct FaceSet {
+    vector<Mat> images;
+    vector<int> labels;
+};
+
+/**
+ * The faces one fold matches against its gallery. Impostors are the faces of the subjects 
+ * left out of the gallery, probes are the fold's own faces of the other subjects.
+ */
+struct Fold {
+    vector<int> probes;
+    vector<int> impostors;
+    vector<int> gallery;
+};
+
+/**
+ * The nearest match found for one probe face, before any threshold is applied. Impostor 
+ * probes are of subjects that are not in the gallery.
+ */
+struct ProbeResult {
+    int label;
+    int predicted;
+    double distance;
+    bool impostor;
+};
+
+/**
+ * Outcome of one model setting at one threshold.
+ */
+struct Evaluation {
+    string model;
+    string parameters;
+    LbphParameters lbphParameters;
+    double threshold;
+    int genuineProbes;
+    int impostorProbes;
+    // Genuine probes accepted with the right label, accepted with the wrong label, and rejected
+    int correct;
+    int misidentified;
+    int falseRejects;
+    // Impostor probes accepted as any subject
+    int falseAccepts;
+    double latencySeconds;
+    // Memory held by the trained model's features
+    size_t modelBytes;
+};
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool parseOptions(int argc, const char *argv[], CrossValidationOptions &options);
+static void printUsage(const char *program);
+static bool loadFaces(const string &path, const string &cascadeFileName, FaceSet &faces);
+static void listImages(const string &directory, vector<string> &paths);
+static int parseSubjectLabel(const string &path);
+static bool prepareFace(const Mat &image, CascadeClassifier &cascade, Mat &face);
+static vector<Fold> assignFolds(const vector<int> &labels, int folds, int unknownSubjects, 
+        unsigned int seed);
+static int countSubjects(const vector<int> &labels);
+static bool contains(const vector<int> &list, int value);
+static void crossValidateLbph(const string &model, const FaceSet &train, 
+        const vector<Fold> &folds, const vector<double> &thresholds, 
+        const CrossValidationOptions &options, LbphFeatureCache &cache, 
+        vector<Evaluation> &evaluations);
+static void crossValidateSubspace(const string &model, const FaceSet &train, 
+        const vector<Fold> &folds, const vector<double> &thresholds, 
+        vector<Evaluation> &evaluations);
+static void testLbph(const FaceSet &train, const FaceSet &test, 
+        const vector<int> &unknownSubjects, LbphFeatureCache &cache, Evaluation &evaluation);
+static void testSubspace(const FaceSet &train, const FaceSet &test, 
+        const vector<int> &unknownSubjects, Evaluation &evaluation);
+static Ptr<face::BasicFaceRecognizer> createSubspaceModel(const string &model);
+static size_t getSubspaceModelBytes(const Ptr<face::BasicFaceRecognizer> &recognizer);
+static bool isLbphModel(const string &model);
+static QuantizedLbphRecognizer::Metric getQuantizedMetric(const string &model);
+static void quantizeHistograms(const vector<Mat> &histograms, float scale, Mat &quantized);
+static void scoreThresholds(const string &model, const string &parameters, 
+        const vector<ProbeResult> &results, const vector<double> &thresholds, 
+        double latencySeconds, size_t modelBytes, vector<Evaluation> &evaluations);
+static Evaluation score(const vector<ProbeResult> &results, double threshold);
+static void copyScores(const Evaluation &scored, Evaluation &evaluation);
+static double getTradeOffError(const Evaluation &evaluation);
+static void printEvaluation(const Evaluation &evaluation, ostream &out);
+template <typename T> static bool parseList(const string &value, vector<T> &list);
+
+//~Functions----------------------------------------------------------------------------------------
+int main(int argc, const char *argv[]) {
+    CrossValidationOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    FaceSet train;
+    if (!loadFaces(options.trainPath, options.cascadeFileName, train) || train.images.empty()) {
+        cerr << "No training faces found at " << options.trainPath << endl;
+        return 1;
+    }
+    // Fisherfaces needs at least two subjects in every gallery
+    if (options.unknownSubjects > countSubjects(train.labels) - 2) {
+        cerr << "Cannot leave " << options.unknownSubjects << " of " 
+                << countSubjects(train.labels) << " subjects out of each fold" << endl;
+        return 1;
+    }
+    vector<Fold> folds = assignFolds(train.labels, options.folds, options.unknownSubjects, 
+            options.seed);
+    cout << "Cross-validating on " << train.images.size() << " faces in " << folds.size() 
+            << " folds, each leaving " << options.unknownSubjects << " subjects out as "
+            << "impostors, on " << WorkerPool::shared().getThreadCount() << " threads" << endl;
+
+    LbphFeatureCache cache(train.images);
+    vector<Evaluation> evaluations;
+    for (unsigned int i = 0; i < options.models.size(); i++) {
+        const string &model = options.models[i];
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        if (isLbphModel(model)) {
+            crossValidateLbph(model, train, folds, model == "qlbph-l1" 
+                    ? options.intersectionThresholds : options.lbphThresholds, options, cache,
+                    evaluations);
+        } else {
+            crossValidateSubspace(model, train, folds, 
+                    model == "eigen" ? options.eigenThresholds : options.fisherThresholds, 
+                    evaluations);
+        }
+        chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+        cout << "Evaluated " << model << " in " << seconds.count() << " seconds" << endl;
+    }
+
+    cout << endl;
+    printf("%-8s %-24s %10s %9s %7s %7s %7s %11s %9s\n", "model", "parameters", "threshold", 
+            "accuracy", "misid", "FRR", "FAR", "latency ms", "model KB");
+    for (unsigned int i = 0; i < evaluations.size(); i++) {
+        printEvaluation(evaluations[i], cout);
+    }
+    if (!options.outputPath.empty()) {
+        std::ofstream output(options.outputPath.c_str());
+        output << "model;parameters;threshold;accuracy;misid;frr;far;genuineProbes;"
+                << "impostorProbes;latencyMs;modelBytes\n";
+        for (unsigned int i = 0; i < evaluations.size(); i++) {
+            const Evaluation &evaluation = evaluations[i];
+            double genuine = max(evaluation.genuineProbes, 1);
+            double impostors = max(evaluation.impostorProbes, 1);
+            output << evaluation.model << separator << evaluation.parameters << separator 
+                    << evaluation.threshold << separator 
+                    << evaluation.correct / genuine << separator 
+                    << evaluation.misidentified / genuine << separator 
+                    << evaluation.falseRejects / genuine << separator 
+                    << evaluation.falseAccepts / impostors << separator 
+                    << evaluation.genuineProbes << separator << evaluation.impostorProbes 
+                    << separator << evaluation.latencySeconds * 1e3 << separator 
+                    << evaluation.modelBytes << "\n";
+        }
+    }
+
+    // The best setting of each model, by the sum of its genuine error rate and false accept 
+    // rate, and then by fewer false accepts
+    vector<Evaluation> best;
+    for (unsigned int i = 0; i < evaluations.size(); i++) {
+        const Evaluation &evaluation = evaluations[i];
+        unsigned int j = 0;
+        while (j < best.size() && best[j].model != evaluation.model) {
+            j++;
+        }
+        if (j == best.size()) {
+            best.push_back(evaluation);
+        } else {
+            double error = getTradeOffError(evaluation);
+            double bestError = getTradeOffError(best[j]);
+            if (error < bestError || (error == bestError 
+                    && evaluation.falseAccepts < best[j].falseAccepts)) {
+                best[j] = evaluation;
+            }
+        }
+    }
+    cout << endl << "Best cross-validated setting of each model:" << endl;
+    for (unsigned int i = 0; i < best.size(); i++) {
+        printEvaluation(best[i], cout);
+    }
+
+    FaceSet test;
+    if (options.testPath.empty()) {
+        return 0;
+    }
+    if (!loadFaces(options.testPath, options.cascadeFileName, test) || test.images.empty()) {
+        cerr << "No test faces found at " << options.testPath << endl;
+        return 1;
+    }
+    cout << endl << "Trained on every training face but subjects";
+    for (unsigned int i = 0; i < options.unknownTestSubjects.size(); i++) {
+        cout << " " << options.unknownTestSubjects[i];
+    }
+    cout << ", scored on " << test.images.size() << " test faces:" << endl;
+    for (unsigned int i = 0; i < best.size(); i++) {
+        if (isLbphModel(best[i].model)) {
+            testLbph(train, test, options.unknownTestSubjects, cache, best[i]);
+        } else {
+            testSubspace(train, test, options.unknownTestSubjects, best[i]);
+        }
+        printEvaluation(best[i], cout);
+    }
+    return 0;
+}
+
+/**
+ * Reads the "--name=value" flags. Lists are comma separated.
+ */
+static bool parseOptions(int argc, const char *argv[], CrossValidationOptions &options) {
+    options.trainPath = "../data/yalefaces--eyewear";
+    options.testPath = "../data/yalefaces--eyewear-test-set";
+    options.cascadeFileName = "../face-detect/haarcascades/haarcascade_frontalface_default.xml";
+    options.folds = 5;
+    // With the 15 yalefaces subjects and 5 folds, every subject is an impostor in one fold
+    options.unknownSubjects = 3;
+    // As the yalefaces-no-9 and yalefaces-only-9 split, subject 9 is the unknown test face
+    parseList<int>("9", options.unknownTestSubjects);
+    options.seed = 0;
+    parseList<string>("lbph,qlbph,qlbph-l1,eigen,fisher", options.models);
+    // The defaults include the radius 10, 8 neighbor, 4x4 grid the recognition tools deploy
+    parseList<int>("1,2,10", options.radii);
+    parseList<int>("8", options.neighbors);
+    parseList<int>("4,8", options.grids);
+    // The thresholds the recognition tools were using are among the candidates
+    parseList<double>("10,15,20,25,30,40,60", options.lbphThresholds);
+    parseList<double>("4,6,8,10,12,16,20,25,30", options.intersectionThresholds);
+    parseList<double>("2500,5000,7250,10000,15000", options.eigenThresholds);
+    parseList<double>("500,1000,2200,3500,5000", options.fisherThresholds);
+    for (int i = 1; i < argc; i++) {
+        string argument(argv[i]);
+        size_t equals = argument.find('=');
+        if (argument.compare(0, 2, "--") != 0 || equals == string::npos) {
+            cerr << "Unknown argument: " << argument << endl;
+            return false;
+        }
+        string name = argument.substr(2, equals - 2);
+        string value = argument.substr(equals + 1);
+        bool valid = true;
+        if (name == "train") {
+            options.trainPath = value;
+        } else if (name == "test") {
+            options.testPath = value;
+        } else if (name == "cascade") {
+            options.cascadeFileName = value;
+        } else if (name == "output") {
+            options.outputPath = value;
+        } else if (name == "folds") {
+            options.folds = atoi(value.c_str());
+            valid = options.folds >= 2;
+        } else if (name == "unknown-subjects") {
+            options.unknownSubjects = atoi(value.c_str());
+            valid = options.unknownSubjects >= 0;
+        } else if (name == "unknown-test-subjects") {
+            // Empty for a closed-set test
+            valid = value.empty() || parseList(value, options.unknownTestSubjects);
+            if (value.empty()) {
+                options.unknownTestSubjects.clear();
+            }
+        } else if (name == "seed") {
+            options.seed = (unsigned int) strtoul(value.c_str(), NULL, 10);
+        } else if (name == "models") {
+            valid = parseList(value, options.models);
+            for (unsigned int j = 0; j < options.models.size(); j++) {
+                const string &model = options.models[j];
+                valid = valid && (isLbphModel(model) || model == "eigen" || model == "fisher");
+            }
+        } else if (name == "radius") {
+            valid = parseList(value, options.radii);
+        } else if (name == "neighbors") {
+            valid = parseList(value, options.neighbors);
+            // Each neighbor doubles the histogram length
+            for (unsigned int j = 0; j < options.neighbors.size(); j++) {
+                valid = valid && options.neighbors[j] > 0 && options.neighbors[j] <= 16;
+            }
+        } else if (name == "grid") {
+            valid = parseList(value, options.grids);
+        } else if (name == "lbph-thresholds") {
+            valid = parseList(value, options.lbphThresholds);
+        } else if (name == "intersection-thresholds") {
+            valid = parseList(value, options.intersectionThresholds);
+        } else if (name == "eigen-thresholds") {
+            valid = parseList(value, options.eigenThresholds);
+        } else if (name == "fisher-thresholds") {
+            valid = parseList(value, options.fisherThresholds);
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            cerr << "Invalid argument: " << argument << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+static void printUsage(const char *program) {
+    cout << "usage: " << program << " [options]" << endl;
+    cout << "\t--train=<dir | csv> -- Training faces, default ../data/yalefaces--eyewear" << endl;
+    cout << "\t--test=<dir | csv> -- Held out faces, default "
+            << "../data/yalefaces--eyewear-test-set, empty to skip" << endl;
+    cout << "\t--cascade=<file> -- Cascade used to crop faces that are not 168x168" << endl;
+    cout << "\t--folds=<k> -- Number of cross-validation folds, default 5" << endl;
+    cout << "\t--unknown-subjects=<n> -- Subjects each fold leaves out of its gallery and" 
+            << " probes as impostors, default 3, 0 for closed-set" << endl;
+    cout << "\t--unknown-test-subjects=<list> -- Subjects left out of the gallery the test set"
+            << " is scored against, default 9, empty for none" << endl;
+    cout << "\t--seed=<n> -- Seed for assigning faces and unknown subjects to folds" << endl;
+    cout << "\t--models=<list> -- Any of lbph,qlbph,qlbph-l1,eigen,fisher" << endl;
+    cout << "\t--radius=<list> --neighbors=<list> --grid=<list> -- LBPH settings to try," 
+            << " default 1,2,10 and 8 and 4,8" << endl;
+    cout << "\t--lbph-thresholds=<list> --eigen-thresholds=<list> --fisher-thresholds=<list>"
+            << " -- Thresholds to score, the LBPH ones are used for qlbph too" << endl;
+    cout << "\t--intersection-thresholds=<list> -- Thresholds to score for qlbph-l1" << endl;
+    cout << "\t--output=<file> -- Also write every result to a csv file" << endl;
+}
+
+/**
+ * Loads grayscale faces from a csv file of path;label lines, or from every image under a 
+ * directory, labelled by the number in its subjectNN file name. Images that are not 
+ * face-sized are cropped to their largest face.
+ */
+static bool loadFaces(const string &path, const string &cascadeFileName, FaceSet &faces) {
+    vector<string> paths;
+    vector<int> labels;
+    if (path.size() > 4 && path.compare(path.size() - 4, 4, ".csv") == 0) {
+        std::ifstream file(path.c_str(), ifstream::in);
+        if (!file) {
+            return false;
+        }
+        string line, imagePath, label;
+        while (getline(file, line)) {
+            stringstream liness(line);
+            getline(liness, imagePath, separator);
+            getline(liness, label);
+            if (!imagePath.empty() && !label.empty()) {
+                paths.push_back(imagePath);
+                labels.push_back(atoi(label.c_str()));
+            }
+        }
+    } else {
+        listImages(path, paths);
+        sort(paths.begin(), paths.end());
+        for (unsigned int i = 0; i < paths.size(); i++) {
+            labels.push_back(parseSubjectLabel(paths[i]));
+        }
+    }
+
+    vector<Mat> images(paths.size());
+    WorkerPool::shared().run(paths.size(), [&](int i) {
+        // CascadeClassifier is not safe to share between threads, each one loads its own copy
+        static thread_local CascadeClassifier cascade;
+        static thread_local string loadedCascade;
+        if (loadedCascade != cascadeFileName) {
+            cascade.load(cascadeFileName);
+            loadedCascade = cascadeFileName;
+        }
+        Mat image = imread(paths[i], IMREAD_GRAYSCALE);
+        if (labels[i] < 0 || image.empty() || !prepareFace(image, cascade, images[i])) {
+            printf("Skipping %s\n", paths[i].c_str());
+        }
+    });
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        if (!images[i].empty()) {
+            faces.images.push_back(images[i]);
+            faces.labels.push_back(labels[i]);
+        }
+    }
+    return true;
+}
+
+/**
+ * Adds the path of every .jpg, .png, .pgm and .gif file under directory to paths.
+ */
+static void listImages(const string &directory, vector<string> &paths) {
+    DIR *dir = opendir(directory.c_str());
+    if (dir == NULL) {
+        return;
+    }
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        string name(entry->d_name);
+        if (name.empty() || name[0] == '.') {
+            continue;
+        }
+        string path = directory + "/" + name;
+        size_t dot = name.find_last_of('.');
+        string extension = dot == string::npos ? "" : name.substr(dot + 1);
+        if (extension == "jpg" || extension == "png" || extension == "pgm" 
+                || extension == "gif") {
+            paths.push_back(path);
+        } else if (dot == string::npos) {
+            listImages(path, paths);
+        }
+    }
+    closedir(dir);
+}
+
+/**
+ * The subject number in a yalefaces file name such as subject07.happy.jpg, or -1.
+ */
+static int parseSubjectLabel(const string &path) {
+    size_t slash = path.find_last_of('/');
+    string name = slash == string::npos ? path : path.substr(slash + 1);
+    if (name.compare(0, 7, "subject") != 0) {
+        return -1;
+    }
+    return atoi(name.c_str() + 7);
+}
+
+/**
+ * Makes a face-sized grayscale face from image. Images of another size are cropped to their
+ * largest face, padded to a square on white and resized, as the preprocessing tools do.
+ */
+static bool prepareFace(const Mat &image, CascadeClassifier &cascade, Mat &face) {
+    if (image.size() == faceSize) {
+        face = image;
+        return true;
+    }
+    if (cascade.empty()) {
+        return false;
+    }
+    Mat equalized;
+    equalizeHist(image, equalized);
+    vector<Rect> faces;
+    cascade.detectMultiScale(equalized, faces, 1.1, 2, CASCADE_SCALE_IMAGE, Size(30, 30));
+    int largest = findLargestFace(faces);
+    if (largest == -1) {
+        return false;
+    }
+    Mat crop = image(faces[largest]);
+    int side = max(crop.cols, crop.rows);
+    Mat squared;
+    copyMakeBorder(crop, squared, (side - crop.rows) / 2, side - crop.rows - (side - crop.rows) / 2,
+            (side - crop.cols) / 2, side - crop.cols - (side - crop.cols) / 2, BORDER_CONSTANT, 
+            Scalar(255));
+    resize(squared, face, faceSize, 0, 0, side > faceSize.width ? INTER_AREA : INTER_CUBIC);
+    return true;
+}
+
+/**
+ * Splits the faces into folds, dealing each subject's shuffled faces out in turn so every 
+ * fold holds about the same share of every subject. Each fold also leaves unknownSubjects of
+ * the shuffled subjects, taken in turn, out of its gallery and probes with all of their faces.
+ */
+static vector<Fold> assignFolds(const vector<int> &labels, int folds, int unknownSubjects, 
+        unsigned int seed) {
+    vector<int> order(labels.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        order[i] = i;
+    }
+    mt19937 generator(seed);
+    shuffle(order.begin(), order.end(), generator);
+    stable_sort(order.begin(), order.end(), [&](int a, int b) { 
+        return labels[a] < labels[b];
+    });
+    vector<int> held(labels.size());
+    for (unsigned int i = 0; i < order.size(); i++) {
+        held[order[i]] = i % folds;
+    }
+    vector<int> subjects(labels);
+    sort(subjects.begin(), subjects.end());
+    subjects.erase(unique(subjects.begin(), subjects.end()), subjects.end());
+    shuffle(subjects.begin(), subjects.end(), generator);
+
+    vector<Fold> assigned(folds);
+    for (int fold = 0; fold < folds; fold++) {
+        vector<int> unknown;
+        for (int j = 0; j < unknownSubjects; j++) {
+            unknown.push_back(subjects[(fold * unknownSubjects + j) % subjects.size()]);
+        }
+        for (unsigned int i = 0; i < labels.size(); i++) {
+            if (contains(unknown, labels[i])) {
+                assigned[fold].impostors.push_back(i);
+            } else if (held[i] == fold) {
+                assigned[fold].probes.push_back(i);
+            } else {
+                assigned[fold].gallery.push_back(i);
+            }
+        }
+    }
+    return assigned;
+}
+
+static int countSubjects(const vector<int> &labels) {
+    vector<int> subjects(labels);
+    sort(subjects.begin(), subjects.end());
+    return unique(subjects.begin(), subjects.end()) - subjects.begin();
+}
+
+static bool contains(const vector<int> &list, int value) {
+    return find(list.begin(), list.end(), value) != list.end();
+}
+
+/**
+ * Scores every combination of radius, neighbors and grid size. Each probe and impostor is 
+ * matched against the cached histograms of its fold's gallery, in parallel across all of 
+ * them. The quantized models quantize the cached histograms with the scale of the whole 
+ * training set.
+ */
+static void crossValidateLbph(const string &model, const FaceSet &train, 
+        const vector<Fold> &folds, const vector<double> &thresholds, 
+        const CrossValidationOptions &options, LbphFeatureCache &cache, 
+        vector<Evaluation> &evaluations) {
+    bool quantized = model != "lbph";
+    QuantizedLbphRecognizer::Metric metric = getQuantizedMetric(model);
+    // Every face matched in every fold, and the fold whose gallery it is matched against
+    vector<int> probes;
+    vector<int> probeFold;
+    vector<bool> impostor;
+    for (unsigned int fold = 0; fold < folds.size(); fold++) {
+        for (unsigned int i = 0; i < folds[fold].probes.size(); i++) {
+            probes.push_back(folds[fold].probes[i]);
+            probeFold.push_back(fold);
+            impostor.push_back(false);
+        }
+        for (unsigned int i = 0; i < folds[fold].impostors.size(); i++) {
+            probes.push_back(folds[fold].impostors[i]);
+            probeFold.push_back(fold);
+            impostor.push_back(true);
+        }
+    }
+
+    for (unsigned int r = 0; r < options.radii.size(); r++) {
+        for (unsigned int n = 0; n < options.neighbors.size(); n++) {
+            for (unsigned int g = 0; g < options.grids.size(); g++) {
+                LbphParameters parameters(options.radii[r], options.neighbors[n], 
+                        options.grids[g], options.grids[g]);
+                const vector<Mat> &histograms = cache.getHistograms(parameters);
+                float scale = 0;
+                Mat quantizedHistograms;
+                if (quantized) {
+                    scale = findQuantizationScale(histograms);
+                    quantizeHistograms(histograms, scale, quantizedHistograms);
+                }
+
+                // Extraction is timed separately since the cache hides it
+                int samples = min((int) train.images.size(), latencySamples);
+                Mat histogram;
+                chrono::steady_clock::time_point start = chrono::steady_clock::now();
+                for (int i = 0; i < samples; i++) {
+                    computeLbphHistogram(train.images[i], parameters, histogram);
+                }
+                chrono::duration<double> extractSeconds = chrono::steady_clock::now() - start;
+
+                vector<ProbeResult> results(probes.size());
+                vector<double> searchSeconds(probes.size());
+                WorkerPool::shared().run(probes.size(), [&](int i) {
+                    int probe = probes[i];
+                    const vector<int> &gallery = folds[probeFold[i]].gallery;
+                    chrono::steady_clock::time_point searchStart = chrono::steady_clock::now();
+                    int nearest = quantized 
+                            ? findNearestQuantizedHistogram(quantizedHistograms, gallery, 
+                                    quantizedHistograms.row(probe), scale, metric, 
+                                    results[i].distance)
+                            : findNearestHistogram(histograms, gallery, histograms[probe], 
+                                    results[i].distance);
+                    chrono::duration<double> seconds = chrono::steady_clock::now() - searchStart;
+                    searchSeconds[i] = seconds.count();
+                    results[i].label = train.labels[probe];
+                    results[i].predicted = nearest == -1 ? -1 : train.labels[nearest];
+                    results[i].impostor = impostor[i];
+                });
+                double latencySeconds = extractSeconds.count() / samples;
+                for (unsigned int i = 0; i < searchSeconds.size(); i++) {
+                    latencySeconds += searchSeconds[i] / searchSeconds.size();
+                }
+                size_t modelBytes = train.images.size() * histograms[0].total() 
+                        * (quantized ? sizeof(uchar) : sizeof(float));
+                size_t before = evaluations.size();
+                scoreThresholds(model, format("r=%d n=%d grid=%dx%d", parameters.radius, 
+                        parameters.neighbors, parameters.gridX, parameters.gridY), results, 
+                        thresholds, latencySeconds, modelBytes, evaluations);
+                for (size_t i = before; i < evaluations.size(); i++) {
+                    evaluations[i].lbphParameters = parameters;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Scores Eigenfaces or Fisherfaces, training one model per fold gallery in parallel. The 
+ * models keep the default threshold so every probe gets its nearest distance.
+ */
+static void crossValidateSubspace(const string &model, const FaceSet &train, 
+        const vector<Fold> &folds, const vector<double> &thresholds, 
+        vector<Evaluation> &evaluations) {
+    vector<vector<ProbeResult> > foldResults(folds.size());
+    vector<double> predictSeconds(folds.size());
+    vector<size_t> foldModelBytes(folds.size());
+    WorkerPool::shared().run(folds.size(), [&](int fold) {
+        vector<Mat> images;
+        vector<int> labels;
+        for (unsigned int i = 0; i < folds[fold].gallery.size(); i++) {
+            images.push_back(train.images[folds[fold].gallery[i]]);
+            labels.push_back(train.labels[folds[fold].gallery[i]]);
+        }
+        Ptr<face::BasicFaceRecognizer> recognizer = createSubspaceModel(model);
+        recognizer->train(images, labels);
+        foldModelBytes[fold] = getSubspaceModelBytes(recognizer);
+        vector<int> probes(folds[fold].probes);
+        probes.insert(probes.end(), folds[fold].impostors.begin(), folds[fold].impostors.end());
+        vector<ProbeResult> &results = foldResults[fold];
+        results.resize(probes.size());
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        for (unsigned int i = 0; i < probes.size(); i++) {
+            results[i].label = train.labels[probes[i]];
+            results[i].impostor = i >= folds[fold].probes.size();
+            recognizer->predict(train.images[probes[i]], results[i].predicted, 
+                    results[i].distance);
+        }
+        chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+        predictSeconds[fold] = seconds.count();
+    });
+    vector<ProbeResult> results;
+    double latencySeconds = 0;
+    size_t modelBytes = 0;
+    for (unsigned int fold = 0; fold < folds.size(); fold++) {
+        results.insert(results.end(), foldResults[fold].begin(), foldResults[fold].end());
+        latencySeconds += predictSeconds[fold];
+        modelBytes = max(modelBytes, foldModelBytes[fold]);
+    }
+    scoreThresholds(model, "default", results, thresholds, 
+            latencySeconds / max((int) results.size(), 1), modelBytes, evaluations);
+}
+
+/**
+ * Rescores an LBPH or quantized LBPH setting with every training face of the known subjects 
+ * as the gallery and the test faces as probes, those of unknownSubjects as impostors.
+ */
+static void testLbph(const FaceSet &train, const FaceSet &test, 
+        const vector<int> &unknownSubjects, LbphFeatureCache &cache, Evaluation &evaluation) {
+    const vector<Mat> &histograms = cache.getHistograms(evaluation.lbphParameters);
+    bool quantized = evaluation.model != "lbph";
+    QuantizedLbphRecognizer::Metric metric = getQuantizedMetric(evaluation.model);
+    float scale = 0;
+    Mat quantizedHistograms;
+    if (quantized) {
+        scale = findQuantizationScale(histograms);
+        quantizeHistograms(histograms, scale, quantizedHistograms);
+    }
+    vector<int> gallery;
+    for (unsigned int i = 0; i < train.images.size(); i++) {
+        if (!contains(unknownSubjects, train.labels[i])) {
+            gallery.push_back(i);
+        }
+    }
+    vector<ProbeResult> results(test.images.size());
+    vector<double> predictSeconds(test.images.size());
+    WorkerPool::shared().run(test.images.size(), [&](int i) {
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        Mat histogram;
+        computeLbphHistogram(test.images[i], evaluation.lbphParameters, histogram);
+        int nearest;
+        if (quantized) {
+            Mat query;
+            quantizeLbphHistogram(histogram, scale, query);
+            nearest = findNearestQuantizedHistogram(quantizedHistograms, gallery, query, scale, 
+                    metric, results[i].distance);
+        } else {
+            nearest = findNearestHistogram(histograms, gallery, histogram, results[i].distance);
+        }
+        chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+        predictSeconds[i] = seconds.count();
+        results[i].label = test.labels[i];
+        results[i].predicted = nearest == -1 ? -1 : train.labels[nearest];
+        results[i].impostor = contains(unknownSubjects, test.labels[i]);
+    });
+    copyScores(score(results, evaluation.threshold), evaluation);
+    evaluation.latencySeconds = 0;
+    for (unsigned int i = 0; i < predictSeconds.size(); i++) {
+        evaluation.latencySeconds += predictSeconds[i] / predictSeconds.size();
+    }
+}
+
+/**
+ * Rescores Eigenfaces or Fisherfaces trained on every training face of the known subjects 
+ * against the test faces, those of unknownSubjects as impostors.
+ */
+static void testSubspace(const FaceSet &train, const FaceSet &test, 
+        const vector<int> &unknownSubjects, Evaluation &evaluation) {
+    vector<Mat> images;
+    vector<int> labels;
+    for (unsigned int i = 0; i < train.images.size(); i++) {
+        if (!contains(unknownSubjects, train.labels[i])) {
+            images.push_back(train.images[i]);
+            labels.push_back(train.labels[i]);
+        }
+    }
+    Ptr<face::BasicFaceRecognizer> recognizer = createSubspaceModel(evaluation.model);
+    recognizer->train(images, labels);
+    evaluation.modelBytes = getSubspaceModelBytes(recognizer);
+    vector<ProbeResult> results(test.images.size());
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    for (unsigned int i = 0; i < test.images.size(); i++) {
+        results[i].label = test.labels[i];
+        results[i].impostor = contains(unknownSubjects, test.labels[i]);
+        recognizer->predict(test.images[i], results[i].predicted, results[i].distance);
+    }
+    chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+    copyScores(score(results, evaluation.threshold), evaluation);
+    evaluation.latencySeconds = seconds.count() / test.images.size();
+}
+
+static Ptr<face::BasicFaceRecognizer> createSubspaceModel(const string &model) {
+    if (model == "eigen") {
+        return face::createEigenFaceRecognizer();
+    }
+    return face::createFisherFaceRecognizer();
+}
+
+/**
+ * Size of the mean, eigenvectors and projected training faces a subspace model keeps.
+ */
+static size_t getSubspaceModelBytes(const Ptr<face::BasicFaceRecognizer> &recognizer) {
+    Mat mean = recognizer->getMean();
+    Mat eigenvectors = recognizer->getEigenVectors();
+    vector<Mat> projections = recognizer->getProjections();
+    size_t bytes = mean.total() * mean.elemSize() + eigenvectors.total() * eigenvectors.elemSize();
+    for (unsigned int i = 0; i < projections.size(); i++) {
+        bytes += projections[i].total() * projections[i].elemSize();
+    }
+    return bytes;
+}
+
+static bool isLbphModel(const string &model) {
+    return model == "lbph" || model == "qlbph" || model == "qlbph-l1";
+}
+
+static QuantizedLbphRecognizer::Metric getQuantizedMetric(const string &model) {
+    return model == "qlbph-l1" 
+            ? QuantizedLbphRecognizer::INTERSECTION : QuantizedLbphRecognizer::CHI_SQUARE;
+}
+
+/**
+ * Quantizes each histogram into one row of quantized.
+ */
+static void quantizeHistograms(const vector<Mat> &histograms, float scale, Mat &quantized) {
+    quantized.create((int) histograms.size(), (int) histograms[0].total(), CV_8UC1);
+    for (unsigned int i = 0; i < histograms.size(); i++) {
+        Mat row = quantized.row(i);
+        quantizeLbphHistogram(histograms[i], scale, row);
+    }
+}
+
+/**
+ * Adds the evaluation of results at each threshold to evaluations.
+ */
+static void scoreThresholds(const string &model, const string &parameters, 
+        const vector<ProbeResult> &results, const vector<double> &thresholds, 
+        double latencySeconds, size_t modelBytes, vector<Evaluation> &evaluations) {
+    for (unsigned int i = 0; i < thresholds.size(); i++) {
+        Evaluation evaluation = score(results, thresholds[i]);
+        evaluation.model = model;
+        evaluation.parameters = parameters;
+        evaluation.latencySeconds = latencySeconds;
+        evaluation.modelBytes = modelBytes;
+        evaluations.push_back(evaluation);
+    }
+}
+
+/**
+ * Counts the genuine probes accepted with the right label, accepted with the wrong one, and 
+ * rejected, and the impostor probes accepted as anyone, when matches must be closer than 
+ * threshold, as the recognizers decide.
+ */
+static Evaluation score(const vector<ProbeResult> &results, double threshold) {
+    Evaluation evaluation;
+    evaluation.threshold = threshold;
+    evaluation.genuineProbes = 0;
+    evaluation.impostorProbes = 0;
+    evaluation.correct = 0;
+    evaluation.misidentified = 0;
+    evaluation.falseRejects = 0;
+    evaluation.falseAccepts = 0;
+    evaluation.latencySeconds = 0;
+    evaluation.modelBytes = 0;
+    for (unsigned int i = 0; i < results.size(); i++) {
+        bool accepted = results[i].predicted != -1 && results[i].distance < threshold;
+        if (results[i].impostor) {
+            evaluation.impostorProbes++;
+            if (accepted) {
+                evaluation.falseAccepts++;
+            }
+        } else {
+            evaluation.genuineProbes++;
+            if (!accepted) {
+                evaluation.falseRejects++;
+            } else if (results[i].predicted == results[i].label) {
+                evaluation.correct++;
+            } else {
+                evaluation.misidentified++;
+            }
+        }
+    }
+    return evaluation;
+}
+
+static void copyScores(const Evaluation &scored, Evaluation &evaluation) {
+    evaluation.genuineProbes = scored.genuineProbes;
+    evaluation.impostorProbes = scored.impostorProbes;
+    evaluation.correct = scored.correct;
+    evaluation.misidentified = scored.misidentified;
+    evaluation.falseRejects = scored.falseRejects;
+    evaluation.falseAccepts = scored.falseAccepts;
+}
+
+/**
+ * The share of genuine probes not accepted with the right label plus the share of impostors
+ * accepted, weighting the two kinds of error equally however many probes each has.
+ */
+static double getTradeOffError(const Evaluation &evaluation) {
+    double genuineError = evaluation.genuineProbes == 0 ? 0.0 
+            : 1.0 - evaluation.correct / (double) evaluation.genuineProbes;
+    double falseAcceptRate = evaluation.impostorProbes == 0 ? 0.0 
+            : evaluation.falseAccepts / (double) evaluation.impostorProbes;
+    return genuineError + falseAcceptRate;
+}
+
+/**
+ * Prints one row of the results table. The false accept rate is "-" without impostors.
+ */
+static void printEvaluation(const Evaluation &evaluation, ostream &out) {
+    double genuine = max(evaluation.genuineProbes, 1);
+    string falseAcceptRate = evaluation.impostorProbes == 0 ? "-" 
+            : format("%.1f%%", 100.0 * evaluation.falseAccepts / evaluation.impostorProbes);
+    out << format("%-8s %-24s %10g %8.1f%% %6.1f%% %6.1f%% %7s %11.3f %9.1f", 
+            evaluation.model.c_str(), evaluation.parameters.c_str(), evaluation.threshold, 
+            100.0 * evaluation.correct / genuine, 100.0 * evaluation.misidentified / genuine,
+            100.0 * evaluation.falseRejects / genuine, falseAcceptRate.c_str(), 
+            evaluation.latencySeconds * 1e3, evaluation.modelBytes / 1024.0) << endl;
+}
+
+/**
+ * Replaces list with the comma separated values in value. Returns false if there are none.
+ */
+template <typename T> static bool parseList(const string &value, vector<T> &list) {
+    list.clear();
+    stringstream values(value);
+    string item;
+    while (getline(values, item, ',')) {
+        stringstream itemStream(item);
+        T parsed;
+        if (itemStream >> parsed) {
+            list.push_back(parsed);
+        }
+    }
+    return !list.empty();
+}
@@ -0,0 +1,398 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "dataset_loader.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const char PACKED_MAGIC[8] = {'L', 'G', 'T', 'M', 'D', 'S', '0', '3'};
+static const char separator = ';';
+// augment_data's output, which would be augmented a second time
+static const string rotatedFileMarker = "--rotated--";
+// Samples generated at once while writing the packed cache
+static const int packBatchSize = 256;
+// Longest --prefix a packed cache header is trusted to hold
+static const uint32_t maxPackedPrefixLength = 4096;
+
+//~Function Headers---------------------------------------------------------------------------------
+template <typename T> static void writeValue(ofstream &out, T value);
+template <typename T> static bool readValue(ifstream &in, T &value);
+
+//~Functions----------------------------------------------------------------------------------------
+DatasetOptions::DatasetOptions() 
+        : augment(false), interpolation(INTER_LANCZOS4) {
+}
+
+Dataset::Dataset() 
+        : variantsPerSource(1), fromCache(false), augmented(false), 
+        interpolation(INTER_LANCZOS4), csvSize(0), csvModifiedTime(0), packedFd(-1) {
+}
+
+Dataset::~Dataset() {
+    closePacked();
+}
+
+/**
+ * Loads the dataset listed in the csv file, from the packed cache if options names an up to 
+ * date one. Writes the cache if it was missing or stale. Returns false if no samples loaded.
+ */
+bool Dataset::load(const string &csvFileName, const DatasetOptions &options) {
+    struct stat csvStat;
+    if (stat(csvFileName.c_str(), &csvStat) != 0) {
+        cerr << "No valid input file was given, please check the given fileName: " 
+                << csvFileName << endl;
+        return false;
+    }
+    csvSize = csvStat.st_size;
+    csvModifiedTime = csvStat.st_mtime;
+    augmented = options.augment;
+    interpolation = options.interpolation;
+    sampleSize = options.sampleSize;
+    filePrefix = options.filePrefix;
+    sources.clear();
+    sourceLabels.clear();
+    sourceMatrices.clear();
+    closePacked();
+
+    if (!options.cachePath.empty() && readPacked(options.cachePath)) {
+        cout << "Indexed " << packedSamples.size() << " samples in " << options.cachePath 
+                << endl;
+        fromCache = true;
+        return true;
+    }
+    fromCache = false;
+    if (!readCsv(csvFileName, filePrefix)) {
+        return false;
+    }
+    variantsPerSource = augmented ? 1 + transforms.getRotations().size() : 1;
+    for (unsigned int i = 0; i < sources.size(); i++) {
+        sourceMatrices.push_back(augmented 
+                ? &transforms.getMatrices(sources[i].size(), sampleSize) : NULL);
+    }
+    if (!options.cachePath.empty() && !writePacked(options.cachePath)) {
+        cerr << "Could not write the dataset cache to " << options.cachePath << endl;
+    }
+    return true;
+}
+
+/**
+ * Writes every sample to path in the packed format, generating augmented samples a batch 
+ * at a time. The file is written next to path and renamed into place once complete.
+ */
+bool Dataset::writePacked(const string &path) {
+    string tempPath = path + ".tmp";
+    ofstream out(tempPath.c_str(), ios::binary | ios::trunc);
+    if (!out) {
+        return false;
+    }
+    out.write(PACKED_MAGIC, sizeof(PACKED_MAGIC));
+    writeValue(out, csvSize);
+    writeValue(out, csvModifiedTime);
+    writeValue(out, (uint32_t) (augmented ? 1 : 0));
+    writeValue(out, (int32_t) interpolation);
+    writeValue(out, (int32_t) sampleSize.width);
+    writeValue(out, (int32_t) sampleSize.height);
+    writeValue(out, (uint32_t) filePrefix.size());
+    out.write(filePrefix.data(), filePrefix.size());
+    writeValue(out, (uint32_t) size());
+
+    vector<Mat> samples;
+    vector<int> labels;
+    for (int start = 0; start < size(); start += packBatchSize) {
+        getBatch(start, min(packBatchSize, size() - start), samples, labels);
+        for (unsigned int i = 0; i < samples.size(); i++) {
+            Mat sample = samples[i].isContinuous() ? samples[i] : samples[i].clone();
+            writeValue(out, (int32_t) labels[i]);
+            writeValue(out, (int32_t) sample.rows);
+            writeValue(out, (int32_t) sample.cols);
+            writeValue(out, (int32_t) sample.type());
+            out.write((const char *) sample.data, sample.total() * sample.elemSize());
+        }
+    }
+    out.close();
+    if (!out || rename(tempPath.c_str(), path.c_str()) != 0) {
+        remove(tempPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Total number of samples, including augmented variants.
+ */
+int Dataset::size() const {
+    return sourceLabels.size() * variantsPerSource;
+}
+
+/**
+ * Number of decoded images the samples are generated from.
+ */
+int Dataset::getSourceCount() const {
+    return sourceLabels.size();
+}
+
+int Dataset::getLabel(int index) const {
+    return sourceLabels[index / variantsPerSource];
+}
+
+/**
+ * True if the samples were read from the packed cache rather than decoded.
+ */
+bool Dataset::isFromCache() const {
+    return fromCache;
+}
+
+/**
+ * Stores sample index in sample, reading it from the packed cache or warping it from its 
+ * source image if it is an augmented variant. Samples that need no work share their data with
+ * the dataset. Safe to call from several threads with different samples.
+ */
+void Dataset::getSample(int index, Mat &sample) const {
+    if (fromCache) {
+        const PackedSample &packed = packedSamples[index];
+        // sample may share a source's data from an earlier call, never read into that
+        sample.release();
+        sample.create(packed.rows, packed.cols, packed.type);
+        size_t length = sample.total() * sample.elemSize();
+        if (pread(packedFd, sample.data, length, packed.offset) != (ssize_t) length) {
+            cerr << "Error reading sample " << index << " from the dataset cache" << endl;
+            sample.release();
+        }
+        return;
+    }
+    const Mat &source = sources[index / variantsPerSource];
+    int variant = index % variantsPerSource;
+    if (variant == 0 && (sampleSize.area() == 0 || source.size() == sampleSize)) {
+        sample = source;
+        return;
+    }
+    // sample may still share a source's data from an earlier call, never write into that
+    sample.release();
+    if (variant == 0) {
+        resize(source, sample, sampleSize, 0, 0, INTER_AREA);
+        return;
+    }
+    applyAugmentation(source, sample, (*sourceMatrices[index / variantsPerSource])[variant - 1], 
+            interpolation, sampleSize);
+}
+
+/**
+ * Generates samples [start, start + count) in parallel on the shared worker pool.
+ */
+void Dataset::getBatch(int start, int count, vector<Mat> &samples, vector<int> &labels) const {
+    samples.resize(count);
+    labels.resize(count);
+    WorkerPool::shared().run(count, [&](int i) {
+        getSample(start + i, samples[i]);
+        labels[i] = getLabel(start + i);
+    });
+}
+
+/**
+ * Decodes the grayscale images listed in the csv file in parallel, in file order.
+ */
+bool Dataset::readCsv(const string &csvFileName, const string &filePrefix) {
+    std::ifstream file(csvFileName.c_str(), ifstream::in);
+    if (!file) {
+        cerr << "No valid input file was given, please check the given fileName: " 
+                << csvFileName << endl;
+        return false;
+    }
+    vector<string> paths;
+    vector<int> labels;
+    string line, path, classlabel;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        getline(liness, classlabel);
+        // If we have a prefix specified and it wasn't found then ignore this sample
+        if (!filePrefix.empty() && path.find(filePrefix) == string::npos) {
+            continue;
+        }
+        // Rotations are generated in memory, skip any augment_data left on disk
+        if (augmented && path.find(rotatedFileMarker) != string::npos) {
+            continue;
+        }
+        if (!path.empty() && !classlabel.empty()) {
+            paths.push_back(path);
+            labels.push_back(atoi(classlabel.c_str()));
+        }
+    }
+
+    vector<Mat> decoded(paths.size());
+    WorkerPool::shared().run(paths.size(), [&](int i) {
+        decoded[i] = imread(paths[i], 0);
+    });
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        if (decoded[i].empty()) {
+            cerr << "Error opening image file at path: \"" << paths[i] << endl;
+            continue;
+        }
+        sources.push_back(decoded[i]);
+        sourceLabels.push_back(labels[i]);
+    }
+    return !sources.empty();
+}
+
+/**
+ * Opens the packed cache at path and indexes its samples, reading only their labels and 
+ * sizes. Returns false, leaving the dataset empty, if the cache is missing, corrupt, or was 
+ * built from a different csv file or with different options.
+ */
+bool Dataset::readPacked(const string &path) {
+    ifstream in(path.c_str(), ios::binary);
+    if (!in) {
+        return false;
+    }
+    char magic[sizeof(PACKED_MAGIC)];
+    int64_t packedCsvSize, packedCsvModifiedTime;
+    uint32_t packedAugmented, prefixLength, count;
+    int32_t packedInterpolation, packedWidth, packedHeight;
+    if (!in.read(magic, sizeof(magic)) || memcmp(magic, PACKED_MAGIC, sizeof(magic)) != 0
+            || !readValue(in, packedCsvSize) || !readValue(in, packedCsvModifiedTime)
+            || !readValue(in, packedAugmented) || !readValue(in, packedInterpolation)
+            || !readValue(in, packedWidth) || !readValue(in, packedHeight)
+            || !readValue(in, prefixLength) || prefixLength > maxPackedPrefixLength) {
+        return false;
+    }
+    string packedPrefix(prefixLength, '\0');
+    if (!in.read(&packedPrefix[0], prefixLength) || !readValue(in, count)) {
+        return false;
+    }
+    if (packedCsvSize != csvSize || packedCsvModifiedTime != csvModifiedTime 
+            || (packedAugmented != 0) != augmented || packedInterpolation != interpolation
+            || packedWidth != sampleSize.width || packedHeight != sampleSize.height
+            || packedPrefix != filePrefix) {
+        cout << "Dataset cache " << path << " is out of date, rebuilding it" << endl;
+        return false;
+    }
+    packedSamples.resize(count);
+    sourceLabels.resize(count);
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t label, rows, cols, type;
+        if (!readValue(in, label) || !readValue(in, rows) || !readValue(in, cols) 
+                || !readValue(in, type) || rows <= 0 || cols <= 0) {
+            packedSamples.clear();
+            sourceLabels.clear();
+            return false;
+        }
+        PackedSample &packed = packedSamples[i];
+        packed.offset = in.tellg();
+        packed.rows = rows;
+        packed.cols = cols;
+        packed.type = type;
+        sourceLabels[i] = label;
+        // Skip the pixels, they are read when the sample is asked for
+        in.seekg((int64_t) rows * cols * CV_ELEM_SIZE(type), ios::cur);
+    }
+    // Seeking past the end succeeds, a truncated cache is one shorter than its last sample
+    streampos indexedEnd = in.tellg();
+    in.seekg(0, ios::end);
+    bool complete = in && in.tellg() >= indexedEnd;
+    packedFd = complete ? open(path.c_str(), O_RDONLY | O_CLOEXEC) : -1;
+    if (packedFd == -1) {
+        packedSamples.clear();
+        sourceLabels.clear();
+        return false;
+    }
+    // Samples were augmented and sized when the cache was written
+    variantsPerSource = 1;
+    sampleSize = Size();
+    sourceMatrices.assign(count, NULL);
+    return true;
+}
+
+void Dataset::closePacked() {
+    if (packedFd != -1) {
+        close(packedFd);
+        packedFd = -1;
+    }
+    packedSamples.clear();
+}
+
+/**
+ * Pulls "--augment", "--cache=<path>", "--prefix=<text>", "--interpolation=<name>", and 
+ * "--sample-size=<n>" out of the command line into options and returns the remaining 
+ * arguments (including argv[0]).
+ */
+vector<string> parseDatasetOptions(int argc, const char *argv[], DatasetOptions &options,
+        vector<string> *otherOptions) {
+    vector<string> positionalArguments;
+    for (int i = 0; i < argc; i++) {
+        string argument(argv[i]);
+        if (argument.compare(0, 2, "--") != 0) {
+            positionalArguments.push_back(argument);
+            continue;
+        }
+        size_t equalsPos = argument.find('=');
+        string name = argument.substr(2, equalsPos == string::npos ? string::npos : equalsPos - 2);
+        string value = equalsPos == string::npos ? "" : argument.substr(equalsPos + 1);
+        if (name == "augment") {
+            options.augment = true;
+        } else if (name == "cache") {
+            options.cachePath = value;
+        } else if (name == "prefix") {
+            options.filePrefix = value;
+        } else if (name == "interpolation" && parseInterpolation(value) != -1) {
+            options.interpolation = parseInterpolation(value);
+        } else if (name == "sample-size") {
+            int side = atoi(value.c_str());
+            options.sampleSize = Size(side, side);
+        } else if (otherOptions != NULL) {
+            otherOptions->push_back(argument);
+        } else {
+            cerr << "Ignoring unrecognized option: " << argument << endl;
+        }
+    }
+    return positionalArguments;
+}
+
+void printDatasetUsage() {
+    cout << "\t --augment -- Add rotated copies of every image, generated in memory." << endl;
+    cout << "\t --cache=<path> -- Load the dataset from a packed binary cache, building it " 
+            << "if it is missing or out of date." << endl;
+    cout << "\t --prefix=<text> -- Only use images whose path contains text." << endl;
+    cout << "\t --interpolation=<linear|cubic|lanczos> -- How rotations are warped." << endl;
+    cout << "\t --sample-size=<n> -- Warp or resize every sample straight to n x n." << endl;
+}
+
+template <typename T> static void writeValue(ofstream &out, T value) {
+    out.write((const char *) &value, sizeof(value));
+}
+
+template <typename T> static bool readValue(ifstream &in, T &value) {
+    return (bool) in.read((char *) &value, sizeof(value));
+}
@@ -0,0 +1,127 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef DATASET_LOADER_HPP_
+#define DATASET_LOADER_HPP_
+
+#include "../augment-data/augmentation.hpp"
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * How a Dataset is built from its csv file, parsed from "--name=value" command line flags by
+ * parseDatasetOptions.
+ */
+struct DatasetOptions {
+    // Add the augment_data rotations of every source image, generated in memory
+    bool augment;
+    // Packed binary copy of the whole (augmented) dataset, read instead of the csv's images 
+    // when it is up to date and written after loading otherwise. Empty for no cache.
+    std::string cachePath;
+    // Only load images whose path contains this
+    std::string filePrefix;
+    // Interpolation used to warp the rotations
+    int interpolation;
+    // Size every sample is warped or resized to in one step, empty to keep the source size
+    cv::Size sampleSize;
+
+    DatasetOptions();
+};
+
+/**
+ * The grayscale training images and labels listed in a csv file.
+ *
+ * Source images are decoded once. With augmentation on, each source also stands for one
+ * rotated variant per augmentation rotation, and those are only warped when a sample is asked
+ * for, so the rotated images never hit the disk. Samples are numbered source by source, the 
+ * source itself first and then its rotations.
+ *
+ * The packed cache holds every sample raw, so a cached dataset is loaded with no decoding or
+ * warping at all. Loading only indexes it, samples are read from the file as they are asked 
+ * for, so training streams it a batch at a time. It stores the csv file's size and 
+ * modification time and is rebuilt when they (or the prefix or augmentation options) change. 
+ * It uses the machine's byte order and is not portable.
+ */
+class Dataset {
+public:
+    Dataset();
+    ~Dataset();
+
+    bool load(const std::string &csvFileName, const DatasetOptions &options);
+    bool writePacked(const std::string &path);
+
+    int size() const;
+    int getSourceCount() const;
+    int getLabel(int index) const;
+    bool isFromCache() const;
+    void getSample(int index, cv::Mat &sample) const;
+    void getBatch(int start, int count, std::vector<cv::Mat> &samples, 
+            std::vector<int> &labels) const;
+
+private:
+    // Where one sample's pixels are in the packed cache
+    struct PackedSample {
+        int64_t offset;
+        int rows;
+        int cols;
+        int type;
+    };
+
+    AugmentationTransforms transforms;
+    std::vector<cv::Mat> sources;
+    std::vector<int> sourceLabels;
+    // The rotation matrices for each source's size, looked up once so getSample need not lock
+    std::vector<const std::vector<cv::Mat> *> sourceMatrices;
+    int variantsPerSource;
+    bool fromCache;
+    bool augmented;
+    int interpolation;
+    cv::Size sampleSize;
+    int64_t csvSize;
+    int64_t csvModifiedTime;
+    std::string filePrefix;
+    // The open packed cache and its index, when loaded from the cache
+    int packedFd;
+    std::vector<PackedSample> packedSamples;
+
+    Dataset(const Dataset &);
+    Dataset &operator=(const Dataset &);
+
+    void closePacked();
+    bool readCsv(const std::string &csvFileName, const std::string &filePrefix);
+    bool readPacked(const std::string &path);
+};
+
+std::vector<std::string> parseDatasetOptions(int argc, const char *argv[], 
+        DatasetOptions &options, std::vector<std::string> *otherOptions = NULL);
+void printDatasetUsage();
+
+#endif
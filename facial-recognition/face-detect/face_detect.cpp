@@ -30,9 +30,19 @@
  * accept or reject each crop.
  * Save the accepted files.
  *
+ * cropImagesToFacesBatch does the same without a window: every image is cropped to its largest
+ * face in parallel, the crops are saved to a separate directory, and a review list takes the
+ * place of the key presses.
+ *
  * This code was adapted from OpenCV tutorials found at:
  */
 #include "face_detect.hpp"
+#include "../worker-pool/worker_pool.hpp"
+
+#include <sys/stat.h>
+
+#include <map>
+#include <set>
 
 using namespace std;
 using namespace cv;
@@ -46,6 +56,9 @@ static string windowName = "Capture - Face detection";
 
 // Private function headers
 static Mat detectAndDisplay(Mat frame);
+static map<string, bool> readReviewList(const string &reviewListFileName);
+static string getFileName(const string &path);
+static string getUniqueFileName(const string &fileName, set<string> &usedFileNames);
 
 void cropImagesToFaces(string csvFileName) {
     // Load the cascade
@@ -107,16 +120,110 @@ void cropImagesToFaces(string csvFileName) {
     }
 }
 
+/**
+ * Crops every image listed in the csv file to its largest face without asking the user, on all
+ * cores, and saves the crops under outputDirectory with the source's file name. Sources that 
+ * share a file name, e.g. from different subject directories, get a numbered suffix instead of
+ * overwriting each other. The source images are left alone. outputDirectory/manifest.csv 
+ * lists each saved crop and its label in the same "path;label" format as the input, ready for 
+ * training.
+ *
+ * The optional review list has one "path;accept" or "path;reject" line per image whose 
+ * automatic crop was checked by hand (a bare path means reject). Rejected images are not 
+ * saved, images not in the list are accepted.
+ * Returns the number of crops saved, or -1 if the cascade or csv file could not be read.
+ */
+int cropImagesToFacesBatch(string csvFileName, string outputDirectory, 
+        string reviewListFileName) {
+    // Fail early if the cascade is missing, the workers load their own copies
+    CascadeClassifier cascade;
+    if (!cascade.load(faceCascadefileName)) {
+        printf("--(!)Error loading\n");
+        return -1;
+    }
+    std::ifstream file(csvFileName.c_str(), ifstream::in);
+    if (!file) {
+        printf("No valid input file was given, please check the given fileName.\n");
+        return -1;
+    }
+    map<string, bool> review = readReviewList(reviewListFileName);
+    mkdir(outputDirectory.c_str(), 0755);
+
+    vector<string> paths;
+    vector<string> labels;
+    string line, path, label;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        getline(liness, label);
+        map<string, bool>::const_iterator reviewed = review.find(path);
+        if (path.empty() || (reviewed != review.end() && !reviewed->second)) {
+            continue;
+        }
+        paths.push_back(path);
+        labels.push_back(label);
+    }
+
+    // Name every crop up front, the workers run in no particular order
+    vector<string> cropPaths(paths.size());
+    set<string> usedFileNames;
+    usedFileNames.insert("manifest.csv");
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        string fileName = getUniqueFileName(getFileName(paths[i]), usedFileNames);
+        if (fileName != getFileName(paths[i])) {
+            printf("%s shares its file name with an earlier image, saving it as %s\n", 
+                    paths[i].c_str(), fileName.c_str());
+        }
+        cropPaths[i] = outputDirectory + "/" + fileName;
+    }
+
+    // CascadeClassifier is not safe to share between threads, each one loads its own copy
+    // Flags rather than vector<bool>, whose packed bits cannot be written from several threads
+    vector<char> saved(paths.size(), 0);
+    WorkerPool::shared().run(paths.size(), [&](int i) {
+        static thread_local CascadeClassifier threadCascade;
+        if (threadCascade.empty() && !threadCascade.load(faceCascadefileName)) {
+            return;
+        }
+        Mat frame = imread(paths[i]);
+        if (frame.empty()) {
+            printf(" --(!) Could not read %s\n", paths[i].c_str());
+            return;
+        }
+        Mat frame_gray;
+        cvtColor(frame, frame_gray, COLOR_BGR2GRAY);
+        equalizeHist(frame_gray, frame_gray);
+        std::vector<Rect> faces;
+        threadCascade.detectMultiScale(frame_gray, faces, 1.1, 2, 0 | CASCADE_SCALE_IMAGE, 
+                Size(30, 30));
+        int largest = findLargestFace(faces);
+        if (largest == -1) {
+            printf("No face found in %s\n", paths[i].c_str());
+            return;
+        }
+        saved[i] = imwrite(cropPaths[i], frame(faces[largest]));
+    });
+
+    // Written in csv order once every crop is done
+    string manifestFileName = outputDirectory + "/manifest.csv";
+    std::ofstream manifest(manifestFileName.c_str());
+    int savedCount = 0;
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        if (saved[i]) {
+            manifest << cropPaths[i] << separator << labels[i] << "\n";
+            savedCount++;
+        }
+    }
+    printf("Saved %d of %d crops to %s, manifest in %s\n", savedCount, (int) paths.size(), 
+            outputDirectory.c_str(), manifestFileName.c_str());
+    return savedCount;
+}
+
 // Function detectAndDisplay
 static Mat detectAndDisplay(Mat frame) {
     std::vector<Rect> faces;
     Mat frame_gray;
     Mat crop;
-    Mat res;
-    Mat gray;
-    string text;
-    stringstream sstm;
-    string fileName;
 
     cvtColor(frame, frame_gray, COLOR_BGR2GRAY);
     equalizeHist(frame_gray, frame_gray);
@@ -124,75 +231,12 @@ static Mat detectAndDisplay(Mat frame) {
     // Detect faces
     faceCascade.detectMultiScale(frame_gray, faces, 1.1, 2, 0 | CASCADE_SCALE_IMAGE, Size(30, 30));
 
-    // Set Region of Interest
-    cv::Rect roi_b;
-    cv::Rect roi_c;
-
-    // ic is index of current element
-    size_t ic = 0;
-    // ac is area of current element
-    int ac = 0; 
-
-    // ib is index of biggest element
-    size_t ib = 0; 
-    // ab is area of biggest element
-    int ab = 0; 
-
-    int numFiles;
-    // Iterate through all current elements (detected faces)
-    for (ic = 0; ic < faces.size(); ic++) {
-        roi_c.x = faces[ic].x;
-        roi_c.y = faces[ic].y;
-        roi_c.width = (faces[ic].width);
-        roi_c.height = (faces[ic].height);
-
-        // Get the area of current element (detected face)
-        ac = roi_c.width * roi_c.height; 
-
-        roi_b.x = faces[ib].x;
-        roi_b.y = faces[ib].y;
-        roi_b.width = (faces[ib].width);
-        roi_b.height = (faces[ib].height);
-
-        // Get the area of biggest element, at beginning it is same as "current" element
-        ab = roi_b.width * roi_b.height; 
-
-        if (ac > ab) {
-            ib = ic;
-            roi_b.x = faces[ib].x;
-            roi_b.y = faces[ib].y;
-            roi_b.width = (faces[ib].width);
-            roi_b.height = (faces[ib].height);
-        }
-
-        crop = frame(roi_b);
-
-        // This will be needed later while saving images
-        resize(crop, res, Size(128, 128), 0, 0, INTER_LINEAR); 
-        // Convert cropped image to Grayscale
-        cvtColor(crop, gray, CV_BGR2GRAY); 
-
-        // Form a fileName
-        fileName = "";
-        stringstream ssfn;
-        ssfn << numFiles << ".png";
-        fileName = ssfn.str();
-        numFiles++;
-
-        imwrite(fileName, gray);
-
-        // Display detected faces on main window - live stream from camera
-        //Point pt1(faces[ic].x, faces[ic].y); 
-        //Point pt2((faces[ic].x + faces[ic].height), (faces[ic].y + faces[ic].width));
-        //rectangle(frame, pt1, pt2, Scalar(0, 255, 0), 2, 8, 0);
+    // Crop to the biggest detected face
+    int largest = findLargestFace(faces);
+    if (largest != -1) {
+        crop = frame(faces[largest]);
     }
 
-    // Show image
-    //sstm << "Crop area size: " << roi_b.width << "x" << roi_b.height << " fileName: " << fileName;
-    //text = sstm.str();
-
-    //putText(frame, text, cvPoint(30, 30), FONT_HERSHEY_COMPLEX_SMALL, 0.8, cvScalar(0, 0, 255), 
-    //        1, CV_AA);
     imshow("original", frame);
 
     if (!crop.empty()) {
@@ -204,3 +248,63 @@ static Mat detectAndDisplay(Mat frame) {
 
     return crop;
 }
+
+/**
+ * Index of the face with the largest area, or -1 if there are none.
+ */
+int findLargestFace(const vector<Rect> &faces) {
+    int largest = -1;
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        if (largest == -1 || faces[i].area() > faces[largest].area()) {
+            largest = i;
+        }
+    }
+    return largest;
+}
+
+/**
+ * Reads "path;accept" and "path;reject" lines into a map from path to whether it was accepted.
+ */
+static map<string, bool> readReviewList(const string &reviewListFileName) {
+    map<string, bool> review;
+    if (reviewListFileName.empty()) {
+        return review;
+    }
+    std::ifstream file(reviewListFileName.c_str(), ifstream::in);
+    if (!file) {
+        printf("Could not read the review list %s\n", reviewListFileName.c_str());
+        return review;
+    }
+    string line, path, decision;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        decision.clear();
+        getline(liness, decision);
+        if (!path.empty()) {
+            review[path] = decision == "accept";
+        }
+    }
+    return review;
+}
+
+static string getFileName(const string &path) {
+    size_t slashPos = path.find_last_of('/');
+    return slashPos == string::npos ? path : path.substr(slashPos + 1);
+}
+
+/**
+ * Returns fileName, or fileName with "_2", "_3", ... inserted before its extension if that is 
+ * already in usedFileNames, and adds the returned name to usedFileNames.
+ */
+static string getUniqueFileName(const string &fileName, set<string> &usedFileNames) {
+    size_t dotPos = fileName.find_last_of('.');
+    string stem = dotPos == string::npos ? fileName : fileName.substr(0, dotPos);
+    string extension = dotPos == string::npos ? "" : fileName.substr(dotPos);
+    string uniqueFileName = fileName;
+    for (int n = 2; usedFileNames.count(uniqueFileName) != 0; n++) {
+        uniqueFileName = stem + "_" + to_string(n) + extension;
+    }
+    usedFileNames.insert(uniqueFileName);
+    return uniqueFileName;
+}
@@ -35,5 +35,8 @@
 
 // Function Headers
 void cropImagesToFaces(std::string csvFileName);
+int cropImagesToFacesBatch(std::string csvFileName, std::string outputDirectory, 
+        std::string reviewListFileName = "");
+int findLargestFace(const std::vector<cv::Rect> &faces);
 
 #endif
\ No newline at end of file
@@ -24,8 +24,25 @@
 #include "face_detect.hpp"
 
 // Function main
-int main(void) {
+// Usage: face_detect [csv file] [--batch=<output directory>] [--review=<review list>]
+// Without --batch every crop is shown and accepted or rejected with a key press.
+int main(int argc, const char *argv[]) {
     std::string csvFileName = "yalefaces.csv";
+    std::string outputDirectory;
+    std::string reviewListFileName;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (argument.compare(0, 8, "--batch=") == 0) {
+            outputDirectory = argument.substr(8);
+        } else if (argument.compare(0, 9, "--review=") == 0) {
+            reviewListFileName = argument.substr(9);
+        } else {
+            csvFileName = argument;
+        }
+    }
+    if (!outputDirectory.empty()) {
+        return cropImagesToFacesBatch(csvFileName, outputDirectory, reviewListFileName) < 0;
+    }
     cropImagesToFaces(csvFileName);
     return 0;
-}
\ No newline at end of file
+}
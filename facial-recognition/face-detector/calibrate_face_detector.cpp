@@ -0,0 +1,223 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Reports the recall/latency trade-off of each face detector profile on a face database or on
+ * frames from a video file, image directory or camera.
+ *
+ * Every image listed in the csv file, or every frame, is expected to hold exactly one face, as 
+ * in the bundled yalefaces sets or a recording of one user. Each profile, the baseline 
+ * included, is run over every image, with the Haar cascade and with the LBP cascade when one 
+ * is given, and the share of images with a face found, the number of extra detections, and the
+ * detection latency percentiles are printed as a table. The profiles differ mostly in how far
+ * they downscale, so only camera-sized frames show their real trade-off.
+ */
+#include "face_detector.hpp"
+#include "../frame-source/frame_source.hpp"
+#include "../stage-timing/stage_timing.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const char *PROFILES[] = {"baseline", "fast", "balanced", "accurate"};
+// Frames read from a source when --max-frames is not given
+static const long DEFAULT_SOURCE_FRAMES = 300;
+// The smallest detection width of any profile, narrower frames are never downscaled
+static const int MIN_DETECTION_WIDTH = 320;
+
+//~Function Headers---------------------------------------------------------------------------------
+static void readImages(const string &fileName, vector<Mat> &images, char separator=';');
+static bool readFrames(const string &spec, const FrameSourceOptions &sourceOptions, 
+        vector<Mat> &images);
+static bool endsWith(const string &value, const string &suffix);
+static void calibrate(const string &cascadeName, const string &cascadePath, 
+        const FaceDetectorConfig &baseConfig, const vector<Mat> &images);
+
+//~Functions----------------------------------------------------------------------------------------
+int main(int argc, const char *argv[]) {
+    FrameSourceOptions sourceOptions;
+    vector<string> detectorOptions;
+    vector<string> arguments = parseFrameSourceOptions(argc, argv, sourceOptions, 
+            &detectorOptions);
+    FaceDetectorConfig baseConfig;
+    bool validOptions = parseFaceDetectorOptions(detectorOptions, baseConfig);
+    if (!validOptions || arguments.size() < 3) {
+        cout << "usage: " << argv[0] << " </path/to/haarCascade> </path/to/csv.ext|source> "
+                << "[options]" << endl;
+        cout << "\t </path/to/haarCascade> -- Path to the Haar Cascade for face detection." 
+                << endl;
+        cout << "\t </path/to/csv.ext> -- CSV file of images holding exactly one face each." 
+                << endl;
+        cout << "\t <source> -- Or a video file, image directory or device id showing one face "
+                << "in every frame, full-size frames show the profiles' real trade-off." << endl;
+        cout << "\t --max-frames=<n> -- Frames to read from a source, " 
+                << DEFAULT_SOURCE_FRAMES << " if not given." << endl;
+        cout << "\t Every profile is swept, --distance, --fov and --lbp-cascade still apply:" 
+                << endl;
+        printFaceDetectorUsage();
+        return 1;
+    }
+
+    vector<Mat> images;
+    if (endsWith(arguments[2], ".csv")) {
+        try {
+            readImages(arguments[2], images);
+        } catch (cv::Exception &e) {
+            cerr << "Error opening file \"" << arguments[2] << "\". Reason: " << e.msg << endl;
+            return 1;
+        }
+    } else if (!readFrames(arguments[2], sourceOptions, images)) {
+        cerr << "Error opening frame source " << arguments[2] << endl;
+        return 1;
+    }
+    if (images.empty()) {
+        cerr << "No images found in " << arguments[2] << endl;
+        return 1;
+    }
+    int maxWidth = 0;
+    for (unsigned int i = 0; i < images.size(); i++) {
+        maxWidth = max(maxWidth, images[i].cols);
+    }
+    cout << images.size() << " images up to " << maxWidth << " pixels wide, distance bounds " 
+            << baseConfig.minDistance << "m to " << baseConfig.maxDistance << "m at a " 
+            << baseConfig.horizontalFov << " degree field of view" << endl;
+    if (maxWidth <= MIN_DETECTION_WIDTH) {
+        cout << "No profile downscales images this small, calibrate on full-size frames from a "
+                << "video source to compare the profiles" << endl;
+    }
+    printf("%-8s %-10s %8s %8s %10s %10s %10s\n", "cascade", "profile", "recall", "extra", 
+            "mean ms", "p50 ms", "p95 ms");
+
+    // The Haar cascade always, the LBP cascade only when one was given
+    string lbpCascadePath = baseConfig.lbpCascadePath;
+    baseConfig.lbpCascadePath.clear();
+    calibrate("haar", arguments[1], baseConfig, images);
+    if (!lbpCascadePath.empty()) {
+        calibrate("lbp", lbpCascadePath, baseConfig, images);
+    }
+    return 0;
+}
+
+/**
+ * Decodes the grayscale image at the start of each line of the csv file into images.
+ */
+static void readImages(const string &fileName, vector<Mat> &images, char separator) {
+    std::ifstream file(fileName.c_str(), ifstream::in);
+    if (!file) {
+        string error_message = "No valid input file was given, please check the given fileName.";
+        CV_Error(CV_StsBadArg, error_message);
+    }
+    string line, path;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        if (path.empty()) {
+            continue;
+        }
+        Mat image = imread(path, 0);
+        if (image.empty()) {
+            cerr << "Error opening image file at path: \"" << path << endl;
+            continue;
+        }
+        images.push_back(image);
+    }
+}
+
+/**
+ * Reads up to --max-frames frames (DEFAULT_SOURCE_FRAMES if not given) from the device, video 
+ * file or image directory named by spec into images as grayscale. Returns false if the source 
+ * could not be opened.
+ */
+static bool readFrames(const string &spec, const FrameSourceOptions &sourceOptions, 
+        vector<Mat> &images) {
+    // Read every frame once and as fast as possible, the detector is what is being timed
+    FrameSourceOptions options = sourceOptions;
+    options.fps = 0.0;
+    options.loops = 1;
+    FrameSource source;
+    if (!source.open(spec, options)) {
+        return false;
+    }
+    long maxFrames = options.maxFrames > 0 ? options.maxFrames : DEFAULT_SOURCE_FRAMES;
+    Mat frame;
+    while ((long) images.size() < maxFrames && source.read(frame)) {
+        Mat gray;
+        if (frame.channels() == 1) {
+            gray = frame.clone();
+        } else {
+            cvtColor(frame, gray, COLOR_BGR2GRAY);
+        }
+        images.push_back(gray);
+    }
+    return true;
+}
+
+static bool endsWith(const string &value, const string &suffix) {
+    return value.size() >= suffix.size() 
+            && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * Runs every profile of the cascade at cascadePath over images and prints one table row each.
+ */
+static void calibrate(const string &cascadeName, const string &cascadePath, 
+        const FaceDetectorConfig &baseConfig, const vector<Mat> &images) {
+    StageTimings timings;
+    vector<Rect> faces;
+    for (unsigned int i = 0; i < sizeof(PROFILES) / sizeof(PROFILES[0]); i++) {
+        FaceDetectorConfig config = baseConfig;
+        setFaceDetectorProfile(PROFILES[i], config);
+        FaceDetector detector(config);
+        if (!detector.load(cascadePath)) {
+            return;
+        }
+        int stage = timings.addStage(cascadeName + "/" + PROFILES[i]);
+        int found = 0;
+        int extra = 0;
+        double totalSeconds = 0.0;
+        for (unsigned int j = 0; j < images.size(); j++) {
+            chrono::steady_clock::time_point start = chrono::steady_clock::now();
+            detector.detect(images[j], faces);
+            chrono::duration<double> seconds = chrono::steady_clock::now() - start;
+            timings.record(stage, seconds.count());
+            totalSeconds += seconds.count();
+            if (!faces.empty()) {
+                found++;
+                extra += faces.size() - 1;
+            }
+        }
+        printf("%-8s %-10s %7.1f%% %8d %10.2f %10.2f %10.2f\n", cascadeName.c_str(), PROFILES[i],
+                100.0 * found / images.size(), extra, 1000.0 * totalSeconds / images.size(),
+                1000.0 * timings.getPercentile(stage, 50.0), 
+                1000.0 * timings.getPercentile(stage, 95.0));
+    }
+}
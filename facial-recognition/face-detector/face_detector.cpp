@@ -0,0 +1,228 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "face_detector.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const double PI = 3.14159265358979323846;
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Detects as the tools always have, at full resolution with OpenCV's default pyramid and no 
+ * face size bounds. Profiles and distance bounds are opt-in.
+ */
+FaceDetectorConfig::FaceDetectorConfig() 
+        : detectionWidth(0), scaleFactor(1.1), minNeighbors(3), minDistance(0.0), 
+        maxDistance(0.0), faceWidth(0.15), horizontalFov(60.0) {
+}
+
+FaceDetector::FaceDetector(const FaceDetectorConfig &config) 
+        : config(config), scale(1.0) {
+}
+
+/**
+ * Loads the LBP cascade if one was configured and cascadePath otherwise.
+ */
+bool FaceDetector::load(const string &cascadePath) {
+    const string &path = config.lbpCascadePath.empty() ? cascadePath : config.lbpCascadePath;
+    if (!cascade.load(path)) {
+        cerr << "Error loading cascade at path: \"" << path << "\"" << endl;
+        return false;
+    }
+    // Face sizes depend on the cascade's window size
+    frameSize = Size();
+    return true;
+}
+
+/**
+ * Finds the faces in gray and stores them in faces, in gray's coordinates.
+ */
+void FaceDetector::detect(const Mat &gray, vector<Rect> &faces) {
+    if (gray.size() != frameSize) {
+        configure(gray.size());
+    }
+    if (scale == 1.0) {
+        cascade.detectMultiScale(gray, faces, config.scaleFactor, config.minNeighbors, 
+                CASCADE_SCALE_IMAGE, minFaceSize, maxFaceSize);
+        return;
+    }
+    resize(gray, smallFrame, detectionSize, 0, 0, INTER_AREA);
+    cascade.detectMultiScale(smallFrame, faces, config.scaleFactor, config.minNeighbors, 
+            CASCADE_SCALE_IMAGE, minFaceSize, maxFaceSize);
+    Rect frameRect(0, 0, frameSize.width, frameSize.height);
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        Rect &face = faces[i];
+        face = Rect(cvRound(face.x / scale), cvRound(face.y / scale), 
+                cvRound(face.width / scale), cvRound(face.height / scale)) & frameRect;
+    }
+}
+
+const FaceDetectorConfig &FaceDetector::getConfig() const {
+    return config;
+}
+
+/**
+ * Smallest face searched for, in detection (possibly downscaled) coordinates.
+ */
+Size FaceDetector::getMinFaceSize() const {
+    return minFaceSize;
+}
+
+/**
+ * Largest face searched for, in detection coordinates, or an empty size if unbounded.
+ */
+Size FaceDetector::getMaxFaceSize() const {
+    return maxFaceSize;
+}
+
+/**
+ * Works out the detection scale and face size bounds for frames of the given size.
+ */
+void FaceDetector::configure(const Size &size) {
+    frameSize = size;
+    scale = 1.0;
+    if (config.detectionWidth > 0 && size.width > config.detectionWidth) {
+        scale = (double) config.detectionWidth / size.width;
+    }
+    detectionSize = Size(cvRound(size.width * scale), cvRound(size.height * scale));
+
+    // Pinhole camera: a face faceWidth meters wide at distance d spans focal * faceWidth / d
+    // pixels, with the focal length in pixels coming from the field of view.
+    double focalLength = (size.width / 2.0) / tan(config.horizontalFov / 2.0 * PI / 180.0);
+    Size windowSize = cascade.empty() ? Size() : cascade.getOriginalWindowSize();
+    minFaceSize = windowSize;
+    if (config.maxDistance > 0.0) {
+        int minWidth = cvRound(focalLength * config.faceWidth / config.maxDistance * scale);
+        minFaceSize = Size(max(minWidth, windowSize.width), max(minWidth, windowSize.height));
+    }
+    maxFaceSize = Size();
+    if (config.minDistance > 0.0) {
+        int maxWidth = cvRound(focalLength * config.faceWidth / config.minDistance * scale);
+        // No point bounding the search by a face larger than the frame
+        if (maxWidth < min(detectionSize.width, detectionSize.height)) {
+            maxFaceSize = Size(max(maxWidth, minFaceSize.width), 
+                    max(maxWidth, minFaceSize.height));
+        }
+    }
+}
+
+/**
+ * Applies one of the preset speed/recall trade-offs to config:
+ *  "baseline" -- detect at full resolution with OpenCV's default pyramid, the default config.
+ *  "fast" -- detect on a 320 pixel wide frame with a coarse scale pyramid.
+ *  "balanced" -- detect on a 480 pixel wide frame with OpenCV's default pyramid.
+ *  "accurate" -- detect at full resolution with a fine scale pyramid.
+ * Returns false for an unknown profile and leaves config unchanged.
+ */
+bool setFaceDetectorProfile(const string &profile, FaceDetectorConfig &config) {
+    if (profile == "baseline") {
+        config.detectionWidth = 0;
+        config.scaleFactor = 1.1;
+        config.minNeighbors = 3;
+    } else if (profile == "fast") {
+        config.detectionWidth = 320;
+        config.scaleFactor = 1.2;
+        config.minNeighbors = 3;
+    } else if (profile == "balanced") {
+        config.detectionWidth = 480;
+        config.scaleFactor = 1.1;
+        config.minNeighbors = 3;
+    } else if (profile == "accurate") {
+        config.detectionWidth = 0;
+        config.scaleFactor = 1.05;
+        config.minNeighbors = 3;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Applies "--detector=<profile>", "--detection-width=<n>", "--scale-factor=<n>", 
+ * "--min-neighbors=<n>", "--distance=<min>,<max>", "--fov=<degrees>", and 
+ * "--lbp-cascade=<path>" options to config. The profile is applied first so the other 
+ * options can override it. Returns false if any option was not understood.
+ */
+bool parseFaceDetectorOptions(const vector<string> &options, FaceDetectorConfig &config) {
+    bool valid = true;
+    for (unsigned int pass = 0; pass < 2; pass++) {
+        for (unsigned int i = 0; i < options.size(); i++) {
+            const string &option = options[i];
+            size_t equalsPos = option.find('=');
+            string name = option.substr(2, 
+                    equalsPos == string::npos ? string::npos : equalsPos - 2);
+            string value = equalsPos == string::npos ? "" : option.substr(equalsPos + 1);
+            if (name == "detector") {
+                if (pass == 0 && !setFaceDetectorProfile(value, config)) {
+                    cerr << "Unknown detector profile: " << value << endl;
+                    valid = false;
+                }
+                continue;
+            }
+            if (pass == 0) {
+                continue;
+            }
+            if (name == "detection-width") {
+                config.detectionWidth = atoi(value.c_str());
+            } else if (name == "scale-factor") {
+                config.scaleFactor = atof(value.c_str());
+            } else if (name == "min-neighbors") {
+                config.minNeighbors = atoi(value.c_str());
+            } else if (name == "distance") {
+                size_t commaPos = value.find(',');
+                config.minDistance = atof(value.substr(0, commaPos).c_str());
+                config.maxDistance = commaPos == string::npos 
+                        ? 0.0 : atof(value.substr(commaPos + 1).c_str());
+            } else if (name == "fov") {
+                config.horizontalFov = atof(value.c_str());
+            } else if (name == "lbp-cascade") {
+                config.lbpCascadePath = value;
+            } else {
+                cerr << "Unrecognized option: " << option << endl;
+                valid = false;
+            }
+        }
+    }
+    return valid;
+}
+
+void printFaceDetectorUsage() {
+    cout << "\t --detector=<baseline|fast|balanced|accurate> -- Face detection speed/recall "
+            << "profile, baseline (full resolution with OpenCV's defaults) if not given." << endl;
+    cout << "\t --detection-width=<n> -- Downscale wider frames to n pixels for detection." 
+            << endl;
+    cout << "\t --scale-factor=<n> --min-neighbors=<n> -- Override the profile's cascade "
+            << "parameters." << endl;
+    cout << "\t --distance=<min>,<max> -- Expected distance to the user in meters, "
+            << "0 for no bound." << endl;
+    cout << "\t --fov=<degrees> -- The camera's horizontal field of view." << endl;
+    cout << "\t --lbp-cascade=<path> -- Detect with an LBP cascade instead of the Haar cascade." 
+            << endl;
+}
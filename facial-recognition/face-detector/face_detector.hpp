@@ -0,0 +1,96 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FACE_DETECTOR_HPP_
+#define FACE_DETECTOR_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Tuning knobs for FaceDetector, see setFaceDetectorProfile for the presets.
+ */
+struct FaceDetectorConfig {
+    // Frames wider than this are downscaled before detection, 0 to always use full resolution.
+    int detectionWidth;
+    // detectMultiScale step between pyramid scales and neighbors needed to keep a detection.
+    double scaleFactor;
+    int minNeighbors;
+    // Range of distances, in meters, a user stands from the camera during an LGTM exchange.
+    // The nearest distance bounds the largest face searched for and the farthest distance the
+    // smallest, 0 leaves that bound open.
+    double minDistance;
+    double maxDistance;
+    // Average width of a face in meters and the camera's horizontal field of view in degrees,
+    // used to turn the distance range into face sizes in pixels.
+    double faceWidth;
+    double horizontalFov;
+    // Cascade to load instead of the Haar cascade given on the command line, normally
+    // OpenCV's lbpcascades/lbpcascade_frontalface.xml which is several times faster.
+    std::string lbpCascadePath;
+
+    FaceDetectorConfig();
+};
+
+/**
+ * Runs a cascade classifier over grayscale frames with the settings from a FaceDetectorConfig.
+ *
+ * Large frames are downscaled to the configured detection width and the detections are scaled
+ * back to frame coordinates. The minimum and maximum face sizes come from the expected 
+ * distance to the user so the cascade does not search scales no face can appear at. All of 
+ * this is recomputed only when the frame size changes, and the downscaled frame is reused.
+ */
+class FaceDetector {
+public:
+    FaceDetector(const FaceDetectorConfig &config = FaceDetectorConfig());
+
+    bool load(const std::string &cascadePath);
+    void detect(const cv::Mat &gray, std::vector<cv::Rect> &faces);
+
+    const FaceDetectorConfig &getConfig() const;
+    cv::Size getMinFaceSize() const;
+    cv::Size getMaxFaceSize() const;
+
+private:
+    cv::CascadeClassifier cascade;
+    FaceDetectorConfig config;
+    cv::Size frameSize;
+    cv::Size detectionSize;
+    double scale;
+    cv::Size minFaceSize;
+    cv::Size maxFaceSize;
+    cv::Mat smallFrame;
+
+    void configure(const cv::Size &size);
+};
+
+bool setFaceDetectorProfile(const std::string &profile, FaceDetectorConfig &config);
+bool parseFaceDetectorOptions(const std::vector<std::string> &options, 
+        FaceDetectorConfig &config);
+void printFaceDetectorUsage();
+
+#endif
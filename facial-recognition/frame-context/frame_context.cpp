@@ -0,0 +1,153 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame_context.hpp"
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Slots in lastBufferData
+static const unsigned int FRAME_SLOT = 0;
+static const unsigned int GRAY_SLOT = 1;
+static const unsigned int DISPLAY_SLOT = 2;
+static const unsigned int NUM_SLOTS = 3;
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Preallocates buffers for frames of frameSize with room for maxFaces faces.
+ * The display copy is only allocated (and only ever written) when displayEnabled is set.
+ */
+FrameContext::FrameContext(const Size &frameSize, bool displayEnabled, int maxFaces) 
+        : displayEnabled(displayEnabled), frame(frameSize, CV_8UC3), gray(frameSize, CV_8UC1),
+        frameCount(0), bufferReallocations(0), steadyStateBufferReallocations(0) {
+    if (displayEnabled) {
+        display.create(frameSize, CV_8UC3);
+    }
+    faces.reserve(maxFaces);
+    identities.reserve(maxFaces);
+
+    lastBufferData.resize(NUM_SLOTS, NULL);
+    lastBufferData[FRAME_SLOT] = frame.data;
+    lastBufferData[GRAY_SLOT] = gray.data;
+    lastBufferData[DISPLAY_SLOT] = display.data;
+    lastFacesCapacity = faces.capacity();
+    lastIdentitiesCapacity = identities.capacity();
+}
+
+/**
+ * Converts the captured frame to grayscale and, if display is enabled, copies it into the
+ * display buffer for overlays. Both conversions write into the existing buffers.
+ */
+void FrameContext::prepare() {
+    cvtColor(frame, gray, CV_BGR2GRAY);
+    if (displayEnabled) {
+        frame.copyTo(display);
+    }
+}
+
+/**
+ * Ends the current frame, counting any buffer that had to be reallocated while processing it.
+ */
+void FrameContext::finish() {
+    if (bufferMoved(FRAME_SLOT, frame)) {
+        countBufferReallocation();
+    }
+    if (bufferMoved(GRAY_SLOT, gray)) {
+        countBufferReallocation();
+    }
+    if (bufferMoved(DISPLAY_SLOT, display)) {
+        countBufferReallocation();
+    }
+    if (faces.capacity() != lastFacesCapacity) {
+        lastFacesCapacity = faces.capacity();
+        countBufferReallocation();
+    }
+    if (identities.capacity() != lastIdentitiesCapacity) {
+        lastIdentitiesCapacity = identities.capacity();
+        countBufferReallocation();
+    }
+    frameCount++;
+}
+
+cv::Mat &FrameContext::getFrame() {
+    return frame;
+}
+
+const cv::Mat &FrameContext::getGray() const {
+    return gray;
+}
+
+cv::Mat &FrameContext::getDisplay() {
+    return display;
+}
+
+std::vector<cv::Rect> &FrameContext::getFaces() {
+    return faces;
+}
+
+std::vector<TrackedIdentity> &FrameContext::getIdentities() {
+    return identities;
+}
+
+bool FrameContext::isDisplayEnabled() const {
+    return displayEnabled;
+}
+
+unsigned long FrameContext::getFrameCount() const {
+    return frameCount;
+}
+
+/**
+ * Number of times one of this context's buffers was reallocated, including during the first 
+ * frame. Other heap allocations made while processing a frame are not counted.
+ */
+unsigned long FrameContext::getBufferReallocationCount() const {
+    return bufferReallocations;
+}
+
+/**
+ * Number of times one of this context's buffers was reallocated after the first frame, should 
+ * stay at zero.
+ */
+unsigned long FrameContext::getSteadyStateBufferReallocationCount() const {
+    return steadyStateBufferReallocations;
+}
+
+void FrameContext::countBufferReallocation() {
+    bufferReallocations++;
+    if (frameCount > 0) {
+        steadyStateBufferReallocations++;
+    }
+}
+
+/**
+ * Checks if buffer's data moved since the last check and remembers its current address.
+ */
+bool FrameContext::bufferMoved(unsigned int slot, const Mat &buffer) {
+    if (lastBufferData[slot] == buffer.data) {
+        return false;
+    }
+    lastBufferData[slot] = buffer.data;
+    return true;
+}
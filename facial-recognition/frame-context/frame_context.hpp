@@ -0,0 +1,84 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAME_CONTEXT_HPP_
+#define FRAME_CONTEXT_HPP_
+
+#include "../recognition-cache/recognition_cache.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <vector>
+
+/**
+ * Owns every intermediate buffer used to process one video frame so the buffers can be reused
+ * from frame to frame instead of being reallocated.
+ *
+ * Usage per frame: capture into getFrame(), call prepare(), detect into getFaces(), recognize
+ * into getIdentities(), draw onto getDisplay() if isDisplayEnabled(), then call finish().
+ * finish() checks whether any of these buffers was reallocated during the frame and counts it,
+ * so a steady state loop should report zero buffer reallocations once the first frame has been
+ * processed. Heap allocations made elsewhere, such as inside detectMultiScale or the 
+ * recognizer, are not seen and not counted.
+ */
+class FrameContext {
+public:
+    FrameContext(const cv::Size &frameSize, bool displayEnabled, int maxFaces = 16);
+
+    void prepare();
+    void finish();
+
+    cv::Mat &getFrame();
+    const cv::Mat &getGray() const;
+    cv::Mat &getDisplay();
+    std::vector<cv::Rect> &getFaces();
+    std::vector<TrackedIdentity> &getIdentities();
+
+    bool isDisplayEnabled() const;
+    unsigned long getFrameCount() const;
+    unsigned long getBufferReallocationCount() const;
+    unsigned long getSteadyStateBufferReallocationCount() const;
+
+private:
+    bool displayEnabled;
+    cv::Mat frame;
+    cv::Mat gray;
+    cv::Mat display;
+    std::vector<cv::Rect> faces;
+    std::vector<TrackedIdentity> identities;
+
+    // Buffer addresses and capacities seen at the end of the previous frame
+    std::vector<const uchar*> lastBufferData;
+    size_t lastFacesCapacity;
+    size_t lastIdentitiesCapacity;
+
+    unsigned long frameCount;
+    unsigned long bufferReallocations;
+    unsigned long steadyStateBufferReallocations;
+
+    void countBufferReallocation();
+    bool bufferMoved(unsigned int slot, const cv::Mat &buffer);
+};
+
+#endif
@@ -0,0 +1,249 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "frame_source.hpp"
+
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const char *IMAGE_PATTERNS[] = {"*.jpg", "*.jpeg", "*.png", "*.pgm", "*.gif"};
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool isDirectory(const string &path);
+static bool isDeviceId(const string &spec);
+
+//~Functions----------------------------------------------------------------------------------------
+FrameSourceOptions::FrameSourceOptions() 
+        : headless(false), fps(0.0), loops(1), maxFrames(0) {
+}
+
+FrameSource::FrameSource() 
+        : nextImage(0), deviceId(-1), fps(0.0), loops(1), loopsPlayed(0) {
+}
+
+/**
+ * Opens the device, video file, or image directory named by spec.
+ * Returns false if nothing could be opened.
+ */
+bool FrameSource::open(const string &spec, const FrameSourceOptions &options) {
+    release();
+    fps = options.fps;
+    loops = options.loops;
+    loopsPlayed = 0;
+    if (isDeviceId(spec)) {
+        deviceId = atoi(spec.c_str());
+        description = "device " + spec;
+        if (!capture.open(deviceId)) {
+            return false;
+        }
+    } else if (isDirectory(spec)) {
+        description = "images in " + spec;
+        for (unsigned int i = 0; i < sizeof(IMAGE_PATTERNS) / sizeof(IMAGE_PATTERNS[0]); i++) {
+            vector<String> matches;
+            glob(spec + "/" + IMAGE_PATTERNS[i], matches, false);
+            imagePaths.insert(imagePaths.end(), matches.begin(), matches.end());
+        }
+        sort(imagePaths.begin(), imagePaths.end());
+        if (imagePaths.empty()) {
+            return false;
+        }
+        // Size the source from the first image
+        decoded = imread(imagePaths[0]);
+        if (decoded.empty()) {
+            return false;
+        }
+        frameSize = decoded.size();
+        return true;
+    } else {
+        videoPath = spec;
+        description = "video " + spec;
+        if (!capture.open(videoPath)) {
+            return false;
+        }
+    }
+    frameSize = Size(capture.get(CV_CAP_PROP_FRAME_WIDTH), 
+            capture.get(CV_CAP_PROP_FRAME_HEIGHT));
+    return true;
+}
+
+/**
+ * Reads the next frame into frame, reusing frame's buffer when the size matches.
+ * Files and image sequences are rewound until they have been played options.loops times.
+ * Returns false once the source is exhausted.
+ */
+bool FrameSource::read(Mat &frame) {
+    if (!isOpened()) {
+        return false;
+    }
+    pace();
+    if (!imagePaths.empty()) {
+        return readImage(frame);
+    }
+    if (capture.read(frame) && !frame.empty()) {
+        return true;
+    }
+    return isLive() ? false : rewind() && capture.read(frame) && !frame.empty();
+}
+
+void FrameSource::release() {
+    if (capture.isOpened()) {
+        capture.release();
+    }
+    imagePaths.clear();
+    nextImage = 0;
+    deviceId = -1;
+    videoPath.clear();
+}
+
+bool FrameSource::isOpened() const {
+    return !imagePaths.empty() || capture.isOpened();
+}
+
+/**
+ * True for cameras, which can neither be rewound nor paced.
+ */
+bool FrameSource::isLive() const {
+    return deviceId >= 0;
+}
+
+cv::Size FrameSource::getFrameSize() const {
+    return frameSize;
+}
+
+const string &FrameSource::getDescription() const {
+    return description;
+}
+
+/**
+ * Decodes the next image of the sequence into frame. Grayscale images are expanded to three 
+ * channels so image sequences look like camera frames to the rest of the pipeline.
+ */
+bool FrameSource::readImage(Mat &frame) {
+    if (nextImage == imagePaths.size() && !rewind()) {
+        return false;
+    }
+    decoded = imread(imagePaths[nextImage++]);
+    if (decoded.empty()) {
+        cerr << "Error opening image file at path: \"" << imagePaths[nextImage - 1] << endl;
+        return false;
+    }
+    decoded.copyTo(frame);
+    return true;
+}
+
+/**
+ * Starts the file or image sequence over, unless it has already been played enough times.
+ */
+bool FrameSource::rewind() {
+    loopsPlayed++;
+    if (loops > 0 && loopsPlayed >= loops) {
+        return false;
+    }
+    if (!imagePaths.empty()) {
+        nextImage = 0;
+        return true;
+    }
+    capture.release();
+    return capture.open(videoPath);
+}
+
+/**
+ * Sleeps until the next frame is due when a fixed frame rate was requested.
+ */
+void FrameSource::pace() {
+    if (fps <= 0.0 || isLive()) {
+        return;
+    }
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    if (nextFrameTime > now) {
+        this_thread::sleep_until(nextFrameTime);
+    } else {
+        // Running behind (or the first frame), do not try to catch up
+        nextFrameTime = now;
+    }
+    nextFrameTime += chrono::duration_cast<chrono::steady_clock::duration>(
+            chrono::duration<double>(1.0 / fps));
+}
+
+/**
+ * Pulls "--headless", "--fps=<n>", "--loops=<n>", "--max-frames=<n>", and "--json=<path>" out
+ * of the command line into options and returns the remaining arguments (including argv[0]).
+ * Any other "--" options are collected in otherOptions for the caller to handle, or reported
+ * and ignored if otherOptions is NULL.
+ */
+vector<string> parseFrameSourceOptions(int argc, const char *argv[], 
+        FrameSourceOptions &options, vector<string> *otherOptions) {
+    vector<string> positionalArguments;
+    for (int i = 0; i < argc; i++) {
+        string argument(argv[i]);
+        if (argument.compare(0, 2, "--") != 0) {
+            positionalArguments.push_back(argument);
+            continue;
+        }
+        size_t equalsPos = argument.find('=');
+        string name = argument.substr(2, equalsPos == string::npos ? string::npos : equalsPos - 2);
+        string value = equalsPos == string::npos ? "" : argument.substr(equalsPos + 1);
+        if (name == "headless") {
+            options.headless = true;
+        } else if (name == "fps") {
+            options.fps = atof(value.c_str());
+        } else if (name == "loops") {
+            options.loops = atoi(value.c_str());
+        } else if (name == "max-frames") {
+            options.maxFrames = atol(value.c_str());
+        } else if (name == "json") {
+            options.jsonPath = value;
+        } else if (otherOptions != NULL) {
+            otherOptions->push_back(argument);
+        } else {
+            cerr << "Ignoring unrecognized option: " << argument << endl;
+        }
+    }
+    return positionalArguments;
+}
+
+void printFrameSourceUsage() {
+    cout << "\t Frames can come from a device id, a video file, or a directory of images." << endl;
+    cout << "\t --headless -- No window or key presses, print per-stage timings as JSON." << endl;
+    cout << "\t --fps=<n> -- Pace files and image directories at n frames per second." << endl;
+    cout << "\t --loops=<n> -- Play files and image directories n times (0 forever)." << endl;
+    cout << "\t --max-frames=<n> -- Stop after n frames." << endl;
+    cout << "\t --json=<path> -- Write the benchmark JSON to path instead of stdout." << endl;
+}
+
+static bool isDirectory(const string &path) {
+    struct stat pathStat;
+    return stat(path.c_str(), &pathStat) == 0 && S_ISDIR(pathStat.st_mode);
+}
+
+static bool isDeviceId(const string &spec) {
+    return !spec.empty() && spec.find_first_not_of("0123456789") == string::npos;
+}
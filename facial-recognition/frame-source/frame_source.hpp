@@ -0,0 +1,99 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef FRAME_SOURCE_HPP_
+#define FRAME_SOURCE_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/highgui/highgui.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/**
+ * Options shared by the video tools for running without a camera or a window.
+ * Parsed from "--name=value" command line flags, see parseFrameSourceOptions.
+ */
+struct FrameSourceOptions {
+    // No windows, no key presses, process until the source runs out
+    bool headless;
+    // Frames per second to pace playback at, 0 to process as fast as possible
+    double fps;
+    // Number of times to play a file or image sequence, 0 to loop forever
+    int loops;
+    // Stop after this many frames, 0 for no limit
+    long maxFrames;
+    // Where to write the benchmark JSON, empty for stdout
+    std::string jsonPath;
+
+    FrameSourceOptions();
+};
+
+/**
+ * Produces frames from a webcam, a video file, or a directory of images.
+ *
+ * The source spec is a device id if it is all digits, an image sequence if it names a 
+ * directory (every image in the directory, in file name order), and a video file otherwise.
+ * Files and image sequences can be replayed several times and paced at a fixed frame rate so
+ * they stand in for a live camera.
+ */
+class FrameSource {
+public:
+    FrameSource();
+
+    bool open(const std::string &spec, const FrameSourceOptions &options);
+    bool read(cv::Mat &frame);
+    void release();
+
+    bool isOpened() const;
+    bool isLive() const;
+    cv::Size getFrameSize() const;
+    const std::string &getDescription() const;
+
+private:
+    cv::VideoCapture capture;
+    std::vector<cv::String> imagePaths;
+    unsigned int nextImage;
+    int deviceId;
+    std::string videoPath;
+    std::string description;
+    cv::Size frameSize;
+    double fps;
+    int loops;
+    int loopsPlayed;
+    cv::Mat decoded;
+    std::chrono::steady_clock::time_point nextFrameTime;
+
+    bool readImage(cv::Mat &frame);
+    bool rewind();
+    void pace();
+};
+
+std::vector<std::string> parseFrameSourceOptions(int argc, const char *argv[], 
+        FrameSourceOptions &options, std::vector<std::string> *otherOptions = NULL);
+void printFrameSourceUsage();
+
+#endif
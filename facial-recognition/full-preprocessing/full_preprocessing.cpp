@@ -23,13 +23,40 @@
 
 #include "../face-detect/face_detect.hpp"
 #include "../pad-images/pad_images.hpp"
+#include "preprocessing_pipeline.hpp"
+
+#include <cstdlib>
 
 using namespace std;
 
-int main(void) {
+// Usage: full_preprocessing [csv file] [--fused=<directory>] [--cascade=<file>] [--size=<n>]
+//        [--json=<file>]
+// --fused decodes every image once and writes the cropped, equalized and padded faces to the
+// directory in a single parallel pass, printing the throughput of each stage. Without it the
+// images are cropped and padded in place, one step after the other.
+int main(int argc, const char *argv[]) {
     cout << "Running Full Preprocessing..." << endl;
     string csvFileName = "yalefaces.csv";
+    PreprocessingOptions options;
+    for (int i = 1; i < argc; i++) {
+        string argument(argv[i]);
+        if (argument.compare(0, 8, "--fused=") == 0) {
+            options.outputDirectory = argument.substr(8);
+        } else if (argument.compare(0, 10, "--cascade=") == 0) {
+            options.cascadeFileName = argument.substr(10);
+        } else if (argument.compare(0, 7, "--size=") == 0) {
+            int size = atoi(argument.substr(7).c_str());
+            options.outputSize = cv::Size(size, size);
+        } else if (argument.compare(0, 7, "--json=") == 0) {
+            options.jsonPath = argument.substr(7);
+        } else {
+            csvFileName = argument;
+        }
+    }
+    if (!options.outputDirectory.empty()) {
+        return runPreprocessingPipeline(csvFileName, options) < 0;
+    }
     cropImagesToFaces(csvFileName);
     padImages(csvFileName);
     return 0;
-}
\ No newline at end of file
+}
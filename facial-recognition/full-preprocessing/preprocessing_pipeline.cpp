@@ -0,0 +1,223 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Preprocesses a face database in one pass per image, instead of cropping every image on disk
+ * and then reading them all back to pad them.
+ *
+ * Each image is decoded once, converted to grayscale, searched for faces, cropped to the 
+ * largest one, histogram equalized, padded to a square and resized to the training size, and
+ * encoded once. Images are processed in parallel. The time every image spends in each stage
+ * is kept and reported as per-stage throughput at the end.
+ */
+#include "preprocessing_pipeline.hpp"
+#include "../face-detect/face_detect.hpp"
+#include "../stage-timing/stage_timing.hpp"
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/objdetect/objdetect.hpp>
+
+#include <sys/stat.h>
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const char separator = ';';
+static const char *STAGE_NAMES[] = {"decode", "grayscale", "detect", "crop", "equalize", 
+        "resize", "encode"};
+static const int NUM_STAGES = sizeof(STAGE_NAMES) / sizeof(STAGE_NAMES[0]);
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool preprocessImage(const string &path, const string &outputPath, 
+        const PreprocessingOptions &options, double stageSeconds[]);
+static string getFileName(const string &path);
+
+//~Functions----------------------------------------------------------------------------------------
+PreprocessingOptions::PreprocessingOptions() 
+        : cascadeFileName("../face-detect/haarcascades/haarcascade_frontalface_default.xml"),
+        outputSize(168, 168) {
+}
+
+/**
+ * Preprocesses every image in the csv file into options.outputDirectory under its file name, 
+ * and lists the saved images with their labels in outputDirectory/manifest.csv. Prints the 
+ * throughput of each stage. Returns the number of images saved, or -1 if the csv file or the
+ * cascade could not be read.
+ */
+int runPreprocessingPipeline(const string &csvFileName, const PreprocessingOptions &options) {
+    CascadeClassifier cascade;
+    if (!cascade.load(options.cascadeFileName)) {
+        cerr << "Error loading cascade: " << options.cascadeFileName << endl;
+        return -1;
+    }
+    std::ifstream file(csvFileName.c_str(), ifstream::in);
+    if (!file) {
+        cerr << "No valid input file was given, please check the given fileName." << endl;
+        return -1;
+    }
+    vector<string> paths;
+    vector<string> labels;
+    string line, path, label;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        getline(liness, label);
+        if (!path.empty()) {
+            paths.push_back(path);
+            labels.push_back(label);
+        }
+    }
+    mkdir(options.outputDirectory.c_str(), 0755);
+
+    // Every image keeps its own stage times, they are added up once all threads are done
+    vector<double> stageSeconds(paths.size() * NUM_STAGES, 0.0);
+    vector<string> outputPaths(paths.size());
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    WorkerPool::shared().run(paths.size(), [&](int i) {
+        string outputPath = options.outputDirectory + "/" + getFileName(paths[i]);
+        if (preprocessImage(paths[i], outputPath, options, &stageSeconds[i * NUM_STAGES])) {
+            outputPaths[i] = outputPath;
+        }
+    });
+    chrono::duration<double> wallSeconds = chrono::steady_clock::now() - start;
+
+    StageTimings timings;
+    for (int stage = 0; stage < NUM_STAGES; stage++) {
+        timings.addStage(STAGE_NAMES[stage]);
+    }
+    string manifestFileName = options.outputDirectory + "/manifest.csv";
+    std::ofstream manifest(manifestFileName.c_str());
+    int saved = 0;
+    for (unsigned int i = 0; i < paths.size(); i++) {
+        for (int stage = 0; stage < NUM_STAGES; stage++) {
+            if (stageSeconds[i * NUM_STAGES + stage] > 0.0) {
+                timings.record(stage, stageSeconds[i * NUM_STAGES + stage]);
+            }
+        }
+        if (!outputPaths[i].empty()) {
+            manifest << outputPaths[i] << separator << labels[i] << "\n";
+            saved++;
+        }
+    }
+
+    printf("Preprocessed %d of %d images in %.3f seconds (%.1f images/s) on %u threads\n", 
+            saved, (int) paths.size(), wallSeconds.count(), paths.size() / wallSeconds.count(),
+            WorkerPool::shared().getThreadCount());
+    printf("%-10s %8s %12s %10s %10s\n", "stage", "images", "images/s", "p50 ms", "p95 ms");
+    for (int stage = 0; stage < NUM_STAGES; stage++) {
+        double totalSeconds = timings.getTotalSeconds(stage);
+        printf("%-10s %8lu %12.1f %10.3f %10.3f\n", STAGE_NAMES[stage], 
+                (unsigned long) timings.getCount(stage),
+                totalSeconds > 0 ? timings.getCount(stage) / totalSeconds : 0.0,
+                timings.getPercentile(stage, 50) * 1e3, timings.getPercentile(stage, 95) * 1e3);
+    }
+    if (!options.jsonPath.empty()) {
+        timings.setField("saved", saved);
+        timings.writeJson(options.jsonPath, csvFileName, paths.size(), wallSeconds.count());
+    }
+    return saved;
+}
+
+/**
+ * Runs every stage on one image, storing the seconds spent in each in stageSeconds. Stops at
+ * the first stage that fails (unreadable image, no face) and returns false.
+ */
+static bool preprocessImage(const string &path, const string &outputPath, 
+        const PreprocessingOptions &options, double stageSeconds[]) {
+    // CascadeClassifier is not safe to share between threads, each one loads its own copy
+    static thread_local CascadeClassifier cascade;
+    static thread_local string cascadeFileName;
+    if (cascadeFileName != options.cascadeFileName) {
+        cascade.load(options.cascadeFileName);
+        cascadeFileName = options.cascadeFileName;
+    }
+    Mat image, gray, equalized, face, squared, resized;
+    vector<Rect> faces;
+    int largest = -1;
+    bool written = false;
+    chrono::steady_clock::time_point stageStart = chrono::steady_clock::now();
+    for (int stage = 0; stage < NUM_STAGES; stage++) {
+        bool succeeded = true;
+        switch (stage) {
+            case 0:
+                image = imread(path);
+                succeeded = !image.empty();
+                break;
+            case 1:
+                cvtColor(image, gray, CV_BGR2GRAY);
+                break;
+            case 2:
+                // Detect on an equalized copy, like cropImagesToFaces
+                equalizeHist(gray, equalized);
+                cascade.detectMultiScale(equalized, faces, 1.1, 2, CASCADE_SCALE_IMAGE, 
+                        Size(30, 30));
+                largest = findLargestFace(faces);
+                succeeded = largest != -1;
+                break;
+            case 3:
+                face = gray(faces[largest]);
+                break;
+            case 4:
+                equalizeHist(face, face);
+                break;
+            case 5: {
+                // Pad to a square on white, centered, so resizing does not stretch the face
+                int side = max(face.cols, face.rows);
+                int padX = side - face.cols;
+                int padY = side - face.rows;
+                copyMakeBorder(face, squared, padY / 2, padY - padY / 2, padX / 2, 
+                        padX - padX / 2, BORDER_CONSTANT, Scalar(255));
+                resize(squared, resized, options.outputSize, 0, 0, 
+                        side > options.outputSize.width ? INTER_AREA : INTER_CUBIC);
+                break;
+            }
+            case 6:
+                written = imwrite(outputPath, resized);
+                succeeded = written;
+                break;
+        }
+        chrono::steady_clock::time_point stageEnd = chrono::steady_clock::now();
+        stageSeconds[stage] = chrono::duration<double>(stageEnd - stageStart).count();
+        stageStart = stageEnd;
+        if (!succeeded) {
+            printf("Skipping %s, %s failed\n", path.c_str(), STAGE_NAMES[stage]);
+            return false;
+        }
+    }
+    return written;
+}
+
+static string getFileName(const string &path) {
+    size_t slashPos = path.find_last_of('/');
+    return slashPos == string::npos ? path : path.substr(slashPos + 1);
+}
@@ -0,0 +1,49 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PREPROCESSING_PIPELINE_HPP_
+#define PREPROCESSING_PIPELINE_HPP_
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+
+/**
+ * Settings for runPreprocessingPipeline.
+ */
+struct PreprocessingOptions {
+    std::string cascadeFileName;
+    // Where the preprocessed images and manifest.csv are written
+    std::string outputDirectory;
+    // Size of the saved faces, the size the recognizers are trained at
+    cv::Size outputSize;
+    // Where to write the per-stage timing JSON, empty for none
+    std::string jsonPath;
+
+    PreprocessingOptions();
+};
+
+int runPreprocessingPipeline(const std::string &csvFileName, 
+        const PreprocessingOptions &options);
+
+#endif
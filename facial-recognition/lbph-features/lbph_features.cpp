@@ -0,0 +1,193 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Local Binary Patterns Histograms features, computed exactly as OpenCV's LBPHFaceRecognizer
+ * computes them so results carry over to the trained models, but available on their own so 
+ * they can be cached and compared without retraining.
+ */
+#include "lbph_features.hpp"
+
+#include <cfloat>
+#include <cmath>
+#include <limits>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const double PI = 3.14159265358979323846;
+
+//~Functions----------------------------------------------------------------------------------------
+LbphParameters::LbphParameters(int radius, int neighbors, int gridX, int gridY) 
+        : radius(radius), neighbors(neighbors), gridX(gridX), gridY(gridY) {
+}
+
+bool LbphParameters::operator<(const LbphParameters &other) const {
+    if (radius != other.radius) {
+        return radius < other.radius;
+    }
+    if (neighbors != other.neighbors) {
+        return neighbors < other.neighbors;
+    }
+    if (gridX != other.gridX) {
+        return gridX < other.gridX;
+    }
+    return gridY < other.gridY;
+}
+
+/**
+ * Computes the spatially enhanced histogram of an 8 bit grayscale image: the extended local
+ * binary pattern of every pixel at least radius pixels from the border, counted per grid 
+ * cell, each cell normalized by its pixel count, in a 1 x (cells * 2^neighbors) CV_32F row.
+ */
+void computeLbphHistogram(const Mat &gray, const LbphParameters &parameters, Mat &histogram) {
+    CV_Assert(gray.type() == CV_8UC1);
+    int radius = parameters.radius;
+    int numPatterns = 1 << parameters.neighbors;
+    int numCells = parameters.gridX * parameters.gridY;
+    histogram.create(1, numCells * numPatterns, CV_32FC1);
+    histogram.setTo(Scalar(0));
+    int rows = gray.rows - 2 * radius;
+    int cols = gray.cols - 2 * radius;
+    if (rows <= 0 || cols <= 0) {
+        return;
+    }
+
+    // Codes of every pixel, built one neighbor bit at a time like OpenCV's elbp
+    Mat codes = Mat::zeros(rows, cols, CV_32SC1);
+    for (int n = 0; n < parameters.neighbors; n++) {
+        float x = static_cast<float>(radius * cos(2.0 * PI * n / (float) parameters.neighbors));
+        float y = static_cast<float>(-radius * sin(2.0 * PI * n / (float) parameters.neighbors));
+        int fx = static_cast<int>(floor(x));
+        int fy = static_cast<int>(floor(y));
+        int cx = static_cast<int>(ceil(x));
+        int cy = static_cast<int>(ceil(y));
+        float ty = y - fy;
+        float tx = x - fx;
+        float w1 = (1 - tx) * (1 - ty);
+        float w2 = tx * (1 - ty);
+        float w3 = (1 - tx) * ty;
+        float w4 = tx * ty;
+        for (int i = radius; i < gray.rows - radius; i++) {
+            const uchar *center = gray.ptr<uchar>(i);
+            const uchar *floorRow = gray.ptr<uchar>(i + fy);
+            const uchar *ceilRow = gray.ptr<uchar>(i + cy);
+            int *codeRow = codes.ptr<int>(i - radius);
+            for (int j = radius; j < gray.cols - radius; j++) {
+                float t = static_cast<float>(w1 * floorRow[j + fx] + w2 * floorRow[j + cx] 
+                        + w3 * ceilRow[j + fx] + w4 * ceilRow[j + cx]);
+                codeRow[j - radius] += ((t > center[j]) 
+                        || (std::abs(t - center[j]) < numeric_limits<float>::epsilon())) << n;
+            }
+        }
+    }
+
+    // Leftover rows and columns that do not fill a cell are ignored, as in OpenCV
+    int cellWidth = cols / parameters.gridX;
+    int cellHeight = rows / parameters.gridY;
+    float cellTotal = (float) (cellWidth * cellHeight);
+    float *bins = histogram.ptr<float>(0);
+    for (int cellY = 0; cellY < parameters.gridY; cellY++) {
+        for (int cellX = 0; cellX < parameters.gridX; cellX++) {
+            float *cellBins = bins + (cellY * parameters.gridX + cellX) * numPatterns;
+            for (int i = cellY * cellHeight; i < (cellY + 1) * cellHeight; i++) {
+                const int *codeRow = codes.ptr<int>(i);
+                for (int j = cellX * cellWidth; j < (cellX + 1) * cellWidth; j++) {
+                    cellBins[codeRow[j]] += 1.0f;
+                }
+            }
+            if (cellTotal > 0) {
+                for (int bin = 0; bin < numPatterns; bin++) {
+                    cellBins[bin] /= cellTotal;
+                }
+            }
+        }
+    }
+}
+
+/**
+ * The alternative chi-square distance between two histograms, the distance 
+ * LBPHFaceRecognizer thresholds on.
+ */
+double compareLbphHistograms(const Mat &first, const Mat &second) {
+    CV_Assert(first.type() == CV_32FC1 && first.size() == second.size());
+    const float *a = first.ptr<float>(0);
+    const float *b = second.ptr<float>(0);
+    int length = (int) first.total();
+    double result = 0;
+    for (int i = 0; i < length; i++) {
+        double sum = a[i] + b[i];
+        if (fabs(sum) > DBL_EPSILON) {
+            double difference = a[i] - b[i];
+            result += difference * difference / sum;
+        }
+    }
+    return 2 * result;
+}
+
+/**
+ * Returns the index of the histogram among candidates closest to query and stores its
+ * distance, or -1 if there are no candidates.
+ */
+int findNearestHistogram(const vector<Mat> &histograms, const vector<int> &candidates, 
+        const Mat &query, double &distance) {
+    int nearest = -1;
+    distance = DBL_MAX;
+    for (unsigned int i = 0; i < candidates.size(); i++) {
+        double curDistance = compareLbphHistograms(histograms[candidates[i]], query);
+        if (curDistance < distance) {
+            distance = curDistance;
+            nearest = candidates[i];
+        }
+    }
+    return nearest;
+}
+
+LbphFeatureCache::LbphFeatureCache(const vector<Mat> &images, WorkerPool &pool) 
+        : images(&images), pool(&pool) {
+}
+
+/**
+ * The histograms of every image for these parameters, extracted in parallel the first time
+ * they are asked for.
+ */
+const vector<Mat> &LbphFeatureCache::getHistograms(const LbphParameters &parameters) {
+    map<LbphParameters, vector<Mat> >::iterator cached = histograms.find(parameters);
+    if (cached != histograms.end()) {
+        return cached->second;
+    }
+    vector<Mat> &features = histograms[parameters];
+    features.resize(images->size());
+    pool->run(images->size(), [&](int i) {
+        computeLbphHistogram((*images)[i], parameters, features[i]);
+    });
+    return features;
+}
+
+/**
+ * Drops every cached histogram.
+ */
+void LbphFeatureCache::clear() {
+    histograms.clear();
+}
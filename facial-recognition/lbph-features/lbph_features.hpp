@@ -0,0 +1,73 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LBPH_FEATURES_HPP_
+#define LBPH_FEATURES_HPP_
+
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <map>
+#include <vector>
+
+/**
+ * The settings of a Local Binary Patterns Histograms model that change its features. The 
+ * defaults match face::createLBPHFaceRecognizer.
+ */
+struct LbphParameters {
+    int radius;
+    int neighbors;
+    int gridX;
+    int gridY;
+
+    LbphParameters(int radius = 1, int neighbors = 8, int gridX = 8, int gridY = 8);
+    bool operator<(const LbphParameters &other) const;
+};
+
+void computeLbphHistogram(const cv::Mat &gray, const LbphParameters &parameters, 
+        cv::Mat &histogram);
+double compareLbphHistograms(const cv::Mat &first, const cv::Mat &second);
+int findNearestHistogram(const std::vector<cv::Mat> &histograms, 
+        const std::vector<int> &candidates, const cv::Mat &query, double &distance);
+
+/**
+ * Computes the LBPH histograms of a fixed set of grayscale images once per set of parameters
+ * and keeps them, so evaluating several folds or thresholds does not extract them again.
+ * The images must outlive the cache.
+ */
+class LbphFeatureCache {
+public:
+    LbphFeatureCache(const std::vector<cv::Mat> &images, 
+            WorkerPool &pool = WorkerPool::shared());
+
+    const std::vector<cv::Mat> &getHistograms(const LbphParameters &parameters);
+    void clear();
+
+private:
+    const std::vector<cv::Mat> *images;
+    WorkerPool *pool;
+    std::map<LbphParameters, std::vector<cv::Mat> > histograms;
+};
+
+#endif
@@ -47,21 +47,31 @@
  */
 
 
-// Switch between Local Binary Patterns Histograms(2), Eigenfaces (1), and Fisherfaces (0)
-#define FACIAL_RECOGNITION_MODEL 2
-
 #include <opencv2/core/core.hpp>
 #include <opencv2/face.hpp>
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/objdetect/objdetect.hpp>
 
+#include "../camera-geometry/camera_geometry.hpp"
+#include "../face-detector/face_detector.hpp"
+#include "../frame-context/frame_context.hpp"
+#include "../frame-source/frame_source.hpp"
+#include "../multi-source/multi_source_capture.hpp"
+#include "../recognition-cache/recognition_cache.hpp"
+#include "../recognizer-factory/recognizer_factory.hpp"
+#include "../stage-timing/stage_timing.hpp"
+#include "../training-import/training_import.hpp"
+
 #include <iostream>
 #include <fstream>
 #include <sstream>
 
+#include <algorithm>
 #include <chrono>
 #include <ctime>
+#include <future>
+#include <memory>
 
 #include <cmath>
 
@@ -76,84 +86,144 @@ static const string confirmationWindow = "Is this who you want to communicate wi
 //~Function Headers---------------------------------------------------------------------------------
 static void readCsv(const string& fileName, vector<Mat>& images, vector<int>& labels);
 static bool withinBounds(double &leftSideAngle, double &rightSideAngle, int &angle);
-static void drawTargettingLines(int &frameWidth, int &frameHeight, Mat &frame);
-static void findAngleBounds(int &frameWidth, int &frameHeight, Rect &faceRectangle, 
-        double &leftSideAngle, double &rightSideAngle);
+static void printFrameContextStats(const FrameContext &frameContext);
+static bool readAnglesOfArrival(const string &fileName, vector<int> &anglesOfArrival);
+static void printSourceStats(MultiSourceCapture &cap, 
+        const vector<unique_ptr<FrameContext> > &frameContexts);
 
 /**
  * Runs facial recognition on a specific face (specified in the arguments) 
  * and only acknowledges that face if it is at a particular angle(s) (specified in arguments).
  */
 int main(int argc, const char *argv[]) {
+    // Pull out the optional "--" flags for headless runs, tracing, camera yaws, the recognizer
+    // and face detection first.
+    FrameSourceOptions sourceOptions;
+    vector<string> traceArguments;
+    vector<string> arguments = parseFrameSourceOptions(argc, argv, sourceOptions, 
+            &traceArguments);
+    TraceOptions traceOptions;
+    vector<string> multiSourceArguments;
+    bool validOptions = parseTraceOptions(traceArguments, traceOptions, &multiSourceArguments);
+    MultiSourceOptions multiSourceOptions;
+    vector<string> recognizerOptions;
+    validOptions = parseMultiSourceOptions(multiSourceArguments, multiSourceOptions, 
+            &recognizerOptions) && validOptions;
+    // "--params" trains on a received facial recognition params buffer instead of a csv file
+    vector<string>::iterator paramsFlag = find(recognizerOptions.begin(), 
+            recognizerOptions.end(), "--params");
+    bool paramsInput = paramsFlag != recognizerOptions.end();
+    if (paramsInput) {
+        recognizerOptions.erase(paramsFlag);
+    }
+    // "--exit-on-confirm" ends a headless run at the first confirmation
+    vector<string>::iterator exitFlag = find(recognizerOptions.begin(), 
+            recognizerOptions.end(), "--exit-on-confirm");
+    bool exitOnConfirm = exitFlag != recognizerOptions.end();
+    if (exitOnConfirm) {
+        recognizerOptions.erase(exitFlag);
+    }
+    // "--aoas-from=<file>" reads more angles of arrival once everything else is ready, and 
+    // "--ready-to=<file>" tells whoever writes them that it is
+    string aoasFileName;
+    string readyFileName;
+    for (unsigned int i = 0; i < recognizerOptions.size(); i++) {
+        if (recognizerOptions[i].compare(0, 12, "--aoas-from=") == 0) {
+            aoasFileName = recognizerOptions[i].substr(12);
+            recognizerOptions.erase(recognizerOptions.begin() + i--);
+        } else if (recognizerOptions[i].compare(0, 11, "--ready-to=") == 0) {
+            readyFileName = recognizerOptions[i].substr(11);
+            recognizerOptions.erase(recognizerOptions.begin() + i--);
+        }
+    }
+    RecognizerConfig recognizerConfig;
+    vector<string> detectorOptions;
+    validOptions = parseRecognizerOptions(recognizerOptions, recognizerConfig, 
+            &detectorOptions) && validOptions;
+    FaceDetectorConfig detectorConfig;
+    validOptions = parseFaceDetectorOptions(detectorOptions, detectorConfig) && validOptions;
     // Validate input.
-    if (argc < 4) {
+    if (!validOptions || arguments.size() < 5) {
         cout << "usage: " << argv[0] 
-                << " </path/to/haarCascade> </path/to/csv.ext> <device id>"
-                << " <face id> <angles of arrival>" << endl;
+                << " </path/to/haarCascade> <device id | video | image dir>[,...]"
+                << " </path/to/csv.ext>"
+                << " <face id> <angles of arrival> [options]" << endl;
         cout << "\t </path/to/haarCascade> -- Path to the Haar Cascade for face detection." 
                 << endl;
         cout << "\t <device id> -- The webcam device id to grab frames from." << endl;
         cout << "\t </path/to/csv.ext> -- Path to the CSV file with the face database." << endl;
         cout << "\t <face id> -- The identification number of the face we WANT to recognize" 
                 << "for LGTM. This is the number " << endl;
+        cout << "\t\t \"auto\" uses the label of the first training image." << endl;
         cout << "\t <angles of arrival> -- A space separated sequence of angle of arrivals" << endl;
+        printFrameSourceUsage();
+        printMultiSourceUsage();
+        printRecognizerUsage();
+        printFaceDetectorUsage();
+        printTraceUsage();
+        cout << "\t --params -- Read the training images from a received facial recognition" 
+                << " params file (\"-\" for stdin) in place of the csv, without extracting it."
+                << endl;
+        cout << "\t --aoas-from=<file> -- Read more angles of arrival from a file or pipe after" 
+                << " training and opening the sources, so they can be found meanwhile." << endl;
+        cout << "\t --ready-to=<file> -- Write \"ready\" to a file or pipe once trained and the" 
+                << " sources are open, before reading --aoas-from." << endl;
+        cout << "\t --exit-on-confirm -- End a --headless run as soon as LGTM passes, instead" 
+                << " of at the end of the sources." << endl;
         exit(1);
     }
 
     // Parse inputs
-    string haarCascadeFileName = string(argv[1]);
-    int deviceId = atoi(argv[2]);
-    string csvFileName = string(argv[3]);
-    int faceId = atoi(argv[4]);
+    string haarCascadeFileName = arguments[1];
+    string sourceSpec = arguments[2];
+    string trainingFileName = arguments[3];
+    int faceId = atoi(arguments[4].c_str());
     vector<int> anglesOfArrival;
-    for (int i = 0; i < (argc - 5); i++) {
-        // Offset index to account for arguments already parsed.
-        anglesOfArrival.push_back(atoi(argv[i + 5]));
+    for (unsigned int i = 5; i < arguments.size(); i++) {
+        anglesOfArrival.push_back(atoi(arguments[i].c_str()));
     }
 
+    // Get a handle to every video device, video file, or image sequence, each captured on its
+    // own thread so a slow camera does not hold up the others. Opening them can take as long
+    // as training, so do both at once:
+    MultiSourceCapture cap;
+    future<bool> capOpened = async(launch::async, [&]() {
+        return cap.open(splitSourceSpecs(sourceSpec), sourceOptions, 
+                detectorConfig.horizontalFov, multiSourceOptions);
+    });
+
     vector<Mat> images;
     vector<int> labels;
 
-    try {
-        readCsv(csvFileName, images, labels);
-    } catch (cv::Exception& e) {
-        cerr << "Error opening file \"" << csvFileName << "\". Reason: " << e.msg << endl;
-        exit(1);
+    if (paramsInput) {
+        vector<unsigned char> received;
+        TrainingImport imported;
+        if (!readParamsBuffer(trainingFileName, received) 
+                || !importTrainingParams(received, imported)) {
+            cerr << "Error reading facial recognition params from \"" << trainingFileName 
+                    << "\"" << endl;
+            exit(1);
+        }
+        cout << "Imported " << imported.images.size() << " training images from " 
+                << received.size() << " received bytes" << endl;
+        images.swap(imported.images);
+        labels.swap(imported.labels);
+    } else {
+        try {
+            readCsv(trainingFileName, images, labels);
+        } catch (cv::Exception& e) {
+            cerr << "Error opening file \"" << trainingFileName << "\". Reason: " << e.msg 
+                    << endl;
+            exit(1);
+        }
+    }
+    if (arguments[4] == "auto" && !labels.empty()) {
+        faceId = labels[0];
     }
-
-    // TODO: cleaning and maybe removing?
-    int imgWidth = 168;//images[0].cols;
-    int imgHeight = 168;//images[0].rows;
 
     // Create a FaceRecognizer and train it on the given images:
-    Ptr<face::FaceRecognizer> model;
-    switch (FACIAL_RECOGNITION_MODEL) {
-        case 0:
-            {
-                cout << "Using Fisherfaces" << endl;
-                double threshold = 2200.0;
-                model = face::createFisherFaceRecognizer(0, threshold);
-            }
-            break;
-        case 1:
-            {
-                cout << "Using Eigenfaces" << endl;
-                double threshold = 7250.0;
-                model = face::createEigenFaceRecognizer(0, threshold);
-            }
-            break;
-        case 2:
-            {
-                cout << "Using Local Binary Pattern Histograms" << endl;
-                int radius = 10;
-                int neighbors = 8;
-                int gridX = 4;
-                int gridY = 4;
-                double threshold = 25.0;
-                model = face::createLBPHFaceRecognizer(radius, neighbors, gridX, gridY, threshold);
-            }
-            break;
-    }
+    Ptr<face::FaceRecognizer> model = createRecognizer(recognizerConfig);
+    cout << "Using " << describeRecognizer(recognizerConfig) << endl;
 
     // Load model if a path to a pretrained model was passed
     cout << "Starting training..." << endl;
@@ -162,7 +232,7 @@ int main(int argc, const char *argv[]) {
     start = std::chrono::system_clock::now();
     
     model->train(images, labels);
-    model->save("new-facial-recognition-model");
+    saveRecognizer(model, recognizerConfig, "new-facial-recognition-model");
 
     end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
@@ -172,98 +242,188 @@ int main(int argc, const char *argv[]) {
     // Much of the code below was adapted from the wonderful tutorials in the OpenCV documentation
     // In particular, the tutorial at: 
     // http://docs.opencv.org/3.0-beta/modules/face/doc/facerec/tutorial/facerec_video_recognition.html
-    // Load HaarCascade from file
-    CascadeClassifier haarCascade;
-    haarCascade.load(haarCascadeFileName);
+    // Load HaarCascade from file, or the LBP cascade if one was given
+    FaceDetector faceDetector(detectorConfig);
+    if (!faceDetector.load(haarCascadeFileName)) {
+        return -1;
+    }
     
-    // Get a handle to the Video device:
-    VideoCapture cap(deviceId);
-    // Check if we can use this device at all:
-    if(!cap.isOpened()) {
-        cerr << "Capture Device ID " << deviceId << "cannot be opened." << endl;
+    // Check if we can use these devices at all:
+    if (!capOpened.get()) {
+        return -1;
+    }
+    if (!readyFileName.empty()) {
+        ofstream readyFile(readyFileName.c_str());
+        readyFile << "ready" << endl;
+    }
+    // Only now wait for the angles still being found
+    if (!aoasFileName.empty() && !readAnglesOfArrival(aoasFileName, anglesOfArrival)) {
+        cerr << "Error reading angles of arrival from \"" << aoasFileName << "\"" << endl;
         return -1;
     }
-    int capFrameWidth = cap.get(CV_CAP_PROP_FRAME_WIDTH);
-    int capFrameHeight = cap.get(CV_CAP_PROP_FRAME_HEIGHT);
+    int sourceCount = cap.getSourceCount();
+
+    // Every source keeps its own tracked faces and per-frame buffers, while the predictions of
+    // all of them run on the shared worker pool. Reuse predictions for faces that have not 
+    // changed since the last frame and smooth the identity of each tracked face over several 
+    // frames before confirming it. Every per-frame buffer is allocated once here and reused 
+    // for every frame, nothing is drawn in headless mode.
+    vector<unique_ptr<RecognitionCache> > recognitionCaches;
+    vector<unique_ptr<FrameContext> > frameContexts;
+    vector<string> windowNames;
+    for (int s = 0; s < sourceCount; s++) {
+        recognitionCaches.emplace_back(new RecognitionCache(model, recognizerConfig.faceSize));
+        frameContexts.emplace_back(new FrameContext(cap.getFrameSize(s), 
+                !sourceOptions.headless));
+        windowNames.push_back(sourceCount == 1 ? viewingWindow 
+                : format("%s %d", viewingWindow.c_str(), s));
+    }
+
+    // Time each stage of every frame
+    StageTimings timings;
+    int captureStage = timings.addStage("capture");
+    int grayscaleStage = timings.addStage("grayscale");
+    int detectStage = timings.addStage("detect");
+    int recognizeStage = timings.addStage("recognize");
+    int renderStage = timings.addStage("render");
+    // Optionally trace the stages, including the resizes and predictions on the worker threads
+    if (traceOptions.isEnabled()) {
+        TraceRecorder::shared().enable(traceOptions);
+        timings.setTrace(&TraceRecorder::shared());
+    }
+    chrono::steady_clock::time_point loopStart = chrono::steady_clock::now();
+    // Headless runs cannot be confirmed with a key press, they report when LGTM first passed.
+    // A round reads one frame from every source that has not ended.
+    long rounds = 0;
+    long confirmedAtFrame = -1;
 
     try {
-        // Holds the current frame from the Video device:
-        Mat frame;
         for(;;) {
+            if (sourceOptions.maxFrames > 0 && rounds >= sourceOptions.maxFrames) {
+                break;
+            }
+            // LGTM passes if the face is confirmed by any of the sources
             bool lgtmConfirm = false;
-            cap >> frame;
-            // Clone the current frame:
-            Mat original = frame.clone();
-            Mat gray;
-            cvtColor(original, gray, CV_BGR2GRAY);
-            // Find the faces in the frame:
-            vector< Rect_<int> > faces;
-            haarCascade.detectMultiScale(gray, faces);
-            // Check each face detected in the frame by the HaarCascade classifier 
-            // for facial recognition
-            for(int i = 0; i < faces.size(); i++) {
-                Rect curFace = faces[i];
-                Mat face = gray(curFace);
-                Mat resizedFace;
-                cv::resize(face, resizedFace, Size(imgWidth, imgHeight), 1.0, 1.0, INTER_CUBIC);
-
-                // Predict what this face's ID is
-                int prediction = -1;
-                double confidence = 0.0;
-                model->predict(resizedFace, prediction, confidence);
-
-                // Loop over the passed angles of arrival to check if the face is at that angle
-                for (int j = 0; j < anglesOfArrival.size(); j++) {
-                    anglesOfArrival[j];
+            int capturedSources = 0;
+            for (int s = 0; s < sourceCount; s++) {
+                FrameContext &frameContext = *frameContexts[s];
+                CameraGeometry &cameraGeometry = cap.getGeometry(s);
+                // Capture into the reused frame buffer, convert to grayscale and copy for 
+                // display
+                bool captured;
+                {
+                    ScopedStageTimer timer(timings, captureStage);
+                    captured = cap.read(s, frameContext.getFrame());
+                }
+                if (!captured) {
+                    continue;
+                }
+                capturedSources++;
+                {
+                    ScopedStageTimer timer(timings, grayscaleStage);
+                    frameContext.prepare();
+                }
+                const Mat &gray = frameContext.getGray();
+                Mat &original = frameContext.getDisplay();
+                // Find the faces in the frame:
+                vector<Rect> &faces = frameContext.getFaces();
+                {
+                    ScopedStageTimer timer(timings, detectStage);
+                    faceDetector.detect(gray, faces);
+                }
+                // Check each face detected in the frame by the HaarCascade classifier 
+                // for facial recognition, predictions are cached per tracked face
+                vector<TrackedIdentity> &identities = frameContext.getIdentities();
+                {
+                    ScopedStageTimer timer(timings, recognizeStage);
+                    recognitionCaches[s]->update(gray, faces, identities);
+                }
+                chrono::steady_clock::time_point renderStart = chrono::steady_clock::now();
+                for(int i = 0; i < identities.size(); i++) {
+                    Rect curFace = identities[i].face;
+                    double confidence = identities[i].confidence;
                     double leftSideAngle = -1;
                     double rightSideAngle = -1;
-                    double toleranceLeftSideAngle = -1;
-                    double toleranceRightSideAngle = -1;
-                    findAngleBounds(capFrameWidth, capFrameHeight, curFace, 
-                            leftSideAngle, rightSideAngle);
-                    toleranceLeftSideAngle = leftSideAngle - ANGLE_TOLERANCE;
-                    toleranceRightSideAngle = rightSideAngle + ANGLE_TOLERANCE;
-                    // If the prediction is the face we are looking for.
-                    //if (prediction == faceId 
-                    //        && withinBounds(leftSideAngle, rightSideAngle, anglesOfArrival[j])) {
-                    rectangle(original, curFace, CV_RGB(0, 255,0), 1);
-                    // Create the text we will annotate the box with:
-                    string boxAngleText = format("Face at angles: %.1g %.1g", leftSideAngle, rightSideAngle);
-                    string boxConfidenceText = format("With confidence: %g", confidence);
-                    // Calculate the position for annotated text (make sure we don't
-                    // put illegal values in there):
-                    // TODO: See below, 10 was the original
-                    int angleTextPosX = std::max(curFace.tl().x - 25, 0);
-                    int angleTextPosY = std::max(curFace.tl().y - 25, 0);
-                    int confidencePosX = std::max(curFace.tl().x - 25, 0);
-                    int confidencePosY = std::max(curFace.tl().y - 10, 0);
-                    // And now put it into the image:
-                    putText(original, boxAngleText, Point(angleTextPosX, angleTextPosY), 
-                            FONT_HERSHEY_PLAIN, 1.0, CV_RGB(0, 255, 0), 2.0);
-                    putText(original, boxConfidenceText, Point(confidencePosX, confidencePosY), 
-                            FONT_HERSHEY_PLAIN, 1.0, CV_RGB(0, 255, 0), 2.0);
-                    if (prediction == faceId 
-                            && withinBounds(toleranceLeftSideAngle, toleranceRightSideAngle, anglesOfArrival[j])) {
-                        // Present confirmation text
-                        int confirmPosX = std::max(curFace.tl().x - 65, 0);
-                        int confirmPosY = std::max(curFace.br().y + 10, 0);
-                        string boxConfirmText = "Press space to confirm this face";
-                        putText(original, boxConfirmText, Point(confirmPosX, confirmPosY), 
+                    cameraGeometry.getAngleBounds(curFace, leftSideAngle, rightSideAngle);
+                    double toleranceLeftSideAngle = leftSideAngle - ANGLE_TOLERANCE;
+                    double toleranceRightSideAngle = rightSideAngle + ANGLE_TOLERANCE;
+
+                    // Loop over the passed angles of arrival to check if the face is at that 
+                    // angle
+                    for (int j = 0; j < anglesOfArrival.size(); j++) {
+                        // If the prediction is the face we are looking for.
+                        bool faceConfirmed = identities[i].stable 
+                                && identities[i].smoothedPrediction == faceId 
+                                && withinBounds(toleranceLeftSideAngle, 
+                                        toleranceRightSideAngle, anglesOfArrival[j]);
+                        lgtmConfirm = lgtmConfirm || faceConfirmed;
+                        if (!frameContext.isDisplayEnabled()) {
+                            continue;
+                        }
+                        rectangle(original, curFace, CV_RGB(0, 255,0), 1);
+                        // Create the text we will annotate the box with:
+                        string boxAngleText = format("Face at angles: %.1g %.1g", leftSideAngle, 
+                                rightSideAngle);
+                        string boxConfidenceText = format("With confidence: %g", confidence);
+                        // Calculate the position for annotated text (make sure we don't
+                        // put illegal values in there):
+                        // TODO: See below, 10 was the original
+                        int angleTextPosX = std::max(curFace.tl().x - 25, 0);
+                        int angleTextPosY = std::max(curFace.tl().y - 25, 0);
+                        int confidencePosX = std::max(curFace.tl().x - 25, 0);
+                        int confidencePosY = std::max(curFace.tl().y - 10, 0);
+                        // And now put it into the image:
+                        putText(original, boxAngleText, Point(angleTextPosX, angleTextPosY), 
+                                FONT_HERSHEY_PLAIN, 1.0, CV_RGB(0, 255, 0), 2.0);
+                        putText(original, boxConfidenceText, 
+                                Point(confidencePosX, confidencePosY), 
                                 FONT_HERSHEY_PLAIN, 1.0, CV_RGB(0, 255, 0), 2.0);
-                        lgtmConfirm = true;
+                        if (faceConfirmed) {
+                            // Present confirmation text
+                            int confirmPosX = std::max(curFace.tl().x - 65, 0);
+                            int confirmPosY = std::max(curFace.br().y + 10, 0);
+                            string boxConfirmText = "Press space to confirm this face";
+                            putText(original, boxConfirmText, Point(confirmPosX, confirmPosY), 
+                                    FONT_HERSHEY_PLAIN, 1.0, CV_RGB(0, 255, 0), 2.0);
+                        }
                     }
                 }
+                frameContext.finish();
+                if (!frameContext.isDisplayEnabled()) {
+                    continue;
+                }
+                // Add "targeting" lines
+                cameraGeometry.drawOverlay(original);
+                // Show the result:
+                imshow(windowNames[s], original);
+                timings.record(renderStage, renderStart, chrono::steady_clock::now());
+            }
+            if (capturedSources == 0) {
+                break;
             }
-            // Add "targeting" lines
-            drawTargettingLines(capFrameWidth, capFrameHeight, original);
+            rounds++;
+            TraceRecorder::shared().reportRollingSummary(cerr);
 
-            // Show the result:
-            imshow(viewingWindow, original);
+            if (sourceOptions.headless) {
+                if (lgtmConfirm && confirmedAtFrame == -1) {
+                    confirmedAtFrame = rounds - 1;
+                    chrono::duration<double> confirmSeconds = 
+                            chrono::steady_clock::now() - loopStart;
+                    timings.setField("confirmedAtFrame", confirmedAtFrame);
+                    timings.setField("confirmedAfterSeconds", confirmSeconds.count());
+                }
+                if (exitOnConfirm && confirmedAtFrame >= 0) {
+                    break;
+                }
+                continue;
+            }
             int key = waitKey(20);
             // Confirm the recognized face with space
             if (key == 32 && lgtmConfirm) {
                 cout << "LOOKS GOOD TO ME!"
                         << " PROCEEDING TO ESTABLISH ENCRYPTED COMMUNICATION!" << endl;
+                printSourceStats(cap, frameContexts);
+                TraceRecorder::shared().finish();
                 // Only exit that is considered a success
                 exit(0);
             // Reject the recognized face with escape
@@ -277,88 +437,88 @@ int main(int argc, const char *argv[]) {
                         << " or space to accept the face (if LGTM has passed it)!" << endl;
             }
         }
-    } catch(Exception e) {
-        cap.release();
+    } catch (cv::Exception &e) {
+        // Stop on the first failure, the sources are released below
+        cerr << "Error recognizing faces. Reason: " << e.msg << endl;
     }
+    TraceRecorder::shared().finish();
+    printSourceStats(cap, frameContexts);
+    string sourceDescription = cap.getDescription();
     cap.release();
+    if (sourceOptions.headless) {
+        chrono::duration<double> loopSeconds = chrono::steady_clock::now() - loopStart;
+        unsigned long predictions = 0;
+        unsigned long cachedPredictions = 0;
+        unsigned long steadyStateBufferReallocations = 0;
+        long frames = 0;
+        for (int s = 0; s < sourceCount; s++) {
+            predictions += recognitionCaches[s]->getPredictionCount();
+            cachedPredictions += recognitionCaches[s]->getCacheHitCount();
+            steadyStateBufferReallocations += 
+                    frameContexts[s]->getSteadyStateBufferReallocationCount();
+            frames += frameContexts[s]->getFrameCount();
+        }
+        timings.setField("sources", sourceCount);
+        timings.setField("predictions", predictions);
+        timings.setField("cachedPredictions", cachedPredictions);
+        timings.setField("steadyStateBufferReallocations", steadyStateBufferReallocations);
+        timings.writeJson(sourceOptions.jsonPath, sourceDescription, frames, 
+                loopSeconds.count());
+        return confirmedAtFrame >= 0 ? 0 : 1;
+    }
     return 1;
 }
 
 /**
- * Checks if angle is between leftSideAngle and rightSideAngle. 
- * If it is, true is returned.
+ * Prints the frames processed and frame buffer reallocations of every source, and how many 
+ * frames of each camera were dropped for a newer one.
  */
-static bool withinBounds(double &leftSideAngle, double &rightSideAngle, int &angle) {
-    return leftSideAngle <= angle && angle <= rightSideAngle;
+static void printSourceStats(MultiSourceCapture &cap, 
+        const vector<unique_ptr<FrameContext> > &frameContexts) {
+    for (int s = 0; s < cap.getSourceCount(); s++) {
+        if (cap.getSourceCount() > 1) {
+            cout << "Source " << s << " (" << cap.getDescription(s) << "): ";
+        }
+        printFrameContextStats(*frameContexts[s]);
+        if (cap.getDroppedFrameCount(s) > 0) {
+            cout << "\t" << cap.getDroppedFrameCount(s) << " frames dropped while busy" << endl;
+        }
+    }
 }
 
 /**
- * Wraps the passed angle to the range [-pi / 2, pi / 2]
+ * Prints how many frames were processed and how often the per-frame buffers were reallocated.
+ * Heap allocations outside those buffers are not counted.
  */
-static double wrapAngle(double angle) {
-    return angle - M_PI * floor(angle / M_PI) - (M_PI / 2);
+static void printFrameContextStats(const FrameContext &frameContext) {
+    cout << "Processed " << frameContext.getFrameCount() << " frames with " 
+            << frameContext.getBufferReallocationCount() << " frame buffer reallocations ("
+            << frameContext.getSteadyStateBufferReallocationCount() << " after the first frame)" 
+            << endl;
 }
 
 /**
- * Calculates the horizontal angles and vertical angles of the passed in rectangle.
- * Annotates the rectangle on the frame with text describing the output.
+ * Appends the whitespace separated angles in a file, waiting for the writer to close it if it
+ * is a pipe. Angles are rounded to whole degrees.
  */
-static void findAngleBounds(int &frameWidth, int &frameHeight, Rect &faceRectangle, 
-        double &leftSideAngle, double &rightSideAngle) {
-    // Get points at the two bottom corners of the rectangle
-    int x1 = faceRectangle.tl().x - frameWidth / 2;
-    int x2 = faceRectangle.br().x - frameWidth / 2;
-
-    // Compute theta1 and theta2 (leftSideAngle and rightSideAngle)
-    // Convert to polar coordinates, with known r and unknown angle
-    double r = 639;
-    leftSideAngle = acos(x1 / r);
-    rightSideAngle = acos(x2 / r);
-    // Wrap angles to [-90, 90]
-    leftSideAngle = wrapAngle(leftSideAngle) * (180 / M_PI);
-    rightSideAngle = wrapAngle(rightSideAngle) * (180 / M_PI);
-    // Invert the circle revolution direction
-    leftSideAngle *= -1;
-    rightSideAngle *= -1;
+static bool readAnglesOfArrival(const string &fileName, vector<int> &anglesOfArrival) {
+    ifstream aoasFile(fileName.c_str());
+    if (!aoasFile) {
+        return false;
+    }
+    double angle;
+    while (aoasFile >> angle) {
+        anglesOfArrival.push_back(cvRound(angle));
+    }
+    return aoasFile.eof();
 }
 
 /**
- * Draw a straight horizontal line across the center of the frame and annotate it with 
- * smaller vertical lines which have angle annotations from -30 - 30
- */ 
-static void drawTargettingLines(int &frameWidth, int &frameHeight, Mat &frame) {
-    // Straight horizontal line across the center of the frame
-    line(frame, Point(0, frameHeight / 2), Point(frameWidth, frameHeight / 2), CV_RGB(0, 255,0), 1);
-    int topY = frameHeight / 2 - 50;
-    int bottomY = frameHeight / 2 + 50;
-    double x1, x2;
-    double r = 639;
-    double theta;
-    string angleString1;
-    string angleString2;
-    for (int i = 0; i <= 30; i+=10) {
-        x1 = r * sin(i * (M_PI / 180));
-        x1 += frameWidth / 2;        
-        x2 = r * sin(-i * (M_PI / 180));
-        x2 += frameWidth / 2;
-        line(frame, Point(x1, topY), Point(x1, bottomY), CV_RGB(0, 255,0), 1);
-        line(frame, Point(x2, topY), Point(x2, bottomY), CV_RGB(0, 255,0), 1);
-        angleString1 = format("%d", i);
-        angleString2 = format("%d", -i);
-        if (i != 30) {
-            putText(frame, angleString1, Point(x1 - 5, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                    CV_RGB(0, 255, 0), 2.0);    
-            if (i != 0) {
-                putText(frame, angleString2, Point(x2 - 20, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                        CV_RGB(0, 255, 0), 2.0);    
-            }
-        } else {
-            putText(frame, angleString1, Point(x1 - 20, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                    CV_RGB(0, 255, 0), 2.0);    
-            putText(frame, angleString2, Point(x2 - 5, bottomY + 15), FONT_HERSHEY_PLAIN, 1.0, 
-                    CV_RGB(0, 255, 0), 2.0);    
-        }
-    }
+ * Checks if angle is between leftSideAngle and rightSideAngle. 
+ * If it is, true is returned.
+ */
+static bool withinBounds(double &leftSideAngle, double &rightSideAngle, int &angle) {
+    return leftSideAngle <= angle && angle <= rightSideAngle;
 }
 
 /**
@@ -0,0 +1,232 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "multi_source_capture.hpp"
+
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+//~Functions----------------------------------------------------------------------------------------
+MultiSourceCapture::MultiSourceCapture() : stopping(false) {
+}
+
+MultiSourceCapture::~MultiSourceCapture() {
+    release();
+}
+
+/**
+ * Opens every source and starts its capture thread. Returns false, with nothing left open, if
+ * any source cannot be opened.
+ */
+bool MultiSourceCapture::open(const vector<string> &specs, const FrameSourceOptions &options, 
+        double horizontalFov, const MultiSourceOptions &multiSourceOptions) {
+    release();
+    stopping = false;
+    for (unsigned int i = 0; i < specs.size(); i++) {
+        unique_ptr<Source> source(new Source());
+        if (!source->frameSource.open(specs[i], options)) {
+            cerr << "Frame source " << specs[i] << " cannot be opened." << endl;
+            sources.clear();
+            return false;
+        }
+        double yaw = i < multiSourceOptions.yaws.size() ? multiSourceOptions.yaws[i] : 0.0;
+        source->geometry.reset(new CameraGeometry(source->frameSource.getFrameSize(), 
+                horizontalFov, yaw));
+        source->full = false;
+        source->ended = false;
+        source->droppedFrames = 0;
+        sources.push_back(move(source));
+    }
+    for (unsigned int i = 0; i < sources.size(); i++) {
+        Source &source = *sources[i];
+        source.thread = thread([this, &source]() { captureLoop(source); });
+    }
+    return !sources.empty();
+}
+
+/**
+ * Copies the next frame of a source into frame, waiting for it if needed. Returns false once
+ * the source has run out of frames.
+ */
+bool MultiSourceCapture::read(int source, Mat &frame) {
+    Source &curSource = *sources[source];
+    unique_lock<mutex> lock(curSource.mutex);
+    curSource.frameReady.wait(lock, [&curSource]() { 
+        return curSource.full || curSource.ended;
+    });
+    if (!curSource.full) {
+        return false;
+    }
+    curSource.latest.copyTo(frame);
+    curSource.full = false;
+    curSource.slotFree.notify_one();
+    return true;
+}
+
+/**
+ * Stops every capture thread and closes the sources.
+ */
+void MultiSourceCapture::release() {
+    stopping = true;
+    for (unsigned int i = 0; i < sources.size(); i++) {
+        lock_guard<mutex> lock(sources[i]->mutex);
+        sources[i]->slotFree.notify_all();
+    }
+    for (unsigned int i = 0; i < sources.size(); i++) {
+        if (sources[i]->thread.joinable()) {
+            sources[i]->thread.join();
+        }
+        sources[i]->frameSource.release();
+    }
+    sources.clear();
+}
+
+int MultiSourceCapture::getSourceCount() const {
+    return sources.size();
+}
+
+/**
+ * Whether a source has run out of frames and its last frame has been read.
+ */
+bool MultiSourceCapture::isEnded(int source) {
+    lock_guard<mutex> lock(sources[source]->mutex);
+    return sources[source]->ended && !sources[source]->full;
+}
+
+Size MultiSourceCapture::getFrameSize(int source) const {
+    return sources[source]->frameSource.getFrameSize();
+}
+
+CameraGeometry &MultiSourceCapture::getGeometry(int source) {
+    return *sources[source]->geometry;
+}
+
+/**
+ * Frames of a camera replaced by a newer one before they were read.
+ */
+unsigned long MultiSourceCapture::getDroppedFrameCount(int source) {
+    lock_guard<mutex> lock(sources[source]->mutex);
+    return sources[source]->droppedFrames;
+}
+
+/**
+ * The descriptions of every source, comma separated.
+ */
+string MultiSourceCapture::getDescription() const {
+    string description;
+    for (unsigned int i = 0; i < sources.size(); i++) {
+        description += (i > 0 ? "," : "") + sources[i]->frameSource.getDescription();
+    }
+    return description;
+}
+
+string MultiSourceCapture::getDescription(int source) const {
+    return sources[source]->frameSource.getDescription();
+}
+
+/**
+ * Runs on a source's own thread until the source runs out or the capture is released.
+ */
+void MultiSourceCapture::captureLoop(Source &source) {
+    bool live = source.frameSource.isLive();
+    for (;;) {
+        bool captured = false;
+        try {
+            captured = source.frameSource.read(source.pending);
+        } catch (const cv::Exception &e) {
+            cerr << "Capture from " << source.frameSource.getDescription() << " failed: " 
+                    << e.msg << endl;
+        }
+        unique_lock<mutex> lock(source.mutex);
+        if (captured && !live) {
+            source.slotFree.wait(lock, [this, &source]() { 
+                return !source.full || stopping;
+            });
+        }
+        if (!captured || stopping) {
+            source.ended = true;
+            source.frameReady.notify_all();
+            return;
+        }
+        if (source.full) {
+            source.droppedFrames++;
+        }
+        swap(source.pending, source.latest);
+        source.full = true;
+        source.frameReady.notify_all();
+    }
+}
+
+/**
+ * Splits a comma separated list of source specs, e.g. "0,1" or "left.mp4,right.mp4".
+ */
+vector<string> splitSourceSpecs(const string &spec) {
+    vector<string> specs;
+    stringstream specStream(spec);
+    string item;
+    while (getline(specStream, item, ',')) {
+        if (!item.empty()) {
+            specs.push_back(item);
+        }
+    }
+    return specs;
+}
+
+/**
+ * Applies the "--yaw=<degrees>[,<degrees>...]" option. Any other options are collected in 
+ * otherOptions, or reported as errors if it is NULL.
+ */
+bool parseMultiSourceOptions(const vector<string> &options, 
+        MultiSourceOptions &multiSourceOptions, vector<string> *otherOptions) {
+    bool valid = true;
+    for (unsigned int i = 0; i < options.size(); i++) {
+        const string &option = options[i];
+        size_t equalsPos = option.find('=');
+        string name = option.substr(2, equalsPos == string::npos ? string::npos : equalsPos - 2);
+        string value = equalsPos == string::npos ? "" : option.substr(equalsPos + 1);
+        if (name == "yaw") {
+            multiSourceOptions.yaws.clear();
+            vector<string> yaws = splitSourceSpecs(value);
+            for (unsigned int j = 0; j < yaws.size(); j++) {
+                multiSourceOptions.yaws.push_back(atof(yaws[j].c_str()));
+            }
+        } else if (otherOptions != NULL) {
+            otherOptions->push_back(option);
+        } else {
+            cerr << "Unrecognized option: " << option << endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+void printMultiSourceUsage() {
+    cout << "\t Several sources can be given comma separated, e.g. 0,1 or left.mp4,right.mp4,"
+            << " each is captured on its own thread." << endl;
+    cout << "\t --yaw=<degrees>[,<degrees>...] -- Direction each source points on the rig, " 
+            << "positive to the right." << endl;
+}
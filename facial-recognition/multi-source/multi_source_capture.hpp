@@ -0,0 +1,107 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MULTI_SOURCE_CAPTURE_HPP_
+#define MULTI_SOURCE_CAPTURE_HPP_
+
+#include "../camera-geometry/camera_geometry.hpp"
+#include "../frame-source/frame_source.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Where the cameras of a rig point, parsed from "--name=value" command line flags by 
+ * parseMultiSourceOptions.
+ */
+struct MultiSourceOptions {
+    // Yaw of each source in degrees, positive to the right, 0 for sources without one
+    std::vector<double> yaws;
+};
+
+/**
+ * Captures from several frame sources at once, each on its own thread.
+ *
+ * Every source has a one frame slot. A camera's thread replaces an unread frame with a newer 
+ * one, so processing always sees the latest frame, while a file's or image directory's thread
+ * waits for its frame to be read, so a recording is processed frame for frame however slowly
+ * the consumer runs. Each source also has its own CameraGeometry, turned by the source's yaw, 
+ * so faces from every camera are placed in the rig's angles.
+ */
+class MultiSourceCapture {
+public:
+    MultiSourceCapture();
+    ~MultiSourceCapture();
+
+    bool open(const std::vector<std::string> &specs, const FrameSourceOptions &options, 
+            double horizontalFov, const MultiSourceOptions &multiSourceOptions);
+    bool read(int source, cv::Mat &frame);
+    void release();
+
+    int getSourceCount() const;
+    bool isEnded(int source);
+    cv::Size getFrameSize(int source) const;
+    CameraGeometry &getGeometry(int source);
+    unsigned long getDroppedFrameCount(int source);
+    std::string getDescription() const;
+    std::string getDescription(int source) const;
+
+private:
+    struct Source {
+        FrameSource frameSource;
+        std::unique_ptr<CameraGeometry> geometry;
+        std::thread thread;
+        std::mutex mutex;
+        std::condition_variable frameReady;
+        std::condition_variable slotFree;
+        // Frame being captured and the captured frame waiting to be read, swapped so neither
+        // is reallocated
+        cv::Mat pending;
+        cv::Mat latest;
+        bool full;
+        bool ended;
+        unsigned long droppedFrames;
+    };
+
+    std::vector<std::unique_ptr<Source> > sources;
+    std::atomic<bool> stopping;
+
+    MultiSourceCapture(const MultiSourceCapture &);
+    MultiSourceCapture &operator=(const MultiSourceCapture &);
+
+    void captureLoop(Source &source);
+};
+
+std::vector<std::string> splitSourceSpecs(const std::string &spec);
+bool parseMultiSourceOptions(const std::vector<std::string> &options, 
+        MultiSourceOptions &multiSourceOptions, std::vector<std::string> *otherOptions = NULL);
+void printMultiSourceUsage();
+
+#endif
@@ -0,0 +1,139 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Reads the width and height of JPEG and PNG images from their headers, without decoding the
+ * pixels. Only the first few hundred bytes of a typical file are read.
+ */
+#include "image_header.hpp"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <fstream>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const unsigned char PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n'};
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool readPngSize(ifstream &file, Size &size);
+static bool readJpegSize(ifstream &file, Size &size);
+static bool readBytes(ifstream &file, unsigned char *bytes, int count);
+static uint32_t bigEndian(const unsigned char *bytes, int count);
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Stores the size of the JPEG or PNG image at path in size. Returns false for other formats 
+ * and for files that cannot be read, in which case the caller has to decode the image.
+ * JPEG EXIF orientation is not applied, matching OpenCV 3.0's imread.
+ */
+bool readImageHeaderSize(const string &path, Size &size) {
+    ifstream file(path.c_str(), ios::binary);
+    unsigned char magic[2];
+    if (!file || !readBytes(file, magic, 2)) {
+        return false;
+    }
+    file.seekg(0);
+    if (magic[0] == PNG_SIGNATURE[0] && magic[1] == PNG_SIGNATURE[1]) {
+        return readPngSize(file, size);
+    } else if (magic[0] == 0xFF && magic[1] == 0xD8) {
+        return readJpegSize(file, size);
+    }
+    return false;
+}
+
+/**
+ * The signature is followed by the IHDR chunk, whose first fields are the width and height.
+ */
+static bool readPngSize(ifstream &file, Size &size) {
+    unsigned char header[24];
+    if (!readBytes(file, header, sizeof(header)) 
+            || !equal(PNG_SIGNATURE, PNG_SIGNATURE + 8, header)
+            || !equal(header + 12, header + 16, (const unsigned char *) "IHDR")) {
+        return false;
+    }
+    size = Size(bigEndian(header + 16, 4), bigEndian(header + 20, 4));
+    return size.width > 0 && size.height > 0;
+}
+
+/**
+ * Walks the JPEG markers up to the first start of frame segment, which holds the height and
+ * width. Every other segment is skipped using its length field.
+ */
+static bool readJpegSize(ifstream &file, Size &size) {
+    unsigned char bytes[7];
+    // Skip the start of image marker
+    file.seekg(2);
+    for (;;) {
+        // Markers start with 0xFF, possibly padded with more 0xFF fill bytes
+        if (!readBytes(file, bytes, 1) || bytes[0] != 0xFF) {
+            return false;
+        }
+        unsigned char marker;
+        do {
+            if (!readBytes(file, &marker, 1)) {
+                return false;
+            }
+        } while (marker == 0xFF);
+        // Standalone markers have no length
+        if (marker == 0x01 || (marker >= 0xD0 && marker <= 0xD7)) {
+            continue;
+        }
+        // Start of scan or end of image before any frame header
+        if (marker == 0xDA || marker == 0xD9) {
+            return false;
+        }
+        if (!readBytes(file, bytes, 2)) {
+            return false;
+        }
+        int length = bigEndian(bytes, 2);
+        if (length < 2) {
+            return false;
+        }
+        // SOF0 - SOF15, except DHT (C4), JPG (C8), and DAC (CC)
+        if (marker >= 0xC0 && marker <= 0xCF 
+                && marker != 0xC4 && marker != 0xC8 && marker != 0xCC) {
+            if (length < 7 || !readBytes(file, bytes, 5)) {
+                return false;
+            }
+            size = Size(bigEndian(bytes + 3, 2), bigEndian(bytes + 1, 2));
+            return size.width > 0 && size.height > 0;
+        }
+        file.seekg(length - 2, ios::cur);
+    }
+}
+
+static bool readBytes(ifstream &file, unsigned char *bytes, int count) {
+    return (bool) file.read((char *) bytes, count);
+}
+
+static uint32_t bigEndian(const unsigned char *bytes, int count) {
+    uint32_t value = 0;
+    for (int i = 0; i < count; i++) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
@@ -30,9 +30,20 @@
  * height and maximum width. 
  * Padding is done such that the images are centered.
  *
+ * padImagesBatch does the same without a window in one decode and one encode per image: sizes
+ * come from the JPEG/PNG headers, images are padded in parallel, and the padded sizes are 
+ * checked in memory instead of by reading every image back.
+ *
  * This code was adapted from OpenCV tutorials found at:
  */
 #include "pad_images.hpp"
+#include "image_header.hpp"
+#include "../worker-pool/worker_pool.hpp"
+
+#include <sys/stat.h>
+
+#include <atomic>
+#include <vector>
 
 using namespace cv;
 using namespace std;
@@ -46,6 +57,7 @@ static const char separator = ';';
 
 // Function headers
 static int makeBorder(string fileName, int newImageHeight, int newImageWidth);
+static string getFileName(const string &path);
 
 void padImages(string csvFileName) {
     // Find max sizes
@@ -132,6 +144,85 @@ void padImages(string csvFileName) {
     printf("MinWidth: %d\n", minWidth);
 }
 
+/**
+ * Pads every image in the csv file to the largest width and height, centered on white, with no
+ * interaction. Padded images overwrite their sources unless outputDirectory is given, in which
+ * case they are saved there under their file names. Returns the number of images that could 
+ * not be read, padded to the right size, or written.
+ */
+int padImagesBatch(string csvFileName, string outputDirectory) {
+    std::ifstream file(csvFileName.c_str(), ifstream::in);
+    if (!file) {
+        string error_message = "No valid input file was given, please check the given fileName.";
+        CV_Error(CV_StsBadArg, error_message);
+    }
+    vector<string> paths;
+    string line, path;
+    while (getline(file, line)) {
+        stringstream liness(line);
+        getline(liness, path, separator);
+        if(!path.empty()) {
+            paths.push_back(path);
+        }
+    }
+    if (!outputDirectory.empty()) {
+        mkdir(outputDirectory.c_str(), 0755);
+    }
+    WorkerPool &pool = WorkerPool::shared();
+
+    // Find max sizes from the headers, decoding only formats without a header reader
+    vector<Size> sizes(paths.size());
+    pool.run(paths.size(), [&](int i) {
+        if (!readImageHeaderSize(paths[i], sizes[i])) {
+            sizes[i] = imread(paths[i]).size();
+        }
+    });
+    int maxHeight = 0;
+    int maxWidth = 0;
+    for (unsigned int i = 0; i < sizes.size(); i++) {
+        maxWidth = max(maxWidth, sizes[i].width);
+        maxHeight = max(maxHeight, sizes[i].height);
+    }
+    printf("MaxHeight: %d\n", maxHeight);
+    printf("MaxWidth: %d\n", maxWidth);
+
+    // Pad, check the padded size, and save each image
+    atomic<int> failures(0);
+    vector<Size> paddedSizes(paths.size(), Size(INT_MAX, INT_MAX));
+    pool.run(paths.size(), [&](int i) {
+        Mat image = imread(paths[i]);
+        if (image.empty() || image.cols > maxWidth || image.rows > maxHeight) {
+            printf("Could not pad %s\n", paths[i].c_str());
+            failures++;
+            return;
+        }
+        Mat padded;
+        copyMakeBorder(image, padded, 
+                floor((maxHeight - image.rows) / 2.0), ceil((maxHeight - image.rows) / 2.0),
+                floor((maxWidth - image.cols) / 2.0), ceil((maxWidth - image.cols) / 2.0),
+                BORDER_CONSTANT, Scalar(255, 255, 255));
+        paddedSizes[i] = padded.size();
+        string outputPath = outputDirectory.empty() 
+                ? paths[i] : outputDirectory + "/" + getFileName(paths[i]);
+        if (padded.rows != maxHeight || padded.cols != maxWidth || !imwrite(outputPath, padded)) {
+            printf("Could not save %s\n", outputPath.c_str());
+            failures++;
+        }
+    });
+
+    // This is a sanity check to ensure that there were no rounding errors in padding, etc.
+    int minHeight = INT_MAX;
+    int minWidth = INT_MAX;
+    for (unsigned int i = 0; i < paddedSizes.size(); i++) {
+        minWidth = min(minWidth, paddedSizes[i].width);
+        minHeight = min(minHeight, paddedSizes[i].height);
+    }
+    // These should be the same!
+    printf("\nMinHeight: %d\n", minHeight);
+    printf("MinWidth: %d\n", minWidth);
+    return failures;
+}
+
 static int makeBorder(string fileName, int newImageHeight, int newImageWidth) {
     /// Load an image
     src = imread(fileName.c_str());
@@ -180,6 +271,11 @@ static int makeBorder(string fileName, int newImageHeight, int newImageWidth) {
     return 0;
 }
 
+static string getFileName(const string &path) {
+    size_t slashPos = path.find_last_of('/');
+    return slashPos == string::npos ? path : path.substr(slashPos + 1);
+}
+
 // Test code for padding a single image
 /* 
 static string test_image_fileName = "../data/me/2015-12-20-150900.jpg";
@@ -38,5 +38,6 @@
 #include <sstream>
 
 void padImages(std::string csvFileName);
+int padImagesBatch(std::string csvFileName, std::string outputDirectory = "");
 
 #endif
\ No newline at end of file
@@ -23,8 +23,27 @@
 
 #include "pad_images.hpp"
 
-int main(void) {
+// Usage: pad_images [csv file] [--batch] [--output=<directory>]
+// --batch pads without showing each image, --output saves the padded images there instead of
+// over the originals.
+int main(int argc, const char *argv[]) {
     std::string csvFileName = "yalefaces.csv";
+    std::string outputDirectory;
+    bool batch = false;
+    for (int i = 1; i < argc; i++) {
+        std::string argument(argv[i]);
+        if (argument == "--batch") {
+            batch = true;
+        } else if (argument.compare(0, 9, "--output=") == 0) {
+            batch = true;
+            outputDirectory = argument.substr(9);
+        } else {
+            csvFileName = argument;
+        }
+    }
+    if (batch) {
+        return padImagesBatch(csvFileName, outputDirectory) != 0;
+    }
 	padImages(csvFileName);
 	return 0;
 }
@@ -0,0 +1,360 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "quantized_lbph.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const float MAX_CODE = 255.0f;
+
+//~Function Headers---------------------------------------------------------------------------------
+static double quantizedDistance(const uchar *a, const uchar *b, int length, float scale, 
+        QuantizedLbphRecognizer::Metric metric);
+static float chiSquareSum(const uchar *a, const uchar *b, int length);
+static uint64_t absoluteDifferenceSum(const uchar *a, const uchar *b, int length);
+#ifdef __SSE2__
+static __m128 addChiSquareLanes(__m128i a, __m128i b, __m128 total);
+#endif
+
+//~Functions----------------------------------------------------------------------------------------
+QuantizedLbphRecognizer::QuantizedLbphRecognizer(const LbphParameters &parameters, 
+        double threshold, Metric metric, WorkerPool &pool) 
+        : parameters(parameters), threshold(threshold), metric(metric), pool(&pool), 
+        scale(0) {
+}
+
+/**
+ * Extracts the histogram of every image in parallel, picks the scale from them and keeps 
+ * their quantized bins. Replaces any earlier training.
+ */
+void QuantizedLbphRecognizer::train(InputArrayOfArrays src, InputArray labels) {
+    histograms.release();
+    this->labels.clear();
+    scale = 0;
+    update(src, labels);
+}
+
+/**
+ * Adds more samples to the model, quantized with the scale found at training so the existing
+ * samples stay comparable. Bins larger than the scale allows are saturated.
+ */
+void QuantizedLbphRecognizer::update(InputArrayOfArrays src, InputArray labels) {
+    vector<Mat> images;
+    src.getMatVector(images);
+    Mat newLabels = labels.getMat();
+    if (images.empty() || (int) newLabels.total() != (int) images.size()) {
+        CV_Error(Error::StsBadArg, format("Expected one label per image, got %d images and %d "
+                "labels.", (int) images.size(), (int) newLabels.total()));
+    }
+    vector<Mat> floatHistograms(images.size());
+    pool->run(images.size(), [&](int i) {
+        computeLbphHistogram(images[i], parameters, floatHistograms[i]);
+    });
+    if (scale == 0) {
+        scale = findQuantizationScale(floatHistograms);
+    }
+    addSamples(floatHistograms, newLabels);
+}
+
+int QuantizedLbphRecognizer::predict(InputArray src) const {
+    int label;
+    double confidence;
+    predict(src, label, confidence);
+    return label;
+}
+
+/**
+ * Finds the training sample nearest to src. label is -1 and confidence DBL_MAX if none is 
+ * closer than the threshold, as with OpenCV's recognizers.
+ */
+void QuantizedLbphRecognizer::predict(InputArray src, int &label, double &confidence) const {
+    label = -1;
+    confidence = DBL_MAX;
+    if (histograms.empty()) {
+        CV_Error(Error::StsError, "QuantizedLbphRecognizer has not been trained or loaded.");
+    }
+    // Buffers are reused between calls, predict may run on several threads at once
+    static thread_local Mat histogram;
+    static thread_local Mat query;
+    computeLbphHistogram(src.getMat(), parameters, histogram);
+    quantizeLbphHistogram(histogram, scale, query);
+    const uchar *queryBins = query.ptr<uchar>(0);
+    for (int i = 0; i < histograms.rows; i++) {
+        double distance = quantizedDistance(histograms.ptr<uchar>(i), queryBins, 
+                histograms.cols, scale, metric);
+        if (distance < confidence && distance < threshold) {
+            confidence = distance;
+            label = labels[i];
+        }
+    }
+}
+
+/**
+ * Writes the LBPH settings and labels under OpenCV's names and the quantized histograms as 
+ * one 8 bit matrix.
+ */
+void QuantizedLbphRecognizer::save(FileStorage &fs) const {
+    fs << "radius" << parameters.radius;
+    fs << "neighbors" << parameters.neighbors;
+    fs << "grid_x" << parameters.gridX;
+    fs << "grid_y" << parameters.gridY;
+    fs << "metric" << (metric == INTERSECTION ? "intersection" : "chi_square");
+    fs << "scale" << scale;
+    fs << "quantized_histograms" << histograms;
+    fs << "labels" << Mat(labels, true);
+}
+
+/**
+ * Reads a model saved by this class, or an OpenCV LBPH model whose float histograms are 
+ * quantized as they are read.
+ */
+void QuantizedLbphRecognizer::load(const FileStorage &fs) {
+    fs["radius"] >> parameters.radius;
+    fs["neighbors"] >> parameters.neighbors;
+    fs["grid_x"] >> parameters.gridX;
+    fs["grid_y"] >> parameters.gridY;
+    Mat loadedLabels;
+    fs["labels"] >> loadedLabels;
+    histograms.release();
+    labels.clear();
+    if (!fs["quantized_histograms"].empty()) {
+        metric = (string) fs["metric"] == "intersection" ? INTERSECTION : CHI_SQUARE;
+        scale = (float) (double) fs["scale"];
+        fs["quantized_histograms"] >> histograms;
+        Mat labels32;
+        loadedLabels.reshape(1, 1).convertTo(labels32, CV_32S);
+        labels.assign(labels32.ptr<int>(0), labels32.ptr<int>(0) + labels32.total());
+        return;
+    }
+    FileNode histogramsNode = fs["histograms"];
+    vector<Mat> floatHistograms(histogramsNode.size());
+    for (unsigned int i = 0; i < floatHistograms.size(); i++) {
+        histogramsNode[i] >> floatHistograms[i];
+    }
+    scale = findQuantizationScale(floatHistograms);
+    addSamples(floatHistograms, loadedLabels);
+}
+
+const LbphParameters &QuantizedLbphRecognizer::getParameters() const {
+    return parameters;
+}
+
+QuantizedLbphRecognizer::Metric QuantizedLbphRecognizer::getMetric() const {
+    return metric;
+}
+
+/**
+ * Changes the distance used from now on. The two metrics have different ranges, so the 
+ * threshold usually needs to change with it.
+ */
+void QuantizedLbphRecognizer::setMetric(Metric metric) {
+    this->metric = metric;
+}
+
+double QuantizedLbphRecognizer::getThreshold() const {
+    return threshold;
+}
+
+void QuantizedLbphRecognizer::setThreshold(double threshold) {
+    this->threshold = threshold;
+}
+
+float QuantizedLbphRecognizer::getScale() const {
+    return scale;
+}
+
+int QuantizedLbphRecognizer::getSampleCount() const {
+    return histograms.rows;
+}
+
+/**
+ * Memory held by the histograms and labels, the whole of the trained model.
+ */
+size_t QuantizedLbphRecognizer::getModelBytes() const {
+    return histograms.total() * histograms.elemSize() + labels.size() * sizeof(int);
+}
+
+/**
+ * Quantizes float histograms into new rows of the model.
+ */
+void QuantizedLbphRecognizer::addSamples(const vector<Mat> &floatHistograms, 
+        const Mat &newLabels) {
+    Mat labels32;
+    newLabels.reshape(1, 1).convertTo(labels32, CV_32S);
+    Mat quantized;
+    for (unsigned int i = 0; i < floatHistograms.size(); i++) {
+        quantizeLbphHistogram(floatHistograms[i], scale, quantized);
+        histograms.push_back(quantized);
+        labels.push_back(labels32.at<int>(i));
+    }
+}
+
+/**
+ * The scale that maps the largest bin of any of the histograms to 255.
+ */
+float findQuantizationScale(const vector<Mat> &histograms) {
+    double largest = 0;
+    for (unsigned int i = 0; i < histograms.size(); i++) {
+        double histogramMax;
+        minMaxLoc(histograms[i], NULL, &histogramMax);
+        largest = max(largest, histogramMax);
+    }
+    return largest > 0 ? (float) (largest / MAX_CODE) : 1.0f / MAX_CODE;
+}
+
+/**
+ * Rounds each bin of a CV_32F histogram to the nearest multiple of scale, as a 1 x B CV_8U 
+ * row. Bins past 255 steps are saturated.
+ */
+void quantizeLbphHistogram(const Mat &histogram, float scale, Mat &quantized) {
+    CV_Assert(histogram.type() == CV_32FC1 && scale > 0);
+    histogram.reshape(1, 1).convertTo(quantized, CV_8U, 1.0 / scale);
+}
+
+/**
+ * The distance between two quantized histograms of the same scale, in units of the original
+ * float histograms.
+ */
+double compareQuantizedHistograms(const Mat &first, const Mat &second, float scale, 
+        QuantizedLbphRecognizer::Metric metric) {
+    CV_Assert(first.type() == CV_8UC1 && first.size() == second.size());
+    return quantizedDistance(first.ptr<uchar>(0), second.ptr<uchar>(0), (int) first.total(),
+            scale, metric);
+}
+
+/**
+ * Returns the index of the row of histograms among candidates closest to query and stores 
+ * its distance, or -1 if there are no candidates.
+ */
+int findNearestQuantizedHistogram(const Mat &histograms, const vector<int> &candidates, 
+        const Mat &query, float scale, QuantizedLbphRecognizer::Metric metric, 
+        double &distance) {
+    int nearest = -1;
+    distance = DBL_MAX;
+    const uchar *queryBins = query.ptr<uchar>(0);
+    for (unsigned int i = 0; i < candidates.size(); i++) {
+        double curDistance = quantizedDistance(histograms.ptr<uchar>(candidates[i]), queryBins, 
+                histograms.cols, scale, metric);
+        if (curDistance < distance) {
+            distance = curDistance;
+            nearest = candidates[i];
+        }
+    }
+    return nearest;
+}
+
+/**
+ * Chi-square is 2 sum((a - b)^2 / (a + b)), which scales linearly with the bins, and the L1
+ * distance sum|a - b| equals sum(a) + sum(b) - 2 sum(min(a, b)), the histogram intersection.
+ */
+static double quantizedDistance(const uchar *a, const uchar *b, int length, float scale, 
+        QuantizedLbphRecognizer::Metric metric) {
+    if (metric == QuantizedLbphRecognizer::INTERSECTION) {
+        return (double) absoluteDifferenceSum(a, b, length) * scale;
+    }
+    return 2.0 * chiSquareSum(a, b, length) * scale;
+}
+
+/**
+ * sum((a - b)^2 / (a + b)) over byte arrays, skipping empty bins, sixteen bins at a time 
+ * where SSE2 is available.
+ */
+static float chiSquareSum(const uchar *a, const uchar *b, int length) {
+    int i = 0;
+    float result = 0;
+#ifdef __SSE2__
+    const __m128i zero = _mm_setzero_si128();
+    __m128 total = _mm_setzero_ps();
+    for (; i + 16 <= length; i += 16) {
+        __m128i a8 = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i b8 = _mm_loadu_si128((const __m128i *) (b + i));
+        total = addChiSquareLanes(_mm_unpacklo_epi8(a8, zero), _mm_unpacklo_epi8(b8, zero), 
+                total);
+        total = addChiSquareLanes(_mm_unpackhi_epi8(a8, zero), _mm_unpackhi_epi8(b8, zero), 
+                total);
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, total);
+    result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < length; i++) {
+        int sum = a[i] + b[i];
+        if (sum > 0) {
+            int difference = a[i] - b[i];
+            result += (float) (difference * difference) / sum;
+        }
+    }
+    return result;
+}
+
+#ifdef __SSE2__
+/**
+ * Adds (a - b)^2 / (a + b) of eight 16 bit lanes to total. The square of a byte difference 
+ * fits an unsigned 16 bit lane, and an empty bin divides 0 by 1.
+ */
+static __m128 addChiSquareLanes(__m128i a, __m128i b, __m128 total) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128 one = _mm_set1_ps(1.0f);
+    __m128i difference = _mm_sub_epi16(a, b);
+    __m128i square = _mm_mullo_epi16(difference, difference);
+    __m128i sum = _mm_add_epi16(a, b);
+    __m128 squareLow = _mm_cvtepi32_ps(_mm_unpacklo_epi16(square, zero));
+    __m128 squareHigh = _mm_cvtepi32_ps(_mm_unpackhi_epi16(square, zero));
+    __m128 sumLow = _mm_max_ps(_mm_cvtepi32_ps(_mm_unpacklo_epi16(sum, zero)), one);
+    __m128 sumHigh = _mm_max_ps(_mm_cvtepi32_ps(_mm_unpackhi_epi16(sum, zero)), one);
+    total = _mm_add_ps(total, _mm_div_ps(squareLow, sumLow));
+    return _mm_add_ps(total, _mm_div_ps(squareHigh, sumHigh));
+}
+#endif
+
+/**
+ * sum|a - b| over byte arrays, sixteen bins per psadbw where SSE2 is available.
+ */
+static uint64_t absoluteDifferenceSum(const uchar *a, const uchar *b, int length) {
+    int i = 0;
+    uint64_t result = 0;
+#ifdef __SSE2__
+    __m128i total = _mm_setzero_si128();
+    for (; i + 16 <= length; i += 16) {
+        __m128i a8 = _mm_loadu_si128((const __m128i *) (a + i));
+        __m128i b8 = _mm_loadu_si128((const __m128i *) (b + i));
+        total = _mm_add_epi64(total, _mm_sad_epu8(a8, b8));
+    }
+    uint64_t lanes[2];
+    _mm_storeu_si128((__m128i *) lanes, total);
+    result = lanes[0] + lanes[1];
+#endif
+    for (; i < length; i++) {
+        result += a[i] > b[i] ? a[i] - b[i] : b[i] - a[i];
+    }
+    return result;
+}
@@ -0,0 +1,258 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "recognition_cache.hpp"
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const int HASH_SIDE = 8;
+
+//~Function Headers---------------------------------------------------------------------------------
+static double overlap(const Rect &a, const Rect &b);
+static int hammingDistance(uint64_t a, uint64_t b);
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * The defaults confirm a still face on its third prediction, 30 frames (about 1 s at 30 fps) 
+ * after it appears; a moving face changes its hash and is predicted, and confirmed, sooner. 
+ * Lower refreshInterval or minVotes to trade recognizer runs or robustness for latency.
+ */
+RecognitionCacheConfig::RecognitionCacheConfig() 
+        : refreshInterval(15), hashDistanceThreshold(8), minTrackOverlap(0.3), 
+        voteWindow(10), minVotes(3), minVoteShare(0.6), maxMissedFrames(5) {
+}
+
+RecognitionCache::RecognitionCache(const Ptr<face::FaceRecognizer> &model, const Size &faceSize,
+        const RecognitionCacheConfig &config) 
+        : recognizer(model, faceSize), config(config), nextTrackId(0), 
+        predictionCount(0), cacheHitCount(0) {
+}
+
+/**
+ * Associates faces (detected in gray) with existing tracks, predicts the identity of new or 
+ * changed faces as one batch, and fills identities with one entry per face in detection order.
+ * Once the number of tracks has stabilized no memory is allocated.
+ */
+void RecognitionCache::update(const Mat &gray, const vector<Rect> &faces, 
+        vector<TrackedIdentity> &identities) {
+    identities.resize(faces.size());
+    faceTracks.resize(faces.size());
+    pendingFaces.clear();
+    pendingTracks.clear();
+    // Only tracks that existed before this frame can be matched, new tracks are appended
+    int numOldTracks = tracks.size();
+    for (int j = 0; j < numOldTracks; j++) {
+        tracks[j].missedFrames++;
+    }
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        // Greedily match this face to the unmatched track it overlaps the most
+        int bestTrack = -1;
+        double bestOverlap = config.minTrackOverlap;
+        for (int j = 0; j < numOldTracks; j++) {
+            double curOverlap = overlap(faces[i], tracks[j].face);
+            if (tracks[j].missedFrames > 0 && curOverlap >= bestOverlap) {
+                bestOverlap = curOverlap;
+                bestTrack = j;
+            }
+        }
+
+        uint64_t hash = averageHash(gray(faces[i]));
+        TrackedIdentity &identity = identities[i];
+        identity.face = faces[i];
+        identity.predicted = true;
+        if (bestTrack == -1) {
+            startTrack(faces[i], hash);
+            faceTracks[i] = tracks.size() - 1;
+            pendingFaces.push_back(faces[i]);
+            pendingTracks.push_back(faceTracks[i]);
+            continue;
+        }
+
+        Track &track = tracks[bestTrack];
+        faceTracks[i] = bestTrack;
+        track.face = faces[i];
+        track.missedFrames = 0;
+        track.framesSinceRefresh++;
+        if (track.framesSinceRefresh >= config.refreshInterval
+                || hammingDistance(track.hash, hash) > config.hashDistanceThreshold) {
+            track.hash = hash;
+            pendingFaces.push_back(faces[i]);
+            pendingTracks.push_back(bestTrack);
+        } else {
+            identity.predicted = false;
+            cacheHitCount++;
+        }
+    }
+
+    // Predict every new or changed face at once, then vote in detection order
+    recognizer.predict(gray, pendingFaces, predictions);
+    for (unsigned int k = 0; k < pendingTracks.size(); k++) {
+        Track &track = tracks[pendingTracks[k]];
+        track.prediction = predictions[k].label;
+        track.confidence = predictions[k].confidence;
+        track.framesSinceRefresh = 0;
+        predictionCount++;
+    }
+    for (unsigned int i = 0; i < faces.size(); i++) {
+        vote(tracks[faceTracks[i]], identities[i]);
+    }
+
+    // Age out tracks that have not been seen for too long, compacting in place
+    unsigned int kept = 0;
+    for (unsigned int j = 0; j < tracks.size(); j++) {
+        if (tracks[j].missedFrames > config.maxMissedFrames) {
+            continue;
+        }
+        if (kept != j) {
+            std::swap(tracks[kept], tracks[j]);
+        }
+        kept++;
+    }
+    tracks.resize(kept);
+}
+
+/**
+ * Drops every track, e.g. when the video source changes.
+ */
+void RecognitionCache::clear() {
+    tracks.clear();
+}
+
+unsigned long RecognitionCache::getPredictionCount() const {
+    return predictionCount;
+}
+
+unsigned long RecognitionCache::getCacheHitCount() const {
+    return cacheHitCount;
+}
+
+/**
+ * Appends a new track for face with empty, preallocated vote buffers.
+ */
+void RecognitionCache::startTrack(const Rect &face, uint64_t hash) {
+    tracks.push_back(Track());
+    Track &track = tracks.back();
+    track.id = nextTrackId++;
+    track.face = face;
+    track.hash = hash;
+    track.missedFrames = 0;
+    track.votes.assign(config.voteWindow, -1);
+    track.voteHead = 0;
+    track.voteCount = 0;
+    track.voteHistogram.reserve(config.voteWindow);
+}
+
+/**
+ * Adds the track's prediction to its vote window if it was just predicted, and writes the 
+ * track's raw and smoothed identity into identity. Reused predictions don't vote, so every 
+ * vote is a separate run of the recognizer.
+ */
+void RecognitionCache::vote(Track &track, TrackedIdentity &identity) {
+    if (identity.predicted) {
+        // Evict the oldest vote once the window is full
+        if (track.voteCount == config.voteWindow) {
+            int oldest = track.votes[track.voteHead];
+            for (unsigned int k = 0; k < track.voteHistogram.size(); k++) {
+                if (track.voteHistogram[k].first == oldest) {
+                    if (--track.voteHistogram[k].second == 0) {
+                        track.voteHistogram.erase(track.voteHistogram.begin() + k);
+                    }
+                    break;
+                }
+            }
+        } else {
+            track.voteCount++;
+        }
+        track.votes[track.voteHead] = track.prediction;
+        track.voteHead = (track.voteHead + 1) % config.voteWindow;
+
+        bool counted = false;
+        for (unsigned int k = 0; k < track.voteHistogram.size() && !counted; k++) {
+            if (track.voteHistogram[k].first == track.prediction) {
+                track.voteHistogram[k].second++;
+                counted = true;
+            }
+        }
+        if (!counted) {
+            track.voteHistogram.push_back(make_pair(track.prediction, 1));
+        }
+    }
+
+    int leader = -1;
+    int leaderVotes = 0;
+    for (unsigned int k = 0; k < track.voteHistogram.size(); k++) {
+        if (track.voteHistogram[k].second > leaderVotes) {
+            leader = track.voteHistogram[k].first;
+            leaderVotes = track.voteHistogram[k].second;
+        }
+    }
+
+    identity.trackId = track.id;
+    identity.prediction = track.prediction;
+    identity.confidence = track.confidence;
+    identity.smoothedPrediction = leader;
+    identity.voteShare = track.voteCount == 0 ? 0.0 : (double) leaderVotes / track.voteCount;
+    identity.stable = leaderVotes >= config.minVotes && identity.voteShare >= config.minVoteShare;
+}
+
+/**
+ * Computes a 64 bit average hash of face: each bit says whether one cell of an 8x8 
+ * downsampled copy is brighter than the mean of all cells.
+ */
+uint64_t RecognitionCache::averageHash(const Mat &face) {
+    cv::resize(face, hashFace, Size(HASH_SIDE, HASH_SIDE), 0, 0, INTER_AREA);
+    int total = 0;
+    for (int y = 0; y < HASH_SIDE; y++) {
+        const uchar *row = hashFace.ptr<uchar>(y);
+        for (int x = 0; x < HASH_SIDE; x++) {
+            total += row[x];
+        }
+    }
+    int mean = total / (HASH_SIDE * HASH_SIDE);
+    uint64_t hash = 0;
+    for (int y = 0; y < HASH_SIDE; y++) {
+        const uchar *row = hashFace.ptr<uchar>(y);
+        for (int x = 0; x < HASH_SIDE; x++) {
+            hash = (hash << 1) | (row[x] > mean ? 1 : 0);
+        }
+    }
+    return hash;
+}
+
+/**
+ * Intersection over union of two rectangles.
+ */
+static double overlap(const Rect &a, const Rect &b) {
+    int intersection = (a & b).area();
+    int combined = a.area() + b.area() - intersection;
+    if (combined <= 0) {
+        return 0.0;
+    }
+    return (double) intersection / combined;
+}
+
+static int hammingDistance(uint64_t a, uint64_t b) {
+    return __builtin_popcountll(a ^ b);
+}
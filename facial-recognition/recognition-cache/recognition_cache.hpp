@@ -0,0 +1,140 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RECOGNITION_CACHE_HPP_
+#define RECOGNITION_CACHE_HPP_
+
+#include "../batch-recognition/batch_recognizer.hpp"
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+#include <opencv2/imgproc/imgproc.hpp>
+
+#include <stdint.h>
+
+#include <utility>
+#include <vector>
+
+/**
+ * Tuning knobs for RecognitionCache.
+ */
+struct RecognitionCacheConfig {
+    // Force a new prediction after this many frames even if the face looks unchanged.
+    int refreshInterval;
+    // Maximum Hamming distance (out of 64 bits) between the average hashes of a track's
+    // last predicted face and its current face for the cached prediction to be reused.
+    int hashDistanceThreshold;
+    // Minimum intersection over union for a detection to be associated with a track.
+    double minTrackOverlap;
+    // Number of recent predictions kept as votes for the smoothed identity decision.
+    int voteWindow;
+    // Minimum number of votes and share of the vote window the leading label needs before
+    // the smoothed identity is considered stable. Only fresh predictions vote, so a face that
+    // keeps still is confirmed no sooner than (minVotes - 1) * refreshInterval frames after it
+    // is first seen.
+    int minVotes;
+    double minVoteShare;
+    // Tracks that go unmatched for more than this many frames are dropped.
+    int maxMissedFrames;
+
+    RecognitionCacheConfig();
+};
+
+/**
+ * The recognition result for one detected face in the current frame.
+ */
+struct TrackedIdentity {
+    int trackId;
+    cv::Rect face;
+    // Raw prediction and confidence, possibly reused from a previous frame.
+    int prediction;
+    double confidence;
+    // Majority label over the track's vote window and the share of the window it holds.
+    int smoothedPrediction;
+    double voteShare;
+    // True when the smoothed prediction has enough votes to be trusted.
+    bool stable;
+    // True when model->predict was actually run for this face in this frame.
+    bool predicted;
+};
+
+/**
+ * Caches face recognition results per tracked face across video frames.
+ *
+ * Detections are associated with tracks from the previous frame by overlap. The recognizer is
+ * only re-run for a track when the face's low resolution average hash drifts past a threshold
+ * or when the track's refresh interval expires; otherwise the cached prediction is reused.
+ * The faces that do need the recognizer are predicted together by a BatchRecognizer.
+ * Every fresh prediction, not a reused one, adds a vote to the track's histogram and the 
+ * majority label is reported as the smoothed identity, so a single misclassification cannot 
+ * confirm or reject a face.
+ */
+class RecognitionCache {
+public:
+    RecognitionCache(const cv::Ptr<cv::face::FaceRecognizer> &model, const cv::Size &faceSize,
+            const RecognitionCacheConfig &config = RecognitionCacheConfig());
+
+    void update(const cv::Mat &gray, const std::vector<cv::Rect> &faces, 
+            std::vector<TrackedIdentity> &identities);
+    void clear();
+
+    unsigned long getPredictionCount() const;
+    unsigned long getCacheHitCount() const;
+
+private:
+    struct Track {
+        int id;
+        cv::Rect face;
+        uint64_t hash;
+        int prediction;
+        double confidence;
+        int framesSinceRefresh;
+        int missedFrames;
+        // Ring buffer of the last config.voteWindow fresh predictions and a (label, count) 
+        // histogram over it, both sized once so that voting does not allocate.
+        std::vector<int> votes;
+        int voteHead;
+        int voteCount;
+        std::vector<std::pair<int, int> > voteHistogram;
+    };
+
+    BatchRecognizer recognizer;
+    RecognitionCacheConfig config;
+    std::vector<Track> tracks;
+    int nextTrackId;
+    unsigned long predictionCount;
+    unsigned long cacheHitCount;
+    // Scratch buffers reused between frames: the track of each face, the faces that need a new
+    // prediction and their tracks, the batch's predictions, and the average hash image
+    std::vector<int> faceTracks;
+    std::vector<cv::Rect> pendingFaces;
+    std::vector<int> pendingTracks;
+    std::vector<FacePrediction> predictions;
+    cv::Mat hashFace;
+
+    void startTrack(const cv::Rect &face, uint64_t hash);
+    void vote(Track &track, TrackedIdentity &identity);
+    uint64_t averageHash(const cv::Mat &face);
+};
+
+#endif
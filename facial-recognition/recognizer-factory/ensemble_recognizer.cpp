@@ -0,0 +1,132 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ensemble_recognizer.hpp"
+
+#include <cfloat>
+
+using namespace cv;
+using namespace std;
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * cheap should have no threshold of its own, it is given acceptDistance and rejectDistance 
+ * instead.
+ */
+EnsembleRecognizer::EnsembleRecognizer(const Ptr<face::FaceRecognizer> &cheap, 
+        const Ptr<face::FaceRecognizer> &costly, double acceptDistance, double rejectDistance)
+        : cheap(cheap), costly(costly), acceptDistance(acceptDistance), 
+        rejectDistance(rejectDistance), predictionCount(0), escalationCount(0) {
+}
+
+void EnsembleRecognizer::train(InputArrayOfArrays src, InputArray labels) {
+    cheap->train(src, labels);
+    costly->train(src, labels);
+}
+
+void EnsembleRecognizer::update(InputArrayOfArrays src, InputArray labels) {
+    cheap->update(src, labels);
+    costly->update(src, labels);
+}
+
+int EnsembleRecognizer::predict(InputArray src) const {
+    int label;
+    double confidence;
+    predict(src, label, confidence);
+    return label;
+}
+
+void EnsembleRecognizer::predict(InputArray src, int &label, double &confidence) const {
+    predictionCount++;
+    cheap->predict(src, label, confidence);
+    if (label != -1 && confidence < acceptDistance) {
+        return;
+    }
+    if (label == -1 || confidence >= rejectDistance) {
+        label = -1;
+        confidence = DBL_MAX;
+        return;
+    }
+    escalationCount++;
+    costly->predict(src, label, confidence);
+}
+
+/**
+ * Saves the ensemble to filename and the two models next to it, in filename.cheap and 
+ * filename.costly.
+ */
+void EnsembleRecognizer::save(const String &filename) const {
+    FileStorage fs(filename, FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        CV_Error(Error::StsError, "File can't be opened for writing!");
+    }
+    save(fs);
+    cheap->save(filename + ".cheap");
+    costly->save(filename + ".costly");
+}
+
+/**
+ * Loads an ensemble saved by save(filename), along with its two models.
+ */
+void EnsembleRecognizer::load(const String &filename) {
+    FileStorage fs(filename, FileStorage::READ);
+    if (!fs.isOpened()) {
+        CV_Error(Error::StsError, "File can't be opened for reading!");
+    }
+    load(fs);
+    cheap->load(filename + ".cheap");
+    costly->load(filename + ".costly");
+}
+
+/**
+ * Writes the distance band only, the models are too large to nest in one file and are saved
+ * on their own.
+ */
+void EnsembleRecognizer::save(FileStorage &fs) const {
+    fs << "accept_distance" << acceptDistance;
+    fs << "reject_distance" << rejectDistance;
+}
+
+void EnsembleRecognizer::load(const FileStorage &fs) {
+    fs["accept_distance"] >> acceptDistance;
+    fs["reject_distance"] >> rejectDistance;
+}
+
+const Ptr<face::FaceRecognizer> &EnsembleRecognizer::getCheap() const {
+    return cheap;
+}
+
+const Ptr<face::FaceRecognizer> &EnsembleRecognizer::getCostly() const {
+    return costly;
+}
+
+unsigned long EnsembleRecognizer::getPredictionCount() const {
+    return predictionCount;
+}
+
+/**
+ * How many predictions the cheap model was unsure of and passed to the costly model.
+ */
+unsigned long EnsembleRecognizer::getEscalationCount() const {
+    return escalationCount;
+}
@@ -0,0 +1,72 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef ENSEMBLE_RECOGNIZER_HPP_
+#define ENSEMBLE_RECOGNIZER_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+
+#include <atomic>
+
+/**
+ * Two recognizers, a cheap one asked first and a costly one asked only when the cheap one is
+ * unsure.
+ *
+ * The cheap model's distance decides on its own when it is below acceptDistance (a match) or
+ * at least rejectDistance (no match). Distances in between are ambiguous and the costly model
+ * is asked instead, with its own threshold. The confidence returned is the distance of 
+ * whichever model decided, so its scale depends on that model. Both models are trained on the
+ * same faces, which must be sized for both.
+ */
+class EnsembleRecognizer : public cv::face::FaceRecognizer {
+public:
+    EnsembleRecognizer(const cv::Ptr<cv::face::FaceRecognizer> &cheap, 
+            const cv::Ptr<cv::face::FaceRecognizer> &costly, double acceptDistance, 
+            double rejectDistance);
+
+    void train(cv::InputArrayOfArrays src, cv::InputArray labels);
+    void update(cv::InputArrayOfArrays src, cv::InputArray labels);
+    int predict(cv::InputArray src) const;
+    void predict(cv::InputArray src, int &label, double &confidence) const;
+
+    void save(const cv::String &filename) const;
+    void load(const cv::String &filename);
+    void save(cv::FileStorage &fs) const;
+    void load(const cv::FileStorage &fs);
+
+    const cv::Ptr<cv::face::FaceRecognizer> &getCheap() const;
+    const cv::Ptr<cv::face::FaceRecognizer> &getCostly() const;
+    unsigned long getPredictionCount() const;
+    unsigned long getEscalationCount() const;
+
+private:
+    cv::Ptr<cv::face::FaceRecognizer> cheap;
+    cv::Ptr<cv::face::FaceRecognizer> costly;
+    double acceptDistance;
+    double rejectDistance;
+    mutable std::atomic<unsigned long> predictionCount;
+    mutable std::atomic<unsigned long> escalationCount;
+};
+
+#endif
@@ -0,0 +1,359 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "recognizer_factory.hpp"
+#include "ensemble_recognizer.hpp"
+#include "../quantized-lbph/quantized_lbph.hpp"
+#include "../subspace-recognizer/subspace_recognizer.hpp"
+
+#include <cfloat>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Name of the metadata map written ahead of the model in saved files, and its layout version
+static const char *METADATA_NODE = "lgtm_recognizer";
+static const int METADATA_VERSION = 1;
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool isKnownModel(const string &model);
+static RecognizerConfig getMemberConfig(const RecognizerConfig &config, bool cheap);
+
+//~Functions----------------------------------------------------------------------------------------
+RecognizerConfig::RecognizerConfig() 
+        : model("lbph"), threshold(-1), numComponents(0), radius(10), neighbors(8), gridX(4),
+        gridY(4), cheapModel("fisher"), costlyModel("lbph"), cheapThreshold(-1), 
+        ambiguity(0.25), faceSize(168, 168) {
+}
+
+/**
+ * The distance threshold each model was tuned to on the yalefaces data. Quantized LBPH 
+ * measures the same chi-square distance as LBPH.
+ */
+double getDefaultThreshold(const string &model) {
+    if (model == "fisher") {
+        return 2200.0;
+    } else if (model == "eigen") {
+        return 7250.0;
+    }
+    return 25.0;
+}
+
+/**
+ * Whether the model can learn a dataset in batches with update() instead of all at once.
+ */
+bool isIncrementalModel(const RecognizerConfig &config) {
+    return config.model == "lbph" || config.model == "qlbph";
+}
+
+/**
+ * A one line summary of the model and its settings, for logs.
+ */
+string describeRecognizer(const RecognizerConfig &config) {
+    if (config.model == "ensemble") {
+        return format("ensemble of %s then %s (ambiguity %g) -> ", config.cheapModel.c_str(),
+                config.costlyModel.c_str(), config.ambiguity) 
+                + describeRecognizer(getMemberConfig(config, true)) + ", " 
+                + describeRecognizer(getMemberConfig(config, false));
+    }
+    double threshold = config.threshold < 0 ? getDefaultThreshold(config.model) : config.threshold;
+    if (config.model == "lbph" || config.model == "qlbph") {
+        return format("%s radius %d, %d neighbors, %dx%d grid, threshold %g", 
+                config.model.c_str(), config.radius, config.neighbors, config.gridX, 
+                config.gridY, threshold);
+    }
+    return format("%s %d components, threshold %g", config.model.c_str(), config.numComponents,
+            threshold);
+}
+
+/**
+ * Builds an untrained recognizer for config. Eigenfaces and Fisherfaces use the single 
+ * precision SubspaceFaceRecognizer, "qlbph" is LBPH with 8 bit histograms. Returns an empty 
+ * pointer for an unknown model.
+ */
+Ptr<face::FaceRecognizer> createRecognizer(const RecognizerConfig &config) {
+    double threshold = config.threshold < 0 ? getDefaultThreshold(config.model) : config.threshold;
+    if (config.model == "lbph") {
+        return face::createLBPHFaceRecognizer(config.radius, config.neighbors, config.gridX, 
+                config.gridY, threshold);
+    } else if (config.model == "qlbph") {
+        return makePtr<QuantizedLbphRecognizer>(LbphParameters(config.radius, config.neighbors,
+                config.gridX, config.gridY), threshold);
+    } else if (config.model == "eigen") {
+        return makePtr<SubspaceFaceRecognizer>(SubspaceFaceRecognizer::EIGENFACES, 
+                config.numComponents, threshold);
+    } else if (config.model == "fisher") {
+        return makePtr<SubspaceFaceRecognizer>(SubspaceFaceRecognizer::FISHERFACES, 
+                config.numComponents, threshold);
+    } else if (config.model == "ensemble") {
+        // The cheap model reports every distance, the ensemble applies its threshold band
+        RecognizerConfig cheapConfig = getMemberConfig(config, true);
+        double cheapThreshold = cheapConfig.threshold;
+        cheapConfig.threshold = DBL_MAX;
+        Ptr<face::FaceRecognizer> cheap = createRecognizer(cheapConfig);
+        Ptr<face::FaceRecognizer> costly = createRecognizer(getMemberConfig(config, false));
+        return makePtr<EnsembleRecognizer>(cheap, costly, 
+                cheapThreshold * (1 - config.ambiguity), cheapThreshold * (1 + config.ambiguity));
+    }
+    return Ptr<face::FaceRecognizer>();
+}
+
+/**
+ * Saves model to path with a metadata map describing config ahead of the model's own nodes,
+ * so loadRecognizer can rebuild the right recognizer without being told which it is.
+ */
+bool saveRecognizer(const Ptr<face::FaceRecognizer> &model, const RecognizerConfig &config, 
+        const string &path) {
+    FileStorage fs(path, FileStorage::WRITE);
+    if (!fs.isOpened()) {
+        cerr << "Could not write the model to " << path << endl;
+        return false;
+    }
+    fs << METADATA_NODE << "{";
+    fs << "version" << METADATA_VERSION;
+    writeRecognizerConfig(fs, config);
+    fs << "}";
+    model->save(fs);
+    // Ensemble members are saved next to the ensemble, each with its own metadata
+    Ptr<EnsembleRecognizer> ensemble = model.dynamicCast<EnsembleRecognizer>();
+    if (!ensemble.empty()) {
+        RecognizerConfig cheapConfig = getMemberConfig(config, true);
+        cheapConfig.threshold = DBL_MAX;
+        return saveRecognizer(ensemble->getCheap(), cheapConfig, path + ".cheap")
+                && saveRecognizer(ensemble->getCostly(), getMemberConfig(config, false), 
+                        path + ".costly");
+    }
+    return true;
+}
+
+/**
+ * Loads a model saved by saveRecognizer, replacing config with its metadata. Files saved 
+ * without metadata, by earlier versions of the tools, are loaded as the model config names.
+ * Returns an empty pointer if the file cannot be read.
+ */
+Ptr<face::FaceRecognizer> loadRecognizer(const string &path, RecognizerConfig &config) {
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) {
+        cerr << "Could not read the model at " << path << endl;
+        return Ptr<face::FaceRecognizer>();
+    }
+    FileNode metadata = fs[METADATA_NODE];
+    if (!metadata.empty() && !readRecognizerConfig(metadata, config)) {
+        cerr << "Unsupported model metadata in " << path << endl;
+        return Ptr<face::FaceRecognizer>();
+    }
+    Ptr<face::FaceRecognizer> model = createRecognizer(config);
+    if (model.empty()) {
+        return model;
+    }
+    model->load(fs);
+    Ptr<EnsembleRecognizer> ensemble = model.dynamicCast<EnsembleRecognizer>();
+    if (!ensemble.empty()) {
+        ensemble->getCheap()->load(path + ".cheap");
+        ensemble->getCostly()->load(path + ".costly");
+    }
+    return model;
+}
+
+/**
+ * Reads the config keys present in node, leaving the others as they are. Returns false if a
+ * model name is not known.
+ */
+bool readRecognizerConfig(const FileNode &node, RecognizerConfig &config) {
+    if (!node["model"].empty()) {
+        config.model = (string) node["model"];
+    }
+    if (!node["threshold"].empty()) {
+        config.threshold = (double) node["threshold"];
+    }
+    if (!node["num_components"].empty()) {
+        config.numComponents = (int) node["num_components"];
+    }
+    if (!node["radius"].empty()) {
+        config.radius = (int) node["radius"];
+    }
+    if (!node["neighbors"].empty()) {
+        config.neighbors = (int) node["neighbors"];
+    }
+    if (!node["grid_x"].empty()) {
+        config.gridX = (int) node["grid_x"];
+    }
+    if (!node["grid_y"].empty()) {
+        config.gridY = (int) node["grid_y"];
+    }
+    if (!node["cheap_model"].empty()) {
+        config.cheapModel = (string) node["cheap_model"];
+    }
+    if (!node["costly_model"].empty()) {
+        config.costlyModel = (string) node["costly_model"];
+    }
+    if (!node["cheap_threshold"].empty()) {
+        config.cheapThreshold = (double) node["cheap_threshold"];
+    }
+    if (!node["ambiguity"].empty()) {
+        config.ambiguity = (double) node["ambiguity"];
+    }
+    if (!node["face_width"].empty() && !node["face_height"].empty()) {
+        config.faceSize = Size((int) node["face_width"], (int) node["face_height"]);
+    }
+    return isKnownModel(config.model) && isKnownModel(config.cheapModel) 
+            && isKnownModel(config.costlyModel) && config.cheapModel != "ensemble"
+            && config.costlyModel != "ensemble";
+}
+
+/**
+ * Writes every config key into the map fs is in.
+ */
+void writeRecognizerConfig(FileStorage &fs, const RecognizerConfig &config) {
+    fs << "model" << config.model;
+    fs << "threshold" << config.threshold;
+    fs << "num_components" << config.numComponents;
+    fs << "radius" << config.radius;
+    fs << "neighbors" << config.neighbors;
+    fs << "grid_x" << config.gridX;
+    fs << "grid_y" << config.gridY;
+    fs << "cheap_model" << config.cheapModel;
+    fs << "costly_model" << config.costlyModel;
+    fs << "cheap_threshold" << config.cheapThreshold;
+    fs << "ambiguity" << config.ambiguity;
+    fs << "face_width" << config.faceSize.width;
+    fs << "face_height" << config.faceSize.height;
+}
+
+/**
+ * Reads a YAML or XML config file whose top level holds the keys writeRecognizerConfig 
+ * writes.
+ */
+bool loadRecognizerConfig(const string &path, RecognizerConfig &config) {
+    FileStorage fs(path, FileStorage::READ);
+    if (!fs.isOpened()) {
+        cerr << "Could not read the recognizer config at " << path << endl;
+        return false;
+    }
+    FileNode root = fs.root();
+    FileNode metadata = root[METADATA_NODE];
+    return readRecognizerConfig(metadata.empty() ? root : metadata, config);
+}
+
+/**
+ * Applies "--recognizer-config=<file>" first and then "--model=<name>", 
+ * "--threshold=<n>", "--components=<n>", "--radius=<n>", "--neighbors=<n>", 
+ * "--grid=<x>,<y>", "--ensemble=<cheap>,<costly>", "--cheap-threshold=<n>" and 
+ * "--ambiguity=<fraction>" to config. Other options are added to otherOptions if it is given.
+ * Returns false if an option was not understood.
+ */
+bool parseRecognizerOptions(const vector<string> &options, RecognizerConfig &config, 
+        vector<string> *otherOptions) {
+    bool valid = true;
+    for (unsigned int pass = 0; pass < 2; pass++) {
+        for (unsigned int i = 0; i < options.size(); i++) {
+            const string &option = options[i];
+            size_t equalsPos = option.find('=');
+            string name = option.substr(2, 
+                    equalsPos == string::npos ? string::npos : equalsPos - 2);
+            string value = equalsPos == string::npos ? "" : option.substr(equalsPos + 1);
+            size_t commaPos = value.find(',');
+            if (name == "recognizer-config") {
+                if (pass == 0) {
+                    valid = loadRecognizerConfig(value, config) && valid;
+                }
+                continue;
+            }
+            if (pass == 0) {
+                continue;
+            }
+            if (name == "model") {
+                config.model = value;
+            } else if (name == "threshold") {
+                config.threshold = atof(value.c_str());
+            } else if (name == "components") {
+                config.numComponents = atoi(value.c_str());
+            } else if (name == "radius") {
+                config.radius = atoi(value.c_str());
+            } else if (name == "neighbors") {
+                config.neighbors = atoi(value.c_str());
+            } else if (name == "grid") {
+                config.gridX = atoi(value.substr(0, commaPos).c_str());
+                config.gridY = commaPos == string::npos 
+                        ? config.gridX : atoi(value.substr(commaPos + 1).c_str());
+            } else if (name == "ensemble" && commaPos != string::npos) {
+                config.model = "ensemble";
+                config.cheapModel = value.substr(0, commaPos);
+                config.costlyModel = value.substr(commaPos + 1);
+            } else if (name == "cheap-threshold") {
+                config.cheapThreshold = atof(value.c_str());
+            } else if (name == "ambiguity") {
+                config.ambiguity = atof(value.c_str());
+            } else if (otherOptions != NULL) {
+                otherOptions->push_back(option);
+            } else {
+                cerr << "Unrecognized option: " << option << endl;
+                valid = false;
+            }
+        }
+    }
+    if (!isKnownModel(config.model) || !isKnownModel(config.cheapModel) 
+            || !isKnownModel(config.costlyModel) || config.cheapModel == "ensemble" 
+            || config.costlyModel == "ensemble") {
+        cerr << "Unknown recognizer model, expected lbph, qlbph, eigen, fisher or ensemble"
+                << endl;
+        valid = false;
+    }
+    return valid;
+}
+
+void printRecognizerUsage() {
+    cout << "\t --model=<lbph|qlbph|eigen|fisher|ensemble> -- Face recognition model, default "
+            << "lbph. qlbph is LBPH with 8 bit histograms." << endl;
+    cout << "\t --threshold=<n> -- Largest distance accepted as a match." << endl;
+    cout << "\t --components=<n> -- Eigenfaces/Fisherfaces components, 0 for all." << endl;
+    cout << "\t --radius=<n> --neighbors=<n> --grid=<x>,<y> -- LBPH and qlbph settings." << endl;
+    cout << "\t --ensemble=<cheap>,<costly> -- Run cheap first and ask costly only when cheap "
+            << "is unsure." << endl;
+    cout << "\t --cheap-threshold=<n> --ambiguity=<fraction> -- Cheap model distances within "
+            << "the fraction of its threshold are unsure." << endl;
+    cout << "\t --recognizer-config=<file> -- Read these settings from a YAML or XML file."
+            << endl;
+}
+
+static bool isKnownModel(const string &model) {
+    return model == "lbph" || model == "qlbph" || model == "eigen" || model == "fisher" 
+            || model == "ensemble";
+}
+
+/**
+ * The config of the cheap or the costly model of an ensemble, with its threshold resolved.
+ */
+static RecognizerConfig getMemberConfig(const RecognizerConfig &config, bool cheap) {
+    RecognizerConfig member = config;
+    member.model = cheap ? config.cheapModel : config.costlyModel;
+    member.threshold = cheap ? config.cheapThreshold : config.threshold;
+    if (member.threshold < 0) {
+        member.threshold = getDefaultThreshold(member.model);
+    }
+    return member;
+}
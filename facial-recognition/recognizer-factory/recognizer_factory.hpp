@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RECOGNIZER_FACTORY_HPP_
+#define RECOGNIZER_FACTORY_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * Which recognizer to build and how, chosen at run time from a config file and command line
+ * flags instead of at compile time. See parseRecognizerOptions.
+ */
+struct RecognizerConfig {
+    // "lbph", "qlbph", "eigen", "fisher" or "ensemble"
+    std::string model;
+    // Largest distance accepted as a match, negative for the model's default. In ensemble
+    // mode this is the threshold of the costly model.
+    double threshold;
+    // Eigenfaces and Fisherfaces components, 0 to keep them all
+    int numComponents;
+    // LBPH and quantized LBPH settings
+    int radius;
+    int neighbors;
+    int gridX;
+    int gridY;
+    // Ensemble mode: the cheap model answers unless its distance falls within ambiguity (a
+    // fraction of cheapThreshold) of cheapThreshold, in which case the costly model decides
+    std::string cheapModel;
+    std::string costlyModel;
+    double cheapThreshold;
+    double ambiguity;
+    // Size the faces are resized to before prediction, for the models that need it
+    cv::Size faceSize;
+
+    RecognizerConfig();
+};
+
+double getDefaultThreshold(const std::string &model);
+bool isIncrementalModel(const RecognizerConfig &config);
+std::string describeRecognizer(const RecognizerConfig &config);
+
+cv::Ptr<cv::face::FaceRecognizer> createRecognizer(const RecognizerConfig &config);
+bool saveRecognizer(const cv::Ptr<cv::face::FaceRecognizer> &model, 
+        const RecognizerConfig &config, const std::string &path);
+cv::Ptr<cv::face::FaceRecognizer> loadRecognizer(const std::string &path, 
+        RecognizerConfig &config);
+
+bool readRecognizerConfig(const cv::FileNode &node, RecognizerConfig &config);
+void writeRecognizerConfig(cv::FileStorage &fs, const RecognizerConfig &config);
+bool loadRecognizerConfig(const std::string &path, RecognizerConfig &config);
+bool parseRecognizerOptions(const std::vector<std::string> &options, RecognizerConfig &config,
+        std::vector<std::string> *otherOptions = NULL);
+void printRecognizerUsage();
+
+#endif
@@ -0,0 +1,226 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "stage_timing.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+using namespace std;
+
+//~Function Headers---------------------------------------------------------------------------------
+static int bucketFor(double seconds);
+static double bucketUpperBoundMicroseconds(int bucket);
+
+//~Functions----------------------------------------------------------------------------------------
+StageTimings::StageTimings() : trace(NULL) {
+}
+
+/**
+ * Adds a stage called name and returns its index for record.
+ */
+int StageTimings::addStage(const string &name) {
+    Stage stage;
+    stage.name = name;
+    stage.traceStage = trace != NULL ? trace->addStage(name) : -1;
+    stage.count = 0;
+    stage.totalSeconds = 0.0;
+    stage.minSeconds = numeric_limits<double>::max();
+    stage.maxSeconds = 0.0;
+    memset(stage.buckets, 0, sizeof(stage.buckets));
+    stages.push_back(stage);
+    return stages.size() - 1;
+}
+
+void StageTimings::record(int stage, double seconds) {
+    Stage &curStage = stages[stage];
+    curStage.count++;
+    curStage.totalSeconds += seconds;
+    curStage.minSeconds = min(curStage.minSeconds, seconds);
+    curStage.maxSeconds = max(curStage.maxSeconds, seconds);
+    curStage.buckets[bucketFor(seconds)]++;
+}
+
+/**
+ * Records the span from start to end as a sample, and as a trace span if a trace is attached.
+ */
+void StageTimings::record(int stage, chrono::steady_clock::time_point start, 
+        chrono::steady_clock::time_point end) {
+    chrono::duration<double> elapsed = end - start;
+    record(stage, elapsed.count());
+    if (trace != NULL) {
+        trace->record(stages[stage].traceStage, start, end);
+    }
+}
+
+/**
+ * Also records every timed sample into trace, NULL to stop.
+ */
+void StageTimings::setTrace(TraceRecorder *trace) {
+    this->trace = trace;
+    for (unsigned int i = 0; i < stages.size(); i++) {
+        stages[i].traceStage = trace != NULL ? trace->addStage(stages[i].name) : -1;
+    }
+}
+
+/**
+ * Adds a top level number to the JSON output, e.g. the frame a face was confirmed at.
+ */
+void StageTimings::setField(const string &name, double value) {
+    for (unsigned int i = 0; i < fields.size(); i++) {
+        if (fields[i].first == name) {
+            fields[i].second = value;
+            return;
+        }
+    }
+    fields.push_back(make_pair(name, value));
+}
+
+int StageTimings::getStageCount() const {
+    return stages.size();
+}
+
+const string &StageTimings::getStageName(int stage) const {
+    return stages[stage].name;
+}
+
+uint64_t StageTimings::getCount(int stage) const {
+    return stages[stage].count;
+}
+
+double StageTimings::getTotalSeconds(int stage) const {
+    return stages[stage].totalSeconds;
+}
+
+/**
+ * Estimates the given percentile (0 - 100) of a stage in seconds as the upper bound of the 
+ * histogram bucket it falls in, capped at the largest sample seen.
+ */
+double StageTimings::getPercentile(int stage, double percentile) const {
+    const Stage &curStage = stages[stage];
+    if (curStage.count == 0) {
+        return 0.0;
+    }
+    uint64_t rank = (uint64_t) ceil(percentile / 100.0 * curStage.count);
+    uint64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; i++) {
+        seen += curStage.buckets[i];
+        if (seen >= rank && seen > 0) {
+            return min(bucketUpperBoundMicroseconds(i) / 1e6, curStage.maxSeconds);
+        }
+    }
+    return curStage.maxSeconds;
+}
+
+/**
+ * Writes the frame count, end to end frames per second, extra fields, and every stage's 
+ * summary and non-empty histogram buckets as a JSON object.
+ */
+void StageTimings::writeJson(ostream &out, const string &source, long frames, 
+        double wallSeconds) const {
+    out << "{" << endl;
+    out << "  \"source\": \"" << source << "\"," << endl;
+    out << "  \"frames\": " << frames << "," << endl;
+    out << "  \"wallSeconds\": " << wallSeconds << "," << endl;
+    out << "  \"fps\": " << (wallSeconds > 0 ? frames / wallSeconds : 0.0) << "," << endl;
+    for (unsigned int i = 0; i < fields.size(); i++) {
+        out << "  \"" << fields[i].first << "\": " << fields[i].second << "," << endl;
+    }
+    out << "  \"stages\": {" << endl;
+    for (unsigned int i = 0; i < stages.size(); i++) {
+        const Stage &curStage = stages[i];
+        double meanSeconds = curStage.count > 0 ? curStage.totalSeconds / curStage.count : 0.0;
+        out << "    \"" << curStage.name << "\": {" << endl;
+        out << "      \"count\": " << curStage.count << "," << endl;
+        // Samples one thread can push through the stage per second
+        out << "      \"perSecond\": " 
+                << (curStage.totalSeconds > 0 ? curStage.count / curStage.totalSeconds : 0.0) 
+                << "," << endl;
+        out << "      \"meanMs\": " << meanSeconds * 1e3 << "," << endl;
+        out << "      \"minMs\": " << (curStage.count > 0 ? curStage.minSeconds * 1e3 : 0.0) 
+                << "," << endl;
+        out << "      \"maxMs\": " << curStage.maxSeconds * 1e3 << "," << endl;
+        out << "      \"p50Ms\": " << getPercentile(i, 50) * 1e3 << "," << endl;
+        out << "      \"p95Ms\": " << getPercentile(i, 95) * 1e3 << "," << endl;
+        out << "      \"p99Ms\": " << getPercentile(i, 99) * 1e3 << "," << endl;
+        out << "      \"histogramUs\": [";
+        bool first = true;
+        for (int j = 0; j < NUM_BUCKETS; j++) {
+            if (curStage.buckets[j] == 0) {
+                continue;
+            }
+            out << (first ? "" : ", ") << "{\"lessThan\": " << bucketUpperBoundMicroseconds(j)
+                    << ", \"count\": " << curStage.buckets[j] << "}";
+            first = false;
+        }
+        out << "]" << endl;
+        out << "    }" << (i + 1 < stages.size() ? "," : "") << endl;
+    }
+    out << "  }" << endl;
+    out << "}" << endl;
+}
+
+/**
+ * Writes the JSON to the file at path, or to stdout if path is empty.
+ */
+void StageTimings::writeJson(const string &path, const string &source, long frames, 
+        double wallSeconds) const {
+    if (path.empty()) {
+        writeJson(cout, source, frames, wallSeconds);
+        return;
+    }
+    ofstream out(path.c_str());
+    if (!out.is_open()) {
+        cerr << "Unable to open " << path << " for writing, printing timings instead" << endl;
+        writeJson(cout, source, frames, wallSeconds);
+        return;
+    }
+    writeJson(out, source, frames, wallSeconds);
+}
+
+ScopedStageTimer::ScopedStageTimer(StageTimings &timings, int stage) 
+        : timings(timings), stage(stage), start(chrono::steady_clock::now()) {
+}
+
+ScopedStageTimer::~ScopedStageTimer() {
+    timings.record(stage, start, chrono::steady_clock::now());
+}
+
+/**
+ * Bucket 0 holds samples under 1us, bucket i holds samples in [2^(i - 1), 2^i) us.
+ */
+static int bucketFor(double seconds) {
+    double microseconds = seconds * 1e6;
+    int bucket = 0;
+    while (bucket < StageTimings::NUM_BUCKETS - 1 && microseconds >= (double) (1ULL << bucket)) {
+        bucket++;
+    }
+    return bucket;
+}
+
+static double bucketUpperBoundMicroseconds(int bucket) {
+    return (double) (1ULL << bucket);
+}
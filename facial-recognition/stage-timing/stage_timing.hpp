@@ -0,0 +1,98 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef STAGE_TIMING_HPP_
+#define STAGE_TIMING_HPP_
+
+#include "trace_recorder.hpp"
+
+#include <stdint.h>
+
+#include <chrono>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Per-stage latency histograms for the video processing loops.
+ *
+ * Each stage keeps a count, total, minimum, maximum and a histogram with power of two 
+ * microsecond buckets, which is enough to report percentiles without storing every sample.
+ * Recording a sample never allocates. With a TraceRecorder attached, every timed sample is 
+ * also recorded as a span of the recorder's stage of the same name.
+ */
+class StageTimings {
+public:
+    static const int NUM_BUCKETS = 32;
+
+    StageTimings();
+
+    int addStage(const std::string &name);
+    void record(int stage, double seconds);
+    void record(int stage, std::chrono::steady_clock::time_point start, 
+            std::chrono::steady_clock::time_point end);
+    void setTrace(TraceRecorder *trace);
+    void setField(const std::string &name, double value);
+
+    int getStageCount() const;
+    const std::string &getStageName(int stage) const;
+    uint64_t getCount(int stage) const;
+    double getTotalSeconds(int stage) const;
+    double getPercentile(int stage, double percentile) const;
+    void writeJson(std::ostream &out, const std::string &source, long frames, 
+            double wallSeconds) const;
+    void writeJson(const std::string &path, const std::string &source, long frames, 
+            double wallSeconds) const;
+
+private:
+    struct Stage {
+        std::string name;
+        int traceStage;
+        uint64_t count;
+        double totalSeconds;
+        double minSeconds;
+        double maxSeconds;
+        uint64_t buckets[NUM_BUCKETS];
+    };
+
+    std::vector<Stage> stages;
+    std::vector<std::pair<std::string, double> > fields;
+    TraceRecorder *trace;
+};
+
+/**
+ * Records the time between its construction and destruction as one sample of a stage.
+ */
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(StageTimings &timings, int stage);
+    ~ScopedStageTimer();
+
+private:
+    StageTimings &timings;
+    int stage;
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif
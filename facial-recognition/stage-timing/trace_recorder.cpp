@@ -0,0 +1,388 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "trace_recorder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const int DEFAULT_EVENTS_PER_THREAD = 1 << 16;
+
+//~Function Headers---------------------------------------------------------------------------------
+static uint64_t toNanos(chrono::steady_clock::duration duration);
+static double percentileOf(const vector<uint64_t> &sorted, double percentile);
+
+//~Functions----------------------------------------------------------------------------------------
+TraceOptions::TraceOptions() : summaryInterval(0.0), eventsPerThread(DEFAULT_EVENTS_PER_THREAD) {
+}
+
+bool TraceOptions::isEnabled() const {
+    return !tracePath.empty() || summaryInterval > 0;
+}
+
+TraceRecorder::TraceRecorder()
+        : enabled(false), epoch(chrono::steady_clock::now()),
+        mainThread(this_thread::get_id()), lastSummary(epoch) {
+}
+
+/**
+ * Starts recording with the given options. Call before any thread records, the rings are
+ * sized when a thread first records.
+ */
+void TraceRecorder::enable(const TraceOptions &options) {
+    this->options = options;
+    this->options.eventsPerThread = max(options.eventsPerThread, 1);
+    lastSummary = chrono::steady_clock::now();
+    enabled.store(true);
+}
+
+bool TraceRecorder::isEnabled() const {
+    return enabled.load(memory_order_relaxed);
+}
+
+/**
+ * Returns the index of the stage called name for record, adding it if it is new, or -1 once
+ * MAX_STAGES stages exist.
+ */
+int TraceRecorder::addStage(const string &name) {
+    lock_guard<mutex> lock(registryMutex);
+    for (unsigned int i = 0; i < stageNames.size(); i++) {
+        if (stageNames[i] == name) {
+            return i;
+        }
+    }
+    if (stageNames.size() >= (size_t) MAX_STAGES) {
+        return -1;
+    }
+    stageNames.push_back(name);
+    return stageNames.size() - 1;
+}
+
+/**
+ * Adds a span of stage to the calling thread's ring and counters.
+ */
+void TraceRecorder::record(int stage, chrono::steady_clock::time_point start,
+        chrono::steady_clock::time_point end) {
+    if (!isEnabled() || stage < 0 || stage >= MAX_STAGES) {
+        return;
+    }
+    ThreadBuffer &buffer = getThreadBuffer();
+    uint64_t written = buffer.written.load(memory_order_relaxed);
+    uint64_t durationNanos = end > start ? toNanos(end - start) : 0;
+    Span &span = buffer.spans[written % buffer.spans.size()];
+    span.sequence.store(2 * written + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    span.stage.store(stage, memory_order_relaxed);
+    span.startNanos.store(start > epoch ? toNanos(start - epoch) : 0, memory_order_relaxed);
+    span.durationNanos.store(durationNanos, memory_order_relaxed);
+    span.sequence.store(2 * written + 2, memory_order_release);
+    buffer.written.store(written + 1, memory_order_release);
+    // Only this thread writes its counters, so a load and a store are enough
+    buffer.counts[stage].store(buffer.counts[stage].load(memory_order_relaxed) + 1,
+            memory_order_relaxed);
+    buffer.totalNanos[stage].store(
+            buffer.totalNanos[stage].load(memory_order_relaxed) + durationNanos,
+            memory_order_relaxed);
+}
+
+/**
+ * Number of spans of a stage recorded by every thread since recording started.
+ */
+uint64_t TraceRecorder::getCount(int stage) const {
+    lock_guard<mutex> lock(registryMutex);
+    uint64_t count = 0;
+    for (unsigned int i = 0; i < buffers.size(); i++) {
+        count += buffers[i]->counts[stage].load(memory_order_relaxed);
+    }
+    return count;
+}
+
+double TraceRecorder::getTotalSeconds(int stage) const {
+    lock_guard<mutex> lock(registryMutex);
+    uint64_t totalNanos = 0;
+    for (unsigned int i = 0; i < buffers.size(); i++) {
+        totalNanos += buffers[i]->totalNanos[stage].load(memory_order_relaxed);
+    }
+    return totalNanos / 1e9;
+}
+
+/**
+ * The 50th, 95th and 99th percentile durations in seconds of the spans of a stage that ended
+ * in the last windowSeconds, across all threads. Returns false if there were none. Spans that
+ * have been overwritten in their ring are not counted.
+ */
+bool TraceRecorder::getRollingPercentiles(int stage, double windowSeconds, double &p50,
+        double &p95, double &p99) {
+    uint64_t nowNanos = toNanos(chrono::steady_clock::now() - epoch);
+    uint64_t windowNanos = (uint64_t) (windowSeconds * 1e9);
+    uint64_t cutoff = nowNanos > windowNanos ? nowNanos - windowNanos : 0;
+    window.clear();
+    {
+        lock_guard<mutex> lock(registryMutex);
+        for (unsigned int i = 0; i < buffers.size(); i++) {
+            const ThreadBuffer &buffer = *buffers[i];
+            uint64_t written = buffer.written.load(memory_order_acquire);
+            uint64_t capacity = buffer.spans.size();
+            uint64_t oldest = written > capacity ? written - capacity : 0;
+            // Spans are recorded when they end, so walk back from the newest until one ended
+            // before the window. A span overwritten while the walk ran means the older ones
+            // were too.
+            for (uint64_t j = written; j > oldest; j--) {
+                int spanStage;
+                uint64_t startNanos, durationNanos;
+                if (!readSpan(buffer, j - 1, spanStage, startNanos, durationNanos)
+                        || startNanos + durationNanos < cutoff) {
+                    break;
+                }
+                if (spanStage == stage) {
+                    window.push_back(durationNanos);
+                }
+            }
+        }
+    }
+    if (window.empty()) {
+        return false;
+    }
+    sort(window.begin(), window.end());
+    p50 = percentileOf(window, 50) / 1e9;
+    p95 = percentileOf(window, 95) / 1e9;
+    p99 = percentileOf(window, 99) / 1e9;
+    return true;
+}
+
+/**
+ * Writes the rolling summary if the summary interval has passed since the last one. Meant to
+ * be called once per frame.
+ */
+void TraceRecorder::reportRollingSummary(ostream &out) {
+    if (!isEnabled() || options.summaryInterval <= 0) {
+        return;
+    }
+    chrono::steady_clock::time_point now = chrono::steady_clock::now();
+    chrono::duration<double> sinceSummary = now - lastSummary;
+    if (sinceSummary.count() < options.summaryInterval) {
+        return;
+    }
+    writeRollingSummary(out, options.summaryInterval);
+    lastSummary = now;
+}
+
+/**
+ * Writes one line with the p50/p95/p99 of every stage seen in the last windowSeconds, in ms.
+ */
+void TraceRecorder::writeRollingSummary(ostream &out, double windowSeconds) {
+    int stageCount;
+    {
+        lock_guard<mutex> lock(registryMutex);
+        stageCount = stageNames.size();
+    }
+    ios::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << "Last " << windowSeconds << "s p50/p95/p99 ms:" << fixed << setprecision(2);
+    for (int stage = 0; stage < stageCount; stage++) {
+        double p50;
+        double p95;
+        double p99;
+        if (!getRollingPercentiles(stage, windowSeconds, p50, p95, p99)) {
+            continue;
+        }
+        out << " " << stageNames[stage] << " " << p50 * 1e3 << "/" << p95 * 1e3 << "/"
+                << p99 * 1e3;
+    }
+    out << endl;
+    out.flags(flags);
+    out.precision(precision);
+}
+
+/**
+ * Writes every span still in the rings as Chrome trace event format JSON, one track per
+ * thread. Returns false if the file could not be written.
+ */
+bool TraceRecorder::writeChromeTrace(const string &path) const {
+    ofstream out(path.c_str());
+    if (!out.is_open()) {
+        return false;
+    }
+    lock_guard<mutex> lock(registryMutex);
+    out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [" << endl;
+    out << fixed << setprecision(3);
+    bool first = true;
+    for (unsigned int i = 0; i < buffers.size(); i++) {
+        const ThreadBuffer &buffer = *buffers[i];
+        int tid = buffer.threadIndex + 1;
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, "
+                << "\"tid\": " << tid << ", \"args\": {\"name\": \""
+                << (buffer.isMain ? string("main") : "worker " + to_string(tid)) << "\"}}";
+        first = false;
+        uint64_t written = buffer.written.load(memory_order_acquire);
+        uint64_t capacity = buffer.spans.size();
+        for (uint64_t j = written > capacity ? written - capacity : 0; j < written; j++) {
+            int stage;
+            uint64_t startNanos, durationNanos;
+            if (!readSpan(buffer, j, stage, startNanos, durationNanos)) {
+                continue;
+            }
+            out << ",\n{\"name\": \"" << stageNames[stage] << "\", \"ph\": \"X\", "
+                    << "\"pid\": 1, \"tid\": " << tid << ", \"ts\": " << startNanos / 1e3
+                    << ", \"dur\": " << durationNanos / 1e3 << "}";
+        }
+    }
+    out << endl << "]}" << endl;
+    return out.good();
+}
+
+/**
+ * Writes the trace file if one was asked for. Call once the last frame is processed.
+ */
+void TraceRecorder::finish() {
+    if (!isEnabled() || options.tracePath.empty()) {
+        return;
+    }
+    if (writeChromeTrace(options.tracePath)) {
+        cout << "Wrote trace to " << options.tracePath << endl;
+    } else {
+        cerr << "Unable to write trace to " << options.tracePath << endl;
+    }
+}
+
+/**
+ * The recorder the video tools and the libraries they use record into.
+ */
+TraceRecorder &TraceRecorder::shared() {
+    static TraceRecorder recorder;
+    return recorder;
+}
+
+/**
+ * The calling thread's ring, created the first time the thread records.
+ */
+TraceRecorder::ThreadBuffer &TraceRecorder::getThreadBuffer() {
+    static thread_local TraceRecorder *owner = NULL;
+    static thread_local ThreadBuffer *buffer = NULL;
+    if (owner == this) {
+        return *buffer;
+    }
+    lock_guard<mutex> lock(registryMutex);
+    unique_ptr<ThreadBuffer> created(new ThreadBuffer());
+    created->threadIndex = buffers.size();
+    created->isMain = this_thread::get_id() == mainThread;
+    // Spans hold atomics, which cannot be moved by resize
+    created->spans = vector<Span>(options.eventsPerThread);
+    for (unsigned int i = 0; i < created->spans.size(); i++) {
+        created->spans[i].sequence.store(0);
+    }
+    created->written.store(0);
+    for (int i = 0; i < MAX_STAGES; i++) {
+        created->counts[i].store(0);
+        created->totalNanos[i].store(0);
+    }
+    owner = this;
+    buffer = created.get();
+    buffers.push_back(move(created));
+    return *buffer;
+}
+
+/**
+ * Copies span index out of its ring. Returns false if the slot no longer holds that span, or
+ * its writer overwrote it while it was being read.
+ */
+bool TraceRecorder::readSpan(const ThreadBuffer &buffer, uint64_t index, int &stage,
+        uint64_t &startNanos, uint64_t &durationNanos) {
+    const Span &span = buffer.spans[index % buffer.spans.size()];
+    uint64_t sequence = span.sequence.load(memory_order_acquire);
+    if (sequence != 2 * index + 2) {
+        return false;
+    }
+    stage = span.stage.load(memory_order_relaxed);
+    startNanos = span.startNanos.load(memory_order_relaxed);
+    durationNanos = span.durationNanos.load(memory_order_relaxed);
+    atomic_thread_fence(memory_order_acquire);
+    return span.sequence.load(memory_order_relaxed) == sequence;
+}
+
+ScopedTrace::ScopedTrace(TraceRecorder &recorder, int stage)
+        : recorder(recorder), stage(stage), active(recorder.isEnabled()) {
+    if (active) {
+        start = chrono::steady_clock::now();
+    }
+}
+
+ScopedTrace::~ScopedTrace() {
+    if (active) {
+        recorder.record(stage, start, chrono::steady_clock::now());
+    }
+}
+
+/**
+ * Applies "--trace=<path>", "--trace-summary=<seconds>" and "--trace-events=<n>" options.
+ * Any other options are collected in otherOptions, or reported as errors if it is NULL.
+ */
+bool parseTraceOptions(const vector<string> &options, TraceOptions &traceOptions,
+        vector<string> *otherOptions) {
+    bool valid = true;
+    for (unsigned int i = 0; i < options.size(); i++) {
+        const string &option = options[i];
+        size_t equalsPos = option.find('=');
+        string name = option.substr(2, equalsPos == string::npos ? string::npos : equalsPos - 2);
+        string value = equalsPos == string::npos ? "" : option.substr(equalsPos + 1);
+        if (name == "trace") {
+            traceOptions.tracePath = value;
+        } else if (name == "trace-summary") {
+            traceOptions.summaryInterval = value.empty() ? 1.0 : atof(value.c_str());
+        } else if (name == "trace-events") {
+            traceOptions.eventsPerThread = atoi(value.c_str());
+        } else if (otherOptions != NULL) {
+            otherOptions->push_back(option);
+        } else {
+            cerr << "Unrecognized option: " << option << endl;
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+void printTraceUsage() {
+    cout << "\t --trace=<file> -- Write every stage of every thread as a Chrome trace." << endl;
+    cout << "\t --trace-summary[=<seconds>] -- Print rolling p50/p95/p99 stage times to stderr."
+            << endl;
+    cout << "\t --trace-events=<n> -- Stage spans kept per thread for the trace." << endl;
+}
+
+static uint64_t toNanos(chrono::steady_clock::duration duration) {
+    return chrono::duration_cast<chrono::nanoseconds>(duration).count();
+}
+
+/**
+ * Nearest rank percentile (0 - 100) of sorted values.
+ */
+static double percentileOf(const vector<uint64_t> &sorted, double percentile) {
+    size_t rank = (size_t) ceil(percentile / 100.0 * sorted.size());
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
@@ -0,0 +1,144 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TRACE_RECORDER_HPP_
+#define TRACE_RECORDER_HPP_
+
+#include <stdint.h>
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * How a TraceRecorder is set up, parsed from "--name=value" command line flags by
+ * parseTraceOptions.
+ */
+struct TraceOptions {
+    // Where to write the Chrome trace JSON at exit, empty for no trace file
+    std::string tracePath;
+    // Seconds between rolling percentile summaries on stderr, 0 for none
+    double summaryInterval;
+    // Spans kept per thread, older ones are overwritten
+    int eventsPerThread;
+
+    TraceOptions();
+    bool isEnabled() const;
+};
+
+/**
+ * Records timed spans of named stages from any thread, for Chrome's trace viewer
+ * (chrome://tracing or ui.perfetto.dev) and for rolling latency percentiles.
+ *
+ * Every thread that records gets its own ring of spans and its own per-stage counters the
+ * first time it records, so recording takes no lock and never allocates after that. Each ring
+ * has a single writer; every slot carries a sequence stamp, so the summaries and the trace
+ * export may run while workers record and drop spans that were overwritten while being read.
+ * Recording is a single relaxed load while the recorder is disabled.
+ */
+class TraceRecorder {
+public:
+    static const int MAX_STAGES = 32;
+
+    TraceRecorder();
+
+    void enable(const TraceOptions &options);
+    bool isEnabled() const;
+    int addStage(const std::string &name);
+    void record(int stage, std::chrono::steady_clock::time_point start,
+            std::chrono::steady_clock::time_point end);
+
+    uint64_t getCount(int stage) const;
+    double getTotalSeconds(int stage) const;
+    bool getRollingPercentiles(int stage, double windowSeconds, double &p50, double &p95,
+            double &p99);
+    void reportRollingSummary(std::ostream &out);
+    void writeRollingSummary(std::ostream &out, double windowSeconds);
+    bool writeChromeTrace(const std::string &path) const;
+    void finish();
+
+    static TraceRecorder &shared();
+
+private:
+    // The fields are atomics, only ever accessed relaxed, so a torn read is not a data race
+    struct Span {
+        // 2 * index + 1 while span index is being written, 2 * index + 2 once it is complete
+        std::atomic<uint64_t> sequence;
+        std::atomic<int> stage;
+        std::atomic<uint64_t> startNanos;
+        std::atomic<uint64_t> durationNanos;
+    };
+
+    struct ThreadBuffer {
+        int threadIndex;
+        bool isMain;
+        std::vector<Span> spans;
+        std::atomic<uint64_t> written;
+        std::atomic<uint64_t> counts[MAX_STAGES];
+        std::atomic<uint64_t> totalNanos[MAX_STAGES];
+    };
+
+    std::atomic<bool> enabled;
+    TraceOptions options;
+    std::chrono::steady_clock::time_point epoch;
+    std::thread::id mainThread;
+    mutable std::mutex registryMutex;
+    std::vector<std::string> stageNames;
+    std::vector<std::unique_ptr<ThreadBuffer> > buffers;
+    std::chrono::steady_clock::time_point lastSummary;
+    // Durations gathered for one stage's percentiles, reused between summaries
+    std::vector<uint64_t> window;
+
+    TraceRecorder(const TraceRecorder &);
+    TraceRecorder &operator=(const TraceRecorder &);
+
+    ThreadBuffer &getThreadBuffer();
+    static bool readSpan(const ThreadBuffer &buffer, uint64_t index, int &stage,
+            uint64_t &startNanos, uint64_t &durationNanos);
+};
+
+/**
+ * Records the time between its construction and destruction as one span of a stage.
+ */
+class ScopedTrace {
+public:
+    ScopedTrace(TraceRecorder &recorder, int stage);
+    ~ScopedTrace();
+
+private:
+    TraceRecorder &recorder;
+    int stage;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+};
+
+bool parseTraceOptions(const std::vector<std::string> &options, TraceOptions &traceOptions,
+        std::vector<std::string> *otherOptions = NULL);
+void printTraceUsage();
+
+#endif
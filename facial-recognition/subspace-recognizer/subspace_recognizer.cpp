@@ -0,0 +1,201 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "subspace_recognizer.hpp"
+
+#include <cmath>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+//~Function Headers---------------------------------------------------------------------------------
+static float squaredDistance(const float *a, const float *b, int length);
+
+//~Functions----------------------------------------------------------------------------------------
+SubspaceFaceRecognizer::SubspaceFaceRecognizer(Method method, int numComponents, 
+        double threshold) 
+        : method(method), numComponents(numComponents), threshold(threshold) {
+}
+
+/**
+ * Trains OpenCV's recognizer for this method and keeps its subspace in single precision.
+ */
+void SubspaceFaceRecognizer::train(InputArrayOfArrays src, InputArray labels) {
+    Ptr<face::BasicFaceRecognizer> model = method == EIGENFACES 
+            ? face::createEigenFaceRecognizer(numComponents)
+            : face::createFisherFaceRecognizer(numComponents);
+    model->train(src, labels);
+    setSubspace(model->getMean(), model->getEigenVectors(), model->getProjections(), 
+            model->getLabels(), model->getEigenValues());
+}
+
+int SubspaceFaceRecognizer::predict(InputArray src) const {
+    int label;
+    double confidence;
+    predict(src, label, confidence);
+    return label;
+}
+
+/**
+ * Finds the training face nearest to src in the subspace. label is -1 and confidence DBL_MAX
+ * if none is closer than the threshold, as with OpenCV's recognizers.
+ */
+void SubspaceFaceRecognizer::predict(InputArray src, int &label, double &confidence) const {
+    label = -1;
+    confidence = DBL_MAX;
+    if (projections.empty()) {
+        CV_Error(Error::StsError, "SubspaceFaceRecognizer has not been trained or loaded.");
+    }
+    Mat face = src.getMat();
+    if ((int) face.total() != mean.cols) {
+        CV_Error(Error::StsBadArg, format("Wrong input image size, expected %d pixels but got %d.",
+                mean.cols, (int) face.total()));
+    }
+    // Buffers are reused between calls, predict may run on several threads at once
+    static thread_local Mat sample;
+    static thread_local Mat projection;
+    face.reshape(1, 1).convertTo(sample, CV_32F);
+    subtract(sample, mean, sample);
+    gemm(eigenvectors, sample, 1.0, noArray(), 0.0, projection, GEMM_2_T);
+
+    const float *query = projection.ptr<float>(0);
+    int components = projections.cols;
+    float nearestDistance = FLT_MAX;
+    int nearest = -1;
+    for (int i = 0; i < projections.rows; i++) {
+        float distance = squaredDistance(projections.ptr<float>(i), query, components);
+        if (distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = i;
+        }
+    }
+    double distance = sqrt((double) nearestDistance);
+    if (nearest != -1 && distance < threshold) {
+        label = labels[nearest];
+        confidence = distance;
+    }
+}
+
+/**
+ * Writes the model in the layout of OpenCV's Eigenfaces and Fisherfaces files, in double 
+ * precision.
+ */
+void SubspaceFaceRecognizer::save(FileStorage &fs) const {
+    Mat mean64, eigenvectors64;
+    mean.convertTo(mean64, CV_64F);
+    Mat(eigenvectors.t()).convertTo(eigenvectors64, CV_64F);
+    fs << "num_components" << numComponents;
+    fs << "mean" << mean64;
+    fs << "eigenvalues" << eigenvalues;
+    fs << "eigenvectors" << eigenvectors64;
+    fs << "projections" << "[";
+    for (int i = 0; i < projections.rows; i++) {
+        Mat projection64;
+        projections.row(i).convertTo(projection64, CV_64F);
+        fs << projection64;
+    }
+    fs << "]";
+    fs << "labels" << Mat(labels, true);
+}
+
+/**
+ * Reads a model saved by this class or by OpenCV's Eigenfaces or Fisherfaces.
+ */
+void SubspaceFaceRecognizer::load(const FileStorage &fs) {
+    Mat loadedMean, loadedEigenvectors, loadedLabels, loadedEigenvalues;
+    fs["num_components"] >> numComponents;
+    fs["mean"] >> loadedMean;
+    fs["eigenvalues"] >> loadedEigenvalues;
+    fs["eigenvectors"] >> loadedEigenvectors;
+    fs["labels"] >> loadedLabels;
+    FileNode projectionsNode = fs["projections"];
+    vector<Mat> loadedProjections(projectionsNode.size());
+    for (unsigned int i = 0; i < loadedProjections.size(); i++) {
+        projectionsNode[i] >> loadedProjections[i];
+    }
+    setSubspace(loadedMean, loadedEigenvectors, loadedProjections, loadedLabels, 
+            loadedEigenvalues);
+}
+
+SubspaceFaceRecognizer::Method SubspaceFaceRecognizer::getMethod() const {
+    return method;
+}
+
+int SubspaceFaceRecognizer::getNumComponents() const {
+    return numComponents;
+}
+
+double SubspaceFaceRecognizer::getThreshold() const {
+    return threshold;
+}
+
+void SubspaceFaceRecognizer::setThreshold(double threshold) {
+    this->threshold = threshold;
+}
+
+/**
+ * Converts a D x K eigenvector matrix and the other double precision parts of a trained 
+ * subspace to the single precision layout predict uses.
+ */
+void SubspaceFaceRecognizer::setSubspace(const Mat &mean, const Mat &eigenvectors, 
+        const vector<Mat> &projections, const Mat &labels, const Mat &eigenvalues) {
+    mean.reshape(1, 1).convertTo(this->mean, CV_32F);
+    Mat(eigenvectors.t()).convertTo(this->eigenvectors, CV_32F);
+    this->projections.create((int) projections.size(), eigenvectors.cols, CV_32F);
+    for (unsigned int i = 0; i < projections.size(); i++) {
+        Mat row = this->projections.row(i);
+        projections[i].reshape(1, 1).convertTo(row, CV_32F);
+    }
+    Mat labels32;
+    labels.reshape(1, 1).convertTo(labels32, CV_32S);
+    this->labels.assign(labels32.ptr<int>(0), labels32.ptr<int>(0) + labels32.total());
+    this->eigenvalues = eigenvalues.clone();
+}
+
+/**
+ * Sum of squared differences of two float arrays, four lanes at a time where SSE2 is 
+ * available.
+ */
+static float squaredDistance(const float *a, const float *b, int length) {
+    int i = 0;
+    float result = 0;
+#ifdef __SSE2__
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= length; i += 4) {
+        __m128 difference = _mm_sub_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i));
+        sum = _mm_add_ps(sum, _mm_mul_ps(difference, difference));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, sum);
+    result = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < length; i++) {
+        float difference = a[i] - b[i];
+        result += difference * difference;
+    }
+    return result;
+}
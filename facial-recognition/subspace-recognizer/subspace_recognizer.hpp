@@ -0,0 +1,83 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef SUBSPACE_RECOGNIZER_HPP_
+#define SUBSPACE_RECOGNIZER_HPP_
+
+#include <opencv2/core/core.hpp>
+#include <opencv2/face.hpp>
+
+#include <cfloat>
+#include <vector>
+
+/**
+ * Eigenfaces or Fisherfaces with single precision prediction.
+ *
+ * Training is done by OpenCV's recognizer of the same method, so the subspace is the same. 
+ * The eigenvectors and the projected training faces are then kept as float32, the eigenvectors
+ * transposed so projecting a face is one matrix-vector product over contiguous rows, and the
+ * nearest neighbor is found with a vectorized squared L2 kernel. Models are saved in OpenCV's
+ * format, so either recognizer can load the other's files.
+ */
+class SubspaceFaceRecognizer : public cv::face::FaceRecognizer {
+public:
+    enum Method {
+        EIGENFACES,
+        FISHERFACES
+    };
+
+    SubspaceFaceRecognizer(Method method, int numComponents = 0, double threshold = DBL_MAX);
+
+    void train(cv::InputArrayOfArrays src, cv::InputArray labels);
+    int predict(cv::InputArray src) const;
+    void predict(cv::InputArray src, int &label, double &confidence) const;
+
+    using cv::face::FaceRecognizer::save;
+    using cv::face::FaceRecognizer::load;
+    void save(cv::FileStorage &fs) const;
+    void load(const cv::FileStorage &fs);
+
+    Method getMethod() const;
+    int getNumComponents() const;
+    double getThreshold() const;
+    void setThreshold(double threshold);
+
+private:
+    Method method;
+    int numComponents;
+    double threshold;
+    // 1 x D mean face and K x D eigenvectors, one component per row
+    cv::Mat mean;
+    cv::Mat eigenvectors;
+    // N x K projected training faces, one per row, and their labels
+    cv::Mat projections;
+    std::vector<int> labels;
+    // Only kept to be saved
+    cv::Mat eigenvalues;
+
+    void setSubspace(const cv::Mat &mean, const cv::Mat &eigenvectors, 
+            const std::vector<cv::Mat> &projections, const cv::Mat &labels, 
+            const cv::Mat &eigenvalues);
+};
+
+#endif
@@ -21,8 +21,8 @@
  * DEALINGS IN THE SOFTWARE.
  */
 
-// Switch between Local Binary Patterns Histograms(2), Eigenfaces (1), and Fisherfaces (0)
-#define FACIAL_RECOGNITION_MODEL 2
+#include "../dataset-loader/dataset_loader.hpp"
+#include "../recognizer-factory/recognizer_factory.hpp"
 
 #include <opencv2/core/core.hpp>
 #include <opencv2/face.hpp>
@@ -40,101 +40,79 @@
 using namespace cv;
 using namespace std;
 
-/**
- * Read images and labels from the csv file specified by fileName.
- */
-static void read_csv(const string& fileName, vector<Mat>& images, vector<int>& labels, 
-        string filePrefix="", char separator=';') {
-    std::ifstream file(fileName.c_str(), ifstream::in);
-    if (!file) {
-        string error_message = "No valid input file was given, please check the given fileName.";
-        CV_Error(CV_StsBadArg, error_message);
-    }
-    string line, path, classlabel;
-    Mat readImage;
-    while (getline(file, line)) {
-        stringstream liness(line);
-        getline(liness, path, separator);
-        getline(liness, classlabel);
-        // If we have a prefix specified and it wasn't found then ignore this sample
-        size_t foundPrefix = path.find(filePrefix);
-        if (!filePrefix.empty() && foundPrefix == std::string::npos) {
-            continue;
-        }
-        if(!path.empty() && !classlabel.empty()) {
-            cout << "Reading image: " << path << endl;
-            readImage = imread(path, 0);
-            if (readImage.empty()) {
-                cerr << "Error opening image file at path: \"" << path << endl;
-                continue;
-            }
-            images.push_back(readImage);
-            labels.push_back(atoi(classlabel.c_str()));
-        }
-    }
-}
+// LBPH models are trained this many samples at a time, so augmented datasets never need to be
+// in memory all at once
+static const int trainingBatchSize = 2048;
+// Saved LBPH models have always been trained with a tighter threshold than the video tools 
+// use, keep it unless one is given
+static const double trainingLbphThreshold = 20.0;
 
 int main(int argc, const char *argv[]) {
 
     // Get the path to your CSV:
-    if (argc != 2) {
-        cout << "Wrong number of args! Usage is train_classifier <csv filename>" << endl;
+    DatasetOptions datasetOptions;
+    vector<string> recognizerOptions;
+    vector<string> arguments = parseDatasetOptions(argc, argv, datasetOptions, 
+            &recognizerOptions);
+    RecognizerConfig recognizerConfig;
+    bool validOptions = parseRecognizerOptions(recognizerOptions, recognizerConfig);
+    if (!validOptions || arguments.size() != 2) {
+        cout << "Wrong number of args! Usage is train_classifier <csv filename> [options]" << endl;
+        printDatasetUsage();
+        printRecognizerUsage();
         exit(1);
     }
+    if (recognizerConfig.threshold < 0 
+            && (recognizerConfig.model == "lbph" || recognizerConfig.model == "qlbph")) {
+        recognizerConfig.threshold = trainingLbphThreshold;
+    }
     // string csvFileName = "yalefaces.csv";
-    string csvFileName(argv[1]);
+    string csvFileName = arguments[1];
     cout << "Using filename: " << csvFileName << endl;
 
-    // These vectors hold the images and corresponding labels:
-    vector<Mat> images;
-    vector<int> labels;
-
-    // Read in the data (fails if no valid input fileName is given, but you'll get an error message):
-    try {
-        // Loop over all files in directory
-        read_csv(csvFileName, images, labels);
-    } catch (cv::Exception& e) {
-        cerr << "Error opening file \"" << csvFileName << "\". Reason: " << e.msg << endl;
+    // Decode the images (or read them from the cache), rotated copies are generated from 
+    // them as training asks for them
+    Dataset dataset;
+    if (!dataset.load(csvFileName, datasetOptions)) {
+        cerr << "Error opening file \"" << csvFileName << "\"." << endl;
         // nothing more we can do
         exit(1);
     }
-
-    // Get the height from the first image. We'll need this
-    // later in code to reshape the images to their original
-    // size AND we need to reshape incoming faces to this size:
-    int imgWidth = images[0].cols;
-    int imgHeight = images[0].rows;
+    cout << "Training on " << dataset.size() << " samples from " << dataset.getSourceCount() 
+            << (dataset.isFromCache() ? " cached samples" : " images") << endl;
 
     // Create a FaceRecognizer and train it on the given images:
-    Ptr<face::FaceRecognizer> model;
-    switch (FACIAL_RECOGNITION_MODEL) {
-        case 0:
-            cout << "Using Fisherfaces" << endl;
-            model = face::createFisherFaceRecognizer();
-            break;
-        case 1:
-            cout << "Using Eigenfaces" << endl;
-            model = face::createEigenFaceRecognizer();
-            break;
-        case 2:
-            cout << "Using Local Binary Pattern Histograms" << endl;
-            int radius = 10;
-            int neighbors = 8;
-            int gridX = 4;
-            int gridY = 4;
-            double threshold = 20.0;
-            cout << "Threshold is: " << threshold << endl;
-            model = face::createLBPHFaceRecognizer(radius, neighbors, gridX, gridY, threshold);
-            break;
-    }
+    Ptr<face::FaceRecognizer> model = createRecognizer(recognizerConfig);
+    cout << "Using " << describeRecognizer(recognizerConfig) << endl;
     cout << "starting training..." << endl;
 
     // Time training...
     chrono::time_point<std::chrono::system_clock> start, end;
     start = std::chrono::system_clock::now();
     
-    model->train(images, labels);
-    model->save("facial-recognition-model");
+    // These vectors hold the images and corresponding labels:
+    vector<Mat> images;
+    vector<int> labels;
+    if (isIncrementalModel(recognizerConfig)) {
+        // LBPH keeps one histogram per sample, so it can learn the dataset a batch at a time
+        for (int batchStart = 0; batchStart < dataset.size(); batchStart += trainingBatchSize) {
+            dataset.getBatch(batchStart, min(trainingBatchSize, dataset.size() - batchStart), 
+                    images, labels);
+            if (batchStart == 0) {
+                model->train(images, labels);
+            } else {
+                model->update(images, labels);
+            }
+        }
+    } else {
+        // Eigenfaces, Fisherfaces and ensembles need every sample at once
+        dataset.getBatch(0, dataset.size(), images, labels);
+        model->train(images, labels);
+    }
+    saveRecognizer(model, recognizerConfig, "facial-recognition-model");
+    ifstream savedModel("facial-recognition-model", ifstream::binary | ifstream::ate);
+    cout << "Saved " << describeRecognizer(recognizerConfig) << ", " 
+            << savedModel.tellg() / 1024 << " KB" << endl;
 
     end = std::chrono::system_clock::now();
     std::chrono::duration<double> elapsed_seconds = end - start;
@@ -0,0 +1,238 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Unpacks the facial recognition params sent during an LGTM exchange in memory.
+ *
+ * The sender wraps a (possibly gzipped) tar archive of training photos between a header and
+ * a footer marker, see send_facial_recognition_params in injection-monitor/full-lgtm.sh.
+ * These functions find the archive between the markers, inflate it if needed, and list the
+ * files in it without extracting anything to disk.
+ */
+#include "training_archive.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Must match FACIAL_RECOGNITION_HEADER and FACIAL_RECOGNITION_FOOTER in full-lgtm.sh
+static const string PARAMS_HEADER = "facial-recognition-params";
+static const string PARAMS_FOOTER = "facial-recognition-params-finished";
+static const size_t TAR_BLOCK_SIZE = 512;
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool readOctal(const unsigned char *field, size_t length, size_t &value);
+static string readString(const unsigned char *field, size_t length);
+static bool isZeroBlock(const unsigned char *block);
+static bool hasValidChecksum(const unsigned char *header);
+static string readPaxPath(const unsigned char *data, size_t size);
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Finds the archive between the first params header and the first footer after it, as the
+ * receiving script did with dd and grep. Returns false if either marker is missing.
+ */
+bool findParamsPayload(const vector<unsigned char> &received, size_t &begin, size_t &end) {
+    vector<unsigned char>::const_iterator header = search(received.begin(), received.end(),
+            PARAMS_HEADER.begin(), PARAMS_HEADER.end());
+    if (header == received.end()) {
+        return false;
+    }
+    vector<unsigned char>::const_iterator payload = header + PARAMS_HEADER.size();
+    vector<unsigned char>::const_iterator footer = search(payload, received.end(),
+            PARAMS_FOOTER.begin(), PARAMS_FOOTER.end());
+    if (footer == received.end()) {
+        return false;
+    }
+    begin = payload - received.begin();
+    end = footer - received.begin();
+    return true;
+}
+
+bool isGzip(const unsigned char *data, size_t size) {
+    return size >= 2 && data[0] == 0x1f && data[1] == 0x8b;
+}
+
+/**
+ * Inflates a gzip stream into inflated. Returns false if the stream is corrupt or truncated.
+ */
+bool inflateGzip(const unsigned char *data, size_t size, vector<unsigned char> &inflated) {
+    z_stream stream;
+    memset(&stream, 0, sizeof(stream));
+    // 16 + MAX_WBITS expects a gzip header instead of a zlib one
+    if (inflateInit2(&stream, 16 + MAX_WBITS) != Z_OK) {
+        return false;
+    }
+    inflated.resize(max(size * 4, (size_t) 64 * 1024));
+    stream.next_in = const_cast<Bytef *>(data);
+    stream.avail_in = (uInt) size;
+    int result = Z_OK;
+    while (result == Z_OK) {
+        if (stream.total_out == inflated.size()) {
+            inflated.resize(inflated.size() * 2);
+        }
+        stream.next_out = &inflated[stream.total_out];
+        stream.avail_out = (uInt) (inflated.size() - stream.total_out);
+        result = inflate(&stream, Z_NO_FLUSH);
+    }
+    inflated.resize(stream.total_out);
+    inflateEnd(&stream);
+    return result == Z_STREAM_END;
+}
+
+/**
+ * Lists the regular files in a ustar or GNU tar archive. GNU long names and pax paths are
+ * followed, other entry types are skipped. Returns false if a header is corrupt or a file
+ * runs past the end of the data.
+ */
+bool parseTar(const unsigned char *data, size_t size, vector<ArchiveEntry> &entries) {
+    string longName;
+    size_t position = 0;
+    while (position + TAR_BLOCK_SIZE <= size) {
+        const unsigned char *header = data + position;
+        // The archive ends with two zero blocks, one is enough to stop
+        if (isZeroBlock(header)) {
+            return true;
+        }
+        size_t fileSize;
+        if (!hasValidChecksum(header) || !readOctal(header + 124, 12, fileSize)) {
+            return false;
+        }
+        size_t dataOffset = position + TAR_BLOCK_SIZE;
+        if (fileSize > size - dataOffset) {
+            return false;
+        }
+        char type = header[156];
+        if (type == 'L') {
+            longName = readString(data + dataOffset, fileSize);
+        } else if (type == 'x') {
+            longName = readPaxPath(data + dataOffset, fileSize);
+        } else {
+            if (type == '0' || type == '\0' || type == '7') {
+                ArchiveEntry entry;
+                entry.path = longName;
+                if (entry.path.empty()) {
+                    entry.path = readString(header, 100);
+                    // ustar splits long paths into a prefix and a name
+                    if (memcmp(header + 257, "ustar", 5) == 0 && header[345] != '\0') {
+                        entry.path = readString(header + 345, 155) + "/" + entry.path;
+                    }
+                }
+                entry.offset = dataOffset;
+                entry.size = fileSize;
+                entries.push_back(entry);
+            }
+            longName.clear();
+        }
+        size_t paddedSize = (fileSize + TAR_BLOCK_SIZE - 1) / TAR_BLOCK_SIZE * TAR_BLOCK_SIZE;
+        position = dataOffset + paddedSize;
+    }
+    // No end of archive blocks, fine as long as the last file was whole
+    return position >= size;
+}
+
+/**
+ * The label in a yalefaces file name such as subject07.happy.jpg, read the way
+ * create_yalefaces_csv.py reads it. Returns -1 for other names.
+ */
+int parseSubjectLabel(const string &path) {
+    size_t slash = path.find_last_of('/');
+    string name = slash == string::npos ? path : path.substr(slash + 1);
+    if (name.compare(0, 7, "subject") != 0 || name.size() == 7
+            || name[7] < '0' || name[7] > '9') {
+        return -1;
+    }
+    return atoi(name.c_str() + 7);
+}
+
+static bool readOctal(const unsigned char *field, size_t length, size_t &value) {
+    value = 0;
+    size_t i = 0;
+    while (i < length && (field[i] == ' ' || field[i] == '\0')) {
+        i++;
+    }
+    bool digits = false;
+    for (; i < length && field[i] >= '0' && field[i] <= '7'; i++) {
+        value = value * 8 + (field[i] - '0');
+        digits = true;
+    }
+    return digits;
+}
+
+static string readString(const unsigned char *field, size_t length) {
+    const unsigned char *end = (const unsigned char *) memchr(field, '\0', length);
+    return string((const char *) field, end == NULL ? length : end - field);
+}
+
+static bool isZeroBlock(const unsigned char *block) {
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        if (block[i] != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * The header checksum is the sum of its bytes with the checksum field read as spaces.
+ */
+static bool hasValidChecksum(const unsigned char *header) {
+    size_t expected;
+    if (!readOctal(header + 148, 8, expected)) {
+        return false;
+    }
+    size_t sum = 0;
+    for (size_t i = 0; i < TAR_BLOCK_SIZE; i++) {
+        sum += i >= 148 && i < 156 ? ' ' : header[i];
+    }
+    return sum == expected;
+}
+
+/**
+ * The path record of a pax extended header, made of "<length> <key>=<value>\n" records.
+ */
+static string readPaxPath(const unsigned char *data, size_t size) {
+    size_t position = 0;
+    while (position < size) {
+        size_t length = 0;
+        size_t i = position;
+        for (; i < size && data[i] >= '0' && data[i] <= '9'; i++) {
+            length = length * 10 + (data[i] - '0');
+        }
+        if (length == 0 || position + length > size || i >= size || data[i] != ' ') {
+            break;
+        }
+        string record((const char *) data + i + 1, position + length - i - 1);
+        if (record.compare(0, 5, "path=") == 0) {
+            // Drop the trailing newline
+            return record.substr(5, record.size() - 6);
+        }
+        position += length;
+    }
+    return "";
+}
@@ -0,0 +1,47 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TRAINING_ARCHIVE_HPP_
+#define TRAINING_ARCHIVE_HPP_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * A file in a tar archive, as a range of the buffer the archive was parsed from.
+ */
+struct ArchiveEntry {
+    std::string path;
+    size_t offset;
+    size_t size;
+};
+
+bool findParamsPayload(const std::vector<unsigned char> &received, size_t &begin,
+        size_t &end);
+bool isGzip(const unsigned char *data, size_t size);
+bool inflateGzip(const unsigned char *data, size_t size, std::vector<unsigned char> &inflated);
+bool parseTar(const unsigned char *data, size_t size, std::vector<ArchiveEntry> &entries);
+int parseSubjectLabel(const std::string &path);
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+/**
+ * Turns the facial recognition params received during an LGTM exchange into a training set
+ * without touching the filesystem. The archive is located and unpacked in memory by
+ * training_archive and every image is decoded straight from the buffer, in parallel.
+ */
+#include "training_import.hpp"
+
+#include "../worker-pool/worker_pool.hpp"
+
+#include <opencv2/imgcodecs.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <iterator>
+
+using namespace cv;
+using namespace std;
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool isImagePath(const string &path);
+
+//~Functions----------------------------------------------------------------------------------------
+TrainingImport::TrainingImport() : faceId(-1) {
+}
+
+/**
+ * Reads a whole received params file, or standard input if fileName is "-".
+ */
+bool readParamsBuffer(const string &fileName, vector<unsigned char> &received) {
+    if (fileName == "-") {
+        received.assign(istreambuf_iterator<char>(cin), istreambuf_iterator<char>());
+        return !received.empty();
+    }
+    ifstream file(fileName.c_str(), ifstream::in | ifstream::binary);
+    if (!file) {
+        return false;
+    }
+    received.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * Decodes the subject images in a received params buffer as grayscale, labelled the way
+ * create_yalefaces_csv.py labels them. Images that fail to decode are reported and skipped,
+ * as readCsv does. Returns false if the buffer holds no readable archive or no images.
+ */
+bool importTrainingParams(const vector<unsigned char> &received, TrainingImport &imported) {
+    size_t begin;
+    size_t end;
+    if (!findParamsPayload(received, begin, end) || begin == end) {
+        cerr << "No facial recognition params between the header and footer" << endl;
+        return false;
+    }
+    const unsigned char *archive = &received[begin];
+    size_t archiveSize = end - begin;
+    vector<unsigned char> inflated;
+    if (isGzip(archive, archiveSize)) {
+        if (!inflateGzip(archive, archiveSize, inflated) || inflated.empty()) {
+            cerr << "Corrupt gzip stream in the facial recognition params" << endl;
+            return false;
+        }
+        archive = &inflated[0];
+        archiveSize = inflated.size();
+    }
+    vector<ArchiveEntry> entries;
+    if (!parseTar(archive, archiveSize, entries)) {
+        cerr << "Corrupt tar archive in the facial recognition params" << endl;
+        return false;
+    }
+
+    vector<ArchiveEntry> images;
+    for (size_t i = 0; i < entries.size(); i++) {
+        if (isImagePath(entries[i].path) && parseSubjectLabel(entries[i].path) >= 0) {
+            images.push_back(entries[i]);
+        }
+    }
+    vector<Mat> decoded(images.size());
+    WorkerPool::shared().run((int) images.size(), [&](int i) {
+        // imdecode only reads the buffer, the header just has no const constructor
+        Mat encoded(1, (int) images[i].size, CV_8UC1,
+                const_cast<unsigned char *>(archive + images[i].offset));
+        decoded[i] = imdecode(encoded, IMREAD_GRAYSCALE);
+    });
+
+    for (size_t i = 0; i < images.size(); i++) {
+        if (decoded[i].empty()) {
+            cerr << "Error decoding image \"" << images[i].path << "\"" << endl;
+            continue;
+        }
+        imported.images.push_back(decoded[i]);
+        imported.labels.push_back(parseSubjectLabel(images[i].path));
+        imported.paths.push_back(images[i].path);
+    }
+    if (imported.images.empty()) {
+        cerr << "No training images in the facial recognition params" << endl;
+        return false;
+    }
+    imported.faceId = imported.labels[0];
+    return true;
+}
+
+/**
+ * Leaves out hidden files, such as the ._ metadata files macOS tar adds next to each image.
+ */
+static bool isImagePath(const string &path) {
+    size_t slash = path.find_last_of('/');
+    size_t nameStart = slash == string::npos ? 0 : slash + 1;
+    return nameStart < path.size() && path[nameStart] != '.';
+}
@@ -0,0 +1,50 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a
+ * copy of this software and associated documentation files (the "Software"),
+ * to deal in the Software without restriction, including without limitation
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense,
+ * and/or sell copies of the Software, and to permit persons to whom the
+ * Software is furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included
+ * in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TRAINING_IMPORT_HPP_
+#define TRAINING_IMPORT_HPP_
+
+#include "training_archive.hpp"
+
+#include <opencv2/core/core.hpp>
+
+#include <string>
+#include <vector>
+
+/**
+ * The training set unpacked from a received facial recognition params buffer.
+ */
+struct TrainingImport {
+    std::vector<cv::Mat> images;
+    std::vector<int> labels;
+    std::vector<std::string> paths;
+    // Label of the first image in the archive, the face the sender wants recognized
+    int faceId;
+
+    TrainingImport();
+};
+
+bool readParamsBuffer(const std::string &fileName, std::vector<unsigned char> &received);
+bool importTrainingParams(const std::vector<unsigned char> &received, TrainingImport &imported);
+
+#endif
@@ -0,0 +1,156 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "worker_pool.hpp"
+
+using namespace std;
+
+//~Functions----------------------------------------------------------------------------------------
+/**
+ * Starts numThreads worker threads, or one less than the number of hardware threads if 
+ * numThreads is 0 since the thread calling run works too.
+ */
+WorkerPool::WorkerPool(unsigned int numThreads) 
+        : task(NULL), taskCount(0), finishedCount(0), activeWorkers(0), generation(0), 
+        stopping(false), nextIndex(0) {
+    if (numThreads == 0) {
+        unsigned int hardwareThreads = thread::hardware_concurrency();
+        numThreads = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+    for (unsigned int i = 0; i < numThreads; i++) {
+        threads.push_back(thread(&WorkerPool::workerLoop, this));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workReady.notify_all();
+    for (unsigned int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+/**
+ * Calls task(i) for every i in [0, count) and waits for all of them to finish. The first 
+ * exception thrown by a task is rethrown here once the others are done.
+ */
+void WorkerPool::run(int count, const function<void(int)> &curTask) {
+    if (count <= 0) {
+        return;
+    }
+    lock_guard<std::mutex> runLock(runMutex);
+    if (threads.empty() || count == 1) {
+        for (int i = 0; i < count; i++) {
+            curTask(i);
+        }
+        return;
+    }
+    {
+        unique_lock<std::mutex> lock(stateMutex);
+        // A worker that woke up late for the previous call may still hold its task
+        workDone.wait(lock, [this] { return activeWorkers == 0; });
+        task = &curTask;
+        taskCount = count;
+        finishedCount = 0;
+        error = exception_ptr();
+        nextIndex = 0;
+        generation++;
+    }
+    workReady.notify_all();
+    int finished = drain(curTask, count);
+
+    unique_lock<std::mutex> lock(stateMutex);
+    finishedCount += finished;
+    workDone.wait(lock, [this] { return finishedCount == taskCount && activeWorkers == 0; });
+    task = NULL;
+    if (error) {
+        exception_ptr curError = error;
+        error = exception_ptr();
+        rethrow_exception(curError);
+    }
+}
+
+/**
+ * Number of threads working on a run call, including the caller.
+ */
+unsigned int WorkerPool::getThreadCount() const {
+    return threads.size() + 1;
+}
+
+/**
+ * The pool shared by everything in the process that wants to run work in parallel.
+ */
+WorkerPool &WorkerPool::shared() {
+    static WorkerPool pool;
+    return pool;
+}
+
+void WorkerPool::workerLoop() {
+    unsigned long seenGeneration = 0;
+    for (;;) {
+        unique_lock<std::mutex> lock(stateMutex);
+        workReady.wait(lock, [&] { return stopping || generation != seenGeneration; });
+        if (stopping) {
+            return;
+        }
+        seenGeneration = generation;
+        if (task == NULL) {
+            continue;
+        }
+        const function<void(int)> &curTask = *task;
+        int curCount = taskCount;
+        activeWorkers++;
+        lock.unlock();
+
+        int finished = drain(curTask, curCount);
+
+        lock.lock();
+        finishedCount += finished;
+        activeWorkers--;
+        if (activeWorkers == 0) {
+            workDone.notify_all();
+        }
+    }
+}
+
+/**
+ * Runs tasks until every index has been claimed and returns how many this thread ran.
+ */
+int WorkerPool::drain(const function<void(int)> &curTask, int curCount) {
+    int finished = 0;
+    for (int i = nextIndex++; i < curCount; i = nextIndex++) {
+        try {
+            curTask(i);
+        } catch (...) {
+            lock_guard<std::mutex> lock(stateMutex);
+            if (!error) {
+                error = current_exception();
+            }
+        }
+        finished++;
+    }
+    return finished;
+}
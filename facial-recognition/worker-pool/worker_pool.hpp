@@ -0,0 +1,76 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef WORKER_POOL_HPP_
+#define WORKER_POOL_HPP_
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * A fixed set of threads that run the iterations of a loop in parallel.
+ *
+ * run(count, task) calls task(0) ... task(count - 1) across the pool's threads and the calling
+ * thread, and returns once every call has finished. Indices are handed out one at a time so
+ * uneven tasks balance themselves. The threads sleep between calls.
+ */
+class WorkerPool {
+public:
+    explicit WorkerPool(unsigned int numThreads = 0);
+    ~WorkerPool();
+
+    void run(int count, const std::function<void(int)> &task);
+    unsigned int getThreadCount() const;
+
+    static WorkerPool &shared();
+
+private:
+    std::vector<std::thread> threads;
+    // Serializes run calls from different threads
+    std::mutex runMutex;
+    // Guards everything below except nextIndex
+    std::mutex stateMutex;
+    std::condition_variable workReady;
+    std::condition_variable workDone;
+    const std::function<void(int)> *task;
+    int taskCount;
+    int finishedCount;
+    int activeWorkers;
+    unsigned long generation;
+    bool stopping;
+    std::exception_ptr error;
+    std::atomic<int> nextIndex;
+
+    WorkerPool(const WorkerPool &);
+    WorkerPool &operator=(const WorkerPool &);
+
+    void workerLoop();
+    int drain(const std::function<void(int)> &curTask, int curCount);
+};
+
+#endif
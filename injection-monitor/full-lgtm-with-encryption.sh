@@ -144,8 +144,7 @@ first_message () {
     # Sleep for 5 seconds to ensure other party has switched into monitor mode....
     sleep $SWITCH_WAIT_TIME
     ../cryptography/lgtm_crypto_runner first-message
-    dd if=.lgtm-crypto-params-first-message of=.lgtm-begin-protocol bs=1
-    echo -n $LGTM_BEGIN_TOKEN | dd of=.lgtm-begin-protocol bs=1 oflag=append conv=notrunc
+    ../cryptography/lgtm_framing frame .lgtm-crypto-params-first-message .lgtm-begin-protocol --footer=$LGTM_BEGIN_TOKEN
     ./packets-from-file/packets_from_file .lgtm-begin-protocol 1 $PACKET_DELAY
 }
 
@@ -154,13 +153,11 @@ reply_to_first_message () {
     echo "Receiving and replying to first message.........................."
     logged_on_user=$(who | head -n1 | awk '{print $1;}')
     sudo -u $logged_on_user matlab -nojvm -nodisplay -nosplash -r "read_mpdu_file .lgtm-begin-monitor.dat .lgtm-first-message, exit"
-    file_size=$(wc --bytes .lgtm-first-message | cut -d ' ' -f 1)
-    bytes_to_copy=$((($file_size - ${#LGTM_BEGIN_TOKEN})))
     # Trim off the $LGTM_BEGIN_TOKEN at the end of the file
-    dd if=.lgtm-first-message of=.lgtm-crypto-params-first-message bs=1 count=$bytes_to_copy
+    ../cryptography/lgtm_framing strip .lgtm-first-message .lgtm-crypto-params-first-message --footer=$LGTM_BEGIN_TOKEN
     ../cryptography/lgtm_crypto_runner first-message-reply
     # Attach footer to crypto params message
-    echo -n $FIRST_MESSAGE_REPLY_FOOTER | dd of=.lgtm-crypto-params-first-message-reply bs=1 oflag=append conv=notrunc
+    echo -n $FIRST_MESSAGE_REPLY_FOOTER >> .lgtm-crypto-params-first-message-reply
     # Setup Injection mode
     injection_mode
     # Sleep to ensure other party has switched into monitor mode....
@@ -190,22 +187,18 @@ third_message () {
             sudo -u $logged_on_user matlab -nojvm -nodisplay -nosplash -r "read_mpdu_file .lgtm-monitor-first-message-reply.dat .lgtm-first-message-reply, exit"
             echo "Data extracted!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
             # Receive ack + params
-            lgtm_ack=$(cat .lgtm-first-message-reply | grep $FIRST_MESSAGE_REPLY_FOOTER | wc -l)
+            lgtm_ack=$(../cryptography/lgtm_framing find .lgtm-first-message-reply $FIRST_MESSAGE_REPLY_FOOTER | wc -l)
         fi
         sleep 3
     done  
     pkill log_to_file
 
     # Cut off the footer so we only have the crypto things
-    file_size=$(wc --bytes .lgtm-first-message-reply | cut -d ' ' -f 1)
-    bytes_to_copy=$((($file_size - ${#SFIRST_MESSAGE_REPLY_FOOTER})))
-    dd if=.lgtm-first-message-reply of=.lgtm-crypto-params-first-message-reply bs=1 count=$bytes_to_copy
+    ../cryptography/lgtm_framing strip .lgtm-first-message-reply .lgtm-crypto-params-first-message-reply --footer=$FIRST_MESSAGE_REPLY_FOOTER
 
     # Setup facial-recognition-params
     rm .lgtm-facial-recognition-params
-    echo -n $FACIAL_RECOGNITION_HEADER > .lgtm-facial-recognition-params
-    dd if=$facial_recognition_file of=.lgtm-facial-recognition-params seek=${#FACIAL_RECOGNITION_HEADER} bs=1
-    echo -n $FACIAL_RECOGNITION_FOOTER | dd of=.lgtm-facial-recognition-params oflag=append conv=notrunc
+    ../cryptography/lgtm_framing frame $facial_recognition_file .lgtm-facial-recognition-params --header=$FACIAL_RECOGNITION_HEADER --footer=$FACIAL_RECOGNITION_FOOTER
 
     # Process crypto parameters and prepare third message
     ../cryptography/lgtm_crypto_runner third-message
@@ -244,7 +237,7 @@ reply_to_third_message () {
             sudo -u $logged_on_user matlab -nojvm -nodisplay -nosplash -r "read_mpdu_file .lgtm-monitor-third-message.dat .lgtm-third-message, exit"
             echo "Data extracted!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
             # Receive ack + params
-            lgtm_ack=$(cat .lgtm-third-message | grep $THIRD_MESSAGE_FOOTER | wc -l)
+            lgtm_ack=$(../cryptography/lgtm_framing find .lgtm-third-message $THIRD_MESSAGE_FOOTER | wc -l)
         fi
         sleep 3
     done    
@@ -252,15 +245,11 @@ reply_to_third_message () {
     chmod 644 .lgtm-monitor-third-message.dat
 
     # Process crypto parameters and prepare third message
-    file_size=$(wc --bytes .lgtm-third-message | cut -d ' ' -f 1)
-    bytes_to_copy=$((($file_size - ${#THIRD_MESSAGE_FOOTER})))
     rm .lgtm-crypto-params-third-message
-    dd if=.lgtm-third-message of=.lgtm-crypto-params-third-message bs=1 count=$bytes_to_copy
+    ../cryptography/lgtm_framing strip .lgtm-third-message .lgtm-crypto-params-third-message --footer=$THIRD_MESSAGE_FOOTER
     # Setup facial-recognition-params
     rm .lgtm-facial-recognition-params
-    echo -n $FACIAL_RECOGNITION_HEADER > .lgtm-facial-recognition-params
-    dd if=$facial_recognition_file of=.lgtm-facial-recognition-params seek=${#FACIAL_RECOGNITION_HEADER} bs=1
-    echo -n $FACIAL_RECOGNITION_FOOTER | dd of=.lgtm-facial-recognition-params oflag=append conv=notrunc
+    ../cryptography/lgtm_framing frame $facial_recognition_file .lgtm-facial-recognition-params --header=$FACIAL_RECOGNITION_HEADER --footer=$FACIAL_RECOGNITION_FOOTER
 
     # Construct message with encryption, etc
     ../cryptography/lgtm_crypto_runner third-message-reply
@@ -298,7 +287,7 @@ verify_reply_to_third_message () {
             sudo -u $logged_on_user matlab -nojvm -nodisplay -nosplash -r "read_mpdu_file .lgtm-monitor-third-message-reply.dat .lgtm-third-message-reply, exit"
             echo "Data extracted!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
             # Receive ack + params
-            lgtm_ack=$(cat .lgtm-third-message-reply | grep $THIRD_MESSAGE_REPLY_FOOTER | wc -l)
+            lgtm_ack=$(../cryptography/lgtm_framing find .lgtm-third-message-reply $THIRD_MESSAGE_REPLY_FOOTER | wc -l)
         fi
         sleep 3
     done    
@@ -306,9 +295,7 @@ verify_reply_to_third_message () {
     chmod 644 .lgtm-monitor-third-message-reply.dat
 
     # Process crypto parameters and prepare third message reply
-    file_size=$(wc --bytes .lgtm-third-message-reply | cut -d ' ' -f 1)
-    bytes_to_copy=$((($file_size - ${#THIRD_MESSAGE_REPLY_FOOTER})))
-    dd if=.lgtm-third-message-reply of=.lgtm-crypto-params-third-message-reply bs=1 count=$bytes_to_copy
+    ../cryptography/lgtm_framing strip .lgtm-third-message-reply .lgtm-crypto-params-third-message-reply --footer=$THIRD_MESSAGE_REPLY_FOOTER
     ../cryptography/lgtm_crypto_runner decrypt-third-message-reply
 }
 
@@ -321,9 +308,7 @@ send_facial_recognition_params () {
     # Send acknowledgment + facial recognition params
     # Send facial recognition params
     rm .lgtm-facial-recognition-params
-    echo $FACIAL_RECOGNITION_HEADER > .lgtm-facial-recognition-params
-    dd if=$facial_recognition_file of=.lgtm-facial-recognition-params seek=${#FACIAL_RECOGNITION_HEADER} bs=1
-    echo -n $FACIAL_RECOGNITION_FOOTER | dd of=.lgtm-facial-recognition-params bs=1 oflag=append conv=notrunc
+    ../cryptography/lgtm_framing frame $facial_recognition_file .lgtm-facial-recognition-params --header=$FACIAL_RECOGNITION_HEADER --footer=$FACIAL_RECOGNITION_FOOTER
 
     ./packets-from-file/packets_from_file .lgtm-facial-recognition-params 1 $PACKET_DELAY
     echo "Sent 'facial recognition params'!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
@@ -354,7 +339,7 @@ receive_facial_recognition_params () {
             sudo -u $logged_on_user matlab -nojvm -nodisplay -nosplash -r "run('read_mpdu_file.m'), exit"    
             echo "Data extracted!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
             # Receive ack + params
-            lgtm_ack=$(cat .lgtm-received-facial-recognition-params | grep $FACIAL_RECOGNITION_FOOTER | wc -l)
+            lgtm_ack=$(../cryptography/lgtm_framing find .lgtm-received-facial-recognition-params $FACIAL_RECOGNITION_FOOTER | wc -l)
         fi
         sleep 3
     done
@@ -380,29 +365,9 @@ compare_wireless_location_with_face_location () {
     echo
     echo "Checking for face/signal overlap................................."
 
-    rm .lgtm-received-facial-recognition-params--no-header
-    rm .lgtm-received-facial-recognition-params--no-header--no-footer
-    # Strip off $FACIAL_RECOGNITION_HEADER, $FACIAL_RECOGNITION_FOOTER, and anything before or after
-    # Plus one for the string terminator ('\0')
-    num_header_bytes=${#FACIAL_RECOGNITION_HEADER}
-    dd if=.lgtm-received-facial-recognition-params bs=1 skip=$num_header_bytes of=.lgtm-received-facial-recognition-params--no-header
-    byte_offset=$(dd if=.lgtm-received-facial-recognition-params--no-header bs=1 | grep --byte-offset --only-matching --text $FACIAL_RECOGNITION_FOOTER | grep --only-matching [0-9]*)
-    dd if=.lgtm-received-facial-recognition-params--no-header bs=1 count=$byte_offset of=.lgtm-received-facial-recognition-params--no-header--no-footer
-    
-    # Extract files from tar archive
-    tar xvf .lgtm-received-facial-recognition-params--no-header--no-footer   
-    facial_recognition_params_folder=$(tar xvf .lgtm-received-facial-recognition-params--no-header--no-footer | head -n 1)
-    echo "facial_recognition_params_folder: " $facial_recognition_params_folder
-    rm -rf .lgtm-facial-recognition-training-photos
-    mv $facial_recognition_params_folder .lgtm-facial-recognition-training-photos
-
-    # Generate csv file with paths to images for training and labels
-    rm .lgtm-facial-recognition-training-photo-paths.csv
-    ./create_yalefaces_csv.py .lgtm-facial-recognition-training-photos > .lgtm-facial-recognition-training-photo-paths.csv
-
-    # Grab the label from the first entry (they're assumed to all be the same)
-    # The label is from after the semi-colon to the end of the line
-    face_id=$(cat .lgtm-facial-recognition-training-photo-paths.csv | head -n1 | grep -o ";.*$" | cut -c 2-)
+    # The recognizer unpacks the training photos straight from the received params, between
+    # $FACIAL_RECOGNITION_HEADER and $FACIAL_RECOGNITION_FOOTER, and takes the face id from
+    # the label of the first photo (they're assumed to all be the same)
     top_aoas=$(cat .lgtm-top-aoas)
 
     # Change folder to run facial recognition program
@@ -410,7 +375,7 @@ compare_wireless_location_with_face_location () {
     cd ../facial-recognition/lgtm-recognition/
 
     # Run facial recognition
-    ./run_lgtm_facial_recognition.sh $webcam_id $old_dir/.lgtm-facial-recognition-training-photo-paths.csv $face_id $top_aoas 2>/dev/null
+    ./run_lgtm_facial_recognition.sh $webcam_id $old_dir/.lgtm-received-facial-recognition-params auto $top_aoas --params 2>/dev/null
 
     # Return to original directory
     cd $old_dir
@@ -436,7 +401,7 @@ begin_lgtm=0
 input='a'
 while [[ $input != 'l' ]] && [[ $begin_lgtm -lt 1 ]]; do
     read -n 1 -s -t 1 -r input
-    begin_lgtm=$(cat .lgtm-begin-monitor.dat | grep $LGTM_BEGIN_TOKEN | wc -l)
+    begin_lgtm=$(../cryptography/lgtm_framing find .lgtm-begin-monitor.dat $LGTM_BEGIN_TOKEN | wc -l)
 done
 
 start_time=$(date +%s)
@@ -137,9 +137,7 @@ send_facial_recognition_params () {
     sleep $SWITCH_WAIT_TIME
     # Send facial recognition params
     rm .lgtm-facial-recognition-params
-    echo $FACIAL_RECOGNITION_HEADER > .lgtm-facial-recognition-params
-    dd if=$facial_recognition_file of=.lgtm-facial-recognition-params seek=${#FACIAL_RECOGNITION_HEADER} bs=1
-    echo $FACIAL_RECOGNITION_FOOTER | dd of=.lgtm-facial-recognition-params bs=1 oflag=append conv=notrunc
+    ../cryptography/lgtm_framing frame $facial_recognition_file .lgtm-facial-recognition-params --header=$FACIAL_RECOGNITION_HEADER --footer=$FACIAL_RECOGNITION_FOOTER
 
     ./packets-from-file/packets_from_file .lgtm-facial-recognition-params 1
     echo "Sent 'facial recognition params'!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
@@ -169,7 +167,7 @@ receive_facial_recognition_params () {
             sudo -u $logged_on_user matlab -nojvm -nodisplay -nosplash -r "run('read_mpdu_file.m'), exit"    
             echo "Data extracted!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!!"
             # Receive ack + params
-            lgtm_ack=$(cat .lgtm-received-facial-recognition-params | grep $FACIAL_RECOGNITION_FOOTER | wc -l)
+            lgtm_ack=$(../cryptography/lgtm_framing find .lgtm-received-facial-recognition-params $FACIAL_RECOGNITION_FOOTER | wc -l)
         fi
         sleep 3
     done
@@ -189,29 +187,9 @@ localize_wireless_signal () {
 compare_wireless_location_with_face_location () {
     echo "Checking for face/signal overlap................................."
 
-    rm .lgtm-received-facial-recognition-params--no-header
-    rm .lgtm-received-facial-recognition-params--no-header--no-footer
-    # Strip off $FACIAL_RECOGNITION_HEADER, $FACIAL_RECOGNITION_FOOTER, and anything before or after
-    # Plus one for the string terminator ('\0')
-    num_header_bytes=${#FACIAL_RECOGNITION_HEADER}
-    dd if=.lgtm-received-facial-recognition-params bs=1 skip=$num_header_bytes of=.lgtm-received-facial-recognition-params--no-header
-    byte_offset=$(dd if=.lgtm-received-facial-recognition-params--no-header bs=1 | grep --byte-offset --only-matching --text $FACIAL_RECOGNITION_FOOTER | grep --only-matching [0-9]*)
-    dd if=.lgtm-received-facial-recognition-params--no-header bs=1 count=$byte_offset of=.lgtm-received-facial-recognition-params--no-header--no-footer
-    
-    # Extract files from tar archive
-    tar xvf .lgtm-received-facial-recognition-params--no-header--no-footer   
-    facial_recognition_params_folder=$(tar xvf .lgtm-received-facial-recognition-params--no-header--no-footer | head -n 1)
-    echo "facial_recognition_params_folder: " $facial_recognition_params_folder
-    rm -rf .lgtm-facial-recognition-training-photos
-    mv $facial_recognition_params_folder .lgtm-facial-recognition-training-photos
-
-    # Generate csv file with paths to images for training and labels
-    rm .lgtm-facial-recognition-training-photo-paths.csv
-    ./create_yalefaces_csv.py .lgtm-facial-recognition-training-photos > .lgtm-facial-recognition-training-photo-paths.csv
-
-    # Grab the label from the first entry (they're assumed to all be the same)
-    # The label is from after the semi-colon to the end of the line
-    face_id=$(cat .lgtm-facial-recognition-training-photo-paths.csv | head -n1 | grep -o ";.*$" | cut -c 2-)
+    # The recognizer unpacks the training photos straight from the received params, between
+    # $FACIAL_RECOGNITION_HEADER and $FACIAL_RECOGNITION_FOOTER, and takes the face id from
+    # the label of the first photo (they're assumed to all be the same)
     top_aoas=$(cat .lgtm-top-aoas)
 
     # Change folder to run facial recognition program
@@ -219,7 +197,7 @@ compare_wireless_location_with_face_location () {
     cd ../facial-recognition/lgtm-recognition/
 
     # Run facial recognition
-    ./run_lgtm_facial_recognition.sh $webcam_id $old_dir/.lgtm-facial-recognition-training-photo-paths.csv $face_id $top_aoas 2>/dev/null
+    ./run_lgtm_facial_recognition.sh $webcam_id $old_dir/.lgtm-received-facial-recognition-params auto $top_aoas --params 2>/dev/null
 
     # Return to original directory
     cd $old_dir
@@ -241,7 +219,7 @@ begin_lgtm=0
 input='a'
 while [[ $input != 'l' ]] && [[ $begin_lgtm -lt 1 ]]; do
     read -n 1 -s -t 1 -r input
-    begin_lgtm=$(cat .lgtm-begin-monitor.dat | grep $LGTM_BEGIN_TOKEN | wc -l)
+    begin_lgtm=$(../cryptography/lgtm_framing find .lgtm-begin-monitor.dat $LGTM_BEGIN_TOKEN | wc -l)
 done
 
 start_time=$(date +%s)
@@ -0,0 +1,432 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "csi_ring.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const uint32_t CSI_RING_MAGIC = 0x4c43534d;
+static const size_t CSI_RING_SLOT_SIZE = 4096;
+// Slot space left for a record after its stamp and length
+static const size_t MAX_RECORD_SIZE = CSI_RING_SLOT_SIZE - 16;
+// Space for the header, before the first slot
+static const size_t HEADER_AREA_SIZE = 4096;
+// Longest a reader sleeps before checking its publisher is still there, since nothing wakes
+// it if the publisher is killed
+static const int PUBLISHER_CHECK_INTERVAL_MS = 1000;
+
+/**
+ * Where one consumer is in the ring, kept by the consumer for the publisher to report on.
+ */
+struct CsiRingConsumer {
+    std::atomic<uint32_t> inUse;
+    std::atomic<uint64_t> cursor;
+    std::atomic<uint64_t> droppedCount;
+};
+
+struct CsiRingHeader {
+    uint32_t magic;
+    uint32_t slotCount;
+    std::atomic<uint64_t> publishedCount;
+    // Futex word bumped after every publish, for readers to sleep on
+    std::atomic<uint32_t> wakeCount;
+    std::atomic<uint32_t> waiterCount;
+    // Set once the publisher is done, after its last record
+    std::atomic<uint32_t> closed;
+    CsiRingConsumer consumers[MAX_CSI_RING_CONSUMERS];
+};
+
+struct CsiRingSlot {
+    // 2 * sequence + 2 once the slot holds record sequence, odd while it's being written
+    std::atomic<uint64_t> stamp;
+    uint32_t length;
+    uint32_t padding;
+    uint8_t data[MAX_RECORD_SIZE];
+};
+
+static_assert(sizeof(CsiRingHeader) <= HEADER_AREA_SIZE, "CSI ring header too large");
+static_assert(sizeof(CsiRingSlot) == CSI_RING_SLOT_SIZE, "CSI ring slot not packed");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word not 32 bits");
+
+//~Function Headers---------------------------------------------------------------------------------
+static CsiRingSlot *slotAt(CsiRingHeader *header, uint32_t slotCount, uint64_t sequence);
+static void wakeReaders(CsiRingHeader *header);
+
+//~Functions----------------------------------------------------------------------------------------
+CsiRing::CsiRing() : memoryFd(-1), mappedSize(0), header(NULL), slotCount(0) {
+}
+
+CsiRing::~CsiRing() {
+    if (header != NULL) {
+        header->closed.store(1);
+        header->wakeCount.fetch_add(1);
+        wakeReaders(header);
+        munmap(header, mappedSize);
+    }
+    if (memoryFd != -1) {
+        close(memoryFd);
+    }
+}
+
+/**
+ * Creates the shared memory for slotCount records, sealed so no consumer can resize it.
+ */
+bool CsiRing::create(uint32_t slotCount) {
+    this->slotCount = slotCount;
+    if (slotCount == 0) {
+        cerr << "A CSI ring needs at least one slot" << endl;
+        return false;
+    }
+    memoryFd = memfd_create("lgtm-csi-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (memoryFd == -1) {
+        perror("memfd_create");
+        return false;
+    }
+    mappedSize = HEADER_AREA_SIZE + (size_t) slotCount * CSI_RING_SLOT_SIZE;
+    if (ftruncate(memoryFd, mappedSize) == -1) {
+        perror("ftruncate");
+        return false;
+    }
+    if (fcntl(memoryFd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) == -1) {
+        perror("fcntl");
+        return false;
+    }
+    void *memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    // Fresh memfd pages are zero, so every slot stamp and consumer starts out empty
+    header = (CsiRingHeader *) memory;
+    header->magic = CSI_RING_MAGIC;
+    header->slotCount = slotCount;
+    return true;
+}
+
+/**
+ * Publishes one record, its code byte and data without the length, overwriting the oldest.
+ * Only one thread may publish. Returns false if the record doesn't fit in a slot.
+ */
+bool CsiRing::publish(const uint8_t *record, size_t size) {
+    if (size > MAX_RECORD_SIZE) {
+        return false;
+    }
+    uint64_t sequence = header->publishedCount.load(memory_order_relaxed);
+    CsiRingSlot *slot = slotAt(header, slotCount, sequence);
+    slot->stamp.store(2 * sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    slot->length = size;
+    memcpy(slot->data, record, size);
+    slot->stamp.store(2 * sequence + 2, memory_order_release);
+    header->publishedCount.store(sequence + 1, memory_order_release);
+    header->wakeCount.fetch_add(1);
+    if (header->waiterCount.load() > 0) {
+        wakeReaders(header);
+    }
+    return true;
+}
+
+/**
+ * Takes a free consumer slot, reading from the next record published, or returns -1.
+ */
+int CsiRing::claimConsumer() {
+    for (int i = 0; i < MAX_CSI_RING_CONSUMERS; i++) {
+        CsiRingConsumer &consumer = header->consumers[i];
+        uint32_t free = 0;
+        if (consumer.inUse.compare_exchange_strong(free, 1)) {
+            consumer.cursor.store(header->publishedCount.load());
+            consumer.droppedCount.store(0);
+            return i;
+        }
+    }
+    return -1;
+}
+
+void CsiRing::releaseConsumer(int consumer) {
+    header->consumers[consumer].inUse.store(0);
+}
+
+/**
+ * Hands the ring and a consumer slot to a CsiRingReader connected on socketFd. A consumer of 
+ * -1 tells the reader the ring is full, without the ring.
+ */
+bool CsiRing::sendTo(int socketFd, int consumer) {
+    int32_t consumerData = consumer;
+    struct iovec dataVector;
+    dataVector.iov_base = &consumerData;
+    dataVector.iov_len = sizeof(consumerData);
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &dataVector;
+    message.msg_iovlen = 1;
+    char control[CMSG_SPACE(sizeof(int))];
+    if (consumer != -1) {
+        memset(control, 0, sizeof(control));
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+        struct cmsghdr *controlMessage = CMSG_FIRSTHDR(&message);
+        controlMessage->cmsg_level = SOL_SOCKET;
+        controlMessage->cmsg_type = SCM_RIGHTS;
+        controlMessage->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(controlMessage), &memoryFd, sizeof(int));
+    }
+    if (sendmsg(socketFd, &message, MSG_NOSIGNAL) != (ssize_t) sizeof(consumerData)) {
+        perror("sendmsg");
+        return false;
+    }
+    return true;
+}
+
+uint64_t CsiRing::getPublishedCount() const {
+    return header->publishedCount.load();
+}
+
+/**
+ * Records published that the consumer hasn't read yet.
+ */
+uint64_t CsiRing::getLag(int consumer) const {
+    return header->publishedCount.load() - header->consumers[consumer].cursor.load();
+}
+
+uint64_t CsiRing::getDroppedCount(int consumer) const {
+    return header->consumers[consumer].droppedCount.load();
+}
+
+CsiRingReader::CsiRingReader() : connectionFd(-1), mappedSize(0), header(NULL), slotCount(0), 
+        consumer(-1), cursor(0), droppedCount(0), interrupted(false) {
+}
+
+CsiRingReader::~CsiRingReader() {
+    if (header != NULL) {
+        munmap(header, mappedSize);
+    }
+    // Frees the consumer slot for the next reader
+    if (connectionFd != -1) {
+        close(connectionFd);
+    }
+}
+
+/**
+ * Connects to the publisher listening on socketPath and maps the ring it hands over.
+ */
+bool CsiRingReader::attach(const string &socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "CSI ring socket path too long: " << socketPath << endl;
+        return false;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    connectionFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (connectionFd == -1) {
+        perror("socket");
+        return false;
+    }
+    if (connect(connectionFd, (struct sockaddr *) &address, sizeof(address)) == -1) {
+        perror(("connect " + socketPath).c_str());
+        return false;
+    }
+
+    int32_t consumerData = -1;
+    struct iovec dataVector;
+    dataVector.iov_base = &consumerData;
+    dataVector.iov_len = sizeof(consumerData);
+    char control[CMSG_SPACE(sizeof(int))];
+    struct msghdr message;
+    memset(&message, 0, sizeof(message));
+    message.msg_iov = &dataVector;
+    message.msg_iovlen = 1;
+    message.msg_control = control;
+    message.msg_controllen = sizeof(control);
+    if (recvmsg(connectionFd, &message, MSG_CMSG_CLOEXEC) != (ssize_t) sizeof(consumerData)) {
+        cerr << "CSI ring publisher closed the connection" << endl;
+        return false;
+    }
+    struct cmsghdr *controlMessage = CMSG_FIRSTHDR(&message);
+    if (consumerData < 0 || consumerData >= MAX_CSI_RING_CONSUMERS || controlMessage == NULL
+            || controlMessage->cmsg_type != SCM_RIGHTS) {
+        cerr << "CSI ring has no room for another consumer" << endl;
+        return false;
+    }
+    int memoryFd;
+    memcpy(&memoryFd, CMSG_DATA(controlMessage), sizeof(int));
+    struct stat memoryStat;
+    void *memory = MAP_FAILED;
+    if (fstat(memoryFd, &memoryStat) == 0) {
+        mappedSize = memoryStat.st_size;
+        memory = mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    }
+    close(memoryFd);
+    if (memory == MAP_FAILED) {
+        perror("mmap");
+        return false;
+    }
+    header = (CsiRingHeader *) memory;
+    if (header->magic != CSI_RING_MAGIC || header->slotCount == 0
+            || mappedSize != HEADER_AREA_SIZE + (size_t) header->slotCount * CSI_RING_SLOT_SIZE) {
+        cerr << "Not a CSI ring" << endl;
+        munmap(header, mappedSize);
+        header = NULL;
+        return false;
+    }
+    slotCount = header->slotCount;
+    consumer = consumerData;
+    cursor = header->consumers[consumer].cursor.load();
+    return true;
+}
+
+/**
+ * Appends every record published since the last read, framed as log_to_file frames them, 
+ * waiting up to timeoutMs for one (forever if negative). Records overwritten before they were 
+ * read are counted by getDroppedCount. Returns false once interrupted, or once every record 
+ * is read and the publisher is gone, which is noticed within PUBLISHER_CHECK_INTERVAL_MS even
+ * if it was killed.
+ */
+bool CsiRingReader::read(vector<uint8_t> &records, int timeoutMs) {
+    if (header == NULL) {
+        return false;
+    }
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() 
+            + chrono::milliseconds(timeoutMs);
+    while (true) {
+        // Read before the interrupt flag and the count, so an interrupt or a publish in 
+        // between makes the wait return at once
+        uint32_t wakeCount = header->wakeCount.load();
+        if (interrupted) {
+            return false;
+        }
+        uint64_t publishedCount = header->publishedCount.load(memory_order_acquire);
+        if (cursor < publishedCount) {
+            if (publishedCount - cursor > slotCount) {
+                droppedCount += publishedCount - slotCount - cursor;
+                cursor = publishedCount - slotCount;
+            }
+            for (; cursor < publishedCount; cursor++) {
+                if (!readSlot(cursor, records)) {
+                    droppedCount++;
+                }
+            }
+            header->consumers[consumer].cursor.store(cursor);
+            header->consumers[consumer].droppedCount.store(droppedCount);
+            return true;
+        } else if (header->closed.load() || isPublisherGone()) {
+            return false;
+        }
+
+        chrono::nanoseconds wait = chrono::milliseconds(PUBLISHER_CHECK_INTERVAL_MS);
+        if (timeoutMs >= 0) {
+            chrono::nanoseconds remaining = deadline - chrono::steady_clock::now();
+            if (remaining.count() <= 0) {
+                return true;
+            }
+            wait = min(wait, remaining);
+        }
+        struct timespec timeout;
+        timeout.tv_sec = wait.count() / 1000000000;
+        timeout.tv_nsec = wait.count() % 1000000000;
+        header->waiterCount.fetch_add(1);
+        syscall(SYS_futex, (uint32_t *) &header->wakeCount, FUTEX_WAIT, wakeCount, &timeout, 
+                NULL, 0);
+        header->waiterCount.fetch_sub(1);
+    }
+}
+
+/**
+ * Makes read return false, from any thread.
+ */
+void CsiRingReader::interrupt() {
+    interrupted = true;
+    if (header != NULL) {
+        header->wakeCount.fetch_add(1);
+        wakeReaders(header);
+    }
+}
+
+uint64_t CsiRingReader::getDroppedCount() const {
+    return droppedCount;
+}
+
+/**
+ * Whether the publisher closed the connection without closing the ring, i.e. it died. It 
+ * writes nothing after handing over the ring, so the connection is only readable at its end.
+ */
+bool CsiRingReader::isPublisherGone() {
+    struct pollfd pollFd;
+    pollFd.fd = connectionFd;
+    pollFd.events = POLLIN;
+    return poll(&pollFd, 1, 0) > 0;
+}
+
+/**
+ * Copies the record in the slot if it's still the one for sequence once copied.
+ */
+bool CsiRingReader::readSlot(uint64_t sequence, vector<uint8_t> &records) {
+    const CsiRingSlot *slot = slotAt(header, slotCount, sequence);
+    uint64_t stamp = slot->stamp.load(memory_order_acquire);
+    uint32_t length = slot->length;
+    if (stamp != 2 * sequence + 2 || length > MAX_RECORD_SIZE) {
+        return false;
+    }
+    size_t start = records.size();
+    records.push_back((uint8_t) (length >> 8));
+    records.push_back((uint8_t) length);
+    records.insert(records.end(), slot->data, slot->data + length);
+    atomic_thread_fence(memory_order_acquire);
+    if (slot->stamp.load(memory_order_relaxed) != stamp) {
+        records.resize(start);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Takes the slot count kept outside the ring, consumers map it writable and could change it.
+ */
+static CsiRingSlot *slotAt(CsiRingHeader *header, uint32_t slotCount, uint64_t sequence) {
+    return (CsiRingSlot *) ((uint8_t *) header + HEADER_AREA_SIZE 
+            + (sequence % slotCount) * CSI_RING_SLOT_SIZE);
+}
+
+static void wakeReaders(CsiRingHeader *header) {
+    syscall(SYS_futex, (uint32_t *) &header->wakeCount, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
@@ -0,0 +1,104 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef CSI_RING_HPP_
+#define CSI_RING_HPP_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//~Constants----------------------------------------------------------------------------------------
+// Slots a CsiRing holds by default, about 16 MiB of records
+static const uint32_t DEFAULT_CSI_RING_SLOTS = 4096;
+// Consumers that can read a CsiRing at once
+static const int MAX_CSI_RING_CONSUMERS = 16;
+
+struct CsiRingHeader;
+
+/**
+ * Publishes the connector messages received once to any number of live consumers through 
+ * shared memory, as log_to_file records, e.g. for logging, effective SNR display and the 
+ * protocol at the same time.
+ *
+ * The ring is a memfd of fixed size slots, one record each, handed to consumers over a unix 
+ * socket. Publishing never waits for consumers: a consumer that falls more than a ring behind 
+ * loses the oldest records and counts them, the way a full connector socket drops messages.
+ */
+class CsiRing {
+public:
+    CsiRing();
+    ~CsiRing();
+
+    bool create(uint32_t slotCount);
+    bool publish(const uint8_t *record, size_t size);
+    int claimConsumer();
+    void releaseConsumer(int consumer);
+    bool sendTo(int socketFd, int consumer);
+
+    uint64_t getPublishedCount() const;
+    uint64_t getLag(int consumer) const;
+    uint64_t getDroppedCount(int consumer) const;
+
+private:
+    int memoryFd;
+    size_t mappedSize;
+    CsiRingHeader *header;
+    uint32_t slotCount;
+
+    CsiRing(const CsiRing &);
+    CsiRing &operator=(const CsiRing &);
+};
+
+/**
+ * Reads the records of a CsiRing from its own cursor, starting with the next one published.
+ */
+class CsiRingReader {
+public:
+    CsiRingReader();
+    ~CsiRingReader();
+
+    bool attach(const std::string &socketPath);
+    bool read(std::vector<uint8_t> &records, int timeoutMs);
+    void interrupt();
+    uint64_t getDroppedCount() const;
+
+private:
+    int connectionFd;
+    size_t mappedSize;
+    CsiRingHeader *header;
+    uint32_t slotCount;
+    int consumer;
+    uint64_t cursor;
+    uint64_t droppedCount;
+    std::atomic<bool> interrupted;
+
+    CsiRingReader(const CsiRingReader &);
+    CsiRingReader &operator=(const CsiRingReader &);
+
+    bool isPublisherGone();
+    bool readSlot(uint64_t sequence, std::vector<uint8_t> &records);
+};
+
+#endif
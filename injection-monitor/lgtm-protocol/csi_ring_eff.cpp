@@ -0,0 +1,105 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "csi_ring.hpp"
+
+extern "C" {
+#include "../log-to-file/bf_to_eff.h"
+#include "../log-to-file/iwl_structs.h"
+}
+
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// How often to check for a signal while no records arrive
+static const int READ_TIMEOUT_MS = 500;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * Logs the beamforming feedback records a csi_ring_publisher publishes and computes their 
+ * effective SNRs, as nl_bf_to_eff does from its own connector socket, alongside any other 
+ * consumers of the ring. Runs until interrupted.
+ */
+int main(int argc, const char *argv[]) {
+    if (argc != 3) {
+        cerr << "usage: " << argv[0] << " <socket> <output file>" << endl;
+        return 1;
+    }
+    CsiRingReader reader;
+    if (!reader.attach(argv[1])) {
+        return 1;
+    }
+    ofstream output(argv[2], ios::out | ios::binary | ios::trunc);
+    if (!output) {
+        cerr << "Error opening " << argv[2] << endl;
+        return 1;
+    }
+    signal(SIGINT, [](int) { stopRequested = 1; });
+    signal(SIGTERM, [](int) { stopRequested = 1; });
+
+    uint64_t bfeeCount = 0;
+    uint64_t reportedDropCount = 0;
+    double effectiveSnrs[MAX_NUM_RATES][4];
+    vector<uint8_t> records;
+    while (!stopRequested && reader.read(records, READ_TIMEOUT_MS)) {
+        if (reader.getDroppedCount() != reportedDropCount) {
+            cerr << "Ring overran, dropped " << reader.getDroppedCount() - reportedDropCount 
+                    << " records" << endl;
+            reportedDropCount = reader.getDroppedCount();
+        }
+        for (size_t offset = 0; offset + 2 <= records.size(); ) {
+            size_t length = (records[offset] << 8) | records[offset + 1];
+            if (records.size() - offset - 2 < length) {
+                break;
+            }
+            uint8_t *record = records.data() + offset + 2;
+            offset += 2 + length;
+            // The bfee notification follows the code byte
+            if (length < 1 + sizeof(struct iwl5000_bfee_notif) 
+                    || record[0] != IWL_CONN_BFEE_NOTIF) {
+                continue;
+            }
+            output.write((const char *) record - 2, length + 2);
+            if (!output) {
+                cerr << "Error writing " << argv[2] << endl;
+                return 1;
+            }
+            cout << "wrote " << length << " bytes" << endl;
+            calc_eff_snrs((struct iwl5000_bfee_notif *) (record + 1), effectiveSnrs);
+            bfeeCount++;
+        }
+        records.clear();
+    }
+    output.flush();
+    cout << "logged " << bfeeCount << " beamforming feedback records, dropped " 
+            << reader.getDroppedCount() << endl;
+    return output ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "csi_ring.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// How often to check for a signal while no records arrive
+static const int READ_TIMEOUT_MS = 500;
+// Print progress about every this many records, as log_to_file does
+static const uint64_t PROGRESS_RECORD_COUNT = 100;
+
+static volatile sig_atomic_t stopRequested = 0;
+
+/**
+ * Writes the records a csi_ring_publisher publishes to a file, as log_to_file does from the 
+ * connector socket, alongside any other consumers of the ring. Runs until interrupted.
+ */
+int main(int argc, const char *argv[]) {
+    if (argc != 3) {
+        cerr << "usage: " << argv[0] << " <socket> <output file>" << endl;
+        return 1;
+    }
+    CsiRingReader reader;
+    if (!reader.attach(argv[1])) {
+        return 1;
+    }
+    ofstream output(argv[2], ios::out | ios::binary | ios::trunc);
+    if (!output) {
+        cerr << "Error opening " << argv[2] << endl;
+        return 1;
+    }
+    signal(SIGINT, [](int) { stopRequested = 1; });
+    signal(SIGTERM, [](int) { stopRequested = 1; });
+
+    uint64_t byteCount = 0;
+    uint64_t recordCount = 0;
+    uint64_t reportedDropCount = 0;
+    vector<uint8_t> records;
+    while (!stopRequested && reader.read(records, READ_TIMEOUT_MS)) {
+        if (reader.getDroppedCount() != reportedDropCount) {
+            cerr << "Ring overran, dropped " << reader.getDroppedCount() - reportedDropCount 
+                    << " records" << endl;
+            reportedDropCount = reader.getDroppedCount();
+        }
+        if (records.empty()) {
+            continue;
+        }
+        output.write((const char *) records.data(), records.size());
+        if (!output) {
+            cerr << "Error writing " << argv[2] << endl;
+            return 1;
+        }
+        uint64_t previousRecordCount = recordCount;
+        for (size_t offset = 0; offset + 2 <= records.size(); recordCount++) {
+            offset += 2 + ((records[offset] << 8) | records[offset + 1]);
+        }
+        byteCount += records.size();
+        if (recordCount / PROGRESS_RECORD_COUNT != previousRecordCount / PROGRESS_RECORD_COUNT) {
+            cout << "wrote " << byteCount << " bytes [msgcnt=" << recordCount << "]" << endl;
+        }
+        records.clear();
+    }
+    output.flush();
+    cout << "wrote " << byteCount << " bytes in " << recordCount << " records, dropped " 
+            << reader.getDroppedCount() << endl;
+    return output ? 0 : 1;
+}
@@ -0,0 +1,199 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "csi_ring.hpp"
+#include "radio_link.hpp"
+
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Only receiving, nothing is injected
+static const string INJECTION_INTERFACE = "mon0";
+static const int LISTEN_BACKLOG = 8;
+
+//~Function Headers---------------------------------------------------------------------------------
+static int listenOn(const string &socketPath);
+static void publishRecords(const vector<uint8_t> &records, CsiRing &ring);
+static void printUsage(const char *program);
+
+/**
+ * Receives from the iwlwifi connector socket once and publishes every record to a CsiRing, 
+ * handing the ring to each consumer that connects to the socket, e.g. csi_ring_log or 
+ * lgtm_protocol --csi-ring. Run as root until interrupted.
+ */
+int main(int argc, const char *argv[]) {
+    vector<string> arguments;
+    long slotCount = DEFAULT_CSI_RING_SLOTS;
+    int statsSeconds = 0;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument.compare(0, 8, "--slots=") == 0) {
+            slotCount = atol(argument.c_str() + 8);
+        } else if (argument.compare(0, 8, "--stats=") == 0) {
+            statsSeconds = atoi(argument.c_str() + 8);
+        } else {
+            arguments.push_back(argument);
+        }
+    }
+    if (arguments.size() != 1 || slotCount <= 0 || slotCount > UINT32_MAX || statsSeconds < 0) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string socketPath = arguments[0];
+
+    CsiRing ring;
+    if (!ring.create(slotCount)) {
+        return 1;
+    }
+    int listenFd = listenOn(socketPath);
+    if (listenFd == -1) {
+        return 1;
+    }
+    {
+        ConnectorLink link(INJECTION_INTERFACE, 0);
+        EventLoop &loop = link.getEventLoop();
+        loop.watchSignals({SIGINT, SIGTERM}, [&link](int signalNumber) {
+            cerr << "Caught signal " << signalNumber << endl;
+            link.close();
+        });
+        // Consumer slot of each connected reader, by connection
+        map<int, int> consumers;
+        loop.watch(listenFd, EPOLLIN, [&](uint32_t) {
+            int connectionFd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (connectionFd == -1) {
+                return;
+            }
+            int consumer = ring.claimConsumer();
+            if (!ring.sendTo(connectionFd, consumer) || consumer == -1) {
+                if (consumer != -1) {
+                    ring.releaseConsumer(consumer);
+                }
+                close(connectionFd);
+                return;
+            }
+            cout << "Consumer " << consumer << " attached" << endl;
+            consumers[connectionFd] = consumer;
+            // Readers never write, so the connection is only readable once it closes
+            loop.watch(connectionFd, EPOLLIN | EPOLLRDHUP, [&, connectionFd](uint32_t) {
+                cout << "Consumer " << consumers[connectionFd] << " detached" << endl;
+                ring.releaseConsumer(consumers[connectionFd]);
+                consumers.erase(connectionFd);
+                loop.unwatch(connectionFd);
+                close(connectionFd);
+            });
+        });
+        if (statsSeconds > 0) {
+            int statsTimer = loop.addTimer([&](uint64_t) {
+                cout << "published " << ring.getPublishedCount() << " records" << endl;
+                for (map<int, int>::iterator consumer = consumers.begin(); 
+                        consumer != consumers.end(); ++consumer) {
+                    cout << "\tconsumer " << consumer->second << ": " 
+                            << ring.getLag(consumer->second) << " behind, " 
+                            << ring.getDroppedCount(consumer->second) << " dropped" << endl;
+                }
+            });
+            loop.setTimer(statsTimer, statsSeconds * 1000000L, true);
+        }
+        if (!link.open()) {
+            close(listenFd);
+            unlink(socketPath.c_str());
+            return 1;
+        }
+        cout << "Publishing CSI on " << socketPath << endl;
+        vector<uint8_t> records;
+        while (link.receive(records, -1)) {
+            publishRecords(records, ring);
+            records.clear();
+        }
+    }
+    close(listenFd);
+    unlink(socketPath.c_str());
+    return 0;
+}
+
+/**
+ * Listens for readers on a unix socket at socketPath, replacing any left from an earlier run.
+ */
+static int listenOn(const string &socketPath) {
+    struct sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path too long: " << socketPath << endl;
+        return -1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    int listenFd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd == -1) {
+        perror("socket");
+        return -1;
+    }
+    unlink(socketPath.c_str());
+    if (bind(listenFd, (struct sockaddr *) &address, sizeof(address)) == -1 
+            || listen(listenFd, LISTEN_BACKLOG) == -1) {
+        perror(socketPath.c_str());
+        close(listenFd);
+        return -1;
+    }
+    return listenFd;
+}
+
+/**
+ * Publishes each log_to_file record, without its length, to the ring.
+ */
+static void publishRecords(const vector<uint8_t> &records, CsiRing &ring) {
+    for (size_t offset = 0; records.size() - offset >= 2; ) {
+        size_t fieldLength = (records[offset] << 8) | records[offset + 1];
+        if (records.size() - offset - 2 < fieldLength) {
+            break;
+        }
+        if (fieldLength > 0 && !ring.publish(records.data() + offset + 2, fieldLength)) {
+            cerr << "Dropped a record of " << fieldLength << " bytes, too large for the ring" 
+                    << endl;
+        }
+        offset += 2 + fieldLength;
+    }
+}
+
+static void printUsage(const char *program) {
+    cout << "usage: " << program << " <socket> [--slots=<count>] [--stats=<seconds>]" << endl;
+    cout << "\t <socket> -- Unix socket to hand the ring to consumers on." << endl;
+    cout << "\t --slots=<count> -- Records the ring holds, default " << DEFAULT_CSI_RING_SLOTS 
+            << "." << endl;
+    cout << "\t --stats=<seconds> -- Print how far behind each consumer is this often." << endl;
+}
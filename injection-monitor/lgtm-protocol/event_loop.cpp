@@ -0,0 +1,315 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "event_loop.hpp"
+
+#include <cerrno>
+#include <cstdio>
+
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/signalfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const int MAX_EVENTS = 32;
+static const size_t PATH_EVENT_BUFFER_SIZE = 4096;
+
+//~Functions----------------------------------------------------------------------------------------
+EventLoop::EventLoop() : epollFd(epoll_create1(EPOLL_CLOEXEC)), 
+        wakeFd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)), signalFd(-1), inotifyFd(-1), 
+        stopped(false) {
+    sigemptyset(&signalMask);
+    if (epollFd == -1 || wakeFd == -1) {
+        perror("event loop");
+        return;
+    }
+    watch(wakeFd, EPOLLIN, [this](uint32_t) { runPosted(); });
+}
+
+/**
+ * Closes every timer and notification fd of the loop, and unblocks the watched signals on 
+ * the calling thread. Watched sockets belong to whoever watched them.
+ */
+EventLoop::~EventLoop() {
+    for (set<int>::iterator timer = timers.begin(); timer != timers.end(); ++timer) {
+        close(*timer);
+    }
+    if (signalFd != -1) {
+        close(signalFd);
+        pthread_sigmask(SIG_UNBLOCK, &signalMask, NULL);
+    }
+    if (inotifyFd != -1) {
+        close(inotifyFd);
+    }
+    if (wakeFd != -1) {
+        close(wakeFd);
+    }
+    if (epollFd != -1) {
+        close(epollFd);
+    }
+}
+
+bool EventLoop::isValid() const {
+    return epollFd != -1 && wakeFd != -1;
+}
+
+/**
+ * Calls handler with the ready events, e.g. EPOLLIN, whenever fd is ready for any of events.
+ */
+bool EventLoop::watch(int fd, uint32_t events, const FdHandler &handler) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == -1) {
+        perror("epoll_ctl");
+        return false;
+    }
+    handlers[fd] = handler;
+    return true;
+}
+
+/**
+ * Changes the events a watched fd is waited on for, e.g. adding EPOLLOUT while a send is 
+ * blocked.
+ */
+bool EventLoop::setEvents(int fd, uint32_t events) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.fd = fd;
+    if (epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event) == -1) {
+        perror("epoll_ctl");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Stops watching fd, before it's closed. Events for it that were already waiting are dropped.
+ */
+void EventLoop::unwatch(int fd) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, NULL);
+    handlers.erase(fd);
+}
+
+/**
+ * Adds a disarmed timer, returning it for setTimer or -1. handler gets the number of times 
+ * the timer expired since it last ran, so paced work can catch up after a late wake-up.
+ */
+int EventLoop::addTimer(const TimerHandler &handler) {
+    int timer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timer == -1) {
+        perror("timerfd_create");
+        return -1;
+    }
+    bool watched = watch(timer, EPOLLIN, [timer, handler](uint32_t) {
+        uint64_t expirations;
+        if (read(timer, &expirations, sizeof(expirations)) == sizeof(expirations)) {
+            handler(expirations);
+        }
+    });
+    if (!watched) {
+        close(timer);
+        return -1;
+    }
+    timers.insert(timer);
+    return timer;
+}
+
+/**
+ * Arms the timer to expire in intervalUs, and every intervalUs after if repeating. An interval
+ * of 0 disarms it.
+ */
+bool EventLoop::setTimer(int timer, long intervalUs, bool repeating) {
+    struct itimerspec timerSpec;
+    timerSpec.it_value.tv_sec = intervalUs / 1000000;
+    timerSpec.it_value.tv_nsec = (intervalUs % 1000000) * 1000;
+    timerSpec.it_interval = repeating ? timerSpec.it_value : timespec();
+    if (timerfd_settime(timer, 0, &timerSpec, NULL) == -1) {
+        perror("timerfd_settime");
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::removeTimer(int timer) {
+    unwatch(timer);
+    timers.erase(timer);
+    close(timer);
+}
+
+/**
+ * Delivers signalNumbers to handler on the loop instead of interrupting whichever thread they 
+ * land on. Blocks them on the calling thread, so call it before starting any other threads, 
+ * which inherit the mask. Once per loop.
+ */
+bool EventLoop::watchSignals(const vector<int> &signalNumbers, const SignalHandler &handler) {
+    if (signalFd != -1) {
+        return false;
+    }
+    sigemptyset(&signalMask);
+    for (size_t i = 0; i < signalNumbers.size(); i++) {
+        sigaddset(&signalMask, signalNumbers[i]);
+    }
+    pthread_sigmask(SIG_BLOCK, &signalMask, NULL);
+    signalFd = signalfd(-1, &signalMask, SFD_NONBLOCK | SFD_CLOEXEC);
+    if (signalFd == -1) {
+        perror("signalfd");
+        pthread_sigmask(SIG_UNBLOCK, &signalMask, NULL);
+        return false;
+    }
+    return watch(signalFd, EPOLLIN, [this, handler](uint32_t) { readSignals(handler); });
+}
+
+/**
+ * Calls handler with the name of the changed entry, empty for path itself, and the inotify 
+ * mask of each change to path, e.g. IN_CLOSE_WRITE. Returns the watch for unwatchPath or -1.
+ */
+int EventLoop::watchPath(const string &path, uint32_t mask, const PathHandler &handler) {
+    if (inotifyFd == -1) {
+        inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotifyFd == -1) {
+            perror("inotify_init1");
+            return -1;
+        }
+        if (!watch(inotifyFd, EPOLLIN, [this](uint32_t) { readPathEvents(); })) {
+            close(inotifyFd);
+            inotifyFd = -1;
+            return -1;
+        }
+    }
+    int pathWatch = inotify_add_watch(inotifyFd, path.c_str(), mask);
+    if (pathWatch == -1) {
+        perror(("inotify_add_watch " + path).c_str());
+        return -1;
+    }
+    pathHandlers[pathWatch] = handler;
+    return pathWatch;
+}
+
+void EventLoop::unwatchPath(int pathWatch) {
+    inotify_rm_watch(inotifyFd, pathWatch);
+    pathHandlers.erase(pathWatch);
+}
+
+/**
+ * Runs work on the loop thread, from any thread. Work posted after stop never runs.
+ */
+void EventLoop::post(const function<void()> &work) {
+    {
+        lock_guard<std::mutex> lock(postedMutex);
+        posted.push_back(work);
+    }
+    wake();
+}
+
+/**
+ * Calls handlers until stop, returning false if waiting fails. A stopped loop stays stopped.
+ */
+bool EventLoop::run() {
+    struct epoll_event events[MAX_EVENTS];
+    while (!stopped) {
+        int readyCount = epoll_wait(epollFd, events, MAX_EVENTS, -1);
+        if (readyCount == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            perror("epoll_wait");
+            return false;
+        }
+        for (int i = 0; i < readyCount && !stopped; i++) {
+            // Earlier handlers may have unwatched the fd, and may unwatch it in this one
+            map<int, FdHandler>::iterator handler = handlers.find(events[i].data.fd);
+            if (handler != handlers.end()) {
+                FdHandler handle = handler->second;
+                handle(events[i].events);
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Ends run once the handler running now returns, from any thread or from a handler.
+ */
+void EventLoop::stop() {
+    stopped = true;
+    wake();
+}
+
+bool EventLoop::isStopped() const {
+    return stopped;
+}
+
+void EventLoop::wake() {
+    uint64_t increment = 1;
+    ssize_t written = write(wakeFd, &increment, sizeof(increment));
+    (void) written;
+}
+
+void EventLoop::runPosted() {
+    uint64_t wakeCount;
+    ssize_t wakeRead = read(wakeFd, &wakeCount, sizeof(wakeCount));
+    (void) wakeRead;
+    vector<function<void()> > work;
+    {
+        lock_guard<std::mutex> lock(postedMutex);
+        work.swap(posted);
+    }
+    for (size_t i = 0; i < work.size() && !stopped; i++) {
+        work[i]();
+    }
+}
+
+void EventLoop::readSignals(const SignalHandler &handler) {
+    struct signalfd_siginfo signalInfo;
+    while (read(signalFd, &signalInfo, sizeof(signalInfo)) == sizeof(signalInfo)) {
+        handler(signalInfo.ssi_signo);
+    }
+}
+
+void EventLoop::readPathEvents() {
+    alignas(struct inotify_event) char buffer[PATH_EVENT_BUFFER_SIZE];
+    ssize_t length;
+    while ((length = read(inotifyFd, buffer, sizeof(buffer))) > 0) {
+        for (char *position = buffer; position < buffer + length; ) {
+            const struct inotify_event *event = (const struct inotify_event *) position;
+            position += sizeof(struct inotify_event) + event->len;
+            map<int, PathHandler>::iterator handler = pathHandlers.find(event->wd);
+            if (handler == pathHandlers.end()) {
+                continue;
+            }
+            PathHandler handle = handler->second;
+            if (event->mask & IN_IGNORED) {
+                // The path is gone and so is the watch
+                pathHandlers.erase(handler);
+            }
+            handle(event->len > 0 ? event->name : "", event->mask);
+        }
+    }
+}
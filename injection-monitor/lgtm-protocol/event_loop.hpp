@@ -0,0 +1,95 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef EVENT_LOOP_HPP_
+#define EVENT_LOOP_HPP_
+
+#include <atomic>
+#include <csignal>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <vector>
+
+/**
+ * Waits on sockets, timers, signals and file changes together with epoll, calling their 
+ * handlers one at a time on the thread that runs the loop.
+ *
+ * Watches are added and removed before run or from handlers, on the loop thread. Other 
+ * threads hand work to the loop with post and end it with stop, which both wake it.
+ */
+class EventLoop {
+public:
+    typedef std::function<void(uint32_t events)> FdHandler;
+    typedef std::function<void(uint64_t expirations)> TimerHandler;
+    typedef std::function<void(int signalNumber)> SignalHandler;
+    typedef std::function<void(const std::string &name, uint32_t mask)> PathHandler;
+
+    EventLoop();
+    ~EventLoop();
+
+    bool isValid() const;
+
+    bool watch(int fd, uint32_t events, const FdHandler &handler);
+    bool setEvents(int fd, uint32_t events);
+    void unwatch(int fd);
+
+    int addTimer(const TimerHandler &handler);
+    bool setTimer(int timer, long intervalUs, bool repeating);
+    void removeTimer(int timer);
+
+    bool watchSignals(const std::vector<int> &signalNumbers, const SignalHandler &handler);
+    int watchPath(const std::string &path, uint32_t mask, const PathHandler &handler);
+    void unwatchPath(int pathWatch);
+
+    void post(const std::function<void()> &work);
+    bool run();
+    void stop();
+    bool isStopped() const;
+
+private:
+    int epollFd;
+    int wakeFd;
+    int signalFd;
+    int inotifyFd;
+    sigset_t signalMask;
+    std::map<int, FdHandler> handlers;
+    std::map<int, PathHandler> pathHandlers;
+    std::set<int> timers;
+    std::mutex postedMutex;
+    std::vector<std::function<void()> > posted;
+    std::atomic<bool> stopped;
+
+    EventLoop(const EventLoop &);
+    EventLoop &operator=(const EventLoop &);
+
+    void wake();
+    void runPosted();
+    void readSignals(const SignalHandler &handler);
+    void readPathEvents();
+};
+
+#endif
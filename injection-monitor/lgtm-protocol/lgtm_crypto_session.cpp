@@ -0,0 +1,158 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "lgtm_crypto_session.hpp"
+
+#include <cstring>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const unsigned int RANDOM_NUMBER_SIZE = 256;
+
+//~Functions----------------------------------------------------------------------------------------
+LgtmCryptoSession::LgtmCryptoSession() : initiator(false) {
+    memset(sendIv, 0, AES::BLOCKSIZE);
+    memset(receiveIv, 0, AES::BLOCKSIZE);
+}
+
+/**
+ * Generates this side's Diffie-Hellman keys and random number, and lays them out as the first
+ * message.
+ */
+void LgtmCryptoSession::createFirstMessage(vector<byte> &message) {
+    generateDiffieHellmanParameters(publicKey, privateKey);
+    generateRandomNumber(randomNumber, RANDOM_NUMBER_SIZE);
+    initiator = true;
+    message.clear();
+    appendHandshake(message);
+}
+
+/**
+ * Agrees on the session key from a received first message and lays out the reply holding this
+ * side's own keys and random number.
+ */
+bool LgtmCryptoSession::replyToFirstMessage(const vector<byte> &received, vector<byte> &reply) {
+    generateDiffieHellmanParameters(publicKey, privateKey);
+    if (!agree(received)) {
+        cerr << "Security Error in replyToFirstMessage." 
+                << " Diffie-Hellman shared secret could not be agreed to." << endl;
+        return false;
+    }
+    generateRandomNumber(randomNumber, RANDOM_NUMBER_SIZE);
+    initiator = false;
+    deriveIvs();
+    reply.clear();
+    appendHandshake(reply);
+    return true;
+}
+
+/**
+ * Agrees on the session key from the reply to the first message.
+ */
+bool LgtmCryptoSession::acceptFirstMessageReply(const vector<byte> &received) {
+    if (privateKey.SizeInBytes() == 0) {
+        cerr << "Security Error in acceptFirstMessageReply. No first message was sent." << endl;
+        return false;
+    }
+    if (!agree(received)) {
+        cerr << "Security Error in acceptFirstMessageReply." 
+                << " Diffie-Hellman shared secret could not be agreed to." << endl;
+        return false;
+    }
+    deriveIvs();
+    return true;
+}
+
+/**
+ * Encrypts the facial recognition params for the third message or its reply.
+ */
+bool LgtmCryptoSession::encrypt(const vector<byte> &plainText, vector<byte> &cipherText) {
+    if (!hasKey()) {
+        cerr << "Security Error in encrypt. No session key was agreed to." << endl;
+        return false;
+    }
+    encryptBytes(plainText, cipherText, key, sendIv);
+    return true;
+}
+
+/**
+ * Decrypts and verifies the third message or its reply. Returns false if the MAC could not be
+ * verified.
+ */
+bool LgtmCryptoSession::decrypt(const vector<byte> &cipherText, vector<byte> &plainText) {
+    if (!hasKey()) {
+        cerr << "Security Error in decrypt. No session key was agreed to." << endl;
+        return false;
+    }
+    if (!decryptBytes(cipherText, plainText, key, receiveIv)) {
+        cerr << "Security Error in decrypt. MAC could not be verified." << endl;
+        return false;
+    }
+    return true;
+}
+
+bool LgtmCryptoSession::hasKey() const {
+    return key.SizeInBytes() > 0;
+}
+
+/**
+ * Splits a received handshake into the other side's random number and public key, and 
+ * computes the shared secret and session key.
+ */
+bool LgtmCryptoSession::agree(const vector<byte> &received) {
+    if (received.size() <= RANDOM_NUMBER_SIZE) {
+        cerr << "Handshake of " << received.size() << " bytes is too short." << endl;
+        return false;
+    }
+    otherRandomNumber.Assign(received.data(), RANDOM_NUMBER_SIZE);
+    SecByteBlock otherPublicKey(received.data() + RANDOM_NUMBER_SIZE, 
+            received.size() - RANDOM_NUMBER_SIZE);
+    SecByteBlock sharedSecret;
+    if (!diffieHellmanSharedSecretAgreement(sharedSecret, otherPublicKey, privateKey)) {
+        return false;
+    }
+    generateSymmetricKeyFromSharedSecret(key, sharedSecret);
+    return true;
+}
+
+/**
+ * Derives the initialization vectors this side sends and receives under, one per direction, so
+ * the third message and its reply are never encrypted under the same key and IV.
+ */
+void LgtmCryptoSession::deriveIvs() {
+    const SecByteBlock &initiatorRandom = initiator ? randomNumber : otherRandomNumber;
+    const SecByteBlock &responderRandom = initiator ? otherRandomNumber : randomNumber;
+    generateInitializationVector(sendIv, initiator, initiatorRandom, responderRandom);
+    generateInitializationVector(receiveIv, !initiator, initiatorRandom, responderRandom);
+}
+
+/**
+ * Appends the random number followed by the public key, as combineFiles does.
+ */
+void LgtmCryptoSession::appendHandshake(vector<byte> &message) {
+    message.insert(message.end(), randomNumber.BytePtr(), 
+            randomNumber.BytePtr() + randomNumber.SizeInBytes());
+    message.insert(message.end(), publicKey.BytePtr(), 
+            publicKey.BytePtr() + publicKey.SizeInBytes());
+}
@@ -0,0 +1,68 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LGTM_CRYPTO_SESSION_HPP_
+#define LGTM_CRYPTO_SESSION_HPP_
+
+#include "../../cryptography/lgtm_crypto.hpp"
+
+#include <vector>
+
+/**
+ * The Diffie-Hellman handshake and the encryption of the facial recognition params for one 
+ * side of an LGTM exchange, held in memory.
+ *
+ * The messages have the same layout as the files lgtm_crypto_runner writes, a 256 byte random
+ * number and the public key for the first message and its reply, the GCM<AES> cipher text and
+ * MAC for the third message and its reply, so either side may still run the shell scripts. 
+ * Each direction encrypts under its own initialization vector, derived by 
+ * generateInitializationVector as lgtm_crypto_runner does.
+ */
+class LgtmCryptoSession {
+public:
+    LgtmCryptoSession();
+
+    void createFirstMessage(std::vector<byte> &message);
+    bool replyToFirstMessage(const std::vector<byte> &received, std::vector<byte> &reply);
+    bool acceptFirstMessageReply(const std::vector<byte> &received);
+    bool encrypt(const std::vector<byte> &plainText, std::vector<byte> &cipherText);
+    bool decrypt(const std::vector<byte> &cipherText, std::vector<byte> &plainText);
+
+    bool hasKey() const;
+
+private:
+    SecByteBlock publicKey;
+    SecByteBlock privateKey;
+    SecByteBlock randomNumber;
+    SecByteBlock otherRandomNumber;
+    SecByteBlock key;
+    bool initiator;
+    byte sendIv[AES::BLOCKSIZE];
+    byte receiveIv[AES::BLOCKSIZE];
+
+    bool agree(const std::vector<byte> &received);
+    void deriveIvs();
+    void appendHandshake(std::vector<byte> &message);
+};
+
+#endif
@@ -0,0 +1,260 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "lgtm_protocol_engine.hpp"
+#include "loopback_pair.hpp"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+
+#include <sys/epoll.h>
+#include <termios.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const string INJECTION_INTERFACE = "mon0";
+static const int PACKET_DELAY_US = 1000;
+static const string CSI_CODE_DIRECTORY = "../csi-code";
+static const string TOP_AOAS_FILE_NAME = ".lgtm-top-aoas";
+static const string RECOGNITION_DIRECTORY = "../facial-recognition/lgtm-recognition";
+
+/**
+ * Options given as "--name=value" after the positional arguments.
+ */
+struct ProtocolOptions {
+    ProtocolOptions() : initiate(false), timeoutSeconds(0), switchWaitSeconds(-1) {}
+
+    bool initiate;
+    int timeoutSeconds;
+    int switchWaitSeconds;
+    vector<double> fixedAoas;
+    string loopbackPeerParams;
+    string csiTracePath;
+    string csiRingSocket;
+    // Passed on to lgtm_facial_recognition
+    vector<string> recognitionOptions;
+};
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool parseOptions(int argc, const char *argv[], vector<string> &arguments, 
+        ProtocolOptions &options);
+static bool readFile(const string &fileName, vector<uint8_t> &contents);
+static void printUsage(const char *program);
+static void listenForStartKey(LgtmProtocolEngine &engine, EventLoop &loop);
+
+/**
+ * Runs one side of LGTM with encryption in this process, in place of 
+ * full-lgtm-with-encryption.sh. Run from injection-monitor as root.
+ */
+int main(int argc, const char *argv[]) {
+    vector<string> arguments;
+    ProtocolOptions options;
+    if (!parseOptions(argc, argv, arguments, options) || arguments.size() != 5) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string channelNumber = arguments[0];
+    string channelType = arguments[1];
+    string wlanInterface = arguments[2];
+    string facialRecognitionFile = arguments[3];
+    string sourceSpec = arguments[4];
+    bool loopback = !options.loopbackPeerParams.empty();
+    // Recognition may stop reading the params early
+    signal(SIGPIPE, SIG_IGN);
+
+    LgtmProtocolConfig config;
+    if (!readFile(facialRecognitionFile, config.facialRecognitionParams)) {
+        return 1;
+    }
+    config.initiate = options.initiate || loopback;
+    config.receiveTimeoutSeconds = options.timeoutSeconds;
+    if (options.switchWaitSeconds >= 0) {
+        config.switchWaitSeconds = options.switchWaitSeconds;
+    } else if (loopback) {
+        config.switchWaitSeconds = 0;
+    }
+
+    // Localize with SpotFi as the logged on user, unless fixed angles were given
+    const char *sudoUser = getenv("SUDO_USER");
+    unique_ptr<Localizer> localizer;
+    if (!options.fixedAoas.empty()) {
+        localizer.reset(new FixedLocalizer(options.fixedAoas));
+    } else {
+        localizer.reset(new MatlabLocalizer(CSI_CODE_DIRECTORY, TOP_AOAS_FILE_NAME, 
+                sudoUser == NULL ? "" : sudoUser));
+    }
+    LgtmRecognitionVerifier verifier(RECOGNITION_DIRECTORY, sourceSpec, 
+            options.recognitionOptions);
+
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    bool lgtm;
+    if (!loopback) {
+        ShellRadioControl radio(wlanInterface, channelNumber, channelType);
+        ConnectorLink link(INJECTION_INTERFACE, PACKET_DELAY_US);
+        LgtmProtocolEngine engine(config, radio, link, *localizer, verifier);
+        // Ctrl-C stops the protocol and cancels recognition, rather than killing the process
+        link.getEventLoop().watchSignals({SIGINT, SIGTERM}, [&engine, &link](int) {
+            engine.requestStop();
+            link.close();
+        });
+        if (!config.initiate) {
+            cout << "Press 'L' to initiate LGTM from this computer" << endl;
+            listenForStartKey(engine, link.getEventLoop());
+        }
+        if (options.csiRingSocket.empty() ? !link.open() : !link.openRing(options.csiRingSocket)) {
+            return 1;
+        }
+        lgtm = engine.run();
+    } else {
+        // The other party runs on its own thread, both over a loopback link without radios
+        LgtmProtocolConfig peerConfig = config;
+        peerConfig.traceDirectory = ".lgtm-loopback-peer";
+        if (system(("mkdir -p " + peerConfig.traceDirectory).c_str()) != 0 
+                || !readFile(options.loopbackPeerParams, peerConfig.facialRecognitionParams)) {
+            return 1;
+        }
+        LgtmRecognitionVerifier peerVerifier(RECOGNITION_DIRECTORY, sourceSpec, 
+                options.recognitionOptions);
+        LoopbackPair pair(config, peerConfig, *localizer, verifier, peerVerifier);
+        if (!options.csiTracePath.empty() && !pair.loadCsiTrace(options.csiTracePath)) {
+            return 1;
+        }
+        pair.run();
+        lgtm = pair.didInitiatorConfirm();
+        cout << "Loopback peer " << (pair.didResponderConfirm() ? "confirmed" : "did not confirm")
+                << " LGTM" << endl;
+    }
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    cout << "LGTM ran in time: " << elapsed.count() << " seconds" << endl;
+    return lgtm ? 0 : 1;
+}
+
+/**
+ * Splits the positional arguments from the "--" options.
+ */
+static bool parseOptions(int argc, const char *argv[], vector<string> &arguments, 
+        ProtocolOptions &options) {
+    bool valid = true;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument.compare(0, 2, "--") != 0) {
+            arguments.push_back(argument);
+            continue;
+        }
+        size_t equalsPos = argument.find('=');
+        string name = argument.substr(2, equalsPos == string::npos ? string::npos 
+                : equalsPos - 2);
+        string value = equalsPos == string::npos ? "" : argument.substr(equalsPos + 1);
+        if (name == "initiate") {
+            options.initiate = true;
+        } else if (name == "timeout") {
+            options.timeoutSeconds = atoi(value.c_str());
+        } else if (name == "switch-wait") {
+            options.switchWaitSeconds = atoi(value.c_str());
+        } else if (name == "aoas") {
+            stringstream aoaStream(value);
+            string aoa;
+            while (getline(aoaStream, aoa, ',')) {
+                options.fixedAoas.push_back(atof(aoa.c_str()));
+            }
+            valid = valid && !options.fixedAoas.empty();
+        } else if (name == "loopback-peer") {
+            options.loopbackPeerParams = value;
+            valid = valid && !value.empty();
+        } else if (name == "csi-trace") {
+            options.csiTracePath = value;
+            valid = valid && !value.empty();
+        } else if (name == "csi-ring") {
+            options.csiRingSocket = value;
+            valid = valid && !value.empty();
+        } else {
+            options.recognitionOptions.push_back(argument);
+        }
+    }
+    return valid;
+}
+
+static bool readFile(const string &fileName, vector<uint8_t> &contents) {
+    ifstream input(fileName.c_str(), ios::in | ios::binary);
+    if (!input) {
+        cerr << "Error opening " << fileName << endl;
+        return false;
+    }
+    contents.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    return true;
+}
+
+static void printUsage(const char *program) {
+    cout << "usage: " << program << " <channel number> <channel type> <wlan interface>" 
+            << " <facial recognition file> <device id | video> [options]" << endl;
+    cout << "\t <channel number> <channel type> <wlan interface> -- Radio to inject and" 
+            << " monitor with, ignored with --loopback-peer." << endl;
+    cout << "\t <facial recognition file> -- Archive of this side's training photos." << endl;
+    cout << "\t <device id | video> -- Camera, or a video in its place, to recognize with." 
+            << endl;
+    cout << "\t --initiate -- Initiate without waiting for the 'L' key." << endl;
+    cout << "\t --timeout=<seconds> -- Fail if a message takes longer to arrive." << endl;
+    cout << "\t --switch-wait=<seconds> -- Wait after switching to injection, default 5." 
+            << endl;
+    cout << "\t --aoas=<degrees>[,<degrees>...] -- Use these angles of arrival instead of" 
+            << " localizing with MATLAB." << endl;
+    cout << "\t --loopback-peer=<facial recognition file> -- Run the other party in this" 
+            << " process over a loopback link, without radios." << endl;
+    cout << "\t --csi-trace=<log_to_file trace> -- Replay the CSI of a recorded trace on the" 
+            << " loopback link." << endl;
+    cout << "\t --csi-ring=<socket> -- Receive from csi_ring_publisher listening on socket," 
+            << " instead of the connector socket." << endl;
+    cout << "\t Any other option, e.g. --headless, is passed on to lgtm_facial_recognition." 
+            << endl;
+}
+
+/**
+ * Requests the start of the protocol when 'l' is typed, without waiting for enter, from the 
+ * link's event loop.
+ */
+static void listenForStartKey(LgtmProtocolEngine &engine, EventLoop &loop) {
+    static struct termios savedTerminal;
+    if (tcgetattr(STDIN_FILENO, &savedTerminal) == 0) {
+        struct termios terminal = savedTerminal;
+        terminal.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &terminal);
+        atexit([]() { tcsetattr(STDIN_FILENO, TCSANOW, &savedTerminal); });
+    }
+    loop.watch(STDIN_FILENO, EPOLLIN, [&engine, &loop](uint32_t) {
+        char key;
+        if (read(STDIN_FILENO, &key, 1) != 1) {
+            loop.unwatch(STDIN_FILENO);
+        } else if (key == 'l' || key == 'L') {
+            engine.requestStart();
+            loop.unwatch(STDIN_FILENO);
+        }
+    });
+}
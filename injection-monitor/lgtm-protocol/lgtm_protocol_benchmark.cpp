@@ -0,0 +1,370 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "loopback_pair.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <csignal>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const string CSI_CODE_DIRECTORY = "../csi-code";
+static const string TOP_AOAS_FILE_NAME = ".lgtm-top-aoas";
+static const string RECOGNITION_DIRECTORY = "../facial-recognition/lgtm-recognition";
+static const string RESPONDER_TRACE_DIRECTORY = ".lgtm-loopback-peer";
+static const string DEFAULT_CSI_TRACE = "../experimental-data/"
+        "lgtm-distance-angle-experiments-monitor-data/"
+        "lgtm-monitor.dat--1m-0-degrees--laptop-1--test-1";
+
+/**
+ * Where the time from initiating to LGTM went, along the initiator's critical path. Whichever 
+ * of localization and training finished last gets the time from the final message arriving to 
+ * recognition starting, the other none. What is left over, e.g. decrypting, is "other".
+ */
+enum LatencySegment {
+    HANDSHAKE,
+    TRANSFER,
+    REASSEMBLY,
+    LOCALIZATION,
+    TRAINING,
+    RECOGNITION,
+    OTHER,
+    TOTAL,
+    // The responder's own time to LGTM, started at the same time
+    RESPONDER_TOTAL,
+    SEGMENT_COUNT
+};
+
+static const char *SEGMENT_NAMES[SEGMENT_COUNT] = {"handshake", "transfer", "reassembly", 
+        "localization", "training", "recognition", "other", "total", "responder-total"};
+
+/**
+ * Options given as "--name=value" after the positional arguments.
+ */
+struct BenchmarkOptions {
+    BenchmarkOptions() : runs(10), switchWaitSeconds(0), timeoutSeconds(30) {}
+
+    int runs;
+    int switchWaitSeconds;
+    int timeoutSeconds;
+    vector<string> csiTracePaths;
+    vector<double> fixedAoas;
+    string csvFileName;
+    // Passed on to lgtm_facial_recognition
+    vector<string> recognitionOptions;
+};
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool parseOptions(int argc, const char *argv[], vector<string> &arguments, 
+        BenchmarkOptions &options);
+static bool readFile(const string &fileName, vector<uint8_t> &contents);
+static void printUsage(const char *program);
+static void measureCriticalPath(const LgtmProtocolEngine &initiator, 
+        const LgtmProtocolEngine &responder, double segments[SEGMENT_COUNT]);
+static const TaskTiming *findTaskTiming(const vector<TaskTiming> &timings, const string &name);
+static double sumPhaseSeconds(const vector<PhaseTiming> &timings);
+static double getPercentile(vector<double> values, double percentile);
+static void printSummary(const vector<vector<double> > &runSegments);
+
+/**
+ * Measures how long LGTM takes from initiating to both parties confirming, over many runs of 
+ * both parties in this process. The loopback link replays recorded CSI and recognition runs 
+ * headless on videos, so the whole flow runs without radios or cameras. Run from 
+ * injection-monitor, as lgtm_protocol.
+ */
+int main(int argc, const char *argv[]) {
+    vector<string> arguments;
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, arguments, options) || arguments.size() != 4) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    // Recognition may stop reading the params early
+    signal(SIGPIPE, SIG_IGN);
+
+    LgtmProtocolConfig initiatorConfig;
+    LgtmProtocolConfig responderConfig;
+    if (!readFile(arguments[0], initiatorConfig.facialRecognitionParams) 
+            || !readFile(arguments[2], responderConfig.facialRecognitionParams)) {
+        return 1;
+    }
+    initiatorConfig.switchWaitSeconds = responderConfig.switchWaitSeconds = 
+            options.switchWaitSeconds;
+    initiatorConfig.receiveTimeoutSeconds = responderConfig.receiveTimeoutSeconds = 
+            options.timeoutSeconds;
+    responderConfig.traceDirectory = RESPONDER_TRACE_DIRECTORY;
+    if (system(("mkdir -p " + RESPONDER_TRACE_DIRECTORY).c_str()) != 0) {
+        return 1;
+    }
+
+    // Localize with SpotFi as the logged on user, unless fixed angles were given
+    const char *sudoUser = getenv("SUDO_USER");
+    unique_ptr<Localizer> localizer;
+    if (!options.fixedAoas.empty()) {
+        localizer.reset(new FixedLocalizer(options.fixedAoas));
+    } else {
+        localizer.reset(new MatlabLocalizer(CSI_CODE_DIRECTORY, TOP_AOAS_FILE_NAME, 
+                sudoUser == NULL ? "" : sudoUser));
+    }
+    // Each side recognizes the other in its own video, and stops as soon as it does
+    vector<string> recognitionOptions = options.recognitionOptions;
+    recognitionOptions.push_back("--headless");
+    recognitionOptions.push_back("--exit-on-confirm");
+    LgtmRecognitionVerifier initiatorVerifier(RECOGNITION_DIRECTORY, arguments[1], 
+            recognitionOptions);
+    LgtmRecognitionVerifier responderVerifier(RECOGNITION_DIRECTORY, arguments[3], 
+            recognitionOptions);
+
+    ofstream csv;
+    if (!options.csvFileName.empty()) {
+        csv.open(options.csvFileName.c_str());
+        if (!csv) {
+            cerr << "Error opening " << options.csvFileName << endl;
+            return 1;
+        }
+        csv << "run,csiTrace,lgtm";
+        for (int s = 0; s < SEGMENT_COUNT; s++) {
+            csv << "," << SEGMENT_NAMES[s];
+        }
+        csv << endl;
+    }
+
+    vector<vector<double> > runSegments;
+    cout << fixed << setprecision(3);
+    for (int run = 0; run < options.runs; run++) {
+        const string &csiTracePath = options.csiTracePaths[run % options.csiTracePaths.size()];
+        LoopbackPair pair(initiatorConfig, responderConfig, *localizer, initiatorVerifier, 
+                responderVerifier);
+        if (!pair.loadCsiTrace(csiTracePath)) {
+            return 1;
+        }
+        bool lgtm = pair.run();
+        vector<double> segments(SEGMENT_COUNT);
+        measureCriticalPath(pair.getInitiator(), pair.getResponder(), segments.data());
+        cout << "Run " << (run + 1) << "/" << options.runs << ": " 
+                << (lgtm ? "LGTM" : "FAILED") << " in " << segments[TOTAL] << " s (";
+        for (int s = 0; s < TOTAL; s++) {
+            cout << (s == 0 ? "" : ", ") << SEGMENT_NAMES[s] << " " << segments[s];
+        }
+        cout << ")" << endl;
+        if (csv.is_open()) {
+            csv << (run + 1) << "," << csiTracePath << "," << (lgtm ? 1 : 0);
+            for (int s = 0; s < SEGMENT_COUNT; s++) {
+                csv << "," << segments[s];
+            }
+            csv << endl;
+        }
+        // Failed runs stopped early, they would only skew the latencies
+        if (lgtm) {
+            runSegments.push_back(segments);
+        }
+    }
+    cout << runSegments.size() << " of " << options.runs << " runs passed LGTM" << endl;
+    if (!runSegments.empty()) {
+        printSummary(runSegments);
+    }
+    return runSegments.size() == (size_t) options.runs ? 0 : 1;
+}
+
+/**
+ * Splits the positional arguments from the "--" options.
+ */
+static bool parseOptions(int argc, const char *argv[], vector<string> &arguments, 
+        BenchmarkOptions &options) {
+    bool valid = true;
+    for (int i = 1; i < argc; i++) {
+        string argument = argv[i];
+        if (argument.compare(0, 2, "--") != 0) {
+            arguments.push_back(argument);
+            continue;
+        }
+        size_t equalsPos = argument.find('=');
+        string name = argument.substr(2, equalsPos == string::npos ? string::npos 
+                : equalsPos - 2);
+        string value = equalsPos == string::npos ? "" : argument.substr(equalsPos + 1);
+        if (name == "runs") {
+            options.runs = atoi(value.c_str());
+            valid = valid && options.runs > 0;
+        } else if (name == "switch-wait") {
+            options.switchWaitSeconds = atoi(value.c_str());
+        } else if (name == "timeout") {
+            options.timeoutSeconds = atoi(value.c_str());
+        } else if (name == "csi-trace") {
+            stringstream traceStream(value);
+            string trace;
+            while (getline(traceStream, trace, ',')) {
+                options.csiTracePaths.push_back(trace);
+            }
+            valid = valid && !options.csiTracePaths.empty();
+        } else if (name == "aoas") {
+            stringstream aoaStream(value);
+            string aoa;
+            while (getline(aoaStream, aoa, ',')) {
+                options.fixedAoas.push_back(atof(aoa.c_str()));
+            }
+            valid = valid && !options.fixedAoas.empty();
+        } else if (name == "csv") {
+            options.csvFileName = value;
+            valid = valid && !value.empty();
+        } else {
+            options.recognitionOptions.push_back(argument);
+        }
+    }
+    if (options.csiTracePaths.empty()) {
+        options.csiTracePaths.push_back(DEFAULT_CSI_TRACE);
+    }
+    return valid;
+}
+
+static bool readFile(const string &fileName, vector<uint8_t> &contents) {
+    ifstream input(fileName.c_str(), ios::in | ios::binary);
+    if (!input) {
+        cerr << "Error opening " << fileName << endl;
+        return false;
+    }
+    contents.assign(istreambuf_iterator<char>(input), istreambuf_iterator<char>());
+    return true;
+}
+
+static void printUsage(const char *program) {
+    cout << "usage: " << program << " <initiator facial recognition file> <initiator video>" 
+            << " <responder facial recognition file> <responder video> [options]" << endl;
+    cout << "\t <facial recognition file> -- Archive of that side's training photos." << endl;
+    cout << "\t <video> -- What that side's camera sees, i.e. the other side's face." << endl;
+    cout << "\t --runs=<count> -- Times to run the whole protocol, default 10." << endl;
+    cout << "\t --csi-trace=<log_to_file trace>[,<trace>...] -- Recorded CSI to replay, one" 
+            << " trace per run in turn. Defaults to one from experimental-data." << endl;
+    cout << "\t --aoas=<degrees>[,<degrees>...] -- Use these angles of arrival instead of" 
+            << " localizing with MATLAB." << endl;
+    cout << "\t --switch-wait=<seconds> -- Wait after each switch to injection, default 0." 
+            << endl;
+    cout << "\t --timeout=<seconds> -- Fail a run if a message takes longer, default 30." 
+            << endl;
+    cout << "\t --csv=<file> -- Write the latencies of every run, in seconds." << endl;
+    cout << "\t Any other option is passed on to lgtm_facial_recognition, which always runs" 
+            << " with --headless and --exit-on-confirm." << endl;
+}
+
+/**
+ * Splits the initiator's time to LGTM into segments of its critical path, in seconds.
+ */
+static void measureCriticalPath(const LgtmProtocolEngine &initiator, 
+        const LgtmProtocolEngine &responder, double segments[SEGMENT_COUNT]) {
+    fill(segments, segments + SEGMENT_COUNT, 0.0);
+    const vector<PhaseTiming> &phaseTimings = initiator.getPhaseTimings();
+    for (unsigned int i = 0; i < phaseTimings.size(); i++) {
+        const PhaseTiming &timing = phaseTimings[i];
+        double waitingSeconds = timing.seconds - timing.reassemblySeconds;
+        segments[REASSEMBLY] += timing.reassemblySeconds;
+        switch (timing.phase) {
+            case AWAIT_START:
+            case SEND_FIRST_MESSAGE:
+            case AWAIT_FIRST_MESSAGE_REPLY:
+                segments[HANDSHAKE] += waitingSeconds;
+                break;
+            case SEND_THIRD_MESSAGE:
+            case AWAIT_THIRD_MESSAGE_REPLY:
+                segments[TRANSFER] += waitingSeconds;
+                break;
+            default:
+                break;
+        }
+    }
+    segments[TOTAL] = sumPhaseSeconds(phaseTimings);
+    segments[RESPONDER_TOTAL] = sumPhaseSeconds(responder.getPhaseTimings());
+
+    const vector<TaskTiming> &taskTimings = initiator.getTaskTimings();
+    const TaskTiming *traceSealed = findTaskTiming(taskTimings, "trace-sealed");
+    const TaskTiming *localize = findTaskTiming(taskTimings, "localize");
+    const TaskTiming *warmUp = findTaskTiming(taskTimings, "recognizer-warm-up");
+    const TaskTiming *recognize = findTaskTiming(taskTimings, "recognize");
+    if (traceSealed != NULL && localize != NULL && warmUp != NULL && recognize != NULL 
+            && recognize->succeeded) {
+        double branchSeconds = recognize->startSeconds - traceSealed->endSeconds;
+        segments[localize->endSeconds >= warmUp->endSeconds ? LOCALIZATION : TRAINING] = 
+                branchSeconds;
+        segments[RECOGNITION] = recognize->endSeconds - recognize->startSeconds;
+    }
+    double accounted = 0;
+    for (int s = 0; s < OTHER; s++) {
+        accounted += segments[s];
+    }
+    segments[OTHER] = max(0.0, segments[TOTAL] - accounted);
+}
+
+static const TaskTiming *findTaskTiming(const vector<TaskTiming> &timings, const string &name) {
+    for (unsigned int i = 0; i < timings.size(); i++) {
+        if (timings[i].name == name) {
+            return &timings[i];
+        }
+    }
+    return NULL;
+}
+
+static double sumPhaseSeconds(const vector<PhaseTiming> &timings) {
+    double seconds = 0;
+    for (unsigned int i = 0; i < timings.size(); i++) {
+        seconds += timings[i].seconds;
+    }
+    return seconds;
+}
+
+/**
+ * Nearest rank percentile.
+ */
+static double getPercentile(vector<double> values, double percentile) {
+    sort(values.begin(), values.end());
+    int rank = (int) ceil(percentile / 100.0 * values.size());
+    return values[max(rank, 1) - 1];
+}
+
+/**
+ * Prints the mean, percentiles and extremes of every segment over the runs that passed.
+ */
+static void printSummary(const vector<vector<double> > &runSegments) {
+    cout << left << setw(16) << "segment" << right << setw(10) << "mean" << setw(10) << "p50" 
+            << setw(10) << "p90" << setw(10) << "min" << setw(10) << "max" << "  (seconds)" 
+            << endl;
+    for (int s = 0; s < SEGMENT_COUNT; s++) {
+        vector<double> values;
+        double sum = 0;
+        for (unsigned int run = 0; run < runSegments.size(); run++) {
+            values.push_back(runSegments[run][s]);
+            sum += runSegments[run][s];
+        }
+        cout << left << setw(16) << SEGMENT_NAMES[s] << right << setw(10) 
+                << sum / values.size() << setw(10) << getPercentile(values, 50) << setw(10) 
+                << getPercentile(values, 90) << setw(10) 
+                << *min_element(values.begin(), values.end()) << setw(10) 
+                << *max_element(values.begin(), values.end()) << endl;
+    }
+}
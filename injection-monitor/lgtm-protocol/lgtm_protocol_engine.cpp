@@ -0,0 +1,411 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "lgtm_protocol_engine.hpp"
+
+#include <iostream>
+#include <thread>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Longest a wait for frames goes without checking for start and stop requests
+static const int POLL_INTERVAL_MS = 100;
+
+//~Functions----------------------------------------------------------------------------------------
+LgtmProtocolConfig::LgtmProtocolConfig() 
+        : initiate(false), switchWaitSeconds(5), receiveTimeoutSeconds(0), traceDirectory(".") {
+}
+
+LgtmProtocolEngine::LgtmProtocolEngine(const LgtmProtocolConfig &config, RadioControl &radio, 
+        RadioLink &link, Localizer &localizer, FaceVerifier &verifier) 
+        : config(config), radio(radio), link(link), localizer(localizer), verifier(verifier), 
+        startRequested(config.initiate), stopRequested(false), phase(AWAIT_START), 
+        initiator(false), monitoring(false), 
+        reassemblyTime(chrono::steady_clock::duration::zero()), traceSealed(-1), 
+        paramsVerified(-1) {
+}
+
+/**
+ * Runs the protocol until the face is confirmed or a step fails. Returns true if LGTM passed.
+ */
+bool LgtmProtocolEngine::run() {
+    phase = AWAIT_START;
+    phaseTimings.clear();
+    startVerification();
+    cout << "Waiting for LGTM initiation" << endl;
+    while (phase != PROTOCOL_SUCCEEDED && phase != PROTOCOL_FAILED) {
+        chrono::steady_clock::time_point phaseStart = chrono::steady_clock::now();
+        reassemblyTime = chrono::steady_clock::duration::zero();
+        ProtocolEvent event = runPhase();
+        chrono::duration<double> phaseSeconds = chrono::steady_clock::now() - phaseStart;
+        chrono::duration<double> reassemblySeconds = reassemblyTime;
+        PhaseTiming timing = {phase, phaseSeconds.count(), reassemblySeconds.count()};
+        phaseTimings.push_back(timing);
+        if (phase == AWAIT_START && event == START_REQUESTED) {
+            initiator = true;
+        }
+        ProtocolPhase next = transition(phase, event);
+        cout << getPhaseName(phase) << " -> " << getEventName(event) << " -> " 
+                << getPhaseName(next) << " (" << (long) (phaseSeconds.count() * 1000) << " ms)"
+                << endl;
+        phase = next;
+    }
+    // Nothing may be left running after a failure
+    stopVerification();
+    recordTaskTimings();
+    if (phase == PROTOCOL_SUCCEEDED) {
+        cout << "LGTM COMPLETE!" << endl;
+    }
+    return phase == PROTOCOL_SUCCEEDED;
+}
+
+/**
+ * Initiates the protocol from this side if the other party has not already. Safe to call from
+ * any thread.
+ */
+void LgtmProtocolEngine::requestStart() {
+    startRequested = true;
+}
+
+/**
+ * Fails the protocol at the next check, at most POLL_INTERVAL_MS into a wait. Safe to call 
+ * from any thread.
+ */
+void LgtmProtocolEngine::requestStop() {
+    stopRequested = true;
+}
+
+ProtocolPhase LgtmProtocolEngine::getPhase() const {
+    return phase;
+}
+
+bool LgtmProtocolEngine::isInitiator() const {
+    return initiator;
+}
+
+const vector<double> &LgtmProtocolEngine::getTopAoas() const {
+    return topAoas;
+}
+
+/**
+ * The facial recognition params received from the other party, with their header and footer.
+ */
+const vector<uint8_t> &LgtmProtocolEngine::getReceivedParams() const {
+    return receivedParams;
+}
+
+const vector<PhaseTiming> &LgtmProtocolEngine::getPhaseTimings() const {
+    return phaseTimings;
+}
+
+const vector<TaskTiming> &LgtmProtocolEngine::getTaskTimings() const {
+    return taskTimings;
+}
+
+/**
+ * Carries out the current phase and returns the event it ended with.
+ */
+ProtocolEvent LgtmProtocolEngine::runPhase() {
+    switch (phase) {
+        case AWAIT_START:
+            return awaitMessage(LGTM_BEGIN_TOKEN, ".lgtm-begin-monitor.dat");
+        case SEND_FIRST_MESSAGE:
+            return sendFirstMessage();
+        case AWAIT_FIRST_MESSAGE_REPLY:
+        {
+            ProtocolEvent event = awaitMessage(FIRST_MESSAGE_REPLY_FOOTER, 
+                    ".lgtm-monitor-first-message-reply.dat");
+            if (event == MESSAGE_RECEIVED && !session.acceptFirstMessageReply(receivedMessage)) {
+                return STEP_FAILED;
+            }
+            return event;
+        }
+        case SEND_THIRD_MESSAGE:
+            return sendThirdMessage(THIRD_MESSAGE_FOOTER);
+        case AWAIT_THIRD_MESSAGE_REPLY:
+            return awaitParams(THIRD_MESSAGE_REPLY_FOOTER, 
+                    ".lgtm-monitor-third-message-reply.dat");
+        case SEND_FIRST_MESSAGE_REPLY:
+        {
+            vector<uint8_t> reply;
+            if (!session.replyToFirstMessage(receivedMessage, reply)) {
+                return STEP_FAILED;
+            }
+            return sendMessage(reply, FIRST_MESSAGE_REPLY_FOOTER);
+        }
+        case AWAIT_THIRD_MESSAGE:
+            return awaitParams(THIRD_MESSAGE_FOOTER, ".lgtm-monitor-third-message.dat");
+        case SEND_THIRD_MESSAGE_REPLY:
+            return sendThirdMessage(THIRD_MESSAGE_REPLY_FOOTER);
+        case AWAIT_VERIFICATION:
+            return awaitVerification();
+        default:
+            return STEP_FAILED;
+    }
+}
+
+/**
+ * Monitors until the footer arrives, keeping the records received in a trace at traceName. 
+ * The message before the footer is left in receivedMessage.
+ */
+ProtocolEvent LgtmProtocolEngine::awaitMessage(const string &footer, const string &traceName) {
+    if (!monitoring) {
+        if (!radio.enterMonitorMode()) {
+            return STEP_FAILED;
+        }
+        monitoring = true;
+    }
+    reassembler.reset();
+    receivedMessage.clear();
+    string tracePath = config.traceDirectory + "/" + traceName;
+    ofstream trace(tracePath.c_str(), ios::out | ios::binary | ios::trunc);
+    if (!trace) {
+        cerr << "Error opening trace " << tracePath << endl;
+        return STEP_FAILED;
+    }
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::now() 
+            + chrono::seconds(config.receiveTimeoutSeconds);
+    vector<uint8_t> records;
+    for (;;) {
+        if (stopRequested) {
+            return STOP_REQUESTED;
+        }
+        if (phase == AWAIT_START && startRequested) {
+            return START_REQUESTED;
+        }
+        records.clear();
+        if (!link.receive(records, POLL_INTERVAL_MS)) {
+            return LINK_CLOSED;
+        }
+        if (!records.empty()) {
+            trace.write((const char *) records.data(), records.size());
+            chrono::steady_clock::time_point reassemblyStart = chrono::steady_clock::now();
+            reassembler.feed(records.data(), records.size());
+            size_t footerPosition;
+            bool found = reassembler.findToken(footer, footerPosition);
+            reassemblyTime += chrono::steady_clock::now() - reassemblyStart;
+            if (found) {
+                // Seal the trace, it holds every frame of the message
+                trace.close();
+                finalTracePath = tracePath;
+                const vector<uint8_t> &payload = reassembler.getPayload();
+                receivedMessage.assign(payload.begin(), payload.begin() + footerPosition);
+                cout << "Received " << receivedMessage.size() << " bytes in " 
+                        << reassembler.getMpduCount() << " frames" << endl;
+                return MESSAGE_RECEIVED;
+            }
+        }
+        if (config.receiveTimeoutSeconds > 0 && chrono::steady_clock::now() > deadline) {
+            return TIMED_OUT;
+        }
+    }
+}
+
+/**
+ * Awaits the third message or its reply and decrypts the facial recognition params from it.
+ */
+ProtocolEvent LgtmProtocolEngine::awaitParams(const string &footer, const string &traceName) {
+    ProtocolEvent event = awaitMessage(footer, traceName);
+    if (event != MESSAGE_RECEIVED) {
+        return event;
+    }
+    // Localization needs only the trace, so it runs while the params are decrypted
+    verification->signal(traceSealed);
+    bool decrypted = session.decrypt(receivedMessage, receivedParams);
+    verification->signal(paramsVerified, decrypted);
+    return decrypted ? event : STEP_FAILED;
+}
+
+/**
+ * Switches to injection, gives the other party time to start monitoring, and sends the 
+ * message followed by its footer.
+ */
+ProtocolEvent LgtmProtocolEngine::sendMessage(const vector<uint8_t> &message, 
+        const string &footer) {
+    if (!radio.enterInjectionMode()) {
+        return STEP_FAILED;
+    }
+    monitoring = false;
+    this_thread::sleep_for(chrono::seconds(config.switchWaitSeconds));
+    vector<uint8_t> framed;
+    framed.reserve(message.size() + footer.size());
+    framed.insert(framed.end(), message.begin(), message.end());
+    framed.insert(framed.end(), footer.begin(), footer.end());
+    cout << "Sending " << framed.size() << " bytes" << endl;
+    return link.send(framed) ? STEP_DONE : STEP_FAILED;
+}
+
+/**
+ * Starts the handshake, the first message is marked by the begin token.
+ */
+ProtocolEvent LgtmProtocolEngine::sendFirstMessage() {
+    vector<uint8_t> message;
+    session.createFirstMessage(message);
+    return sendMessage(message, LGTM_BEGIN_TOKEN);
+}
+
+/**
+ * Sends this side's facial recognition params, framed by their header and footer and 
+ * encrypted with the session key.
+ */
+ProtocolEvent LgtmProtocolEngine::sendThirdMessage(const string &footer) {
+    vector<uint8_t> framed;
+    framed.reserve(FACIAL_RECOGNITION_HEADER.size() + config.facialRecognitionParams.size() 
+            + FACIAL_RECOGNITION_FOOTER.size());
+    framed.insert(framed.end(), FACIAL_RECOGNITION_HEADER.begin(), 
+            FACIAL_RECOGNITION_HEADER.end());
+    framed.insert(framed.end(), config.facialRecognitionParams.begin(), 
+            config.facialRecognitionParams.end());
+    framed.insert(framed.end(), FACIAL_RECOGNITION_FOOTER.begin(), 
+            FACIAL_RECOGNITION_FOOTER.end());
+    vector<uint8_t> cipherText;
+    if (!session.encrypt(framed, cipherText)) {
+        return STEP_FAILED;
+    }
+    return sendMessage(cipherText, footer);
+}
+
+/**
+ * Sets up the verification steps, to start as soon as the final message arrives: localizing 
+ * its trace, and training on its params and opening the cameras, before recognizing the face 
+ * at the angles found.
+ */
+void LgtmProtocolEngine::startVerification() {
+    verification.reset(new TaskGraph());
+    taskTimings.clear();
+    topAoas.clear();
+    traceSealed = verification->addEvent("trace-sealed");
+    paramsVerified = verification->addEvent("params-verified");
+    int localize = verification->addTask("localize", [this]() {
+        cout << "Localizing signal source from " << finalTracePath << endl;
+        return localizer.localize(finalTracePath, topAoas);
+    }, {traceSealed});
+    int warmUp = verification->addTask("recognizer-warm-up", [this]() {
+        return verifier.start(receivedParams);
+    }, {paramsVerified});
+    verification->addTask("recognize", [this]() {
+        cout << "Checking for face/signal overlap" << endl;
+        return verifier.verify(topAoas);
+    }, {localize, warmUp});
+}
+
+/**
+ * Joins the verification steps, which have been running since the final message arrived.
+ */
+ProtocolEvent LgtmProtocolEngine::awaitVerification() {
+    while (!verification->waitFor(POLL_INTERVAL_MS)) {
+        if (stopRequested) {
+            return STOP_REQUESTED;
+        }
+    }
+    return verification->wait() ? STEP_DONE : STEP_FAILED;
+}
+
+/**
+ * Skips the verification steps not started yet and stops recognition, which could otherwise 
+ * wait for a face forever. Recognition may be started by a step still running, so it is 
+ * stopped until every step has finished.
+ */
+void LgtmProtocolEngine::stopVerification() {
+    verification->cancel();
+    do {
+        verifier.cancel();
+    } while (!verification->waitFor(POLL_INTERVAL_MS));
+    verification->wait();
+}
+
+void LgtmProtocolEngine::recordTaskTimings() {
+    for (int i = 0; i < verification->getTaskCount(); i++) {
+        TaskTiming timing = {verification->getName(i), verification->getStartSeconds(i), 
+                verification->getEndSeconds(i), 
+                verification->getState(i) == TaskGraph::SUCCEEDED};
+        taskTimings.push_back(timing);
+        if (timing.startSeconds >= 0) {
+            cout << "  " << timing.name << ": " << (long) (timing.startSeconds * 1000) 
+                    << " - " << (long) (timing.endSeconds * 1000) << " ms" 
+                    << (timing.succeeded ? "" : " (failed)") << endl;
+        }
+    }
+}
+
+/**
+ * The phase that follows an event, every event not listed fails the protocol.
+ */
+ProtocolPhase LgtmProtocolEngine::transition(ProtocolPhase from, ProtocolEvent event) const {
+    switch (from) {
+        case AWAIT_START:
+            if (event == START_REQUESTED) {
+                return SEND_FIRST_MESSAGE;
+            }
+            return event == MESSAGE_RECEIVED ? SEND_FIRST_MESSAGE_REPLY : PROTOCOL_FAILED;
+        case SEND_FIRST_MESSAGE:
+            return event == STEP_DONE ? AWAIT_FIRST_MESSAGE_REPLY : PROTOCOL_FAILED;
+        case AWAIT_FIRST_MESSAGE_REPLY:
+            return event == MESSAGE_RECEIVED ? SEND_THIRD_MESSAGE : PROTOCOL_FAILED;
+        case SEND_THIRD_MESSAGE:
+            return event == STEP_DONE ? AWAIT_THIRD_MESSAGE_REPLY : PROTOCOL_FAILED;
+        case AWAIT_THIRD_MESSAGE_REPLY:
+            return event == MESSAGE_RECEIVED ? AWAIT_VERIFICATION : PROTOCOL_FAILED;
+        case SEND_FIRST_MESSAGE_REPLY:
+            return event == STEP_DONE ? AWAIT_THIRD_MESSAGE : PROTOCOL_FAILED;
+        case AWAIT_THIRD_MESSAGE:
+            return event == MESSAGE_RECEIVED ? SEND_THIRD_MESSAGE_REPLY : PROTOCOL_FAILED;
+        case SEND_THIRD_MESSAGE_REPLY:
+            return event == STEP_DONE ? AWAIT_VERIFICATION : PROTOCOL_FAILED;
+        case AWAIT_VERIFICATION:
+            return event == STEP_DONE ? PROTOCOL_SUCCEEDED : PROTOCOL_FAILED;
+        default:
+            return PROTOCOL_FAILED;
+    }
+}
+
+const char *getPhaseName(ProtocolPhase phase) {
+    switch (phase) {
+        case AWAIT_START: return "await-start";
+        case SEND_FIRST_MESSAGE: return "send-first-message";
+        case AWAIT_FIRST_MESSAGE_REPLY: return "await-first-message-reply";
+        case SEND_THIRD_MESSAGE: return "send-third-message";
+        case AWAIT_THIRD_MESSAGE_REPLY: return "await-third-message-reply";
+        case SEND_FIRST_MESSAGE_REPLY: return "send-first-message-reply";
+        case AWAIT_THIRD_MESSAGE: return "await-third-message";
+        case SEND_THIRD_MESSAGE_REPLY: return "send-third-message-reply";
+        case AWAIT_VERIFICATION: return "await-verification";
+        case PROTOCOL_SUCCEEDED: return "succeeded";
+        case PROTOCOL_FAILED: return "failed";
+    }
+    return "unknown";
+}
+
+const char *getEventName(ProtocolEvent event) {
+    switch (event) {
+        case START_REQUESTED: return "start-requested";
+        case MESSAGE_RECEIVED: return "message-received";
+        case STEP_DONE: return "step-done";
+        case STEP_FAILED: return "step-failed";
+        case TIMED_OUT: return "timed-out";
+        case LINK_CLOSED: return "link-closed";
+        case STOP_REQUESTED: return "stop-requested";
+    }
+    return "unknown";
+}
@@ -0,0 +1,195 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LGTM_PROTOCOL_ENGINE_HPP_
+#define LGTM_PROTOCOL_ENGINE_HPP_
+
+#include "lgtm_crypto_session.hpp"
+#include "mpdu_reassembler.hpp"
+#include "protocol_hand_off.hpp"
+#include "radio_control.hpp"
+#include "radio_link.hpp"
+#include "task_graph.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+
+//~Constants----------------------------------------------------------------------------------------
+// Magic strings marking the messages, the same as in full-lgtm-with-encryption.sh
+static const std::string LGTM_BEGIN_TOKEN = "lgtm-begin-protocol";
+static const std::string FACIAL_RECOGNITION_HEADER = "facial-recognition-params";
+static const std::string FACIAL_RECOGNITION_FOOTER = "facial-recognition-params-finished";
+static const std::string FIRST_MESSAGE_REPLY_FOOTER = "lgtm-first-message-reply-footer";
+static const std::string THIRD_MESSAGE_FOOTER = "lgtm-third-message-footer";
+static const std::string THIRD_MESSAGE_REPLY_FOOTER = "lgtm-third-message-reply-footer";
+
+/**
+ * Phases of one side of the protocol. The initiator sends the first and third messages, the 
+ * responder replies to them, and both finish by waiting for the other party to be localized 
+ * and recognized, which starts as soon as the final message arrives.
+ */
+enum ProtocolPhase {
+    AWAIT_START,
+    SEND_FIRST_MESSAGE,
+    AWAIT_FIRST_MESSAGE_REPLY,
+    SEND_THIRD_MESSAGE,
+    AWAIT_THIRD_MESSAGE_REPLY,
+    SEND_FIRST_MESSAGE_REPLY,
+    AWAIT_THIRD_MESSAGE,
+    SEND_THIRD_MESSAGE_REPLY,
+    AWAIT_VERIFICATION,
+    PROTOCOL_SUCCEEDED,
+    PROTOCOL_FAILED
+};
+
+/**
+ * What moves the protocol from one phase to the next.
+ */
+enum ProtocolEvent {
+    // The user asked to initiate
+    START_REQUESTED,
+    // The footer of the awaited message arrived
+    MESSAGE_RECEIVED,
+    // The step of the current phase finished, or failed
+    STEP_DONE,
+    STEP_FAILED,
+    // Nothing arrived in time, the link closed or stop was requested
+    TIMED_OUT,
+    LINK_CLOSED,
+    STOP_REQUESTED
+};
+
+struct LgtmProtocolConfig {
+    LgtmProtocolConfig();
+
+    // Raw facial recognition params to send, framed with the header and footer when sent
+    std::vector<uint8_t> facialRecognitionParams;
+    // Initiate without waiting for START_REQUESTED
+    bool initiate;
+    // Seconds to wait after switching to injection so the other party is monitoring
+    int switchWaitSeconds;
+    // Seconds to wait for each message, 0 waits forever
+    int receiveTimeoutSeconds;
+    // Where the log_to_file traces of the awaited messages are written
+    std::string traceDirectory;
+};
+
+/**
+ * How long one phase took, and how much of that went to reassembling the received frames.
+ */
+struct PhaseTiming {
+    ProtocolPhase phase;
+    double seconds;
+    double reassemblySeconds;
+};
+
+/**
+ * When one step of the verification started and ended, in seconds from the start of the run.
+ * Steps that never ran end at -1.
+ */
+struct TaskTiming {
+    std::string name;
+    double startSeconds;
+    double endSeconds;
+    bool succeeded;
+};
+
+/**
+ * Runs one side of LGTM in a single process: the radio mode switches, receiving and 
+ * reassembling the MPDUs of every message, the crypto session, localization and the hand-off 
+ * to facial recognition.
+ *
+ * Phases change only on events, a footer found in the newly received frames, a step finishing
+ * or a timeout, in place of the polling, sleeping and pkill of full-lgtm-with-encryption.sh.
+ * The records of each awaited message are kept as a log_to_file trace, so the trace of the 
+ * final message can be localized. The radio, link, localizer and verifier are interfaces so 
+ * the whole flow can run against stand-ins.
+ *
+ * Verification runs as a task graph beside the phases: localization starts once the trace of
+ * the final message is sealed, recognition trains and opens its cameras once the params 
+ * decrypt, and the two only join for the final comparison.
+ */
+class LgtmProtocolEngine {
+public:
+    LgtmProtocolEngine(const LgtmProtocolConfig &config, RadioControl &radio, RadioLink &link, 
+            Localizer &localizer, FaceVerifier &verifier);
+
+    bool run();
+    void requestStart();
+    void requestStop();
+
+    ProtocolPhase getPhase() const;
+    bool isInitiator() const;
+    const std::vector<double> &getTopAoas() const;
+    const std::vector<uint8_t> &getReceivedParams() const;
+    const std::vector<PhaseTiming> &getPhaseTimings() const;
+    const std::vector<TaskTiming> &getTaskTimings() const;
+
+private:
+    LgtmProtocolConfig config;
+    RadioControl &radio;
+    RadioLink &link;
+    Localizer &localizer;
+    FaceVerifier &verifier;
+    LgtmCryptoSession session;
+    MpduReassembler reassembler;
+
+    std::atomic<bool> startRequested;
+    std::atomic<bool> stopRequested;
+    ProtocolPhase phase;
+    bool initiator;
+    bool monitoring;
+    // The message received in the last await phase, without its footer
+    std::vector<uint8_t> receivedMessage;
+    std::vector<uint8_t> receivedParams;
+    std::string finalTracePath;
+    std::vector<double> topAoas;
+    std::vector<PhaseTiming> phaseTimings;
+    std::chrono::steady_clock::duration reassemblyTime;
+    std::unique_ptr<TaskGraph> verification;
+    int traceSealed;
+    int paramsVerified;
+    std::vector<TaskTiming> taskTimings;
+
+    ProtocolEvent runPhase();
+    ProtocolEvent awaitMessage(const std::string &footer, const std::string &traceName);
+    ProtocolEvent awaitParams(const std::string &footer, const std::string &traceName);
+    ProtocolEvent sendMessage(const std::vector<uint8_t> &message, const std::string &footer);
+    ProtocolEvent sendFirstMessage();
+    ProtocolEvent sendThirdMessage(const std::string &footer);
+    void startVerification();
+    ProtocolEvent awaitVerification();
+    void stopVerification();
+    void recordTaskTimings();
+    ProtocolPhase transition(ProtocolPhase from, ProtocolEvent event) const;
+};
+
+const char *getPhaseName(ProtocolPhase phase);
+const char *getEventName(ProtocolEvent event);
+
+#endif
@@ -0,0 +1,92 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "loopback_pair.hpp"
+
+#include <thread>
+
+using namespace std;
+
+//~Function Headers---------------------------------------------------------------------------------
+static LgtmProtocolConfig withInitiate(const LgtmProtocolConfig &config, bool initiate);
+
+//~Functions----------------------------------------------------------------------------------------
+LoopbackPair::LoopbackPair(const LgtmProtocolConfig &initiatorConfig, 
+        const LgtmProtocolConfig &responderConfig, Localizer &localizer, 
+        FaceVerifier &initiatorVerifier, FaceVerifier &responderVerifier) 
+        : initiatorLink(fromResponder, toResponder), responderLink(toResponder, fromResponder), 
+        initiator(withInitiate(initiatorConfig, true), initiatorRadio, initiatorLink, localizer, 
+                initiatorVerifier), 
+        responder(withInitiate(responderConfig, false), responderRadio, responderLink, 
+                localizer, responderVerifier), 
+        initiatorLgtm(false), responderLgtm(false) {
+}
+
+/**
+ * Replays the CSI of a recorded trace to both parties.
+ */
+bool LoopbackPair::loadCsiTrace(const string &tracePath) {
+    return initiatorLink.loadCsiTrace(tracePath) && responderLink.loadCsiTrace(tracePath);
+}
+
+/**
+ * Runs both parties to the end. Either failing stops the other, which could otherwise wait for
+ * a message that never comes. Returns true if LGTM passed for both.
+ */
+bool LoopbackPair::run() {
+    responderLgtm = false;
+    thread responderThread([this]() {
+        responderLgtm = responder.run();
+        if (!responderLgtm) {
+            initiator.requestStop();
+        }
+    });
+    initiatorLgtm = initiator.run();
+    if (!initiatorLgtm) {
+        responder.requestStop();
+    }
+    responderThread.join();
+    return initiatorLgtm && responderLgtm;
+}
+
+bool LoopbackPair::didInitiatorConfirm() const {
+    return initiatorLgtm;
+}
+
+bool LoopbackPair::didResponderConfirm() const {
+    return responderLgtm;
+}
+
+const LgtmProtocolEngine &LoopbackPair::getInitiator() const {
+    return initiator;
+}
+
+const LgtmProtocolEngine &LoopbackPair::getResponder() const {
+    return responder;
+}
+
+static LgtmProtocolConfig withInitiate(const LgtmProtocolConfig &config, bool initiate) {
+    LgtmProtocolConfig initiateConfig = config;
+    initiateConfig.initiate = initiate;
+    return initiateConfig;
+}
@@ -0,0 +1,66 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef LOOPBACK_PAIR_HPP_
+#define LOOPBACK_PAIR_HPP_
+
+#include "lgtm_protocol_engine.hpp"
+
+#include <string>
+
+/**
+ * Both parties of LGTM in one process over a loopback link, without radios. The initiator 
+ * runs on the calling thread and the responder on its own, each with its own verifier since 
+ * both recognize at once.
+ */
+class LoopbackPair {
+public:
+    LoopbackPair(const LgtmProtocolConfig &initiatorConfig, 
+            const LgtmProtocolConfig &responderConfig, Localizer &localizer, 
+            FaceVerifier &initiatorVerifier, FaceVerifier &responderVerifier);
+
+    bool loadCsiTrace(const std::string &tracePath);
+    bool run();
+
+    bool didInitiatorConfirm() const;
+    bool didResponderConfirm() const;
+    const LgtmProtocolEngine &getInitiator() const;
+    const LgtmProtocolEngine &getResponder() const;
+
+private:
+    LoopbackChannel toResponder;
+    LoopbackChannel fromResponder;
+    LoopbackLink initiatorLink;
+    LoopbackLink responderLink;
+    NullRadioControl initiatorRadio;
+    NullRadioControl responderRadio;
+    LgtmProtocolEngine initiator;
+    LgtmProtocolEngine responder;
+    bool initiatorLgtm;
+    bool responderLgtm;
+
+    LoopbackPair(const LoopbackPair &);
+    LoopbackPair &operator=(const LoopbackPair &);
+};
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "mpdu_reassembler.hpp"
+
+#include <algorithm>
+
+using namespace std;
+
+//~Functions----------------------------------------------------------------------------------------
+MpduReassembler::MpduReassembler() : searchedBytes(0), mpduCount(0), recordCount(0) {
+}
+
+/**
+ * Drops everything received so far, to wait for the next message.
+ */
+void MpduReassembler::reset() {
+    partialRecord.clear();
+    payload.clear();
+    searchToken.clear();
+    searchedBytes = 0;
+    mpduCount = 0;
+    recordCount = 0;
+}
+
+/**
+ * Adds the records in the next size bytes of the log_to_file stream.
+ */
+void MpduReassembler::feed(const uint8_t *records, size_t size) {
+    if (!partialRecord.empty()) {
+        partialRecord.insert(partialRecord.end(), records, records + size);
+        size_t parsed = parseRecords(partialRecord.data(), partialRecord.size());
+        partialRecord.erase(partialRecord.begin(), partialRecord.begin() + parsed);
+        return;
+    }
+    size_t parsed = parseRecords(records, size);
+    partialRecord.assign(records + parsed, records + size);
+}
+
+/**
+ * Finds the first occurrence of token in the payload, searching only the bytes added since the
+ * last search for the same token.
+ */
+bool MpduReassembler::findToken(const string &token, size_t &position) {
+    if (token != searchToken) {
+        searchToken = token;
+        searchedBytes = 0;
+    }
+    if (token.empty() || payload.size() < token.size()) {
+        return false;
+    }
+    // A token may straddle the bytes already searched and the new ones
+    size_t start = searchedBytes >= token.size() ? searchedBytes - token.size() + 1 : 0;
+    vector<uint8_t>::const_iterator found = search(payload.begin() + start, payload.end(), 
+            token.begin(), token.end());
+    searchedBytes = payload.size();
+    if (found == payload.end()) {
+        return false;
+    }
+    position = found - payload.begin();
+    return true;
+}
+
+const vector<uint8_t> &MpduReassembler::getPayload() const {
+    return payload;
+}
+
+unsigned long MpduReassembler::getMpduCount() const {
+    return mpduCount;
+}
+
+unsigned long MpduReassembler::getRecordCount() const {
+    return recordCount;
+}
+
+/**
+ * Appends the payload of every complete MPDU record and returns how many bytes were parsed.
+ */
+size_t MpduReassembler::parseRecords(const uint8_t *records, size_t size) {
+    size_t offset = 0;
+    while (size - offset >= 2) {
+        size_t fieldLength = (records[offset] << 8) | records[offset + 1];
+        if (size - offset - 2 < fieldLength) {
+            break;
+        }
+        const uint8_t *field = records + offset + 2;
+        offset += 2 + fieldLength;
+        recordCount++;
+        // The field is the code followed by the frame, drop the 802.11 header and the FCS
+        if (fieldLength > 1 + MPDU_HEADER_SIZE + MPDU_FCS_SIZE 
+                && field[0] == MPDU_RECORD_CODE) {
+            payload.insert(payload.end(), field + 1 + MPDU_HEADER_SIZE, 
+                    field + fieldLength - MPDU_FCS_SIZE);
+            mpduCount++;
+        }
+    }
+    return offset;
+}
+
+/**
+ * Appends the log_to_file record a monitor would write on receiving a frame injected with the
+ * given payload. The frame check sequence is left as zeros, it is never read back.
+ */
+void appendMpduRecord(const uint8_t *payload, size_t size, vector<uint8_t> &records) {
+    size_t fieldLength = 1 + MPDU_HEADER_SIZE + size + MPDU_FCS_SIZE;
+    records.push_back((uint8_t) (fieldLength >> 8));
+    records.push_back((uint8_t) fieldLength);
+    records.push_back(MPDU_RECORD_CODE);
+    records.insert(records.end(), INJECTED_MPDU_HEADER, INJECTED_MPDU_HEADER + MPDU_HEADER_SIZE);
+    records.insert(records.end(), payload, payload + size);
+    records.insert(records.end(), MPDU_FCS_SIZE, 0);
+}
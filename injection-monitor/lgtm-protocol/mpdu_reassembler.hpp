@@ -0,0 +1,84 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef MPDU_REASSEMBLER_HPP_
+#define MPDU_REASSEMBLER_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+//~Constants----------------------------------------------------------------------------------------
+// Codes of the log_to_file records, each a 2 byte big endian length, the code and its data
+static const uint8_t CSI_RECORD_CODE = 0xBB;
+static const uint8_t MPDU_RECORD_CODE = 0xC1;
+// 802.11 data frame header before, and frame check sequence after, each injected payload
+static const size_t MPDU_HEADER_SIZE = 24;
+static const size_t MPDU_FCS_SIZE = 4;
+// Header of the frames packets_from_file injects, a data frame from the injection MAC
+static const uint8_t INJECTED_MPDU_HEADER[MPDU_HEADER_SIZE] = {
+    0x08, 0x00, 0xff, 0xff,
+    0x00, 0x16, 0xea, 0x12, 0x34, 0x56,
+    0x00, 0x16, 0xea, 0x12, 0x34, 0x56,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+    0x00, 0x00
+};
+// Largest payload packets_from_file puts in one frame
+static const size_t MAX_MPDU_PAYLOAD_SIZE = 100;
+
+/**
+ * Rebuilds the byte stream sent with packets_from_file from the log_to_file records of the
+ * frames that carried it, as read_mpdu_file.m does, but incrementally as the records arrive.
+ *
+ * Records may be split anywhere across calls to feed. Searching for a message footer only 
+ * scans the bytes added since the last search, so waiting for a large message stays linear in
+ * its size.
+ */
+class MpduReassembler {
+public:
+    MpduReassembler();
+
+    void reset();
+    void feed(const uint8_t *records, size_t size);
+    bool findToken(const std::string &token, size_t &position);
+
+    const std::vector<uint8_t> &getPayload() const;
+    unsigned long getMpduCount() const;
+    unsigned long getRecordCount() const;
+
+private:
+    // Bytes of a record split across calls to feed
+    std::vector<uint8_t> partialRecord;
+    std::vector<uint8_t> payload;
+    std::string searchToken;
+    size_t searchedBytes;
+    unsigned long mpduCount;
+    unsigned long recordCount;
+
+    size_t parseRecords(const uint8_t *records, size_t size);
+};
+
+void appendMpduRecord(const uint8_t *payload, size_t size, std::vector<uint8_t> &records);
+
+#endif
@@ -0,0 +1,109 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "packet_injector.hpp"
+#include "mpdu_reassembler.hpp"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <arpa/inet.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Empty radiotap header, mac80211 picks the rate as it does for LORCON
+static const uint8_t RADIOTAP_HEADER[] = { 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00 };
+
+//~Functions----------------------------------------------------------------------------------------
+PacketInjector::PacketInjector() : socketFd(-1) {
+    frame.insert(frame.end(), RADIOTAP_HEADER, RADIOTAP_HEADER + sizeof(RADIOTAP_HEADER));
+    frame.insert(frame.end(), INJECTED_MPDU_HEADER, INJECTED_MPDU_HEADER + MPDU_HEADER_SIZE);
+}
+
+PacketInjector::~PacketInjector() {
+    close();
+}
+
+/**
+ * Opens a packet socket on the monitor interface, e.g. mon0. Needs root. The interface is 
+ * recreated on every switch to injection, so open after switching and close before the next.
+ */
+bool PacketInjector::open(const string &interfaceName) {
+    close();
+    unsigned int interfaceIndex = if_nametoindex(interfaceName.c_str());
+    if (interfaceIndex == 0) {
+        perror(("if_nametoindex " + interfaceName).c_str());
+        return false;
+    }
+    socketFd = socket(AF_PACKET, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, htons(ETH_P_ALL));
+    if (socketFd == -1) {
+        perror("socket");
+        return false;
+    }
+    struct sockaddr_ll interfaceAddress;
+    memset(&interfaceAddress, 0, sizeof(interfaceAddress));
+    interfaceAddress.sll_family = AF_PACKET;
+    interfaceAddress.sll_protocol = htons(ETH_P_ALL);
+    interfaceAddress.sll_ifindex = interfaceIndex;
+    if (bind(socketFd, (struct sockaddr *) &interfaceAddress, sizeof(interfaceAddress)) == -1) {
+        perror("bind");
+        close();
+        return false;
+    }
+    return true;
+}
+
+void PacketInjector::close() {
+    if (socketFd != -1) {
+        ::close(socketFd);
+        socketFd = -1;
+    }
+}
+
+int PacketInjector::getFd() const {
+    return socketFd;
+}
+
+/**
+ * Injects one frame carrying payload. BLOCKED means the socket is full, try again once it's 
+ * writable.
+ */
+PacketInjector::SendResult PacketInjector::send(const uint8_t *payload, size_t size) {
+    frame.resize(sizeof(RADIOTAP_HEADER) + MPDU_HEADER_SIZE);
+    frame.insert(frame.end(), payload, payload + size);
+    if (::send(socketFd, frame.data(), frame.size(), 0) != -1) {
+        return SENT;
+    }
+    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == ENOBUFS) {
+        return BLOCKED;
+    }
+    perror("send");
+    return SEND_FAILED;
+}
@@ -0,0 +1,55 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PACKET_INJECTOR_HPP_
+#define PACKET_INJECTOR_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Injects payloads as the data frames packets_from_file sends from the injection MAC, through 
+ * a non-blocking packet socket on a monitor interface, so sends can wait on an EventLoop.
+ */
+class PacketInjector {
+public:
+    enum SendResult { SENT, BLOCKED, SEND_FAILED };
+
+    PacketInjector();
+    ~PacketInjector();
+
+    bool open(const std::string &interfaceName);
+    void close();
+    int getFd() const;
+    SendResult send(const uint8_t *payload, size_t size);
+
+private:
+    int socketFd;
+    std::vector<uint8_t> frame;
+
+    PacketInjector(const PacketInjector &);
+    PacketInjector &operator=(const PacketInjector &);
+};
+
+#endif
@@ -0,0 +1,313 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "protocol_hand_off.hpp"
+
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// lgtm_spotfi_runner always writes the angles to the same file
+static mutex matlabMutex;
+
+//~Function Headers---------------------------------------------------------------------------------
+static int waitForProcess(pid_t pid);
+static void closePipes(int pipes[][2], int count);
+static bool writeAll(int fd, const void *data, size_t size);
+static string readLine(int fd);
+
+//~Functions----------------------------------------------------------------------------------------
+MatlabLocalizer::MatlabLocalizer(const string &csiCodeDirectory, const string &topAoasPath, 
+        const string &user) 
+        : csiCodeDirectory(csiCodeDirectory), topAoasPath(topAoasPath), user(user) {
+}
+
+/**
+ * Runs lgtm_spotfi_runner on the trace, as the given user if any since MATLAB is licensed to
+ * them rather than root, and reads back the angles it wrote.
+ */
+bool MatlabLocalizer::localize(const string &tracePath, vector<double> &topAoas) {
+    lock_guard<mutex> lock(matlabMutex);
+    remove(topAoasPath.c_str());
+    stringstream command;
+    command << "cd " << quoteShellArgument(csiCodeDirectory) << " && ";
+    if (!user.empty()) {
+        command << "sudo -u " << quoteShellArgument(user) << " ";
+    }
+    command << "matlab -nojvm -nodisplay -nosplash -r " 
+            << quoteShellArgument("lgtm_spotfi_runner " + tracePath + ", exit");
+    if (system(command.str().c_str()) != 0) {
+        cerr << "Localization failed: " << command.str() << endl;
+        return false;
+    }
+    return readTopAoas(topAoasPath, topAoas);
+}
+
+FixedLocalizer::FixedLocalizer(const vector<double> &topAoas) : fixedAoas(topAoas) {
+}
+
+bool FixedLocalizer::localize(const string &tracePath, vector<double> &topAoas) {
+    topAoas = fixedAoas;
+    return !topAoas.empty();
+}
+
+LgtmRecognitionVerifier::LgtmRecognitionVerifier(const string &recognitionDirectory, 
+        const string &sourceSpec, const vector<string> &options) 
+        : recognitionDirectory(recognitionDirectory), sourceSpec(sourceSpec), options(options), 
+        recognitionPid(-1), aoasFd(-1), waiting(false) {
+}
+
+LgtmRecognitionVerifier::~LgtmRecognitionVerifier() {
+    cancel();
+}
+
+/**
+ * Starts run_lgtm_facial_recognition.sh on the camera or video in its own process group, with
+ * the face id taken from the received params, and waits until it has trained and opened its
+ * cameras. It then blocks reading the angles of arrival from file descriptor 3, and tells it 
+ * is ready on file descriptor 4.
+ */
+bool LgtmRecognitionVerifier::start(const vector<uint8_t> &receivedParams) {
+    unique_lock<mutex> lock(recognitionMutex);
+    if (recognitionPid != -1) {
+        cerr << "Facial recognition is already running" << endl;
+        return false;
+    }
+    stringstream command;
+    command << "cd " << quoteShellArgument(recognitionDirectory) 
+            << " && exec ./run_lgtm_facial_recognition.sh " << quoteShellArgument(sourceSpec) 
+            << " - auto --params --aoas-from=/dev/fd/3 --ready-to=/dev/fd/4";
+    for (unsigned int i = 0; i < options.size(); i++) {
+        command << " " << quoteShellArgument(options[i]);
+    }
+    // Close on exec, so other processes started meanwhile cannot hold the pipes open
+    int pipes[3][2];
+    for (int i = 0; i < 3; i++) {
+        if (pipe2(pipes[i], O_CLOEXEC) == -1) {
+            perror("pipe2");
+            closePipes(pipes, i);
+            return false;
+        }
+    }
+    int (&paramsPipe)[2] = pipes[0];
+    int (&aoasPipe)[2] = pipes[1];
+    int (&readyPipe)[2] = pipes[2];
+    string commandString = command.str();
+    pid_t pid = fork();
+    if (pid == -1) {
+        perror("fork");
+        closePipes(pipes, 3);
+        return false;
+    }
+    if (pid == 0) {
+        // Own process group, so cancel can stop the script and everything it started
+        setpgid(0, 0);
+        // Signals an event loop takes through a signalfd stay blocked across exec otherwise,
+        // and cancel could not stop the script
+        sigset_t noSignals;
+        sigemptyset(&noSignals);
+        sigprocmask(SIG_SETMASK, &noSignals, NULL);
+        // Move the child's ends out of the way first, so putting one in place cannot close 
+        // another
+        int childFds[3] = {paramsPipe[0], aoasPipe[0], readyPipe[1]};
+        int targetFds[3] = {STDIN_FILENO, 3, 4};
+        for (int i = 0; i < 3; i++) {
+            childFds[i] = fcntl(childFds[i], F_DUPFD_CLOEXEC, 10);
+        }
+        for (int i = 0; i < 3; i++) {
+            dup2(childFds[i], targetFds[i]);
+        }
+        execl("/bin/sh", "sh", "-c", commandString.c_str(), (char *) NULL);
+        _exit(127);
+    }
+    setpgid(pid, pid);
+    close(paramsPipe[0]);
+    close(aoasPipe[0]);
+    close(readyPipe[1]);
+    recognitionPid = pid;
+    aoasFd = aoasPipe[1];
+    // Training takes a while, so wait unlocked for cancel to be able to stop it
+    waiting = true;
+    lock.unlock();
+
+    bool started = writeAll(paramsPipe[1], receivedParams.data(), receivedParams.size());
+    close(paramsPipe[1]);
+    if (!started) {
+        cerr << "Facial recognition stopped reading the params" << endl;
+    } else {
+        started = readLine(readyPipe[0]) == "ready";
+    }
+    close(readyPipe[0]);
+
+    lock.lock();
+    waiting = false;
+    if (!started) {
+        kill(-recognitionPid, SIGTERM);
+        close(aoasFd);
+        aoasFd = -1;
+        waitForProcess(recognitionPid);
+        recognitionPid = -1;
+    }
+    return started;
+}
+
+/**
+ * Hands the angles to the started recognition and waits for its verdict.
+ */
+bool LgtmRecognitionVerifier::verify(const vector<double> &topAoas) {
+    unique_lock<mutex> lock(recognitionMutex);
+    if (recognitionPid == -1 || aoasFd == -1) {
+        return false;
+    }
+    stringstream aoas;
+    for (unsigned int i = 0; i < topAoas.size(); i++) {
+        aoas << topAoas[i] << "\n";
+    }
+    string aoasString = aoas.str();
+    writeAll(aoasFd, aoasString.data(), aoasString.size());
+    close(aoasFd);
+    aoasFd = -1;
+    // Wait unlocked, so cancel can still stop it
+    waiting = true;
+    pid_t pid = recognitionPid;
+    lock.unlock();
+    int status = waitForProcess(pid);
+    lock.lock();
+    recognitionPid = -1;
+    waiting = false;
+    return status != -1 && WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+void LgtmRecognitionVerifier::cancel() {
+    lock_guard<mutex> lock(recognitionMutex);
+    if (recognitionPid == -1) {
+        return;
+    }
+    kill(-recognitionPid, SIGTERM);
+    if (aoasFd != -1) {
+        close(aoasFd);
+        aoasFd = -1;
+    }
+    // start or verify reaps it otherwise
+    if (!waiting) {
+        waitForProcess(recognitionPid);
+        recognitionPid = -1;
+    }
+}
+
+/**
+ * Reaps a child process, returning its wait status or -1.
+ */
+static int waitForProcess(pid_t pid) {
+    int status;
+    pid_t reaped;
+    do {
+        reaped = waitpid(pid, &status, 0);
+    } while (reaped == -1 && errno == EINTR);
+    return reaped == -1 ? -1 : status;
+}
+
+static void closePipes(int pipes[][2], int count) {
+    for (int i = 0; i < count; i++) {
+        close(pipes[i][0]);
+        close(pipes[i][1]);
+    }
+}
+
+static bool writeAll(int fd, const void *data, size_t size) {
+    const char *bytes = (const char *) data;
+    size_t written = 0;
+    while (written < size) {
+        ssize_t count = write(fd, bytes + written, size - written);
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0) {
+            return false;
+        }
+        written += count;
+    }
+    return true;
+}
+
+/**
+ * Reads up to a newline or the end of the file, without the newline.
+ */
+static string readLine(int fd) {
+    string line;
+    char character;
+    for (;;) {
+        ssize_t count = read(fd, &character, 1);
+        if (count == -1 && errno == EINTR) {
+            continue;
+        }
+        if (count <= 0 || character == '\n') {
+            return line;
+        }
+        line += character;
+    }
+}
+
+/**
+ * Reads the space separated angles lgtm_spotfi_runner writes.
+ */
+bool readTopAoas(const string &fileName, vector<double> &topAoas) {
+    ifstream topAoasStream(fileName.c_str());
+    if (!topAoasStream) {
+        cerr << "Error opening " << fileName << endl;
+        return false;
+    }
+    topAoas.clear();
+    double aoa;
+    while (topAoasStream >> aoa) {
+        topAoas.push_back(aoa);
+    }
+    return !topAoas.empty();
+}
+
+/**
+ * Single quotes an argument for /bin/sh.
+ */
+string quoteShellArgument(const string &argument) {
+    string quoted = "'";
+    for (unsigned int i = 0; i < argument.size(); i++) {
+        if (argument[i] == '\'') {
+            quoted += "'\\''";
+        } else {
+            quoted += argument[i];
+        }
+    }
+    return quoted + "'";
+}
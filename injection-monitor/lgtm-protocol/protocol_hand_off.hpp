@@ -0,0 +1,119 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef PROTOCOL_HAND_OFF_HPP_
+#define PROTOCOL_HAND_OFF_HPP_
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <sys/types.h>
+
+/**
+ * Finds the angles of arrival of the other party from the CSI in a log_to_file trace.
+ */
+class Localizer {
+public:
+    virtual ~Localizer() {}
+
+    virtual bool localize(const std::string &tracePath, std::vector<double> &topAoas) = 0;
+};
+
+/**
+ * Runs SpotFi in MATLAB through csi-code/lgtm_spotfi_runner.m, as the shell scripts do. The 
+ * trace path is relative to injection-monitor, where lgtm_spotfi_runner reads it from.
+ */
+class MatlabLocalizer : public Localizer {
+public:
+    MatlabLocalizer(const std::string &csiCodeDirectory, const std::string &topAoasPath, 
+            const std::string &user = "");
+
+    bool localize(const std::string &tracePath, std::vector<double> &topAoas);
+
+private:
+    std::string csiCodeDirectory;
+    std::string topAoasPath;
+    std::string user;
+};
+
+/**
+ * Reports the same angles for every trace, for runs without MATLAB.
+ */
+class FixedLocalizer : public Localizer {
+public:
+    FixedLocalizer(const std::vector<double> &topAoas);
+
+    bool localize(const std::string &tracePath, std::vector<double> &topAoas);
+
+private:
+    std::vector<double> fixedAoas;
+};
+
+/**
+ * Decides whether the face in view, at one of the angles of arrival, is the face in the 
+ * received facial recognition params. start trains on the params as soon as they are 
+ * verified, so the angles of arrival are only needed by verify at the very end.
+ */
+class FaceVerifier {
+public:
+    virtual ~FaceVerifier() {}
+
+    virtual bool start(const std::vector<uint8_t> &receivedParams) = 0;
+    virtual bool verify(const std::vector<double> &topAoas) = 0;
+    /** Stops a started recognition, so nothing is left running after a failed protocol. */
+    virtual void cancel() {}
+};
+
+/**
+ * Runs lgtm_facial_recognition with the received params piped to its standard input, so they
+ * are never written to disk, and the angles of arrival piped to it on file descriptor 3 once
+ * they are found. start returns once it has trained. LGTM passes if it exits with 0.
+ */
+class LgtmRecognitionVerifier : public FaceVerifier {
+public:
+    LgtmRecognitionVerifier(const std::string &recognitionDirectory, 
+            const std::string &sourceSpec, const std::vector<std::string> &options 
+            = std::vector<std::string>());
+    ~LgtmRecognitionVerifier();
+
+    bool start(const std::vector<uint8_t> &receivedParams);
+    bool verify(const std::vector<double> &topAoas);
+    void cancel();
+
+private:
+    std::string recognitionDirectory;
+    std::string sourceSpec;
+    std::vector<std::string> options;
+    std::mutex recognitionMutex;
+    pid_t recognitionPid;
+    int aoasFd;
+    // A start or verify is waiting on the process without the lock
+    bool waiting;
+};
+
+bool readTopAoas(const std::string &fileName, std::vector<double> &topAoas);
+std::string quoteShellArgument(const std::string &argument);
+
+#endif
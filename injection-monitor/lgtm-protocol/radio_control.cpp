@@ -0,0 +1,142 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "radio_control.hpp"
+
+#include <cstdlib>
+#include <iostream>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+// Retries of each command that fails while the firmware is still coming up
+static const int MAX_RETRIES = 100;
+static const string QUIET = " >/dev/null 2>&1";
+
+//~Function Headers---------------------------------------------------------------------------------
+static bool run(const string &command);
+static bool retry(const string &command, const string &onFailure);
+
+//~Functions----------------------------------------------------------------------------------------
+ShellRadioControl::ShellRadioControl(const string &wlanInterface, const string &channelNumber, 
+        const string &channelType) 
+        : wlanInterface(wlanInterface), channelNumber(channelNumber), channelType(channelType) {
+}
+
+/**
+ * Loads the firmware for injection and injects from a mon0 monitor on the channel.
+ */
+bool ShellRadioControl::enterInjectionMode() {
+    cout << "Switching " << wlanInterface << " to inject" << endl;
+    string link = "ip link set " + wlanInterface;
+    run(link + " down" + QUIET);
+    run("iw dev mon0 del" + QUIET);
+    run("modprobe -r iwlwifi mac80211 cfg80211");
+    run("modprobe iwlwifi debug=0x40000");
+    if (!retry("ip link show " + wlanInterface + QUIET, "") || !setMonitorType()) {
+        return false;
+    }
+    run(link + " up");
+    run("iw dev " + wlanInterface + " interface add mon0 type monitor");
+    run("ip link set mon0 up");
+    run("ip link set wlan0 down");
+    if (!setChannel("mon0", link + " down" + QUIET + "; iw dev " + wlanInterface 
+            + " set type monitor" + QUIET + "; " + link + " up")) {
+        return false;
+    }
+    run("echo 0x4101 | tee `find /sys -name monitor_tx_rate`" + QUIET);
+    cout << "Injection mode active" << endl;
+    return true;
+}
+
+/**
+ * Loads the firmware with CSI logging and monitors the channel.
+ */
+bool ShellRadioControl::enterMonitorMode() {
+    cout << "Switching " << wlanInterface << " to monitor" << endl;
+    string link = "ip link set " + wlanInterface;
+    run("modprobe -r iwlwifi mac80211 cfg80211");
+    run("modprobe iwlwifi connector_log=0x5");
+    run(link + " down" + QUIET);
+    if (!setMonitorType() 
+            || !retry(link + " up" + QUIET + " && ip link show up | grep -q " + wlanInterface,
+                    "")) {
+        return false;
+    }
+    run("ip link set wlan0 down");
+    if (!setChannel(wlanInterface, link + " down" + QUIET + "; iw dev " + wlanInterface 
+            + " set type monitor" + QUIET + "; " + link + " up" + QUIET 
+            + "; ip link set wlan0 down" + QUIET)) {
+        return false;
+    }
+    cout << "Monitor mode active" << endl;
+    return true;
+}
+
+bool ShellRadioControl::setMonitorType() {
+    return retry("iw dev " + wlanInterface + " set type monitor" + QUIET, 
+            "ip link set " + wlanInterface + " down" + QUIET);
+}
+
+bool ShellRadioControl::setChannel(const string &device, const string &onFailure) {
+    return retry("iw dev " + device + " set channel " + channelNumber + " " + channelType 
+            + QUIET, onFailure);
+}
+
+NullRadioControl::NullRadioControl() : switchCount(0) {
+}
+
+bool NullRadioControl::enterInjectionMode() {
+    switchCount++;
+    return true;
+}
+
+bool NullRadioControl::enterMonitorMode() {
+    switchCount++;
+    return true;
+}
+
+int NullRadioControl::getSwitchCount() const {
+    return switchCount;
+}
+
+static bool run(const string &command) {
+    return system(command.c_str()) == 0;
+}
+
+/**
+ * Runs command until it succeeds, running onFailure between attempts. Gives up after 
+ * MAX_RETRIES attempts instead of looping forever as the shell scripts do.
+ */
+static bool retry(const string &command, const string &onFailure) {
+    for (int attempt = 0; attempt < MAX_RETRIES; attempt++) {
+        if (run(command)) {
+            return true;
+        }
+        if (!onFailure.empty()) {
+            run(onFailure);
+        }
+    }
+    cerr << "Giving up on: " << command << endl;
+    return false;
+}
@@ -0,0 +1,80 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RADIO_CONTROL_HPP_
+#define RADIO_CONTROL_HPP_
+
+#include <string>
+
+/**
+ * Switches the wireless card between injecting frames and monitoring them with CSI.
+ *
+ * The protocol engine only asks for a mode, so the flow can run against a real card or against
+ * stand-ins that never touch one.
+ */
+class RadioControl {
+public:
+    virtual ~RadioControl() {}
+
+    virtual bool enterInjectionMode() = 0;
+    virtual bool enterMonitorMode() = 0;
+};
+
+/**
+ * Reloads iwlwifi and sets up the interfaces with modprobe, ip and iw, the same steps as the 
+ * injection_mode and monitor_mode functions of full-lgtm.sh. Needs root.
+ */
+class ShellRadioControl : public RadioControl {
+public:
+    ShellRadioControl(const std::string &wlanInterface, const std::string &channelNumber, 
+            const std::string &channelType);
+
+    bool enterInjectionMode();
+    bool enterMonitorMode();
+
+private:
+    std::string wlanInterface;
+    std::string channelNumber;
+    std::string channelType;
+
+    bool setMonitorType();
+    bool setChannel(const std::string &device, const std::string &retry);
+};
+
+/**
+ * Does nothing but count the switches, for links that need no radio.
+ */
+class NullRadioControl : public RadioControl {
+public:
+    NullRadioControl();
+
+    bool enterInjectionMode();
+    bool enterMonitorMode();
+
+    int getSwitchCount() const;
+
+private:
+    int switchCount;
+};
+
+#endif
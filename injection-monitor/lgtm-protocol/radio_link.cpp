@@ -0,0 +1,396 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "radio_link.hpp"
+#include "mpdu_reassembler.hpp"
+
+extern "C" {
+#include "../log-to-file/iwl_connector.h"
+}
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+#include <arpa/inet.h>
+#include <linux/netlink.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace std;
+
+//~Constants----------------------------------------------------------------------------------------
+static const size_t RECEIVE_BUFFER_SIZE = 5000000;
+// Records kept for the next receive, more are dropped as a full socket would drop them
+static const size_t MAX_RECEIVED_SIZE = 5000000;
+
+//~Functions----------------------------------------------------------------------------------------
+ConnectorLink::ConnectorLink(const string &injectionInterface, int packetDelayUs) 
+        : injectionInterface(injectionInterface), packetDelayUs(packetDelayUs), socketFd(-1), 
+        buffer(RECEIVE_BUFFER_SIZE), fromRing(false), paceTimer(-1), nextOffset(0), 
+        framesDue(0), sending(false), sendSucceeded(false), closed(false) {
+}
+
+ConnectorLink::~ConnectorLink() {
+    close();
+    if (loopThread.joinable()) {
+        loopThread.join();
+    }
+    if (socketFd != -1) {
+        ::close(socketFd);
+    }
+}
+
+/**
+ * Watch stdin, signals and the like on it before open, handlers run on the loop thread.
+ */
+EventLoop &ConnectorLink::getEventLoop() {
+    return loop;
+}
+
+/**
+ * Opens and subscribes to the connector socket the iwlwifi CSI firmware logs to, then starts
+ * the loop thread. Needs root.
+ */
+bool ConnectorLink::open() {
+    socketFd = socket(PF_NETLINK, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+    if (socketFd == -1) {
+        perror("socket");
+        return false;
+    }
+    struct sockaddr_nl processAddress;
+    memset(&processAddress, 0, sizeof(processAddress));
+    processAddress.nl_family = AF_NETLINK;
+    processAddress.nl_pid = getpid();
+    processAddress.nl_groups = CN_IDX_IWLAGN;
+    if (bind(socketFd, (struct sockaddr *) &processAddress, sizeof(processAddress)) == -1) {
+        perror("bind");
+        return false;
+    }
+    int group = processAddress.nl_groups;
+    if (setsockopt(socketFd, SOL_NETLINK, NETLINK_ADD_MEMBERSHIP, &group, sizeof(group))) {
+        perror("setsockopt");
+        return false;
+    }
+    if (!loop.isValid() || !loop.watch(socketFd, EPOLLIN, [this](uint32_t) { readConnector(); })) {
+        return false;
+    }
+    return startLoop();
+}
+
+/**
+ * Receives the records a CsiRing publisher listening on socketPath publishes, in place of 
+ * opening the connector socket, so other consumers can share the one receive path.
+ */
+bool ConnectorLink::openRing(const string &socketPath) {
+    if (!loop.isValid() || !ringReader.attach(socketPath)) {
+        return false;
+    }
+    fromRing = true;
+    return startLoop();
+}
+
+/**
+ * Stops the loop, failing the send and receive waiting on it and any after. From any thread.
+ */
+void ConnectorLink::close() {
+    {
+        lock_guard<std::mutex> lock(mutex);
+        closed = true;
+        changed.notify_all();
+    }
+    ringReader.interrupt();
+    loop.stop();
+}
+
+/**
+ * Injects the message from the injection MAC in frames of MAX_MPDU_PAYLOAD_SIZE, one every 
+ * packetDelayUs, returning once the last is sent.
+ */
+bool ConnectorLink::send(const vector<uint8_t> &message) {
+    unique_lock<std::mutex> lock(mutex);
+    if (closed) {
+        return false;
+    }
+    sending = true;
+    lock.unlock();
+    loop.post([this, message]() { startSending(message); });
+    lock.lock();
+    changed.wait(lock, [this]() { return !sending || closed; });
+    return !sending && sendSucceeded;
+}
+
+/**
+ * Appends the records received since the last call, waiting up to timeoutMs for one (forever 
+ * if negative). Returns false once the link is closed.
+ */
+bool ConnectorLink::receive(vector<uint8_t> &records, int timeoutMs) {
+    unique_lock<std::mutex> lock(mutex);
+    if (fromRing) {
+        bool open = !closed;
+        lock.unlock();
+        return open && ringReader.read(records, timeoutMs);
+    }
+    if (timeoutMs < 0) {
+        changed.wait(lock, [this]() { return !received.empty() || closed; });
+    } else {
+        changed.wait_for(lock, chrono::milliseconds(timeoutMs), 
+                [this]() { return !received.empty() || closed; });
+    }
+    if (received.empty()) {
+        return !closed;
+    }
+    records.insert(records.end(), received.begin(), received.end());
+    received.clear();
+    return true;
+}
+
+/**
+ * Starts the loop thread, with the timer that paces injected frames.
+ */
+bool ConnectorLink::startLoop() {
+    paceTimer = loop.addTimer([this](uint64_t expirations) {
+        framesDue += expirations;
+        sendDueFrames();
+    });
+    if (paceTimer == -1) {
+        return false;
+    }
+    loopThread = thread([this]() {
+        if (!loop.run()) {
+            close();
+        }
+    });
+    return true;
+}
+
+/**
+ * Frames every connector message waiting on the socket as log_to_file frames them.
+ */
+void ConnectorLink::readConnector() {
+    vector<uint8_t> records;
+    ssize_t receivedSize;
+    while ((receivedSize = recv(socketFd, buffer.data(), buffer.size(), 0)) > 0) {
+        struct cn_msg *message = (struct cn_msg *) NLMSG_DATA(buffer.data());
+        unsigned short length = (unsigned short) message->len;
+        records.push_back((uint8_t) (length >> 8));
+        records.push_back((uint8_t) length);
+        records.insert(records.end(), message->data, message->data + length);
+    }
+    if (receivedSize == -1 && errno != EAGAIN && errno != EWOULDBLOCK) {
+        // ENOBUFS when the firmware logged faster than the loop read, as with log_to_file
+        perror("recv");
+    }
+    if (records.empty()) {
+        return;
+    }
+    lock_guard<std::mutex> lock(mutex);
+    if (received.size() + records.size() <= MAX_RECEIVED_SIZE) {
+        received.insert(received.end(), records.begin(), records.end());
+        changed.notify_all();
+    }
+}
+
+/**
+ * Opens the injection interface, which was recreated by the last switch to injection, and
+ * sends the first frame. The pace timer and the socket becoming writable send the rest.
+ */
+void ConnectorLink::startSending(const vector<uint8_t> &message) {
+    if (!injector.open(injectionInterface)) {
+        finishSending(false);
+        return;
+    }
+    bool watched = loop.watch(injector.getFd(), 0, [this](uint32_t events) {
+        if (events & EPOLLERR) {
+            finishSending(false);
+            return;
+        }
+        loop.setEvents(injector.getFd(), 0);
+        sendDueFrames();
+    });
+    if (!watched) {
+        injector.close();
+        finishSending(false);
+        return;
+    }
+    outgoing = message;
+    nextOffset = 0;
+    if (packetDelayUs > 0) {
+        framesDue = 1;
+        loop.setTimer(paceTimer, packetDelayUs, true);
+    } else {
+        framesDue = numeric_limits<uint64_t>::max();
+    }
+    sendDueFrames();
+}
+
+/**
+ * Sends the frames the pace timer has made due, catching up after a late wake-up as 
+ * packets_from_file does, until the socket is full.
+ */
+void ConnectorLink::sendDueFrames() {
+    if (injector.getFd() == -1) {
+        return;
+    }
+    while (framesDue > 0 && nextOffset < outgoing.size()) {
+        size_t size = min(MAX_MPDU_PAYLOAD_SIZE, outgoing.size() - nextOffset);
+        PacketInjector::SendResult result = injector.send(outgoing.data() + nextOffset, size);
+        if (result == PacketInjector::BLOCKED) {
+            loop.setEvents(injector.getFd(), EPOLLOUT);
+            return;
+        } else if (result == PacketInjector::SEND_FAILED) {
+            finishSending(false);
+            return;
+        }
+        nextOffset += size;
+        framesDue--;
+    }
+    if (nextOffset >= outgoing.size()) {
+        finishSending(true);
+    }
+}
+
+void ConnectorLink::finishSending(bool succeeded) {
+    loop.setTimer(paceTimer, 0, false);
+    if (injector.getFd() != -1) {
+        loop.unwatch(injector.getFd());
+        injector.close();
+    }
+    outgoing.clear();
+    lock_guard<std::mutex> lock(mutex);
+    sending = false;
+    sendSucceeded = succeeded;
+    changed.notify_all();
+}
+
+LoopbackChannel::LoopbackChannel() : closed(false) {
+}
+
+void LoopbackChannel::push(const vector<uint8_t> &message) {
+    lock_guard<std::mutex> lock(mutex);
+    messages.push_back(message);
+    messageReady.notify_all();
+}
+
+/**
+ * Takes the oldest message, waiting up to timeoutMs for one (forever if negative). Returns 
+ * false with message empty on timeout or once the channel is closed and drained.
+ */
+bool LoopbackChannel::pop(vector<uint8_t> &message, int timeoutMs) {
+    unique_lock<std::mutex> lock(mutex);
+    if (timeoutMs < 0) {
+        messageReady.wait(lock, [this]() { return !messages.empty() || closed; });
+    } else {
+        messageReady.wait_for(lock, chrono::milliseconds(timeoutMs), 
+                [this]() { return !messages.empty() || closed; });
+    }
+    if (messages.empty()) {
+        message.clear();
+        return false;
+    }
+    message.swap(messages.front());
+    messages.pop_front();
+    return true;
+}
+
+bool LoopbackChannel::isClosed() {
+    lock_guard<std::mutex> lock(mutex);
+    return closed;
+}
+
+/**
+ * Wakes any endpoint waiting on the channel, nothing more will be sent.
+ */
+void LoopbackChannel::close() {
+    lock_guard<std::mutex> lock(mutex);
+    closed = true;
+    messageReady.notify_all();
+}
+
+LoopbackLink::LoopbackLink(LoopbackChannel &incoming, LoopbackChannel &outgoing) 
+        : incoming(incoming), outgoing(outgoing), nextCsiRecord(0) {
+}
+
+/**
+ * Keeps the CSI records of a log_to_file trace to replay after each received frame.
+ */
+bool LoopbackLink::loadCsiTrace(const string &tracePath) {
+    ifstream traceStream(tracePath.c_str(), ios::in | ios::binary);
+    if (!traceStream) {
+        cerr << "Error opening CSI trace " << tracePath << endl;
+        return false;
+    }
+    vector<uint8_t> trace((istreambuf_iterator<char>(traceStream)), 
+            istreambuf_iterator<char>());
+    csiRecords.clear();
+    for (size_t offset = 0; trace.size() - offset >= 3; ) {
+        size_t fieldLength = (trace[offset] << 8) | trace[offset + 1];
+        if (trace.size() - offset - 2 < fieldLength) {
+            break;
+        }
+        if (fieldLength > 0 && trace[offset + 2] == CSI_RECORD_CODE) {
+            csiRecords.push_back(vector<uint8_t>(trace.begin() + offset, 
+                    trace.begin() + offset + 2 + fieldLength));
+        }
+        offset += 2 + fieldLength;
+    }
+    nextCsiRecord = 0;
+    if (csiRecords.empty()) {
+        cerr << "No CSI records in " << tracePath << endl;
+        return false;
+    }
+    return true;
+}
+
+bool LoopbackLink::send(const vector<uint8_t> &message) {
+    outgoing.push(message);
+    return true;
+}
+
+/**
+ * Appends the records of the next message, waiting up to timeoutMs for it. Returns false once
+ * the other endpoint has closed the channel and every message has been received.
+ */
+bool LoopbackLink::receive(vector<uint8_t> &records, int timeoutMs) {
+    vector<uint8_t> message;
+    if (!incoming.pop(message, timeoutMs)) {
+        return !incoming.isClosed();
+    }
+    for (size_t offset = 0; offset < message.size(); offset += MAX_MPDU_PAYLOAD_SIZE) {
+        appendMpduRecord(message.data() + offset, 
+                min(MAX_MPDU_PAYLOAD_SIZE, message.size() - offset), records);
+        if (!csiRecords.empty()) {
+            const vector<uint8_t> &csiRecord = csiRecords[nextCsiRecord];
+            records.insert(records.end(), csiRecord.begin(), csiRecord.end());
+            nextCsiRecord = (nextCsiRecord + 1) % csiRecords.size();
+        }
+    }
+    return true;
+}
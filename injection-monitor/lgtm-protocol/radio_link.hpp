@@ -0,0 +1,141 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef RADIO_LINK_HPP_
+#define RADIO_LINK_HPP_
+
+#include "csi_ring.hpp"
+#include "event_loop.hpp"
+#include "packet_injector.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Sends messages as injected frames and receives what the monitor logs, as log_to_file 
+ * records (see MpduReassembler).
+ */
+class RadioLink {
+public:
+    virtual ~RadioLink() {}
+
+    virtual bool send(const std::vector<uint8_t> &message) = 0;
+    virtual bool receive(std::vector<uint8_t> &records, int timeoutMs) = 0;
+};
+
+/**
+ * Receives from the iwlwifi connector socket, as log_to_file does, or from a CsiRing, and 
+ * injects on the monitor interface, as packets_from_file does, from one event loop thread.
+ */
+class ConnectorLink : public RadioLink {
+public:
+    ConnectorLink(const std::string &injectionInterface, int packetDelayUs);
+    ~ConnectorLink();
+
+    EventLoop &getEventLoop();
+    bool open();
+    bool openRing(const std::string &socketPath);
+    void close();
+    bool send(const std::vector<uint8_t> &message);
+    bool receive(std::vector<uint8_t> &records, int timeoutMs);
+
+private:
+    std::string injectionInterface;
+    int packetDelayUs;
+    int socketFd;
+    std::vector<char> buffer;
+    CsiRingReader ringReader;
+    bool fromRing;
+    EventLoop loop;
+    std::thread loopThread;
+    // Only used on the loop thread
+    PacketInjector injector;
+    int paceTimer;
+    std::vector<uint8_t> outgoing;
+    size_t nextOffset;
+    uint64_t framesDue;
+    // Shared with the threads sending and receiving
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::vector<uint8_t> received;
+    bool sending;
+    bool sendSucceeded;
+    bool closed;
+
+    ConnectorLink(const ConnectorLink &);
+    ConnectorLink &operator=(const ConnectorLink &);
+
+    bool startLoop();
+    void readConnector();
+    void startSending(const std::vector<uint8_t> &message);
+    void sendDueFrames();
+    void finishSending(bool succeeded);
+};
+
+/**
+ * Messages in flight from one loopback endpoint to the other.
+ */
+class LoopbackChannel {
+public:
+    LoopbackChannel();
+
+    void push(const std::vector<uint8_t> &message);
+    bool pop(std::vector<uint8_t> &message, int timeoutMs);
+    void close();
+    bool isClosed();
+
+private:
+    std::mutex mutex;
+    std::condition_variable messageReady;
+    std::deque<std::vector<uint8_t> > messages;
+    bool closed;
+};
+
+/**
+ * One endpoint of an in-process link, for running both sides of the protocol without radios.
+ *
+ * Received messages are turned into the records a monitor would log for the injected frames.
+ * Given a recorded log_to_file trace, the CSI records of the trace are replayed after the 
+ * frames, one per frame as the card logs them, so localization runs on real measurements.
+ */
+class LoopbackLink : public RadioLink {
+public:
+    LoopbackLink(LoopbackChannel &incoming, LoopbackChannel &outgoing);
+
+    bool loadCsiTrace(const std::string &tracePath);
+    bool send(const std::vector<uint8_t> &message);
+    bool receive(std::vector<uint8_t> &records, int timeoutMs);
+
+private:
+    LoopbackChannel &incoming;
+    LoopbackChannel &outgoing;
+    std::vector<std::vector<uint8_t> > csiRecords;
+    size_t nextCsiRecord;
+};
+
+#endif
@@ -0,0 +1,219 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#include "task_graph.hpp"
+
+using namespace std;
+
+//~Functions----------------------------------------------------------------------------------------
+TaskGraph::TaskGraph() : created(chrono::steady_clock::now()) {
+}
+
+TaskGraph::~TaskGraph() {
+    cancel();
+    wait();
+}
+
+/**
+ * Adds a step that runs work once every dependency has succeeded. Steps can only depend on 
+ * steps added before them, and run as soon as they are added if they are ready.
+ */
+int TaskGraph::addTask(const string &name, const function<bool()> &work, 
+        const vector<int> &dependencies) {
+    lock_guard<std::mutex> lock(mutex);
+    Task task;
+    task.name = name;
+    task.work = work;
+    task.dependencies = dependencies;
+    task.event = false;
+    task.state = WAITING;
+    tasks.push_back(task);
+    launchReady();
+    return tasks.size() - 1;
+}
+
+/**
+ * Adds an event for steps to depend on, done once signal is called for it.
+ */
+int TaskGraph::addEvent(const string &name) {
+    lock_guard<std::mutex> lock(mutex);
+    Task task;
+    task.name = name;
+    task.event = true;
+    task.state = WAITING;
+    task.start = chrono::steady_clock::now();
+    tasks.push_back(task);
+    return tasks.size() - 1;
+}
+
+/**
+ * Marks an event done, starting every step that was only waiting for it.
+ */
+void TaskGraph::signal(int event, bool succeeded) {
+    lock_guard<std::mutex> lock(mutex);
+    Task &task = tasks[event];
+    if (!task.event || task.state != WAITING) {
+        return;
+    }
+    task.state = succeeded ? SUCCEEDED : FAILED;
+    task.end = chrono::steady_clock::now();
+    taskFinished.notify_all();
+    launchReady();
+}
+
+/**
+ * Fails every event not signalled yet, so the steps waiting on them are skipped. Steps that
+ * are running are left to finish.
+ */
+void TaskGraph::cancel() {
+    lock_guard<std::mutex> lock(mutex);
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+        if (tasks[i].event && tasks[i].state == WAITING) {
+            tasks[i].state = FAILED;
+            tasks[i].end = chrono::steady_clock::now();
+        }
+    }
+    taskFinished.notify_all();
+    launchReady();
+}
+
+/**
+ * Waits up to timeoutMs for every step to finish, returning true if they have. wait still has 
+ * to be called to join them.
+ */
+bool TaskGraph::waitFor(int timeoutMs) {
+    unique_lock<std::mutex> lock(mutex);
+    return taskFinished.wait_for(lock, chrono::milliseconds(timeoutMs), 
+            [this]() { return allFinished(); });
+}
+
+/**
+ * Waits for every step to finish or be skipped, events included. Returns true if all 
+ * succeeded.
+ */
+bool TaskGraph::wait() {
+    unique_lock<std::mutex> lock(mutex);
+    taskFinished.wait(lock, [this]() { return allFinished(); });
+    bool succeeded = true;
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+        succeeded = succeeded && tasks[i].state == SUCCEEDED;
+    }
+    vector<thread> finishedThreads;
+    finishedThreads.swap(threads);
+    lock.unlock();
+    for (unsigned int i = 0; i < finishedThreads.size(); i++) {
+        finishedThreads[i].join();
+    }
+    return succeeded;
+}
+
+int TaskGraph::getTaskCount() const {
+    return tasks.size();
+}
+
+const string &TaskGraph::getName(int task) const {
+    return tasks[task].name;
+}
+
+TaskGraph::TaskState TaskGraph::getState(int task) {
+    lock_guard<std::mutex> lock(mutex);
+    return tasks[task].state;
+}
+
+/**
+ * Seconds from the creation of the graph to the start of a step, or to the creation of an 
+ * event.
+ */
+double TaskGraph::getStartSeconds(int task) {
+    lock_guard<std::mutex> lock(mutex);
+    chrono::duration<double> seconds = tasks[task].start - created;
+    return tasks[task].state == WAITING && !tasks[task].event ? -1.0 : seconds.count();
+}
+
+/**
+ * Seconds from the creation of the graph to the end of a step or the signal of an event, -1 if
+ * it has not finished.
+ */
+double TaskGraph::getEndSeconds(int task) {
+    lock_guard<std::mutex> lock(mutex);
+    chrono::duration<double> seconds = tasks[task].end - created;
+    return isFinished(tasks[task]) ? seconds.count() : -1.0;
+}
+
+/**
+ * Starts every waiting step whose dependencies succeeded, and fails every waiting step with a
+ * failed dependency, until nothing changes. Called with the mutex held.
+ */
+void TaskGraph::launchReady() {
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (unsigned int i = 0; i < tasks.size(); i++) {
+            Task &task = tasks[i];
+            if (task.event || task.state != WAITING) {
+                continue;
+            }
+            bool ready = true;
+            bool skipped = false;
+            for (unsigned int j = 0; j < task.dependencies.size(); j++) {
+                TaskState dependencyState = tasks[task.dependencies[j]].state;
+                ready = ready && dependencyState == SUCCEEDED;
+                skipped = skipped || dependencyState == FAILED;
+            }
+            if (skipped) {
+                task.state = FAILED;
+                task.start = task.end = chrono::steady_clock::now();
+                taskFinished.notify_all();
+                changed = true;
+            } else if (ready) {
+                task.state = RUNNING;
+                task.start = chrono::steady_clock::now();
+                // The work is copied, tasks may grow while it runs
+                int index = i;
+                function<bool()> work = task.work;
+                threads.push_back(thread([this, index, work]() { finish(index, work()); }));
+            }
+        }
+    }
+}
+
+void TaskGraph::finish(int task, bool succeeded) {
+    lock_guard<std::mutex> lock(mutex);
+    tasks[task].state = succeeded ? SUCCEEDED : FAILED;
+    tasks[task].end = chrono::steady_clock::now();
+    taskFinished.notify_all();
+    launchReady();
+}
+
+bool TaskGraph::isFinished(const Task &task) const {
+    return task.state == SUCCEEDED || task.state == FAILED;
+}
+
+bool TaskGraph::allFinished() const {
+    for (unsigned int i = 0; i < tasks.size(); i++) {
+        if (!isFinished(tasks[i])) {
+            return false;
+        }
+    }
+    return true;
+}
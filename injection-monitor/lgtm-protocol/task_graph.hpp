@@ -0,0 +1,90 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Ethan Gaebel <egaebel@vt.edu>
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a 
+ * copy of this software and associated documentation files (the "Software"), 
+ * to deal in the Software without restriction, including without limitation 
+ * the rights to use, copy, modify, merge, publish, distribute, sublicense, 
+ * and/or sell copies of the Software, and to permit persons to whom the 
+ * Software is furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included 
+ * in all copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS 
+ * OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING 
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER 
+ * DEALINGS IN THE SOFTWARE.
+ */
+
+#ifndef TASK_GRAPH_HPP_
+#define TASK_GRAPH_HPP_
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs steps as soon as the steps and events they depend on have finished, each on its own 
+ * thread, so independent steps overlap and only the steps that need them wait.
+ *
+ * Events are steps without work that are marked done from outside the graph, e.g. when a 
+ * message arrives. A step whose dependency failed or was cancelled is skipped and counts as 
+ * failed itself.
+ */
+class TaskGraph {
+public:
+    enum TaskState { WAITING, RUNNING, SUCCEEDED, FAILED };
+
+    TaskGraph();
+    ~TaskGraph();
+
+    int addTask(const std::string &name, const std::function<bool()> &work, 
+            const std::vector<int> &dependencies = std::vector<int>());
+    int addEvent(const std::string &name);
+    void signal(int event, bool succeeded = true);
+    void cancel();
+    bool waitFor(int timeoutMs);
+    bool wait();
+
+    int getTaskCount() const;
+    const std::string &getName(int task) const;
+    TaskState getState(int task);
+    double getStartSeconds(int task);
+    double getEndSeconds(int task);
+
+private:
+    struct Task {
+        std::string name;
+        std::function<bool()> work;
+        std::vector<int> dependencies;
+        bool event;
+        TaskState state;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point end;
+    };
+
+    std::vector<Task> tasks;
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable taskFinished;
+    std::chrono::steady_clock::time_point created;
+
+    TaskGraph(const TaskGraph &);
+    TaskGraph &operator=(const TaskGraph &);
+
+    void launchReady();
+    void finish(int task, bool succeeded);
+    bool isFinished(const Task &task) const;
+    bool allFinished() const;
+};
+
+#endif